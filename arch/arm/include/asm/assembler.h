@@ -57,6 +57,11 @@
 #define PLD(code...)
 #endif
 
+/*
+ * Size from which memcpy()/memset() hand over to the NEON routines
+ */
+#define NEON_MEM_MIN	128
+
 /*
  * We only support cores that support at least Thumb-1 and thus we use
  * 'bx lr'
@@ -44,6 +44,13 @@ void system_clock_init(void);
  */
 int do_lowlevel_init(void);
 
+/*
+ * Write the SPL hand-off information for U-Boot proper into a bloblist
+ *
+ * This must be called once DRAM is set up.
+ */
+void exynos_spl_handoff(void);
+
 void sdelay(unsigned long);
 
 enum l2_cache_params {
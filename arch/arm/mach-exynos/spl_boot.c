@@ -337,6 +337,9 @@ void board_init_f(unsigned long bootflag)
 	if (do_lowlevel_init())
 		power_exit_wakeup();
 
+	if (CONFIG_IS_ENABLED(HANDOFF))
+		exynos_spl_handoff();
+
 	copy_uboot_to_ram();
 
 	/* Jump to U-Boot image */
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Pass hand-off information from the Exynos SPL to U-Boot proper
+ *
+ * The Exynos SPL runs from iRAM without the common library, so it cannot use
+ * common/bloblist.c. Instead it writes a bloblist holding just the SPL
+ * hand-off record, which U-Boot proper then finds in the usual way and uses
+ * instead of probing each DRAM bank again.
+ */
+
+#include <common.h>
+#include <bloblist.h>
+#include <handoff.h>
+
+#include "common_setup.h"
+
+/**
+ * struct exynos_bloblist - The bloblist written by SPL
+ *
+ * @hdr: Bloblist header
+ * @rec: Record header for @ho, which follows it directly
+ * @ho: SPL hand-off information
+ */
+struct exynos_bloblist {
+	struct bloblist_hdr hdr;
+	struct bloblist_rec rec;
+	struct spl_handoff ho;
+} __aligned(BLOBLIST_ALIGN);
+
+/* CRC32 as used by bloblist, without the 1KB table of lib/crc32.c */
+static u32 handoff_crc32(u32 crc, const void *buf, uint len)
+{
+	const u8 *p = buf;
+	int i;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *p++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+	}
+
+	return ~crc;
+}
+
+void exynos_spl_handoff(void)
+{
+	struct exynos_bloblist *bl = (void *)CONFIG_BLOBLIST_ADDR;
+	struct spl_handoff *ho = &bl->ho;
+	u32 chksum;
+	int i;
+
+	memzero(bl, sizeof(*bl));
+	bl->hdr.version = BLOBLIST_VERSION;
+	bl->hdr.hdr_size = sizeof(bl->hdr);
+	bl->hdr.magic = BLOBLIST_MAGIC;
+	bl->hdr.size = CONFIG_BLOBLIST_SIZE;
+	bl->hdr.alloced = sizeof(*bl);
+	bl->rec.tag = BLOBLISTT_SPL_HANDOFF;
+	bl->rec.hdr_size = sizeof(bl->rec);
+	bl->rec.size = sizeof(*ho);
+
+	/* mem_ctrl_init() has set up every bank at its full size */
+	for (i = 0; i < CONFIG_NR_DRAM_BANKS; i++) {
+		ho->ram_bank[i].start = CONFIG_SYS_SDRAM_BASE +
+					i * SDRAM_BANK_SIZE;
+		ho->ram_bank[i].size = SDRAM_BANK_SIZE;
+		ho->ram_size += SDRAM_BANK_SIZE;
+	}
+
+	chksum = handoff_crc32(0, &bl->hdr,
+			       offsetof(struct bloblist_hdr, chksum));
+	chksum = handoff_crc32(chksum, &bl->rec, sizeof(bl->rec));
+	bl->hdr.chksum = handoff_crc32(chksum, ho, sizeof(*ho));
+}
@@ -43,6 +43,12 @@ void sandbox_exit(void)
 	os_exit(0);
 }
 
+int initjmp(jmp_buf jmp, void (*func)(void), void *stack_base,
+	    size_t stack_sz)
+{
+	return os_initjmp(jmp, func, stack_base, stack_sz);
+}
+
 /* delay x useconds */
 void __udelay(unsigned long usec)
 {
@@ -828,3 +828,52 @@ void os_relaunch(char *argv[])
 	execv(argv[0], argv);
 	os_exit(1);
 }
+
+static jmp_buf *initjmp_buf;
+static void (*initjmp_func)(void);
+
+static void os_initjmp_handler(int sig)
+{
+	void (*func)(void) = initjmp_func;
+
+	/* Save a context on the new stack, then return from the signal */
+	if (!_setjmp(*initjmp_buf))
+		return;
+
+	/* A longjmp() to the context brings us here */
+	func();
+	os_abort();
+}
+
+/*
+ * The host's jmp_buf cannot be filled in by hand, since the C library may
+ * mangle the pointers in it. Instead, run a signal handler on the new stack
+ * and save the context from there.
+ */
+int os_initjmp(void *jmp, void (*func)(void), void *stack_base,
+	       size_t stack_sz)
+{
+	struct sigaction act, old_act;
+	stack_t stack, old_stack;
+
+	stack.ss_sp = stack_base;
+	stack.ss_size = stack_sz;
+	stack.ss_flags = 0;
+	if (sigaltstack(&stack, &old_stack))
+		return -errno;
+
+	memset(&act, '\0', sizeof(act));
+	act.sa_handler = os_initjmp_handler;
+	act.sa_flags = SA_ONSTACK | SA_NODEFER;
+	sigemptyset(&act.sa_mask);
+	sigaction(SIGUSR2, &act, &old_act);
+
+	initjmp_buf = jmp;
+	initjmp_func = func;
+	raise(SIGUSR2);
+
+	sigaction(SIGUSR2, &old_act, NULL);
+	sigaltstack(&old_stack, NULL);
+
+	return 0;
+}
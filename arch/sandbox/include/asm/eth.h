@@ -41,6 +41,22 @@ int sandbox_eth_arp_req_to_reply(struct udevice *dev, void *packet,
 int sandbox_eth_ping_req_to_reply(struct udevice *dev, void *packet,
 				  unsigned int len);
 
+/*
+ * sandbox_eth_queue_udp()
+ *
+ * Queue a UDP packet from the fake host at fake_host_ipaddr to U-Boot. The
+ * caller fills in the payload.
+ *
+ * @dev: device that will receive the packet
+ * @pos: position in the receive queue, or -1 to add it at the end
+ * @sport: UDP source port
+ * @dport: UDP destination port
+ * @len: length of the payload
+ * @return pointer to the payload, or NULL if there is no room
+ */
+void *sandbox_eth_queue_udp(struct udevice *dev, int pos, int sport,
+			    int dport, int len);
+
 /*
  * sandbox_eth_recv_arp_req()
  *
@@ -71,6 +87,13 @@ int sandbox_eth_recv_ping_req(struct udevice *dev);
 typedef int sandbox_eth_tx_hand_f(struct udevice *dev, void *pkt,
 				   unsigned int len);
 
+/**
+ * A start handler
+ *
+ * dev - device pointer
+ */
+typedef int sandbox_eth_start_hand_f(struct udevice *dev);
+
 /**
  * struct eth_sandbox_priv - memory for sandbox mock driver
  *
@@ -81,16 +104,22 @@ typedef int sandbox_eth_tx_hand_f(struct udevice *dev, void *pkt,
  * recv_packet_length - lengths of the packet returned as received
  * recv_packets - number of packets returned
  * tx_handler - function to generate responses to sent packets
+ * start_handler - function to queue packets when the device starts, or NULL
  * priv - a pointer to some structure a test may want to keep track of
+ * has_link - get_link() reports link_up, rather than that it cannot tell
+ * link_up - link state reported by get_link()
  */
 struct eth_sandbox_priv {
 	uchar fake_host_hwaddr[ARP_HLEN];
 	struct in_addr fake_host_ipaddr;
 	bool disabled;
+	bool has_link;
+	bool link_up;
 	uchar * recv_packet_buffer[PKTBUFSRX];
 	int recv_packet_length[PKTBUFSRX];
 	int recv_packets;
 	sandbox_eth_tx_hand_f *tx_handler;
+	sandbox_eth_start_hand_f *start_handler;
 	void *priv;
 };
 
@@ -101,6 +130,17 @@ struct eth_sandbox_priv {
  */
 void sandbox_eth_set_tx_handler(int index, sandbox_eth_tx_hand_f *handler);
 
+/*
+ * Set start handler
+ *
+ * This lets a test act as a host which sends the first packet, for
+ * protocols where U-Boot waits to be contacted.
+ *
+ * handler - The func ptr to call on start, or NULL for none
+ */
+void sandbox_eth_set_start_handler(int index,
+				   sandbox_eth_start_hand_f *handler);
+
 /*
  * Set priv ptr
  *
@@ -108,4 +148,12 @@ void sandbox_eth_set_tx_handler(int index, sandbox_eth_tx_hand_f *handler);
  */
 void sandbox_eth_set_priv(int index, void *priv);
 
+/*
+ * Set the link state reported by the device
+ *
+ * index - interface to set the link state of
+ * link - 1 if up, 0 if down, -ENOSYS to report that it cannot tell
+ */
+void sandbox_eth_set_link(int index, int link);
+
 #endif /* __ETH_H */
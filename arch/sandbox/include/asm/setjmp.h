@@ -32,4 +32,19 @@ typedef struct jmp_buf_data jmp_buf[1];
 int setjmp(jmp_buf jmp);
 __noreturn void longjmp(jmp_buf jmp, int ret);
 
+/**
+ * initjmp() - Set up a context which runs a function on a new stack
+ *
+ * A later longjmp() to @jmp calls @func with its stack pointer at the top
+ * of the stack. @func must not return.
+ *
+ * @jmp: Context to set up
+ * @func: Function to call
+ * @stack_base: Lowest address of the stack, aligned to 16 bytes
+ * @stack_sz: Size of the stack in bytes, a multiple of 16
+ * @return 0
+ */
+int initjmp(jmp_buf jmp, void (*func)(void), void *stack_base,
+	    size_t stack_sz);
+
 #endif /* _SETJMP_H_ */
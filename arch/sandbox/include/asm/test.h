@@ -33,6 +33,21 @@
 
 #define SANDBOX_CLK_RATE		32768
 
+/* Load address and size of the files sent by the network test servers */
+#define SANDBOX_NET_TEST_ADDR		0x1000000
+#define SANDBOX_NET_TEST_SIZE		(10 * 1024 + 300)
+
+/**
+ * sandbox_test_byte() - Get a byte of the data sent by the test servers
+ *
+ * @offset: Offset of the byte within the data
+ * @return value of the byte
+ */
+static inline u8 sandbox_test_byte(int offset)
+{
+	return offset * 7 + (offset >> 8);
+}
+
 /* Macros used to test PCI EA capability structure */
 #define PCI_CAP_EA_BASE_LO0		0x00100000
 #define PCI_CAP_EA_BASE_LO1		0x00110000
@@ -218,6 +233,14 @@ int sandbox_get_pch_spi_protect(struct udevice *dev);
  */
 int sandbox_get_pci_ep_irq_count(struct udevice *dev);
 
+/**
+ * sandbox_mmc_get_blocks_written() - Get the number of blocks written to an MMC
+ *
+ * @dev: MMC device to check
+ * @return number of blocks written since the device was probed
+ */
+uint sandbox_mmc_get_blocks_written(struct udevice *dev);
+
 /**
  * sandbox_pci_read_bar() - Read the BAR value for a read_config operation
  *
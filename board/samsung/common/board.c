@@ -9,6 +9,7 @@
 #include <env.h>
 #include <errno.h>
 #include <fdtdec.h>
+#include <handoff.h>
 #include <hang.h>
 #include <init.h>
 #include <log.h>
@@ -123,6 +124,13 @@ int dram_init(void)
 	unsigned int i;
 	unsigned long addr;
 
+#if CONFIG_IS_ENABLED(HANDOFF)
+	/* SPL has already set up the banks, so there is no need to probe */
+	if (gd->spl_handoff) {
+		handoff_load_dram_size(gd->spl_handoff);
+		return 0;
+	}
+#endif
 	for (i = 0; i < CONFIG_NR_DRAM_BANKS; i++) {
 		addr = CONFIG_SYS_SDRAM_BASE + (i * SDRAM_BANK_SIZE);
 		gd->ram_size += get_ram_size((long *)addr, SDRAM_BANK_SIZE);
@@ -135,6 +143,12 @@ int dram_init_banksize(void)
 	unsigned int i;
 	unsigned long addr, size;
 
+#if CONFIG_IS_ENABLED(HANDOFF)
+	if (gd->spl_handoff) {
+		handoff_load_dram_banks(gd->spl_handoff);
+		return 0;
+	}
+#endif
 	for (i = 0; i < CONFIG_NR_DRAM_BANKS; i++) {
 		addr = CONFIG_SYS_SDRAM_BASE + (i * SDRAM_BANK_SIZE);
 		size = get_ram_size((long *)addr, SDRAM_BANK_SIZE);
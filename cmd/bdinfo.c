@@ -127,6 +127,10 @@ int do_bdinfo(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 
 		lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 		lmb_dump_all_force(&lmb);
+#if CONFIG_IS_ENABLED(LMB_AUTO)
+		printf("auto load regions:\n");
+		lmb_auto_show();
+#endif
 	}
 
 	arch_print_bdinfo();
@@ -11,6 +11,23 @@
 #include <common.h>
 #include <blk.h>
 #include <command.h>
+#include <display_options.h>
+#include <time.h>
+#include <linux/math64.h>
+
+/* Show the transfer rate of @cnt blocks of device @devnum over @time ms */
+static void blk_show_rate(enum if_type if_type, int devnum, ulong cnt,
+			  ulong time)
+{
+	struct blk_desc *desc;
+
+	desc = blk_get_devnum_by_type(if_type, devnum);
+	if (!desc || !time)
+		return;
+	puts(" (");
+	print_size(div_u64((u64)cnt * desc->blksz, time) * 1000, "/s");
+	puts(")");
+}
 
 int blk_common_cmd(int argc, char *const argv[], enum if_type if_type,
 		   int *cur_devnump)
@@ -66,31 +83,39 @@ int blk_common_cmd(int argc, char *const argv[], enum if_type if_type,
 			ulong addr = simple_strtoul(argv[2], NULL, 16);
 			lbaint_t blk = simple_strtoul(argv[3], NULL, 16);
 			ulong cnt = simple_strtoul(argv[4], NULL, 16);
-			ulong n;
+			ulong n, time;
 
 			printf("\n%s read: device %d block # "LBAFU", count %lu ... ",
 			       if_name, *cur_devnump, blk, cnt);
 
+			time = get_timer(0);
 			n = blk_read_devnum(if_type, *cur_devnump, blk, cnt,
 					    (ulong *)addr);
+			time = get_timer(time);
 
-			printf("%ld blocks read: %s\n", n,
+			printf("%ld blocks read: %s", n,
 			       n == cnt ? "OK" : "ERROR");
+			blk_show_rate(if_type, *cur_devnump, n, time);
+			puts("\n");
 			return n == cnt ? 0 : 1;
 		} else if (strcmp(argv[1], "write") == 0) {
 			ulong addr = simple_strtoul(argv[2], NULL, 16);
 			lbaint_t blk = simple_strtoul(argv[3], NULL, 16);
 			ulong cnt = simple_strtoul(argv[4], NULL, 16);
-			ulong n;
+			ulong n, time;
 
 			printf("\n%s write: device %d block # "LBAFU", count %lu ... ",
 			       if_name, *cur_devnump, blk, cnt);
 
+			time = get_timer(0);
 			n = blk_write_devnum(if_type, *cur_devnump, blk, cnt,
 					     (ulong *)addr);
+			time = get_timer(time);
 
-			printf("%ld blocks written: %s\n", n,
+			printf("%ld blocks written: %s", n,
 			       n == cnt ? "OK" : "ERROR");
+			blk_show_rate(if_type, *cur_devnump, n, time);
+			puts("\n");
 			return n == cnt ? 0 : 1;
 		} else {
 			return CMD_RET_USAGE;
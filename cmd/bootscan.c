@@ -0,0 +1,333 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Find which distro boot targets are ready before trying to boot them
+ *
+ * distro_bootcmd runs the boot targets strictly in order, so a missing SD
+ * card, an unplugged USB stick or a network without a cable each cost their
+ * full timeout before a working eMMC is tried. This command starts a cheap
+ * probe on every target at once and then polls them in turn, so that slow
+ * steps such as card power-up and PHY autonegotiation overlap. Targets that
+ * turn out to be absent are dropped and those found ready are moved to the
+ * front, keeping their relative order. Probing stops as soon as the
+ * highest-priority target still in the running is ready.
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <command.h>
+#include <console.h>
+#include <dm.h>
+#include <env.h>
+#include <fs.h>
+#include <log.h>
+#include <malloc.h>
+#include <mmc.h>
+#include <net.h>
+#include <part.h>
+#include <linux/ctype.h>
+#include <linux/delay.h>
+
+#define BOOTSCAN_MAX_TARGETS	16
+#define BOOTSCAN_POLL_MS	10
+
+enum bootscan_state {
+	BOOTSCAN_PENDING,	/* probe started, poll again */
+	BOOTSCAN_UNKNOWN,	/* cannot tell without a slow init */
+	BOOTSCAN_READY,		/* has something to boot from */
+	BOOTSCAN_ABSENT,	/* not there, or nothing to boot from */
+};
+
+struct bootscan_target;
+
+/**
+ * struct bootscan_probe - How to probe one type of boot target
+ *
+ * @name: Target name without the instance number, e.g. "mmc"
+ * @start: Start probing a target. This must not wait for the hardware.
+ *	Returns the new state
+ * @poll: Continue probing a target in BOOTSCAN_PENDING state. Returns the
+ *	new state. May be NULL if @start never returns BOOTSCAN_PENDING
+ */
+struct bootscan_probe {
+	const char *name;
+	enum bootscan_state (*start)(struct bootscan_target *tgt);
+	enum bootscan_state (*poll)(struct bootscan_target *tgt);
+};
+
+/**
+ * struct bootscan_target - A boot target being probed
+ *
+ * @name: Target name, as in ${boot_targets}
+ * @devnum: Instance number, from the end of @name (0 if none)
+ * @probe: Probe for this type of target, or NULL if not known
+ * @state: Current state
+ * @priv: Private data for the probe
+ */
+struct bootscan_target {
+	const char *name;
+	int devnum;
+	const struct bootscan_probe *probe;
+	enum bootscan_state state;
+	void *priv;
+};
+
+/* Check whether a block device has a partition or filesystem to boot from */
+static enum bootscan_state bootscan_check_blk(struct blk_desc *desc)
+{
+	struct disk_partition info;
+
+	if (!desc || desc->type == DEV_TYPE_UNKNOWN)
+		return BOOTSCAN_ABSENT;
+	if (!part_get_info(desc, 1, &info))
+		return BOOTSCAN_READY;
+	if (!fs_set_blk_dev_with_part(desc, 0)) {
+		fs_close();
+		return BOOTSCAN_READY;
+	}
+
+	return BOOTSCAN_ABSENT;
+}
+
+#if CONFIG_IS_ENABLED(DM_MMC)
+/* Let an eMMC device power up while the other targets are probed */
+static enum bootscan_state bootscan_mmc_poll(struct bootscan_target *tgt)
+{
+	struct mmc *mmc = tgt->priv;
+	int ret;
+
+	ret = mmc_poll_init(mmc);
+	if (ret == -EAGAIN)
+		return BOOTSCAN_PENDING;
+	else if (ret)
+		return BOOTSCAN_ABSENT;
+
+	return bootscan_check_blk(mmc_get_blk_desc(mmc));
+}
+
+static enum bootscan_state bootscan_mmc_start(struct bootscan_target *tgt)
+{
+	struct udevice *dev;
+	struct mmc *mmc;
+
+	if (uclass_get_device_by_seq(UCLASS_MMC, tgt->devnum, &dev))
+		return BOOTSCAN_ABSENT;
+	mmc = mmc_get_mmc_dev(dev);
+	if (!mmc)
+		return BOOTSCAN_ABSENT;
+	tgt->priv = mmc;
+	if (!mmc->has_init && !IS_ENABLED(CONFIG_MMC_BROKEN_CD) &&
+	    !mmc_getcd(mmc))
+		return BOOTSCAN_ABSENT;
+
+	return bootscan_mmc_poll(tgt);
+}
+#endif
+
+static enum bootscan_state bootscan_blk_start(struct bootscan_target *tgt)
+{
+	struct blk_desc *desc;
+
+	desc = blk_get_devnum_by_typename(tgt->probe->name, tgt->devnum);
+
+	return bootscan_check_blk(desc);
+}
+
+#ifdef CONFIG_CMD_USB
+static enum bootscan_state bootscan_usb_start(struct bootscan_target *tgt)
+{
+	extern char usb_started;
+
+	/* Starting USB takes seconds, so leave that to the boot itself */
+	if (!usb_started)
+		return BOOTSCAN_UNKNOWN;
+
+	return bootscan_blk_start(tgt);
+}
+#endif
+
+#ifdef CONFIG_DM_ETH
+static enum bootscan_state bootscan_net_poll(struct bootscan_target *tgt)
+{
+	int ret;
+
+	ret = eth_get_link(tgt->priv);
+	if (ret == -ENOSYS)
+		return BOOTSCAN_READY;	/* cannot tell, so assume it is up */
+	else if (ret < 0)
+		return BOOTSCAN_ABSENT;
+
+	return ret ? BOOTSCAN_READY : BOOTSCAN_PENDING;
+}
+
+static enum bootscan_state bootscan_net_start(struct bootscan_target *tgt)
+{
+	struct udevice *dev;
+
+	dev = eth_get_dev();
+	if (!dev) {
+		/* A USB adapter may appear once USB is started */
+		return IS_ENABLED(CONFIG_USB_HOST_ETHER) ? BOOTSCAN_UNKNOWN :
+			BOOTSCAN_ABSENT;
+	}
+	tgt->priv = dev;
+
+	return bootscan_net_poll(tgt);
+}
+#endif
+
+static const struct bootscan_probe bootscan_probes[] = {
+#if CONFIG_IS_ENABLED(DM_MMC)
+	{ "mmc", bootscan_mmc_start, bootscan_mmc_poll },
+#endif
+#ifdef CONFIG_SANDBOX
+	{ "host", bootscan_blk_start, NULL },
+#endif
+#ifdef CONFIG_CMD_USB
+	{ "usb", bootscan_usb_start, NULL },
+#endif
+#ifdef CONFIG_DM_ETH
+	{ "dhcp", bootscan_net_start, bootscan_net_poll },
+	{ "pxe", bootscan_net_start, bootscan_net_poll },
+#endif
+};
+
+static const struct bootscan_probe *bootscan_find_probe(const char *name,
+							int len)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bootscan_probes); i++) {
+		const struct bootscan_probe *probe = &bootscan_probes[i];
+
+		if (strlen(probe->name) == len &&
+		    !strncmp(probe->name, name, len))
+			return probe;
+	}
+
+	return NULL;
+}
+
+static void bootscan_init(struct bootscan_target *tgt, const char *name)
+{
+	const char *p = name + strlen(name);
+
+	while (p > name && isdigit(p[-1]))
+		p--;
+	tgt->name = name;
+	tgt->devnum = *p ? simple_strtoul(p, NULL, 10) : 0;
+	tgt->probe = bootscan_find_probe(name, p - name);
+	tgt->state = BOOTSCAN_UNKNOWN;
+	tgt->priv = NULL;
+}
+
+/*
+ * Scanning is done once the first target that is neither absent nor unknown
+ * is ready, or nothing is pending
+ */
+static bool bootscan_done(struct bootscan_target *tgts, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (tgts[i].state == BOOTSCAN_READY)
+			return true;
+		if (tgts[i].state == BOOTSCAN_PENDING)
+			return false;
+	}
+
+	return true;
+}
+
+/* Add the names of targets in a state to a space-separated list */
+static char *bootscan_add(char *p, struct bootscan_target *tgts, int count,
+			  bool ready)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		struct bootscan_target *tgt = &tgts[i];
+
+		if (tgt->state == BOOTSCAN_ABSENT ||
+		    (tgt->state == BOOTSCAN_READY) != ready)
+			continue;
+		p += sprintf(p, "%s ", tgt->name);
+	}
+
+	return p;
+}
+
+static int do_bootscan(struct cmd_tbl *cmdtp, int flag, int argc,
+		       char *const argv[])
+{
+	struct bootscan_target tgts[BOOTSCAN_MAX_TARGETS];
+	ulong timeout = CONFIG_CMD_BOOTSCAN_TIMEOUT;
+	const char *varname;
+	char *list, *p;
+	ulong start;
+	int count, i, len;
+
+	if (argc > 2 && !strcmp(argv[1], "-t")) {
+		timeout = simple_strtoul(argv[2], NULL, 10);
+		argc -= 2;
+		argv += 2;
+	}
+	if (argc < 2)
+		return CMD_RET_USAGE;
+	varname = argv[1];
+	argc -= 2;
+	argv += 2;
+	if (argc > BOOTSCAN_MAX_TARGETS) {
+		printf("Too many boot targets (max %d)\n", BOOTSCAN_MAX_TARGETS);
+		return CMD_RET_FAILURE;
+	}
+
+	for (count = 0, len = 1; count < argc; count++) {
+		bootscan_init(&tgts[count], argv[count]);
+		len += strlen(argv[count]) + 1;
+	}
+
+	for (i = 0; i < count; i++) {
+		struct bootscan_target *tgt = &tgts[i];
+
+		if (tgt->probe)
+			tgt->state = tgt->probe->start(tgt);
+	}
+
+	start = get_timer(0);
+	while (!bootscan_done(tgts, count)) {
+		if (ctrlc() || get_timer(start) >= timeout)
+			break;
+		mdelay(BOOTSCAN_POLL_MS);
+		for (i = 0; i < count; i++) {
+			struct bootscan_target *tgt = &tgts[i];
+
+			if (tgt->state == BOOTSCAN_PENDING)
+				tgt->state = tgt->probe->poll(tgt);
+			if (tgt->state == BOOTSCAN_READY)
+				break;
+		}
+	}
+	log_debug("scan took %lu ms\n", get_timer(start));
+
+	list = malloc(len);
+	if (!list)
+		return CMD_RET_FAILURE;
+	p = bootscan_add(list, tgts, count, true);
+	p = bootscan_add(p, tgts, count, false);
+	if (p > list)
+		p--;
+	*p = '\0';
+	env_set(varname, list);
+	free(list);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	bootscan, CONFIG_SYS_MAXARGS, 0, do_bootscan,
+	"find which boot targets are ready",
+	"[-t <timeout_ms>] <varname> <target>...\n"
+	"    - probe the targets (e.g. mmc0 usb0 dhcp) at the same time and\n"
+	"      set <varname> to those not found to be absent, with the ready\n"
+	"      ones first"
+);
@@ -64,6 +64,16 @@ static int do_dm_dump_static_driver_info(struct cmd_tbl *cmdtp, int flag, int ar
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+static int do_dm_dump_stats(struct cmd_tbl *cmdtp, int flag, int argc,
+			    char *const argv[])
+{
+	dm_dump_stats();
+
+	return 0;
+}
+#endif
+
 static struct cmd_tbl test_commands[] = {
 	U_BOOT_CMD_MKENT(tree, 0, 1, do_dm_dump_all, "", ""),
 	U_BOOT_CMD_MKENT(uclass, 1, 1, do_dm_dump_uclass, "", ""),
@@ -71,6 +81,9 @@ static struct cmd_tbl test_commands[] = {
 	U_BOOT_CMD_MKENT(drivers, 1, 1, do_dm_dump_drivers, "", ""),
 	U_BOOT_CMD_MKENT(compat, 1, 1, do_dm_dump_driver_compat, "", ""),
 	U_BOOT_CMD_MKENT(static, 1, 1, do_dm_dump_static_driver_info, "", ""),
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+	U_BOOT_CMD_MKENT(stats, 1, 1, do_dm_dump_stats, "", ""),
+#endif
 };
 
 static __maybe_unused void dm_reloc(void)
@@ -115,4 +128,7 @@ U_BOOT_CMD(
 	"dm drivers       Dump list of drivers with uclass and instances\n"
 	"dm compat        Dump list of drivers with compatibility strings\n"
 	"dm static        Dump list of drivers with static platform data"
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+	"\ndm stats         Show bind times and compatible-string index size"
+#endif
 );
@@ -11,8 +11,10 @@
 #include <console.h>
 #include <g_dnl.h>
 #include <fastboot.h>
+#include <mapmem.h>
 #include <net.h>
 #include <usb.h>
+#include <uthread.h>
 #include <watchdog.h>
 #include <linux/stringify.h>
 
@@ -77,6 +79,7 @@ static int do_fastboot_usb(int argc, char *const argv[],
 		if (ctrlc())
 			break;
 		WATCHDOG_RESET();
+		uthread_schedule();
 		usb_gadget_handle_interrupts(controller_index);
 	}
 
@@ -135,7 +138,8 @@ NXTARG:
 		return CMD_RET_USAGE;
 	}
 
-	fastboot_init((void *)buf_addr, buf_size);
+	fastboot_init(buf_addr ? map_sysmem(buf_addr, buf_size) : NULL,
+		      buf_size);
 
 	if (!strcmp(argv[1], "udp"))
 		return do_fastboot_udp(argc, argv, buf_addr, buf_size);
@@ -18,6 +18,7 @@
 #include <console.h>
 #include <flash.h>
 #include <hash.h>
+#include <lmb.h>
 #include <log.h>
 #include <mapmem.h>
 #include <rand.h>
@@ -27,6 +28,8 @@
 #include <linux/compiler.h>
 #include <linux/ctype.h>
 #include <linux/delay.h>
+#include <linux/math64.h>
+#include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -124,6 +127,75 @@ static int do_mem_nm(struct cmd_tbl *cmdtp, int flag, int argc,
 	return mod_mem (cmdtp, 0, flag, argc, argv);
 }
 
+/* Smallest mw request handed to mem_fill() */
+#define MW_BULK_MIN	256
+
+/**
+ * mem_is_dram() - Check if a region lies inside a single DRAM bank
+ *
+ * Bulk routines may use wider accesses than requested, which is only safe
+ * on normal memory, not on device registers.
+ *
+ * @addr: Start address
+ * @len: Length of region in bytes
+ * @return true if the region is inside a DRAM bank
+ */
+static bool mem_is_dram(ulong addr, ulong len)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_NR_DRAM_BANKS; i++) {
+		ulong start = gd->bd->bi_dram[i].start;
+		ulong size = gd->bd->bi_dram[i].size;
+
+		if (size && addr >= start && addr - start + len <= size)
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * mem_fill() - Fill memory with a value using the bulk memory routines
+ *
+ * Values made of a single repeated byte go straight to memset(). Others
+ * are written once and then replicated with memcpy(), doubling up to a
+ * block of 4KiB which is then copied repeatedly.
+ *
+ * @buf: Buffer to fill
+ * @val: Value to write
+ * @size: Size of each value in bytes (1, 2, 4 or 8)
+ * @count: Number of values to write
+ */
+static void mem_fill(void *buf, ulong val, int size, ulong count)
+{
+	ulong bytes = size * count;
+	ulong done, len;
+	ulong rep;
+
+	if (size < sizeof(ulong))
+		val &= (1UL << (size * 8)) - 1;
+	rep = ((ulong)-1 / 0xff * (val & 0xff));
+	if (size < sizeof(ulong))
+		rep &= (1UL << (size * 8)) - 1;
+	if (val == rep) {
+		memset(buf, val & 0xff, bytes);
+		return;
+	}
+
+	if (size == 4)
+		*((u32 *)buf) = (u32)val;
+	else if (SUPPORT_64BIT_DATA && size == 8)
+		*((ulong *)buf) = val;
+	else
+		*((u16 *)buf) = (u16)val;
+	for (done = size; done < bytes; done += len) {
+		len = min(done, (ulong)SZ_4K);
+		len = min(len, bytes - done);
+		memcpy(buf + done, buf, len);
+	}
+}
+
 static int do_mem_mw(struct cmd_tbl *cmdtp, int flag, int argc,
 		     char *const argv[])
 {
@@ -163,6 +235,10 @@ static int do_mem_mw(struct cmd_tbl *cmdtp, int flag, int argc,
 	bytes = size * count;
 	start = map_sysmem(addr, bytes);
 	buf = start;
+	if (bytes >= MW_BULK_MIN && mem_is_dram(addr, bytes)) {
+		mem_fill(buf, writeval, size, count);
+		count = 0;
+	}
 	while (count-- > 0) {
 		if (size == 4)
 			*((u32 *)buf) = (u32)writeval;
@@ -1056,6 +1132,264 @@ static ulong mem_test_quick(vu_long *buf, ulong start_addr, ulong end_addr,
 	return errs;
 }
 
+#ifdef CONFIG_SYS_MEMTEST_BANKS
+/* Amount written to one region before moving on to the next */
+#define MTEST_CHUNK		SZ_1M
+#define MTEST_MAX_REGIONS	16
+
+/**
+ * struct mtest_region - a free region of DRAM to test
+ *
+ * @start: Start address
+ * @size: Size in bytes
+ * @buf: Pointer to the start of the region
+ */
+struct mtest_region {
+	ulong start;
+	ulong size;
+	ulong *buf;
+};
+
+/* Kinds of pass made by mem_test_banks() */
+enum mtest_pass {
+	MTEST_BYTE,		/* memset() with a byte pattern */
+	MTEST_ADDR,		/* each word holds its own address */
+	MTEST_NOT_ADDR,		/* each word holds its inverted address */
+};
+
+/**
+ * mtest_add_region() - Add a region to the list, if there is space
+ *
+ * @rgn: Region list
+ * @count: Number of regions in list, updated on exit
+ * @start: Start address
+ * @end: End address (exclusive)
+ */
+static void mtest_add_region(struct mtest_region *rgn, int *count,
+			     ulong start, ulong end)
+{
+	start = ALIGN(start, sizeof(ulong));
+	end &= ~(sizeof(ulong) - 1);
+	if (end <= start)
+		return;
+	if (*count == MTEST_MAX_REGIONS) {
+		printf("Skipping %08lx ... %08lx: too many regions\n", start,
+		       end);
+		return;
+	}
+	rgn[*count].start = start;
+	rgn[*count].size = end - start;
+	rgn[*count].buf = map_sysmem(start, end - start);
+	(*count)++;
+}
+
+/**
+ * mtest_get_regions() - Find the parts of each DRAM bank not used by U-Boot
+ *
+ * This uses LMB so that U-Boot's code, heap, stack and any reserved
+ * regions from the device tree are left alone.
+ *
+ * @rgn: Returns the list of regions
+ * @return number of regions found
+ */
+static int mtest_get_regions(struct mtest_region *rgn)
+{
+	struct lmb lmb;
+	int count = 0;
+	int i, j;
+
+	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+	for (i = 0; i < CONFIG_NR_DRAM_BANKS; i++) {
+		ulong start = gd->bd->bi_dram[i].start;
+		ulong end = start + gd->bd->bi_dram[i].size;
+
+		if (start == end)
+			continue;
+		for (j = 0; j < lmb.reserved.cnt; j++) {
+			ulong rsv = lmb.reserved.region[j].base;
+			ulong rsv_end = rsv + lmb.reserved.region[j].size;
+
+			if (rsv >= end || rsv_end <= start)
+				continue;
+			mtest_add_region(rgn, &count, start, rsv);
+			start = max(start, rsv_end);
+		}
+		mtest_add_region(rgn, &count, start, end);
+	}
+
+	return count;
+}
+
+/**
+ * mtest_fill() - Write one chunk for a pass
+ *
+ * @rgn: Region being written
+ * @offset: Offset of chunk within region in bytes
+ * @len: Length of chunk in bytes
+ * @pass: Kind of pass
+ * @pattern: Byte pattern, for MTEST_BYTE
+ */
+static void mtest_fill(struct mtest_region *rgn, ulong offset, ulong len,
+		       enum mtest_pass pass, u8 pattern)
+{
+	ulong *ptr = rgn->buf + offset / sizeof(ulong);
+	ulong *end = ptr + len / sizeof(ulong);
+	ulong addr = rgn->start + offset;
+	ulong inv = pass == MTEST_NOT_ADDR ? ~0UL : 0;
+
+	if (pass == MTEST_BYTE) {
+		memset(ptr, pattern, len);
+		return;
+	}
+	for (; ptr < end; ptr++, addr += sizeof(ulong))
+		*ptr = addr ^ inv;
+}
+
+/**
+ * mtest_check() - Check one chunk for a pass
+ *
+ * @rgn: Region being checked
+ * @offset: Offset of chunk within region in bytes
+ * @len: Length of chunk in bytes
+ * @pass: Kind of pass
+ * @pattern: Byte pattern, for MTEST_BYTE
+ * @return number of errors found
+ */
+static ulong mtest_check(struct mtest_region *rgn, ulong offset, ulong len,
+			 enum mtest_pass pass, u8 pattern)
+{
+	ulong *ptr = rgn->buf + offset / sizeof(ulong);
+	ulong *end = ptr + len / sizeof(ulong);
+	ulong addr = rgn->start + offset;
+	ulong inv = pass == MTEST_NOT_ADDR ? ~0UL : 0;
+	ulong expect = (ulong)-1 / 0xff * pattern;
+	ulong errs = 0;
+
+	for (; ptr < end; ptr++, addr += sizeof(ulong)) {
+		if (pass != MTEST_BYTE)
+			expect = addr ^ inv;
+		if (*ptr != expect) {
+			if (errs++ < 8)
+				printf("\nMem error @ 0x%08lX: found %08lX, expected %08lX\n",
+				       addr, *ptr, expect);
+		}
+	}
+
+	return errs;
+}
+
+/**
+ * mtest_run_pass() - Write and then check all regions
+ *
+ * Regions are visited a chunk at a time in turn, so that all DRAM banks
+ * are kept busy rather than one bank being tested after another.
+ *
+ * @rgn: Regions to test
+ * @count: Number of regions
+ * @pass: Kind of pass
+ * @pattern: Byte pattern, for MTEST_BYTE
+ * @bytesp: Incremented by the number of bytes written and read
+ * @return number of errors, or -1 if interrupted
+ */
+static ulong mtest_run_pass(struct mtest_region *rgn, int count,
+			    enum mtest_pass pass, u8 pattern, u64 *bytesp)
+{
+	ulong offset, errs = 0;
+	bool check, more;
+	int i;
+
+	for (check = false; ; check = true) {
+		for (offset = 0, more = true; more; offset += MTEST_CHUNK) {
+			more = false;
+			for (i = 0; i < count; i++) {
+				ulong len;
+
+				if (offset >= rgn[i].size)
+					continue;
+				len = min((ulong)MTEST_CHUNK,
+					  rgn[i].size - offset);
+				WATCHDOG_RESET();
+				if (check)
+					errs += mtest_check(&rgn[i], offset,
+							    len, pass, pattern);
+				else
+					mtest_fill(&rgn[i], offset, len, pass,
+						   pattern);
+				*bytesp += len;
+				more = true;
+			}
+			if (ctrlc())
+				return -1;
+		}
+		if (check)
+			break;
+	}
+
+	return errs;
+}
+
+/*
+ * Test all free DRAM in every bank, using the bulk memory routines for the
+ * byte patterns. The throughput is shown so that slow or misconfigured
+ * memory stands out.
+ */
+static int do_mem_mtest_banks(int argc, char *const argv[])
+{
+	static const u8 patterns[] = { 0x00, 0xff, 0x55, 0xaa };
+	struct mtest_region rgn[MTEST_MAX_REGIONS];
+	ulong iteration_limit = 1;
+	ulong start, errs = 0;
+	ulong count = 0;
+	int iteration;
+	int nrgn, i;
+	u64 bytes;
+
+	if (argc > 1 && strict_strtoul(argv[1], 16, &iteration_limit) < 0)
+		return CMD_RET_USAGE;
+
+	nrgn = mtest_get_regions(rgn);
+	for (i = 0; i < nrgn; i++)
+		printf("Testing %08lx ... %08lx\n", rgn[i].start,
+		       rgn[i].start + rgn[i].size - 1);
+
+	for (iteration = 0;
+	     !iteration_limit || iteration < iteration_limit;
+	     iteration++) {
+		ulong ms;
+		int p;
+
+		printf("Iteration: %6d ", iteration + 1);
+		bytes = 0;
+		start = get_timer(0);
+		for (p = 0; p < ARRAY_SIZE(patterns) + 2; p++) {
+			if (p < ARRAY_SIZE(patterns))
+				errs = mtest_run_pass(rgn, nrgn, MTEST_BYTE,
+						      patterns[p], &bytes);
+			else
+				errs = mtest_run_pass(rgn, nrgn,
+					p == ARRAY_SIZE(patterns) ?
+					MTEST_ADDR : MTEST_NOT_ADDR, 0,
+					&bytes);
+			if (errs == -1UL)
+				break;
+			count += errs;
+		}
+		if (errs == -1UL)
+			break;
+		ms = max(get_timer(start), 1UL);
+		print_size(div_u64(bytes * 1000, ms), "/s\n");
+	}
+
+	for (i = 0; i < nrgn; i++)
+		unmap_sysmem(rgn[i].buf);
+	if (errs == -1UL)
+		putc('\n');
+	printf("Tested %d iteration(s) with %lu errors.\n", iteration, count);
+
+	return errs != 0 || count != 0;
+}
+#endif /* CONFIG_SYS_MEMTEST_BANKS */
+
 /*
  * Perform a memory test. A more complete alternative test can be
  * configured using CONFIG_SYS_ALT_MEMTEST. The complete test loops until
@@ -1073,6 +1407,10 @@ static int do_mem_mtest(struct cmd_tbl *cmdtp, int flag, int argc,
 	ulong pattern = 0;
 	int iteration;
 
+#ifdef CONFIG_SYS_MEMTEST_BANKS
+	if (argc > 1 && !strcmp(argv[1], "-b"))
+		return do_mem_mtest_banks(argc - 1, argv + 1);
+#endif
 	start = CONFIG_SYS_MEMTEST_START;
 	end = CONFIG_SYS_MEMTEST_END;
 
@@ -1420,6 +1758,9 @@ U_BOOT_CMD(
 	mtest,	5,	1,	do_mem_mtest,
 	"simple RAM read/write test",
 	"[start [end [pattern [iterations]]]]"
+#ifdef CONFIG_SYS_MEMTEST_BANKS
+	"\nmtest -b [iterations] - test all free DRAM, showing throughput"
+#endif
 );
 #endif	/* CONFIG_CMD_MEMTEST */
 
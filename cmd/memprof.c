@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Command-line access to the heap and LMB usage profiler
+ */
+
+#include <common.h>
+#include <command.h>
+#include <memprof.h>
+
+static int do_memprof_info(struct cmd_tbl *cmdtp, int flag, int argc,
+			   char *const argv[])
+{
+	memprof_show_info();
+
+	return 0;
+}
+
+static int do_memprof_sites(struct cmd_tbl *cmdtp, int flag, int argc,
+			    char *const argv[])
+{
+	memprof_show_sites();
+
+	return 0;
+}
+
+static int do_memprof_lmb(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	memprof_show_lmb();
+
+	return 0;
+}
+
+static int do_memprof_reset(struct cmd_tbl *cmdtp, int flag, int argc,
+			    char *const argv[])
+{
+	memprof_reset();
+
+	return 0;
+}
+
+static char memprof_help_text[] =
+	"\n"
+	"memprof info   - show heap use overall and per subsystem\n"
+	"memprof sites  - show the busiest malloc() call sites\n"
+	"memprof lmb    - show the LMB reservation timeline\n"
+	"memprof reset  - clear the recorded profile";
+
+U_BOOT_CMD_WITH_SUBCMDS(memprof, "Heap and LMB usage profile",
+	memprof_help_text,
+	U_BOOT_SUBCMD_MKENT(info, 1, 1, do_memprof_info),
+	U_BOOT_SUBCMD_MKENT(sites, 1, 1, do_memprof_sites),
+	U_BOOT_SUBCMD_MKENT(lmb, 1, 1, do_memprof_lmb),
+	U_BOOT_SUBCMD_MKENT(reset, 1, 1, do_memprof_reset));
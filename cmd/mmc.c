@@ -1529,7 +1529,6 @@ static int create_mmc_fdisk(int argc, char *const argv[])
 
 	printf("fdisk is completed\n");
 
-	argv[1][1] = 'p';
 	print_mmc_part_info(argc, argv);
 	return 0;
 }
@@ -8,11 +8,17 @@
  * Boot support
  */
 #include <common.h>
+#include <blk.h>
 #include <bootstage.h>
 #include <command.h>
 #include <env.h>
+#include <errno.h>
 #include <image.h>
+#include <lmb.h>
+#include <memprof.h>
 #include <net.h>
+#include <part.h>
+#include <net/tftp.h>
 #include <net/udp.h>
 #include <net/sntp.h>
 
@@ -81,6 +87,46 @@ U_BOOT_CMD(
 );
 #endif
 
+#ifdef CONFIG_CMD_TFTPSERVE
+static int do_tftpserve(struct cmd_tbl *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	struct disk_partition info;
+	struct blk_desc *desc;
+	int part, count = 0;
+	int ret;
+
+	if (argc < 3)
+		return CMD_RET_USAGE;
+	part = blk_get_device_part_str(argv[1], argv[2], &desc, &info, 1);
+	if (part < 0)
+		return CMD_RET_FAILURE;
+	if (argc > 3)
+		count = simple_strtoul(argv[3], NULL, 10);
+
+	tftp_serve_setup(desc, part, &info, count);
+	ret = net_loop(TFTPSERVE);
+	/* Without a count, Ctrl-C is the normal way to stop serving */
+	if (ret == -EINTR && !count && tftp_serve_get_done())
+		return CMD_RET_SUCCESS;
+	if (ret < 0)
+		return CMD_RET_FAILURE;
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	tftpserve,	4,	1,	do_tftpserve,
+	"serve a block device or partition to TFTP clients",
+	"<interface> <dev[:part]> [count]\n"
+	"Answer TFTP read requests from the given device or partition. A\n"
+	"client asks for '<start>+<count>' to read blocks, in hex, from the\n"
+	"start of the partition (leave out <count> to read to its end), or\n"
+	"for the name of a file in its filesystem. Stop after 'count'\n"
+	"transfers have completed, or when Ctrl-C is pressed."
+);
+#endif
+
 
 #ifdef CONFIG_CMD_RARP
 int do_rarpb(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
@@ -193,11 +239,13 @@ static void netboot_update_env(void)
 static int netboot_common(enum proto_t proto, struct cmd_tbl *cmdtp, int argc,
 			  char *const argv[])
 {
+	const char *prev;
 	char *s;
 	char *end;
 	int   rcode = 0;
 	int   size;
 	ulong addr;
+	bool auto_addr = false;
 
 	net_boot_file_name_explicit = false;
 
@@ -220,7 +268,11 @@ static int netboot_common(enum proto_t proto, struct cmd_tbl *cmdtp, int argc,
 		 * mis-interpreted as a valid number.
 		 */
 		addr = simple_strtoul(argv[1], &end, 16);
-		if (end == (argv[1] + strlen(argv[1]))) {
+		if (lmb_auto_requested(argv[1])) {
+			auto_addr = true;
+			copy_filename(net_boot_file_name, env_get("bootfile"),
+				      sizeof(net_boot_file_name));
+		} else if (end == (argv[1] + strlen(argv[1]))) {
 			image_load_addr = addr;
 			/* refresh bootfile name from env */
 			copy_filename(net_boot_file_name, env_get("bootfile"),
@@ -233,7 +285,10 @@ static int netboot_common(enum proto_t proto, struct cmd_tbl *cmdtp, int argc,
 		break;
 
 	case 3:
-		image_load_addr = simple_strtoul(argv[1], NULL, 16);
+		if (lmb_auto_requested(argv[1]))
+			auto_addr = true;
+		else
+			image_load_addr = simple_strtoul(argv[1], NULL, 16);
 		net_boot_file_name_explicit = true;
 		copy_filename(net_boot_file_name, argv[2],
 			      sizeof(net_boot_file_name));
@@ -258,7 +313,15 @@ static int netboot_common(enum proto_t proto, struct cmd_tbl *cmdtp, int argc,
 	}
 	bootstage_mark(BOOTSTAGE_ID_NET_START);
 
+	/* The image size is not known in advance, so use the default */
+	if (auto_addr && lmb_auto_alloc(argv[1], 0, &image_load_addr))
+		return CMD_RET_FAILURE;
+
+	prev = memprof_push("net");
 	size = net_loop(proto);
+	memprof_pop(prev);
+	if (auto_addr)
+		lmb_auto_done(image_load_addr, size > 0 ? size : 0);
 	if (size < 0) {
 		bootstage_error(BOOTSTAGE_ID_NET_NETLOOP_OK);
 		return CMD_RET_FAILURE;
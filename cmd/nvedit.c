@@ -1071,7 +1071,9 @@ sep_err:
  *		to import text files created with editors which are using CRLF
  *		for line endings. Only effective in addition to -t.
  *	-b:	assume binary format ('\0' separated, "\0\0" terminated)
- *	-c:	assume checksum protected environment format
+ *	-c:	assume checksum protected environment format; with
+ *		CONFIG_ENV_BINARY this may also be a binary environment, in
+ *		which case any var list is ignored
  *	addr:	memory address to read from
  *	size:	length of input data; if missing, proper '\0'
  *		termination is mandatory
@@ -1186,7 +1188,14 @@ static int do_env_import(struct cmd_tbl *cmdtp, int flag,
 		ptr = (char *)ep->data;
 	}
 
-	if (!himport_r(&env_htab, ptr, size, sep, del ? 0 : H_NOCLEAR,
+	if (IS_ENABLED(CONFIG_ENV_BINARY) && chk && !wl &&
+	    env_is_binary(ptr)) {
+		if (!himport_bin_r(&env_htab, ptr, size, del ? 0 : H_NOCLEAR)) {
+			pr_err("## Error: Environment import failed: errno = %d\n",
+			       errno);
+			return 1;
+		}
+	} else if (!himport_r(&env_htab, ptr, size, sep, del ? 0 : H_NOCLEAR,
 		       crlf_is_lf, wl ? argc - 2 : 0, wl ? &argv[2] : NULL)) {
 		pr_err("## Error: Environment import failed: errno = %d\n",
 		       errno);
@@ -18,6 +18,7 @@
 #include <dm.h>
 #include <dm/uclass-internal.h>
 #include <memalign.h>
+#include <memprof.h>
 #include <asm/byteorder.h>
 #include <asm/unaligned.h>
 #include <part.h>
@@ -576,9 +577,15 @@ static int do_usb_stop_keyboard(int force)
 
 static void do_usb_start(void)
 {
+	const char *prev;
+	int ret;
+
 	bootstage_mark_name(BOOTSTAGE_ID_USB_START, "usb_start");
 
-	if (usb_init() < 0)
+	prev = memprof_push("usb");
+	ret = usb_init();
+	memprof_pop(prev);
+	if (ret < 0)
 		return;
 
 	/* Driver model will probe the devices as they are found */
@@ -33,6 +33,7 @@ static const char *const tag_name[] = {
 	[BLOBLISTT_SPL_HANDOFF]		= "SPL hand-off",
 	[BLOBLISTT_VBOOT_CTX]		= "Chrome OS vboot context",
 	[BLOBLISTT_VBOOT_HANDOFF]	= "Chrome OS vboot hand-off",
+	[BLOBLISTT_U_BOOT_MEMPROF]	= "U-Boot heap/LMB profile",
 };
 
 const char *bloblist_tag_name(enum bloblist_tag_t tag)
@@ -572,6 +572,18 @@ static int reserve_stacks(void)
 	return arch_reserve_stacks();
 }
 
+static int reserve_malloc_arena(void)
+{
+#if CONFIG_IS_ENABLED(MALLOC_ARENA)
+	gd->start_addr_sp = reserve_stack_aligned(CONFIG_MALLOC_ARENA_LEN);
+	gd->arena_base = gd->start_addr_sp;
+	debug("Reserving %dk for arena at: %08lx\n",
+	      CONFIG_MALLOC_ARENA_LEN >> 10, gd->arena_base);
+#endif
+
+	return 0;
+}
+
 static int reserve_bloblist(void)
 {
 #ifdef CONFIG_BLOBLIST
@@ -921,6 +933,7 @@ static const init_fnc_t init_sequence_f[] = {
 	reserve_trace,
 	reserve_uboot,
 	reserve_malloc,
+	reserve_malloc_arena,
 	reserve_board,
 	setup_machine,
 	reserve_global_data,
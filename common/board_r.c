@@ -41,7 +41,9 @@
 #endif
 #include <irq_func.h>
 #include <malloc.h>
+#include <malloc_arena.h>
 #include <mapmem.h>
+#include <memprof.h>
 #ifdef CONFIG_BITBANGMII
 #include <miiphy.h>
 #endif
@@ -282,6 +284,14 @@ static int initr_malloc(void)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(MALLOC_ARENA)
+static int initr_malloc_arena(void)
+{
+	return arena_init(map_sysmem(gd->arena_base, CONFIG_MALLOC_ARENA_LEN),
+			  CONFIG_MALLOC_ARENA_LEN);
+}
+#endif
+
 static int initr_console_record(void)
 {
 #if defined(CONFIG_CONSOLE_RECORD)
@@ -318,6 +328,7 @@ static int initr_of_live(void)
 #ifdef CONFIG_DM
 static int initr_dm(void)
 {
+	const char *prev;
 	int ret;
 
 	/* Save the pre-reloc driver model and start a new one */
@@ -327,7 +338,9 @@ static int initr_dm(void)
 	gd->timer = NULL;
 #endif
 	bootstage_start(BOOTSTAGE_ID_ACCUM_DM_R, "dm_r");
+	prev = memprof_push("dm");
 	ret = dm_init_and_scan(false);
+	memprof_pop(prev);
 	bootstage_accum(BOOTSTAGE_ID_ACCUM_DM_R);
 	if (ret)
 		return ret;
@@ -711,6 +724,9 @@ static init_fnc_t init_sequence_r[] = {
 #endif
 	initr_barrier,
 	initr_malloc,
+#if CONFIG_IS_ENABLED(MALLOC_ARENA)
+	initr_malloc_arena,
+#endif
 	log_init,
 	initr_bootstage,	/* Needs malloc() but has its own timer */
 	initr_console_record,
@@ -442,12 +442,15 @@ ulong bootm_disable_interrupts(void)
 	 * recover from any failures any more...
 	 */
 	iflag = disable_interrupts();
-#ifdef CONFIG_NETCONSOLE
-	/* Stop the ethernet stack if NetConsole could have left it up */
+#if defined(CONFIG_NETCONSOLE) || defined(CONFIG_NET_WARM_LINK)
+	/*
+	 * Stop the ethernet stack if NetConsole or a warm link could have
+	 * left it up
+	 */
 	eth_halt();
-# ifndef CONFIG_DM_ETH
+#endif
+#if defined(CONFIG_NETCONSOLE) && !defined(CONFIG_DM_ETH)
 	eth_unregister(eth_get_dev());
-# endif
 #endif
 
 #if defined(CONFIG_CMD_USB)
@@ -376,8 +376,16 @@ static inline void debug_printf(const char *format, ...) { }
 #define final_printf debug_printf
 
 #ifdef __U_BOOT__
+#ifdef CONFIG_HUSH_PARSE_CACHE
+static int syntax_quiet;	/* parsing ahead for the cache */
+static int hush_cache_depth;	/* number of cached strings being run */
+#else
+#define syntax_quiet 0
+#endif
+
 static void syntax_err(void) {
-	 printf("syntax error\n");
+	if (!syntax_quiet)
+		printf("syntax error\n");
 }
 #else
 static void __syntax(char *file, int line) {
@@ -1532,6 +1540,29 @@ shell_terminal_error:
  * now has its stdout directed to the input of the appropriate pipe,
  * so this routine is noticeably simpler.
  */
+#if defined(__U_BOOT__) && defined(CONFIG_HUSH_PARSE_CACHE)
+/* Copy an argument list and its strings into a single allocation */
+static char **dup_argv(int argc, char **argv)
+{
+	size_t size = (argc + 1) * sizeof(char *);
+	char **copy, *p;
+	int i;
+
+	for (i = 0; i < argc; i++)
+		size += strlen(argv[i]) + 1;
+	copy = xmalloc(size);
+	p = (char *)(copy + argc + 1);
+	for (i = 0; i < argc; i++) {
+		copy[i] = p;
+		strcpy(p, argv[i]);
+		p += strlen(p) + 1;
+	}
+	copy[argc] = NULL;
+
+	return copy;
+}
+#endif
+
 static int run_pipe_real(struct pipe *pi)
 {
 	int i;
@@ -1541,6 +1572,7 @@ static int run_pipe_real(struct pipe *pi)
 	struct child_prog *child;
 	struct built_in_command *x;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1553,6 +1585,7 @@ static int run_pipe_real(struct pipe *pi)
 	int flag = do_repeat ? CMD_FLAG_REPEAT : 0;
 	struct child_prog *child;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1619,6 +1652,8 @@ static int run_pipe_real(struct pipe *pi)
 			}
 			return EXIT_SUCCESS;   /* don't worry about errors in set_local_var() yet */
 		}
+		/* count locally, since a cached parse tree may be run again */
+		sp = child->sp;
 		for (i = 0; is_assignment(child->argv[i]); i++) {
 			p = insert_var_value(child->argv[i]);
 #ifndef __U_BOOT__
@@ -1627,11 +1662,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string(child->argv + i,
@@ -1674,6 +1709,18 @@ static int run_pipe_real(struct pipe *pi)
 					"'run' command\n", child->argv[i]);
 			return -1;
 		}
+#ifdef CONFIG_HUSH_PARSE_CACHE
+		/* Commands may write to argv, which must not change the cache */
+		if (hush_cache_depth) {
+			char **argv = dup_argv(child->argc, child->argv);
+			int rcode;
+
+			rcode = cmd_process(flag, child->argc, argv,
+					    &flag_repeat, NULL);
+			free(argv);
+			return rcode;
+		}
+#endif
 		/* Process the command */
 		return cmd_process(flag, child->argc, child->argv,
 				   &flag_repeat, NULL);
@@ -1764,7 +1811,7 @@ static int run_list_real(struct pipe *pi)
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
-	struct pipe *rpipe;
+	struct pipe *rpipe, *for_pipe = NULL;
 	int flag_rep = 0;
 #ifndef __U_BOOT__
 	int save_num_progs;
@@ -1803,7 +1850,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
-					return 1;
+					rcode = 1;
+					break;
 				}
 #endif
 				flag_restore = 0;
@@ -1833,6 +1881,7 @@ static int run_list_real(struct pipe *pi)
 					pi->progs->argv[0]);
 				save_list = list;
 				save_name = pi->progs->argv[0];
+				for_pipe = pi;
 				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
 			}
@@ -1902,7 +1951,8 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
-			return -2;	/* exit */
+			rcode = -2;	/* exit */
+			break;
 		}
 		last_return_code=(rcode == 0) ? 0 : 1;
 #endif
@@ -1920,6 +1970,18 @@ static int run_list_real(struct pipe *pi)
 			skip_more_in_this_rmode=rmode;
 #ifndef __U_BOOT__
 		checkjobs(NULL);
+#endif
+	}
+	if (list) {
+		/* left in the middle of a "for": put the loop variable back */
+		while (*list)
+			free(*list++);
+		free(for_pipe->progs->argv[0]);
+		free(save_list);
+		for_pipe->progs->argv[0] = save_name;
+#ifndef __U_BOOT__
+		for_pipe->progs->glob_result.gl_pathv[0] =
+			for_pipe->progs->argv[0];
 #endif
 	}
 	return rcode;
@@ -3244,6 +3306,180 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #endif /* __U_BOOT__ */
 }
 
+#ifdef CONFIG_HUSH_PARSE_CACHE
+/*
+ * Scripts in the environment (bootcmd, 'run', boot.scr) are usually run
+ * many times with the same text. Keep the parse trees of recently run
+ * strings, keyed by their text and parser flags, so that each is parsed
+ * only once. Variables are expanded when a command runs rather than when
+ * it is parsed, so a tree stays valid for as long as its text does; after
+ * a setenv the new text is simply a different key.
+ */
+struct hush_cache_entry {
+	char *text;		/* string that was parsed, NULL if unused */
+	int flag;		/* FLAG_... it was parsed with */
+	uint hash;		/* hush_cache_hash() of text */
+	struct pipe **lists;	/* one list per line, run in turn */
+	int count;		/* number of lists */
+	int busy;		/* being run, so must not be replaced */
+	ulong last_used;	/* for picking the entry to replace */
+};
+
+static struct hush_cache_entry hush_cache[CONFIG_HUSH_PARSE_CACHE_ENTRIES];
+static ulong hush_cache_clock;
+
+static uint hush_cache_hash(const char *s)
+{
+	uint hash = 0;
+
+	while (*s)
+		hash = hash * 31 + (uchar)*s++;
+
+	return hash;
+}
+
+static void hush_cache_free(struct hush_cache_entry *ent)
+{
+	int i;
+
+	for (i = 0; i < ent->count; i++)
+		free_pipe_list(ent->lists[i], 0);
+	free(ent->lists);
+	free(ent->text);
+	ent->lists = NULL;
+	ent->count = 0;
+	ent->text = NULL;
+}
+
+void hush_cache_flush(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(hush_cache); i++) {
+		if (hush_cache[i].text && !hush_cache[i].busy)
+			hush_cache_free(&hush_cache[i]);
+	}
+}
+
+/*
+ * Parse the whole of a string the way parse_stream_outer() does, one line
+ * at a time, but without running anything. Returns 0 if OK, 1 on a syntax
+ * error.
+ */
+static int hush_cache_parse(struct hush_cache_entry *ent, const char *s,
+			    int flag)
+{
+	struct in_str input;
+	struct p_context ctx;
+	o_string temp = NULL_O_STRING;
+	int rcode;
+
+	setup_string_in_str(&input, s);
+	syntax_quiet = 1;
+	do {
+		ctx.type = flag;
+		initialize_context(&ctx);
+		update_ifs_map();
+		if (!(flag & FLAG_PARSE_SEMICOLON) || (flag & FLAG_REPARSING))
+			mapset((uchar *)";$&|", 0);
+		input.promptmode = 1;
+		rcode = parse_stream(&temp, &ctx, &input,
+				     flag & FLAG_CONT_ON_NEWLINE ? -1 : '\n');
+		if (rcode == 1 || ctx.old_flag != 0) {
+			if (ctx.old_flag != 0)
+				free(ctx.stack);
+			free_pipe_list(ctx.list_head, 0);
+			b_free(&temp);
+			rcode = 1;
+			break;
+		}
+		done_word(&temp, &ctx);
+		done_pipe(&ctx, PIPE_SEQ);
+		b_free(&temp);
+		ent->lists = xrealloc(ent->lists,
+				      sizeof(*ent->lists) * (ent->count + 1));
+		ent->lists[ent->count++] = ctx.list_head;
+	} while (rcode != -1 && !(flag & FLAG_EXIT_FROM_LOOP) &&
+		 b_peek(&input));
+	syntax_quiet = 0;
+
+	return rcode == 1;
+}
+
+/* Run the lists of a cached string, as parse_stream_outer() would */
+static int hush_cache_run(struct hush_cache_entry *ent)
+{
+	int code = 1;
+	int i;
+
+	ent->busy = 1;
+	ent->last_used = ++hush_cache_clock;
+	hush_cache_depth++;
+	for (i = 0; i < ent->count; i++) {
+		code = run_list_real(ent->lists[i]);
+		if (code == -2) {	/* exit */
+			code = 0;
+			break;
+		}
+		if (code == -1)
+			flag_repeat = 0;
+	}
+	hush_cache_depth--;
+	ent->busy = 0;
+
+	return (code != 0) ? 1 : 0;
+}
+
+/*
+ * Run a string from the cache, parsing and adding it first if needed.
+ * Returns -1 if the string cannot be cached, in which case the caller
+ * should parse and run it as usual. This happens on a syntax error, so
+ * that the lines before the error still run, and if the same string is
+ * already running further up the call chain.
+ */
+static int hush_cache_run_string(const char *s, int flag)
+{
+	struct hush_cache_entry *ent, *victim = NULL;
+	uint hash = hush_cache_hash(s);
+	char *text, *nl;
+	int i, len;
+
+	for (i = 0; i < ARRAY_SIZE(hush_cache); i++) {
+		ent = &hush_cache[i];
+		if (ent->text && ent->hash == hash && ent->flag == flag &&
+		    !strcmp(ent->text, s))
+			return ent->busy ? -1 : hush_cache_run(ent);
+		if (ent->busy)
+			continue;
+		if (!victim || (victim->text && (!ent->text ||
+		    ent->last_used < victim->last_used)))
+			victim = ent;
+	}
+	if (!victim)
+		return -1;
+	if (victim->text)
+		hush_cache_free(victim);
+
+	/* Parse with a trailing newline, as parse_string_outer() does */
+	len = strlen(s);
+	text = xmalloc(len + 2);
+	strcpy(text, s);
+	nl = strchr(s, '\n');
+	if (!nl || nl[1])
+		strcpy(text + len, "\n");
+	victim->text = text;
+	if (hush_cache_parse(victim, text, flag)) {
+		hush_cache_free(victim);
+		return -1;
+	}
+	text[len] = '\0';
+	victim->hash = hash;
+	victim->flag = flag;
+
+	return hush_cache_run(victim);
+}
+#endif /* CONFIG_HUSH_PARSE_CACHE */
+
 #ifndef __U_BOOT__
 static int parse_string_outer(const char *s, int flag)
 #else
@@ -3258,6 +3494,17 @@ int parse_string_outer(const char *s, int flag)
 		return 1;
 	if (!*s)
 		return 0;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	/*
+	 * A re-parsed string is the result of expanding variables, so it is
+	 * seldom the same twice and would only push useful entries out
+	 */
+	if (!(flag & FLAG_REPARSING)) {
+		rcode = hush_cache_run_string(s, flag);
+		if (rcode != -1)
+			return rcode;
+	}
+#endif
 	if (!(p = strchr(s, '\n')) || *++p) {
 		p = xmalloc(strlen(s) + 2);
 		strcpy(p, s);
@@ -18,6 +18,7 @@
 #include <console.h>
 #include <g_dnl.h>
 #include <usb.h>
+#include <uthread.h>
 #include <net.h>
 
 int run_usb_dnl_gadget(int usbctrl_index, char *usb_dnl_gadget)
@@ -99,6 +100,7 @@ int run_usb_dnl_gadget(int usbctrl_index, char *usb_dnl_gadget)
 #endif
 
 		WATCHDOG_RESET();
+		uthread_schedule();
 		usb_gadget_handle_interrupts(usbctrl_index);
 	}
 exit:
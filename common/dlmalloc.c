@@ -6,8 +6,34 @@
 #endif
 
 #include <malloc.h>
+#include <memprof.h>
 #include <asm/io.h>
 
+#if CONFIG_IS_ENABLED(MEMPROF)
+/*
+ * The public allocator entry points are wrappers (at the end of this file)
+ * which record each request with the profiler. Internal calls, e.g. from
+ * calloc() to malloc(), go straight to the *_impl functions so that each
+ * request is only counted once.
+ */
+#undef mALLOc
+#undef fREe
+#undef rEALLOc
+#undef mEMALIGn
+#undef cALLOc
+#define mALLOc		dlmalloc_impl
+#define fREe		dlfree_impl
+#define rEALLOc		dlrealloc_impl
+#define mEMALIGn	dlmemalign_impl
+#define cALLOc		dlcalloc_impl
+
+static Void_t *mALLOc(size_t bytes);
+static void fREe(Void_t *mem);
+static Void_t *rEALLOc(Void_t *oldmem, size_t bytes);
+static Void_t *mEMALIGn(size_t alignment, size_t bytes);
+static Void_t *cALLOc(size_t n, size_t elem_size);
+#endif
+
 #ifdef DEBUG
 #if __STD_C
 static void malloc_update_mallinfo (void);
@@ -2419,6 +2445,95 @@ int mALLOPt(param_number, value) int param_number; int value;
   }
 }
 
+#if CONFIG_IS_ENABLED(MEMPROF)
+void malloc_get_usage(ulong *size, ulong *used, ulong *peak)
+{
+	INTERNAL_SIZE_T avail;
+	mbinptr b;
+	mchunkptr p;
+	int i;
+
+	*size = mem_malloc_end - mem_malloc_start;
+	*peak = max_sbrked_mem;
+	if (sbrk_base == (char *)(-1)) {
+		*used = 0;
+		return;
+	}
+	avail = chunksize(top);
+	for (i = 1; i < NAV; ++i) {
+		b = bin_at(i);
+		for (p = last(b); p != b; p = p->bk)
+			avail += chunksize(p);
+	}
+	*used = sbrked_mem - avail;
+}
+
+#ifdef USE_DL_PREFIX
+#define MEMPROF_PUBLIC(name)	dl##name
+#else
+#define MEMPROF_PUBLIC(name)	name
+#endif
+
+static bool memprof_active(void)
+{
+	return gd->flags & GD_FLG_FULL_MALLOC_INIT;
+}
+
+Void_t *MEMPROF_PUBLIC(malloc)(size_t bytes)
+{
+	Void_t *mem = mALLOc(bytes);
+
+	if (memprof_active() && mem)
+		memprof_alloc(mem, malloc_usable_size(mem),
+			      __builtin_return_address(0));
+
+	return mem;
+}
+
+void MEMPROF_PUBLIC(free)(Void_t *mem)
+{
+	if (memprof_active() && mem)
+		memprof_free(mem, __builtin_return_address(0));
+	fREe(mem);
+}
+
+Void_t *MEMPROF_PUBLIC(realloc)(Void_t *oldmem, size_t bytes)
+{
+	Void_t *mem = rEALLOc(oldmem, bytes);
+
+	if (memprof_active() && mem) {
+		if (oldmem)
+			memprof_free(oldmem, __builtin_return_address(0));
+		memprof_alloc(mem, malloc_usable_size(mem),
+			      __builtin_return_address(0));
+	}
+
+	return mem;
+}
+
+Void_t *MEMPROF_PUBLIC(memalign)(size_t alignment, size_t bytes)
+{
+	Void_t *mem = mEMALIGn(alignment, bytes);
+
+	if (memprof_active() && mem)
+		memprof_alloc(mem, malloc_usable_size(mem),
+			      __builtin_return_address(0));
+
+	return mem;
+}
+
+Void_t *MEMPROF_PUBLIC(calloc)(size_t n, size_t elem_size)
+{
+	Void_t *mem = cALLOc(n, elem_size);
+
+	if (memprof_active() && mem)
+		memprof_alloc(mem, malloc_usable_size(mem),
+			      __builtin_return_address(0));
+
+	return mem;
+}
+#endif /* MEMPROF */
+
 int initf_malloc(void)
 {
 #if CONFIG_VAL(SYS_MALLOC_F_LEN)
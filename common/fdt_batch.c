@@ -0,0 +1,555 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Batched device-tree edits
+ *
+ * Edits are queued against offsets in the tree as it was when the batch
+ * was opened. On fdt_batch_end() each edit is turned into a splice of the
+ * old structure block: a property record replaced in place, new property
+ * records inserted after a node's name, or new nodes inserted after their
+ * parent's properties. The splices are sorted by offset and the new
+ * structure block is built in one pass. New records go where libfdt would
+ * put them, so the result matches a series of fdt_setprop() and
+ * fdt_add_subnode() calls.
+ */
+
+#define LOG_CATEGORY LOGC_BOOT
+
+#include <common.h>
+#include <fdt_batch.h>
+#include <fdt_support.h>
+#include <log.h>
+#include <malloc.h>
+#include <sort.h>
+#include <linux/libfdt.h>
+
+/* Size of a property record with a value of @len bytes */
+#define FDT_BATCH_PROP_SIZE(len) \
+	(sizeof(struct fdt_property) + ALIGN(len, FDT_TAGSIZE))
+
+/**
+ * struct fdt_batch_prop - a queued property
+ *
+ * @node: Offset of node in the original tree, or a new-node handle
+ * @name: Property name
+ * @val: Property value
+ * @len: Length of @val in bytes
+ * @nameoff: Offset of @name in the strings block (set when applying)
+ * @offset: Offset of the existing property record, or of the place to
+ *	insert a new one (set when applying)
+ * @oldsize: Size of the existing property record, 0 if none (set when
+ *	applying)
+ */
+struct fdt_batch_prop {
+	int node;
+	char *name;
+	void *val;
+	int len;
+	int nameoff;
+	int offset;
+	int oldsize;
+};
+
+/**
+ * struct fdt_batch_node - a queued node
+ *
+ * @parent: Offset of parent in the original tree, or a new-node handle
+ * @name: Node name
+ * @offset: Place to insert the node, if @parent is in the original tree
+ *	(set when applying)
+ */
+struct fdt_batch_node {
+	int parent;
+	char *name;
+	int offset;
+};
+
+/**
+ * struct fdt_batch_op - a splice of the old structure block
+ *
+ * @offset: Offset in the old structure block
+ * @skip: Number of bytes removed from the old block at @offset
+ * @is_node: true to insert @nodes[@idx], false for @props[@idx]
+ * @idx: Index of property or node
+ */
+struct fdt_batch_op {
+	int offset;
+	int skip;
+	bool is_node;
+	int idx;
+};
+
+/**
+ * struct fdt_batch - state of the open batch
+ *
+ * @fdt: Device tree being edited, NULL if no batch is open
+ * @depth: Number of fdt_batch_begin() calls not yet ended
+ * @size_struct: Size of the structure block when the batch was opened
+ * @size_strings: Size of the strings block when the batch was opened
+ * @props: Queued properties, in the order they were first set
+ * @num_props: Number of entries in @props
+ * @max_props: Number of entries allocated in @props
+ * @nodes: Queued nodes, in the order they were added
+ * @num_nodes: Number of entries in @nodes
+ * @max_nodes: Number of entries allocated in @nodes
+ */
+struct fdt_batch {
+	void *fdt;
+	int depth;
+	int size_struct;
+	int size_strings;
+	struct fdt_batch_prop *props;
+	int num_props;
+	int max_props;
+	struct fdt_batch_node *nodes;
+	int num_nodes;
+	int max_nodes;
+};
+
+static struct fdt_batch fdt_batch;
+
+static bool fdt_batch_is_new(int nodeoffset)
+{
+	return nodeoffset >= FDT_BATCH_NODE_BASE;
+}
+
+static struct fdt_batch *fdt_batch_get(void *fdt)
+{
+	return fdt_batch.fdt == fdt ? &fdt_batch : NULL;
+}
+
+static int fdt_batch_check_node(struct fdt_batch *b, int nodeoffset)
+{
+	int next;
+
+	if (fdt_batch_is_new(nodeoffset)) {
+		if (nodeoffset - FDT_BATCH_NODE_BASE >= b->num_nodes)
+			return -FDT_ERR_BADOFFSET;
+		return 0;
+	}
+	if (nodeoffset < 0 || nodeoffset % FDT_TAGSIZE ||
+	    fdt_next_tag(b->fdt, nodeoffset, &next) != FDT_BEGIN_NODE)
+		return -FDT_ERR_BADOFFSET;
+
+	return 0;
+}
+
+static void fdt_batch_free(struct fdt_batch *b)
+{
+	int i;
+
+	for (i = 0; i < b->num_props; i++)
+		free(b->props[i].val);
+	for (i = 0; i < b->num_nodes; i++)
+		free(b->nodes[i].name);
+	free(b->props);
+	free(b->nodes);
+	memset(b, '\0', sizeof(*b));
+}
+
+int fdt_batch_begin(void *fdt)
+{
+	struct fdt_batch *b = &fdt_batch;
+	int ret;
+
+	if (b->fdt) {
+		if (b->fdt != fdt)
+			return -FDT_ERR_BADSTATE;
+		b->depth++;
+		return 0;
+	}
+	ret = fdt_check_header(fdt);
+	if (ret)
+		return ret;
+	b->fdt = fdt;
+	b->depth = 1;
+	b->size_struct = fdt_size_dt_struct(fdt);
+	b->size_strings = fdt_size_dt_strings(fdt);
+
+	return 0;
+}
+
+int fdt_batch_setprop(void *fdt, int nodeoffset, const char *name,
+		      const void *val, int len)
+{
+	struct fdt_batch *b = fdt_batch_get(fdt);
+	struct fdt_batch_prop *prop;
+	void *copy;
+	int ret, i;
+
+	if (!b)
+		return fdt_setprop(fdt, nodeoffset, name, val, len);
+	ret = fdt_batch_check_node(b, nodeoffset);
+	if (ret)
+		return ret;
+	if (len < 0)
+		return -FDT_ERR_BADVALUE;
+
+	/* The name and value share one allocation */
+	copy = malloc(strlen(name) + 1 + len);
+	if (!copy)
+		return -FDT_ERR_NOSPACE;
+	if (len)
+		memcpy(copy, val, len);
+	strcpy(copy + len, name);
+
+	/* Setting a property again replaces the value but keeps its place */
+	for (i = 0; i < b->num_props; i++) {
+		prop = &b->props[i];
+		if (prop->node == nodeoffset && !strcmp(prop->name, name)) {
+			free(prop->val);
+			break;
+		}
+	}
+	if (i == b->num_props) {
+		if (b->num_props == b->max_props) {
+			int max = b->max_props ? b->max_props * 2 : 16;
+
+			prop = realloc(b->props, max * sizeof(*prop));
+			if (!prop) {
+				free(copy);
+				return -FDT_ERR_NOSPACE;
+			}
+			b->props = prop;
+			b->max_props = max;
+		}
+		prop = &b->props[b->num_props++];
+		prop->node = nodeoffset;
+	}
+	prop->name = copy + len;
+	prop->val = copy;
+	prop->len = len;
+
+	return 0;
+}
+
+int fdt_batch_find_or_add_subnode(void *fdt, int parentoffset,
+				  const char *name)
+{
+	struct fdt_batch *b = fdt_batch_get(fdt);
+	struct fdt_batch_node *node;
+	int ret, i;
+
+	if (!b)
+		return fdt_find_or_add_subnode(fdt, parentoffset, name);
+	ret = fdt_batch_check_node(b, parentoffset);
+	if (ret)
+		return ret;
+	if (!fdt_batch_is_new(parentoffset)) {
+		ret = fdt_subnode_offset(fdt, parentoffset, name);
+		if (ret != -FDT_ERR_NOTFOUND)
+			return ret;
+	}
+	for (i = 0; i < b->num_nodes; i++) {
+		node = &b->nodes[i];
+		if (node->parent == parentoffset && !strcmp(node->name, name))
+			return FDT_BATCH_NODE_BASE + i;
+	}
+
+	if (b->num_nodes == b->max_nodes) {
+		int max = b->max_nodes ? b->max_nodes * 2 : 4;
+
+		node = realloc(b->nodes, max * sizeof(*node));
+		if (!node)
+			return -FDT_ERR_NOSPACE;
+		b->nodes = node;
+		b->max_nodes = max;
+	}
+	node = &b->nodes[b->num_nodes];
+	node->name = strdup(name);
+	if (!node->name)
+		return -FDT_ERR_NOSPACE;
+	node->parent = parentoffset;
+
+	return FDT_BATCH_NODE_BASE + b->num_nodes++;
+}
+
+/* Find a string as libfdt does, so that the same offsets are chosen */
+static int fdt_batch_find_string(const char *strtab, int tabsize,
+				 const char *s)
+{
+	int len = strlen(s) + 1;
+	const char *p;
+
+	for (p = strtab; p <= strtab + tabsize - len; p++) {
+		if (!memcmp(p, s, len))
+			return p - strtab;
+	}
+
+	return -1;
+}
+
+/**
+ * fdt_batch_emit_prop() - Write a property record
+ *
+ * @prop: Property to write
+ * @buf: Place to write it, or NULL to just return the size
+ * @return size of the record in bytes
+ */
+static int fdt_batch_emit_prop(struct fdt_batch_prop *prop, void *buf)
+{
+	int size = FDT_BATCH_PROP_SIZE(prop->len);
+	struct fdt_property *rec = buf;
+
+	if (rec) {
+		rec->tag = cpu_to_fdt32(FDT_PROP);
+		rec->len = cpu_to_fdt32(prop->len);
+		rec->nameoff = cpu_to_fdt32(prop->nameoff);
+		if (prop->len)
+			memcpy(rec->data, prop->val, prop->len);
+		memset(rec->data + prop->len, '\0',
+		       size - sizeof(*rec) - prop->len);
+	}
+
+	return size;
+}
+
+/**
+ * fdt_batch_emit_node() - Write a new node with its properties and subnodes
+ *
+ * libfdt inserts each new property ahead of the existing ones and each new
+ * subnode ahead of the existing subnodes, so both are written newest
+ * first.
+ *
+ * @b: Batch state
+ * @idx: Index of node in @b->nodes
+ * @buf: Place to write it, or NULL to just return the size
+ * @return size of the node in bytes
+ */
+static int fdt_batch_emit_node(struct fdt_batch *b, int idx, char *buf)
+{
+	struct fdt_batch_node *node = &b->nodes[idx];
+	int handle = FDT_BATCH_NODE_BASE + idx;
+	int namesize = ALIGN(strlen(node->name) + 1, FDT_TAGSIZE);
+	int size, i;
+
+	if (buf) {
+		*(fdt32_t *)buf = cpu_to_fdt32(FDT_BEGIN_NODE);
+		memset(buf + FDT_TAGSIZE, '\0', namesize);
+		strcpy(buf + FDT_TAGSIZE, node->name);
+	}
+	size = FDT_TAGSIZE + namesize;
+	for (i = b->num_props - 1; i >= 0; i--) {
+		if (b->props[i].node == handle)
+			size += fdt_batch_emit_prop(&b->props[i],
+						    buf ? buf + size : NULL);
+	}
+	for (i = b->num_nodes - 1; i > idx; i--) {
+		if (b->nodes[i].parent == handle)
+			size += fdt_batch_emit_node(b, i,
+						    buf ? buf + size : NULL);
+	}
+	if (buf)
+		*(fdt32_t *)(buf + size) = cpu_to_fdt32(FDT_END_NODE);
+
+	return size + FDT_TAGSIZE;
+}
+
+static int h_cmp_op(const void *v1, const void *v2)
+{
+	const struct fdt_batch_op *op1 = v1, *op2 = v2;
+
+	if (op1->offset != op2->offset)
+		return op1->offset - op2->offset;
+	/*
+	 * Properties go before nodes and insertions before a replacement
+	 * at the same place; newer entries go before older ones
+	 */
+	if (op1->is_node != op2->is_node)
+		return op1->is_node - op2->is_node;
+	if (!op1->skip != !op2->skip)
+		return op1->skip ? 1 : -1;
+
+	return op2->idx - op1->idx;
+}
+
+/* Make sure the blob is in the layout that libfdt can edit */
+static int fdt_batch_open_tree(struct fdt_batch *b)
+{
+	void *fdt = b->fdt;
+	int ret;
+
+	if (fdt_version(fdt) >= 17 &&
+	    fdt_off_dt_struct(fdt) >= fdt_off_mem_rsvmap(fdt) &&
+	    fdt_off_dt_strings(fdt) >= fdt_off_dt_struct(fdt) +
+				       fdt_size_dt_struct(fdt)) {
+		if (fdt_version(fdt) > 17)
+			fdt_set_version(fdt, 17);
+		return 0;
+	}
+	ret = fdt_open_into(fdt, fdt, fdt_totalsize(fdt));
+	if (ret)
+		return ret;
+	if (fdt_size_dt_struct(fdt) != b->size_struct)
+		return -FDT_ERR_BADSTATE;
+
+	return 0;
+}
+
+static int fdt_batch_apply(struct fdt_batch *b)
+{
+	void *fdt = b->fdt;
+	struct fdt_batch_op *ops, *op;
+	const struct fdt_property *old;
+	int num_ops, delta, newstr_len;
+	int size_struct, size_strings;
+	char *strtab, *base, *newstr;
+	char *buf = NULL;
+	int i, ret, pos, src;
+
+	if (!b->num_props && !b->num_nodes)
+		return 0;
+	if (fdt_size_dt_struct(fdt) != b->size_struct ||
+	    fdt_size_dt_strings(fdt) != b->size_strings)
+		return -FDT_ERR_BADSTATE;
+	ret = fdt_batch_open_tree(b);
+	if (ret)
+		return ret;
+	base = fdt + fdt_off_dt_struct(fdt);
+	strtab = fdt + fdt_off_dt_strings(fdt);
+	size_struct = b->size_struct;
+	size_strings = b->size_strings;
+
+	newstr = NULL;
+	ops = malloc((b->num_props + b->num_nodes) * sizeof(*ops));
+	if (!ops) {
+		ret = -FDT_ERR_NOSPACE;
+		goto out;
+	}
+
+	/* Work out where everything goes and which strings are needed */
+	newstr_len = 0;
+	num_ops = 0;
+	for (i = 0; i < b->num_props; i++) {
+		struct fdt_batch_prop *prop = &b->props[i];
+		int len;
+
+		prop->nameoff = fdt_batch_find_string(strtab, size_strings,
+						      prop->name);
+		if (prop->nameoff < 0) {
+			ret = newstr_len ? fdt_batch_find_string(newstr,
+					newstr_len, prop->name) : -1;
+			if (ret < 0) {
+				len = strlen(prop->name) + 1;
+				buf = realloc(newstr, newstr_len + len);
+				if (!buf) {
+					ret = -FDT_ERR_NOSPACE;
+					goto out;
+				}
+				newstr = buf;
+				buf = NULL;
+				memcpy(newstr + newstr_len, prop->name, len);
+				ret = newstr_len;
+				newstr_len += len;
+			}
+			prop->nameoff = size_strings + ret;
+		}
+		if (fdt_batch_is_new(prop->node))
+			continue;
+
+		old = fdt_get_property(fdt, prop->node, prop->name, &len);
+		if (old) {
+			prop->offset = (char *)old - base;
+			prop->oldsize = FDT_BATCH_PROP_SIZE(len);
+		} else {
+			/* New properties go straight after the node name */
+			fdt_next_tag(fdt, prop->node, &prop->offset);
+			prop->oldsize = 0;
+		}
+		op = &ops[num_ops++];
+		op->offset = prop->offset;
+		op->skip = prop->oldsize;
+		op->is_node = false;
+		op->idx = i;
+	}
+	for (i = 0; i < b->num_nodes; i++) {
+		struct fdt_batch_node *node = &b->nodes[i];
+		int next, tag;
+
+		if (fdt_batch_is_new(node->parent))
+			continue;
+
+		/* New subnodes go after the parent's properties */
+		fdt_next_tag(fdt, node->parent, &next);
+		do {
+			node->offset = next;
+			tag = fdt_next_tag(fdt, node->offset, &next);
+		} while (tag == FDT_PROP || tag == FDT_NOP);
+		op = &ops[num_ops++];
+		op->offset = node->offset;
+		op->skip = 0;
+		op->is_node = true;
+		op->idx = i;
+	}
+	qsort(ops, num_ops, sizeof(*ops), h_cmp_op);
+
+	delta = 0;
+	for (op = ops; op < ops + num_ops; op++) {
+		if (op->is_node)
+			delta += fdt_batch_emit_node(b, op->idx, NULL);
+		else
+			delta += fdt_batch_emit_prop(&b->props[op->idx], NULL);
+		delta -= op->skip;
+	}
+	if (fdt_off_dt_strings(fdt) + delta + size_strings + newstr_len >
+	    fdt_totalsize(fdt)) {
+		ret = -FDT_ERR_NOSPACE;
+		goto out;
+	}
+
+	/* Build the new structure block */
+	buf = malloc(size_struct + delta);
+	if (!buf) {
+		ret = -FDT_ERR_NOSPACE;
+		goto out;
+	}
+	pos = 0;
+	src = 0;
+	for (op = ops; op < ops + num_ops; op++) {
+		memcpy(buf + pos, base + src, op->offset - src);
+		pos += op->offset - src;
+		if (op->is_node)
+			pos += fdt_batch_emit_node(b, op->idx, buf + pos);
+		else
+			pos += fdt_batch_emit_prop(&b->props[op->idx],
+						   buf + pos);
+		src = op->offset + op->skip;
+	}
+	memcpy(buf + pos, base + src, size_struct - src);
+
+	/*
+	 * Move anything between the blocks along with the strings, as libfdt
+	 * does, then add the new strings and the new structure block
+	 */
+	memmove(base + size_struct + delta, base + size_struct,
+		strtab + size_strings - (base + size_struct));
+	strtab += delta;
+	memcpy(strtab + size_strings, newstr, newstr_len);
+	memcpy(base, buf, size_struct + delta);
+	fdt_set_size_dt_struct(fdt, size_struct + delta);
+	fdt_set_off_dt_strings(fdt, fdt_off_dt_strings(fdt) + delta);
+	fdt_set_size_dt_strings(fdt, size_strings + newstr_len);
+	log_debug("%d properties, %d nodes, struct %x -> %x\n", b->num_props,
+		  b->num_nodes, size_struct, size_struct + delta);
+	ret = 0;
+out:
+	free(buf);
+	free(newstr);
+	free(ops);
+
+	return ret;
+}
+
+int fdt_batch_end(void *fdt)
+{
+	struct fdt_batch *b = fdt_batch_get(fdt);
+	int ret;
+
+	if (!b)
+		return -FDT_ERR_BADSTATE;
+	if (--b->depth)
+		return 0;
+	ret = fdt_batch_apply(b);
+	fdt_batch_free(b);
+
+	return ret;
+}
@@ -9,6 +9,8 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
+#include <fdt_batch.h>
 #include <fdt_support.h>
 #include <fdtdec.h>
 #include <env.h>
@@ -17,6 +19,7 @@
 #include <lmb.h>
 #include <log.h>
 #include <malloc.h>
+#include <memprof.h>
 #include <linux/libfdt.h>
 #include <mapmem.h>
 #include <asm/io.h>
@@ -197,6 +200,12 @@ int boot_relocate_fdt(struct lmb *lmb, char **of_flat_tree, ulong *of_size)
 			of_start =
 			    (void *)(ulong) lmb_alloc(lmb, of_len, 0x1000);
 		}
+	} else if (lmb_auto_fits((ulong)fdt_blob, of_len,
+				 env_get_bootm_mapsize() +
+				 env_get_bootm_low())) {
+		/* Loaded to an 'auto' address, which is already padded */
+		of_start = fdt_blob;
+		disable_relocation = 1;
 	} else {
 		of_start =
 		    (void *)(ulong) lmb_alloc_base(lmb, of_len, 0x1000,
@@ -537,6 +546,28 @@ __weak int arch_fixup_fdt(void *blob)
 	return 0;
 }
 
+/*
+ * Fixups which make their edits through the fdt_batch_...() functions, so
+ * that they can be applied to the tree in one go
+ */
+static int image_fixup_batched(void *blob)
+{
+	if (fdt_root(blob) < 0) {
+		printf("ERROR: root node setup failed\n");
+		return -EPERM;
+	}
+	if (fdt_chosen(blob) < 0) {
+		printf("ERROR: /chosen node create failed\n");
+		return -EPERM;
+	}
+	/* Update ethernet nodes */
+	fdt_fixup_ethernet(blob);
+	/* Pass heap/LMB usage to the OS */
+	memprof_fdt_fixup(blob);
+
+	return 0;
+}
+
 int image_setup_libfdt(bootm_headers_t *images, void *blob,
 		       int of_size, struct lmb *lmb)
 {
@@ -545,14 +576,21 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 	int ret = -EPERM;
 	int fdt_ret;
 
-	if (fdt_root(blob) < 0) {
-		printf("ERROR: root node setup failed\n");
-		goto err;
+	bootstage_start(BOOTSTAGE_ID_ACCUM_FDT_FIXUP, "fdt_fixup");
+	fdt_ret = fdt_batch_begin(blob);
+	if (!fdt_ret) {
+		ret = image_fixup_batched(blob);
+		fdt_ret = fdt_batch_end(blob);
 	}
-	if (fdt_chosen(blob) < 0) {
-		printf("ERROR: /chosen node create failed\n");
-		goto err;
+	if (fdt_ret) {
+		printf("ERROR: fdt fixup failed: %s\n", fdt_strerror(fdt_ret));
+		ret = -EPERM;
 	}
+	if (ret)
+		goto err;
+
+	/* The fixups below edit the tree directly */
+	ret = -EPERM;
 	if (arch_fixup_fdt(blob) < 0) {
 		printf("ERROR: arch-specific fdt fixup failed\n");
 		goto err;
@@ -565,8 +603,6 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 		goto err;
 	}
 
-	/* Update ethernet nodes */
-	fdt_fixup_ethernet(blob);
 #if CONFIG_IS_ENABLED(CMD_PSTORE)
 	/* Append PStore configuration */
 	fdt_fixup_pstore(blob);
@@ -588,6 +624,8 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 		}
 	}
 
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FDT_FIXUP);
+
 	/* Delete the old LMB reservation */
 	if (lmb)
 		lmb_free(lmb, (phys_addr_t)(u32)(uintptr_t)blob,
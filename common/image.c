@@ -1376,6 +1376,10 @@ int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
 		initrd_high = env_get_bootm_mapsize() + env_get_bootm_low();
 	}
 
+	/* A ramdisk loaded to an 'auto' address is already in place */
+	if (rd_data && lmb_auto_fits(rd_data, rd_len, initrd_high))
+		initrd_copy_to_ram = 0;
+
 
 	debug("## initrd_high = 0x%08lx, copy_to_ram = %d\n",
 			initrd_high, initrd_copy_to_ram);
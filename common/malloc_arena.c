@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Scoped arena allocator for transient buffers
+ *
+ * This is a bump allocator in the style of malloc_simple.c, but it runs
+ * after relocation from a dedicated region and supports releasing memory
+ * through push/pop marks.
+ */
+
+#define LOG_CATEGORY LOGC_ALLOC
+
+#include <common.h>
+#include <log.h>
+#include <malloc.h>
+#include <malloc_arena.h>
+#include <memalign.h>
+
+/**
+ * struct arena_priv - state of the arena
+ *
+ * @base: Start address of region
+ * @limit: End address of region (exclusive)
+ * @ptr: Next free address
+ * @last: Start of the most recent allocation, or 0 if none
+ * @last_ptr: Value of @ptr before the most recent allocation
+ * @depth: Number of marks taken and not yet popped
+ * @stats: Usage statistics
+ */
+struct arena_priv {
+	ulong base;
+	ulong limit;
+	ulong ptr;
+	ulong last;
+	ulong last_ptr;
+	int depth;
+	struct arena_stats stats;
+};
+
+static struct arena_priv arena;
+
+int arena_init(void *base, ulong size)
+{
+	if (!size)
+		return -EINVAL;
+	memset(&arena, '\0', sizeof(arena));
+	arena.base = (ulong)base;
+	arena.limit = arena.base + size;
+	arena.ptr = arena.base;
+	arena.stats.size = size;
+	log_debug("arena at %lx, size %lx\n", arena.base, size);
+
+	return 0;
+}
+
+ulong arena_push(void)
+{
+	if (arena.base)
+		arena.depth++;
+
+	return arena.ptr;
+}
+
+void arena_pop(ulong mark)
+{
+	if (!arena.base)
+		return;
+	if (arena.depth)
+		arena.depth--;
+	if (mark < arena.base || mark > arena.ptr) {
+		log_err("invalid arena mark %lx (ptr %lx)\n", mark, arena.ptr);
+		return;
+	}
+	arena.ptr = mark;
+	if (arena.last >= mark)
+		arena.last = 0;
+	arena.stats.used = arena.ptr - arena.base;
+}
+
+void *arena_alloc(size_t size)
+{
+	ulong addr, new_ptr;
+	void *ptr;
+
+	/* Nothing would release the buffer without a mark, so use malloc() */
+	if (!arena.depth)
+		return malloc_cache_aligned(size);
+
+	addr = ALIGN(arena.ptr, ARCH_DMA_MINALIGN);
+	new_ptr = addr + size;
+	if (new_ptr > arena.limit || new_ptr < addr) {
+		arena.stats.fallbacks++;
+		log_debug("size=%zx: fallback to malloc\n", size);
+		return malloc_cache_aligned(size);
+	}
+	arena.last = addr;
+	arena.last_ptr = arena.ptr;
+	arena.ptr = new_ptr;
+
+	arena.stats.allocs++;
+	arena.stats.bytes += size;
+	arena.stats.used = arena.ptr - arena.base;
+	if (arena.stats.used > arena.stats.peak)
+		arena.stats.peak = arena.stats.used;
+	ptr = (void *)addr;
+	log_debug("size=%zx, ptr=%p\n", size, ptr);
+
+	return ptr;
+}
+
+void *arena_calloc(size_t nmemb, size_t size)
+{
+	size_t len = nmemb * size;
+	void *ptr;
+
+	if (size && len / size != nmemb)
+		return NULL;
+	ptr = arena_alloc(len);
+	if (ptr)
+		memset(ptr, '\0', len);
+
+	return ptr;
+}
+
+bool arena_contains(const void *ptr)
+{
+	ulong addr = (ulong)ptr;
+
+	return arena.base && addr >= arena.base && addr < arena.limit;
+}
+
+void arena_free(void *ptr)
+{
+	if (!ptr)
+		return;
+	if (!arena_contains(ptr)) {
+		free(ptr);
+		return;
+	}
+
+	/* The most recent allocation can be handed back immediately */
+	if ((ulong)ptr == arena.last) {
+		arena.ptr = arena.last_ptr;
+		arena.last = 0;
+		arena.stats.used = arena.ptr - arena.base;
+	}
+}
+
+void arena_get_stats(struct arena_stats *stats)
+{
+	*stats = arena.stats;
+}
+
+void arena_info(void)
+{
+	struct arena_stats *st = &arena.stats;
+
+	printf("arena: %lx bytes at %lx\n", st->size, arena.base);
+	printf("  in use    %lx, peak %lx\n", st->used, st->peak);
+	printf("  allocs    %lu (%lu bytes) kept out of malloc()\n",
+	       st->allocs, st->bytes);
+	printf("  fallbacks %lu\n", st->fallbacks);
+}
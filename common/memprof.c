@@ -0,0 +1,515 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Heap and LMB usage profiler
+ */
+
+#define LOG_CATEGORY LOGC_ALLOC
+
+#include <common.h>
+#include <bloblist.h>
+#include <fdt_batch.h>
+#include <log.h>
+#include <malloc.h>
+#include <malloc_arena.h>
+#include <memprof.h>
+#include <sort.h>
+#include <time.h>
+#include <linux/libfdt.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+enum {
+	MEMPROF_MAX_SUBSYS	= 16,
+};
+
+/**
+ * struct memprof_site - statistics for one call site
+ *
+ * @caller: Return address of the call to the allocator (0 if unused)
+ * @allocs: Number of allocations
+ * @frees: Number of frees
+ * @bytes: Total bytes allocated
+ */
+struct memprof_site {
+	ulong caller;
+	ulong allocs;
+	ulong frees;
+	ulong bytes;
+};
+
+/**
+ * struct memprof_block - a live allocation
+ *
+ * @ptr: Pointer returned by the allocator (NULL if unused)
+ * @subsys: Subsystem which was active when it was allocated
+ * @size: Usable size of the allocation
+ */
+struct memprof_block {
+	void *ptr;
+	const char *subsys;
+	ulong size;
+};
+
+/**
+ * struct memprof_subsys - statistics for one subsystem
+ *
+ * @name: Subsystem name (NULL if unused)
+ * @allocs: Number of allocations
+ * @frees: Number of frees of allocations made by this subsystem
+ * @live: Bytes allocated by this subsystem and not yet freed
+ * @peak: Highest value of @live
+ */
+struct memprof_subsys {
+	const char *name;
+	ulong allocs;
+	ulong frees;
+	long live;
+	long peak;
+};
+
+/**
+ * struct memprof_lmb_rec - one LMB event
+ *
+ * @time_us: Time of the event
+ * @kind: Kind of event (enum memprof_lmb_kind)
+ * @base: Base address of region
+ * @size: Size of region
+ */
+struct memprof_lmb_rec {
+	ulong time_us;
+	enum memprof_lmb_kind kind;
+	phys_addr_t base;
+	phys_size_t size;
+};
+
+/**
+ * struct memprof_priv - profiler state
+ *
+ * @sites: Call-site table, hashed by caller address
+ * @site_overflow: Number of requests which did not fit in @sites
+ * @blocks: Live allocations, hashed by pointer
+ * @block_overflow: Number of allocations which did not fit in @blocks
+ * @subsys: Subsystem table
+ * @cur: Currently active subsystem
+ * @live: Sum of the sizes of live allocations
+ * @live_peak: Highest value of @live
+ * @lmb: Ring buffer of LMB events
+ * @lmb_count: Total number of LMB events recorded
+ * @lmb_low: Lowest address reserved/allocated through LMB
+ * @lmb_high: Highest address (exclusive) reserved/allocated through LMB
+ */
+struct memprof_priv {
+	struct memprof_site sites[CONFIG_MEMPROF_SITES];
+	ulong site_overflow;
+	struct memprof_block blocks[CONFIG_MEMPROF_BLOCKS];
+	ulong block_overflow;
+	struct memprof_subsys subsys[MEMPROF_MAX_SUBSYS];
+	const char *cur;
+	long live;
+	long live_peak;
+	struct memprof_lmb_rec lmb[CONFIG_MEMPROF_LMB_EVENTS];
+	ulong lmb_count;
+	phys_addr_t lmb_low;
+	phys_addr_t lmb_high;
+};
+
+static struct memprof_priv memprof;
+
+static const char *const lmb_kind_name[] = {
+	[MEMPROF_LMB_RESERVE]	= "reserve",
+	[MEMPROF_LMB_ALLOC]	= "alloc",
+	[MEMPROF_LMB_FREE]	= "free",
+};
+
+static struct memprof_site *memprof_find_site(void *caller)
+{
+	ulong addr = (ulong)caller;
+	uint start, i;
+
+	start = (addr >> 2) % CONFIG_MEMPROF_SITES;
+	for (i = 0; i < CONFIG_MEMPROF_SITES; i++) {
+		struct memprof_site *site;
+
+		site = &memprof.sites[(start + i) % CONFIG_MEMPROF_SITES];
+		if (site->caller == addr)
+			return site;
+		if (!site->caller) {
+			site->caller = addr;
+			return site;
+		}
+	}
+	memprof.site_overflow++;
+
+	return NULL;
+}
+
+static struct memprof_subsys *memprof_find_subsys(const char *name)
+{
+	struct memprof_subsys *ss;
+
+	if (!name)
+		name = "other";
+	for (ss = memprof.subsys; ss < memprof.subsys + MEMPROF_MAX_SUBSYS;
+	     ss++) {
+		if (!ss->name) {
+			ss->name = name;
+			return ss;
+		}
+		if (ss->name == name || !strcmp(ss->name, name))
+			return ss;
+	}
+
+	/* Table full; lump everything else into the last entry */
+	return ss - 1;
+}
+
+static uint memprof_block_hash(void *ptr)
+{
+	return ((ulong)ptr >> 3) % CONFIG_MEMPROF_BLOCKS;
+}
+
+/* Find the slot holding @ptr, or the empty slot where it would go */
+static struct memprof_block *memprof_find_block(void *ptr)
+{
+	uint start, i;
+
+	start = memprof_block_hash(ptr);
+	for (i = 0; i < CONFIG_MEMPROF_BLOCKS; i++) {
+		struct memprof_block *blk;
+
+		blk = &memprof.blocks[(start + i) % CONFIG_MEMPROF_BLOCKS];
+		if (blk->ptr == ptr || !blk->ptr)
+			return blk;
+	}
+
+	return NULL;
+}
+
+/* Remove a block, moving up later entries so that lookups still find them */
+static void memprof_remove_block(struct memprof_block *blk)
+{
+	uint hole = blk - memprof.blocks;
+	uint i = hole;
+
+	for (;;) {
+		uint home;
+
+		i = (i + 1) % CONFIG_MEMPROF_BLOCKS;
+		blk = &memprof.blocks[i];
+		if (!blk->ptr)
+			break;
+		home = memprof_block_hash(blk->ptr);
+		if ((i > hole && (home <= hole || home > i)) ||
+		    (i < hole && home <= hole && home > i)) {
+			memprof.blocks[hole] = *blk;
+			hole = i;
+		}
+	}
+	memprof.blocks[hole].ptr = NULL;
+}
+
+static void memprof_charge(struct memprof_subsys *ss, long size)
+{
+	ss->live += size;
+	if (ss->live > ss->peak)
+		ss->peak = ss->live;
+
+	memprof.live += size;
+	if (memprof.live > memprof.live_peak)
+		memprof.live_peak = memprof.live;
+}
+
+void memprof_alloc(void *ptr, size_t size, void *caller)
+{
+	struct memprof_block *blk;
+	struct memprof_subsys *ss;
+	struct memprof_site *site;
+
+	site = memprof_find_site(caller);
+	if (site) {
+		site->allocs++;
+		site->bytes += size;
+	}
+
+	ss = memprof_find_subsys(memprof.cur);
+	ss->allocs++;
+
+	/* Only charge what can be credited back when it is freed */
+	blk = memprof_find_block(ptr);
+	if (!blk) {
+		memprof.block_overflow++;
+		return;
+	}
+	blk->ptr = ptr;
+	blk->subsys = ss->name;
+	blk->size = size;
+	memprof_charge(ss, size);
+}
+
+void memprof_free(void *ptr, void *caller)
+{
+	struct memprof_block *blk;
+	struct memprof_subsys *ss;
+	struct memprof_site *site;
+
+	site = memprof_find_site(caller);
+	if (site)
+		site->frees++;
+
+	/* Ignore allocations made before profiling started, or not tracked */
+	blk = memprof_find_block(ptr);
+	if (!blk || !blk->ptr)
+		return;
+	ss = memprof_find_subsys(blk->subsys);
+	ss->frees++;
+	ss->live -= blk->size;
+	memprof.live -= blk->size;
+	memprof_remove_block(blk);
+}
+
+long memprof_get_live(const char *subsys)
+{
+	struct memprof_subsys *ss;
+
+	for (ss = memprof.subsys; ss < memprof.subsys + MEMPROF_MAX_SUBSYS;
+	     ss++) {
+		if (!ss->name)
+			break;
+		if (ss->name == subsys || !strcmp(ss->name, subsys))
+			return ss->live;
+	}
+
+	return 0;
+}
+
+const char *memprof_push(const char *subsys)
+{
+	const char *prev = memprof.cur;
+
+	memprof.cur = subsys;
+
+	return prev;
+}
+
+void memprof_pop(const char *prev)
+{
+	memprof.cur = prev;
+}
+
+void memprof_lmb(enum memprof_lmb_kind kind, phys_addr_t base,
+		 phys_size_t size)
+{
+	struct memprof_lmb_rec *rec;
+
+	rec = &memprof.lmb[memprof.lmb_count % CONFIG_MEMPROF_LMB_EVENTS];
+	rec->time_us = timer_get_us();
+	rec->kind = kind;
+	rec->base = base;
+	rec->size = size;
+	memprof.lmb_count++;
+
+	if (kind == MEMPROF_LMB_FREE || !size)
+		return;
+	if (!memprof.lmb_high || base < memprof.lmb_low)
+		memprof.lmb_low = base;
+	if (base + size > memprof.lmb_high)
+		memprof.lmb_high = base + size;
+}
+
+void memprof_get_export(struct memprof_export *exp)
+{
+	ulong size, used, peak;
+
+	memset(exp, '\0', sizeof(*exp));
+	malloc_get_usage(&size, &used, &peak);
+	exp->malloc_size = size;
+	exp->malloc_peak = peak;
+	exp->malloc_used = used;
+	exp->live_peak = memprof.live_peak;
+	exp->lmb_low = memprof.lmb_low;
+	exp->lmb_high = memprof.lmb_high;
+#if CONFIG_IS_ENABLED(MALLOC_ARENA)
+	{
+		struct arena_stats st;
+
+		arena_get_stats(&st);
+		exp->arena_size = st.size;
+		exp->arena_peak = st.peak;
+	}
+#endif
+}
+
+int memprof_fdt_fixup(void *blob)
+{
+	struct memprof_export exp;
+	int node, ret;
+
+	memprof_get_export(&exp);
+#if CONFIG_IS_ENABLED(BLOBLIST)
+	{
+		struct memprof_export *rec;
+
+		rec = bloblist_ensure(BLOBLISTT_U_BOOT_MEMPROF, sizeof(*rec));
+		if (rec)
+			*rec = exp;
+	}
+#endif
+
+	node = fdt_batch_find_or_add_subnode(blob, 0, "chosen");
+	if (node < 0)
+		return node;
+	ret = fdt_batch_setprop_u32(blob, node, "u-boot,memprof-malloc-size",
+				    exp.malloc_size);
+	if (!ret)
+		ret = fdt_batch_setprop_u32(blob, node,
+					    "u-boot,memprof-malloc-peak",
+					    exp.malloc_peak);
+	if (!ret)
+		ret = fdt_batch_setprop_u32(blob, node,
+					    "u-boot,memprof-malloc-used",
+					    exp.malloc_used);
+	if (!ret && exp.lmb_high) {
+		ret = fdt_batch_setprop_u64(blob, node,
+					    "u-boot,memprof-lmb-low",
+					    exp.lmb_low);
+		if (!ret)
+			ret = fdt_batch_setprop_u64(blob, node,
+						    "u-boot,memprof-lmb-high",
+						    exp.lmb_high);
+	}
+	if (ret) {
+		log_err("Cannot add memprof properties: %s\n",
+			fdt_strerror(ret));
+		return -ENOSPC;
+	}
+
+	return 0;
+}
+
+void memprof_reset(void)
+{
+	struct memprof_block *blk;
+
+	memset(memprof.sites, '\0', sizeof(memprof.sites));
+	memprof.site_overflow = 0;
+	memprof.block_overflow = 0;
+	memset(memprof.subsys, '\0', sizeof(memprof.subsys));
+	memprof.lmb_count = 0;
+	memprof.lmb_low = 0;
+	memprof.lmb_high = 0;
+
+	/* Allocations which are still live stay charged to their owners */
+	memprof.live = 0;
+	memprof.live_peak = 0;
+	for (blk = memprof.blocks; blk < memprof.blocks + CONFIG_MEMPROF_BLOCKS;
+	     blk++) {
+		if (blk->ptr)
+			memprof_charge(memprof_find_subsys(blk->subsys),
+				       blk->size);
+	}
+}
+
+void *memprof_save(void)
+{
+	struct memprof_priv *save;
+
+	save = malloc(sizeof(*save));
+	if (save)
+		memcpy(save, &memprof, sizeof(*save));
+
+	return save;
+}
+
+void memprof_restore(void *save)
+{
+	memcpy(&memprof, save, sizeof(memprof));
+	free(save);
+}
+
+void memprof_show_info(void)
+{
+	struct memprof_export exp;
+	struct memprof_subsys *ss;
+
+	memprof_get_export(&exp);
+	printf("malloc region %8x\n", exp.malloc_size);
+	printf("  in use      %8x\n", exp.malloc_used);
+	printf("  peak (brk)  %8x (%u%%)\n", exp.malloc_peak,
+	       exp.malloc_size ? (uint)((u64)exp.malloc_peak * 100 /
+					exp.malloc_size) : 0);
+	printf("  live peak   %8x\n", exp.live_peak);
+	if (exp.lmb_high)
+		printf("lmb span      %llx-%llx\n",
+		       (unsigned long long)exp.lmb_low,
+		       (unsigned long long)exp.lmb_high);
+#if CONFIG_IS_ENABLED(MALLOC_ARENA)
+	arena_info();
+#endif
+
+	printf("\n%-12s %8s %8s %10s %10s\n", "Subsystem", "Allocs", "Frees",
+	       "Live", "Peak");
+	for (ss = memprof.subsys; ss < memprof.subsys + MEMPROF_MAX_SUBSYS;
+	     ss++) {
+		if (!ss->name)
+			break;
+		printf("%-12s %8lu %8lu %10lx %10lx\n", ss->name, ss->allocs,
+		       ss->frees, ss->live, ss->peak);
+	}
+	if (memprof.block_overflow)
+		printf("%lu allocations not charged; increase CONFIG_MEMPROF_BLOCKS\n",
+		       memprof.block_overflow);
+}
+
+static int h_compare_site(const void *v1, const void *v2)
+{
+	const struct memprof_site *s1 = v1, *s2 = v2;
+
+	if (s1->bytes == s2->bytes)
+		return 0;
+
+	return s1->bytes < s2->bytes ? 1 : -1;
+}
+
+void memprof_show_sites(void)
+{
+	struct memprof_site sites[CONFIG_MEMPROF_SITES];
+	int i;
+
+	memcpy(sites, memprof.sites, sizeof(sites));
+	qsort(sites, CONFIG_MEMPROF_SITES, sizeof(*sites), h_compare_site);
+
+	/* Addresses are shown unrelocated so they match u-boot.map */
+	printf("%-10s %8s %8s %10s\n", "Caller", "Allocs", "Frees", "Bytes");
+	for (i = 0; i < CONFIG_MEMPROF_SITES; i++) {
+		struct memprof_site *site = &sites[i];
+
+		if (!site->caller)
+			continue;
+		printf("%08lx   %8lu %8lu %10lx\n", site->caller - gd->reloc_off,
+		       site->allocs, site->frees, site->bytes);
+	}
+	if (memprof.site_overflow)
+		printf("%lu requests from untracked sites; increase CONFIG_MEMPROF_SITES\n",
+		       memprof.site_overflow);
+}
+
+void memprof_show_lmb(void)
+{
+	ulong first = 0;
+	ulong i;
+
+	if (memprof.lmb_count > CONFIG_MEMPROF_LMB_EVENTS)
+		first = memprof.lmb_count - CONFIG_MEMPROF_LMB_EVENTS;
+	printf("%11s %-8s %16s %16s\n", "Time (us)", "Event", "Base", "Size");
+	for (i = first; i < memprof.lmb_count; i++) {
+		struct memprof_lmb_rec *rec;
+
+		rec = &memprof.lmb[i % CONFIG_MEMPROF_LMB_EVENTS];
+		printf("%11lu %-8s %16llx %16llx\n", rec->time_us,
+		       lmb_kind_name[rec->kind],
+		       (unsigned long long)rec->base,
+		       (unsigned long long)rec->size);
+	}
+	if (first)
+		printf("(%lu older events dropped)\n", first);
+}
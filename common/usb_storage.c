@@ -40,12 +40,14 @@
 #include <log.h>
 #include <mapmem.h>
 #include <memalign.h>
+#include <watchdog.h>
 #include <asm/byteorder.h>
 #include <asm/cache.h>
 #include <asm/processor.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <linux/delay.h>
+#include <linux/kernel.h>
 
 #include <part.h>
 #include <usb.h>
@@ -101,6 +103,7 @@ struct us_data {
 	trans_reset	transport_reset;	/* reset routine */
 	trans_cmnd	transport;		/* transport routine */
 	unsigned short	max_xfer_blk;		/* maximum transfer blocks */
+	unsigned short	max_xfer_limit;		/* largest max_xfer_blk to try */
 };
 
 #if !CONFIG_IS_ENABLED(BLK)
@@ -111,6 +114,12 @@ static struct us_data usb_stor[USB_MAX_STOR_DEV];
 #define USB_STOR_TRANSPORT_FAILED -1
 #define USB_STOR_TRANSPORT_ERROR  -2
 
+/* Transfer size, in blocks, which all known devices handle */
+#define USB_STOR_SAFE_XFER_BLK	240
+
+/* Number of READ commands kept in flight by usb_stor_BBB_read_queued() */
+#define USB_STOR_QUEUE_CMDS	2
+
 int usb_stor_get_info(struct usb_device *dev, struct us_data *us,
 		      struct blk_desc *dev_desc);
 int usb_storage_probe(struct usb_device *dev, unsigned int ifnum,
@@ -958,19 +967,25 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 	 * Windows 7 limiting transfers to 128 sectors for both USB2 and USB3
 	 * and Apple Mac OS X 10.11 limiting transfers to 256 sectors for USB2
 	 * and 2048 for USB3 devices.
+	 *
+	 * Reads start at that size and grow, as long as they succeed, up to
+	 * CONFIG_USB_STORAGE_MAX_XFER_BLK. See usb_stor_read(). Writes use
+	 * the same size and both shrink it again if a command fails.
 	 */
-	unsigned short blk = 240;
+	unsigned short blk = USB_STOR_SAFE_XFER_BLK;
+	unsigned short limit = CONFIG_USB_STORAGE_MAX_XFER_BLK;
 
 #if CONFIG_IS_ENABLED(DM_USB)
 	size_t size;
 	int ret;
 
 	ret = usb_get_max_xfer_size(udev, (size_t *)&size);
-	if ((ret >= 0) && (size < blk * 512))
-		blk = size / 512;
+	if ((ret >= 0) && (size < limit * 512))
+		limit = size / 512;
 #endif
 
-	us->max_xfer_blk = blk;
+	us->max_xfer_limit = limit;
+	us->max_xfer_blk = min(blk, limit);
 }
 
 static int usb_inquiry(struct scsi_cmd *srb, struct us_data *ss)
@@ -1066,8 +1081,8 @@ static int usb_read_capacity(struct scsi_cmd *srb, struct us_data *ss)
 	return -1;
 }
 
-static int usb_read_10(struct scsi_cmd *srb, struct us_data *ss,
-		       unsigned long start, unsigned short blocks)
+static void usb_setup_read_10(struct scsi_cmd *srb, unsigned long start,
+			      unsigned short blocks)
 {
 	memset(&srb->cmd[0], 0, 12);
 	srb->cmd[0] = SCSI_READ10;
@@ -1080,6 +1095,13 @@ static int usb_read_10(struct scsi_cmd *srb, struct us_data *ss,
 	srb->cmd[8] = (unsigned char) blocks & 0xff;
 	srb->cmdlen = 12;
 	debug("read10: start %lx blocks %x\n", start, blocks);
+}
+
+static int usb_read_10(struct scsi_cmd *srb, struct us_data *ss,
+		       unsigned long start, unsigned short blocks)
+{
+	usb_setup_read_10(srb, start, blocks);
+
 	return ss->transport(srb, ss);
 }
 
@@ -1124,6 +1146,154 @@ static void usb_bin_fixup(struct usb_device_descriptor descriptor,
 }
 #endif /* CONFIG_USB_BIN_FIXUP */
 
+/* Wait for the oldest transfer in @queue, which should be into @buf */
+static int usb_stor_wait_queue(struct usb_device *udev,
+			       struct bulk_queue *queue, void *buf)
+{
+	ulong start = get_timer(0);
+	void *done;
+	int ret;
+
+	do {
+		ret = poll_bulk_queue(udev, queue, &done);
+		if (ret != -EAGAIN)
+			break;
+		WATCHDOG_RESET();
+	} while (get_timer(start) < USB_CNTL_TIMEOUT * 5);
+	if (ret >= 0 && done != buf)
+		return -EIO;
+
+	return ret;
+}
+
+/**
+ * struct us_queued_read - A READ command kept in flight by a queued read
+ *
+ * @addr: Address to read into
+ * @blks: Number of blocks to read
+ * @tag: Tag of the command's CBW
+ * @csw: Buffer for the command's CSW
+ */
+struct us_queued_read {
+	uintptr_t addr;
+	unsigned short blks;
+	u32 tag;
+	struct umass_bbb_csw *csw;
+};
+
+/*
+ * Read from a BBB device, keeping the data and status stages of the next
+ * READ command queued on the bulk-in endpoint. The device can then send the
+ * data as soon as it has the command, while the previous status is checked
+ * and the one after is queued.
+ *
+ * This returns the number of blocks read before any error. The caller reads
+ * the rest with the usual transport, which also deals with recovery.
+ */
+static lbaint_t usb_stor_BBB_read_queued(struct us_data *ss,
+					 struct scsi_cmd *srb,
+					 struct blk_desc *block_dev,
+					 lbaint_t start, lbaint_t blks,
+					 uintptr_t buf_addr)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, csw_buf, USB_STOR_QUEUE_CMDS *
+				 ROUND(UMASS_BBB_CSW_SIZE, ARCH_DMA_MINALIGN));
+	struct us_queued_read cmds[USB_STOR_QUEUE_CMDS], *cmd, *next;
+	struct usb_device *udev = ss->pusb_dev;
+	ulong blksz = block_dev->blksz;
+	lbaint_t queued = 0, done = 0;
+	struct bulk_queue *queue;
+	struct umass_bbb_csw *csw;
+	int i, ret;
+
+	queue = create_bulk_queue(udev, usb_rcvbulkpipe(udev, ss->ep_in),
+				  2 * USB_STOR_QUEUE_CMDS,
+				  ss->max_xfer_blk * blksz);
+	if (!queue)
+		return 0;
+
+	for (i = 0; i < USB_STOR_QUEUE_CMDS; i++)
+		cmds[i].csw = (void *)csw_buf +
+			i * ROUND(UMASS_BBB_CSW_SIZE, ARCH_DMA_MINALIGN);
+
+	/* Queue the data and status stages of the first commands */
+	for (i = 0; i < USB_STOR_QUEUE_CMDS && queued < blks; i++) {
+		cmd = &cmds[i];
+		cmd->addr = buf_addr + queued * blksz;
+		cmd->blks = min_t(lbaint_t, blks - queued, ss->max_xfer_blk);
+		queued += cmd->blks;
+		if (submit_bulk_queue(udev, queue, (void *)cmd->addr,
+				      cmd->blks * blksz) ||
+		    submit_bulk_queue(udev, queue, cmd->csw,
+				      UMASS_BBB_CSW_SIZE))
+			goto fail;
+	}
+
+	cmd = &cmds[0];
+	srb->pdata = (unsigned char *)cmd->addr;
+	srb->datalen = cmd->blks * blksz;
+	usb_setup_read_10(srb, start, cmd->blks);
+	cmd->tag = CBWTag;
+	if (usb_stor_BBB_comdat(srb, ss) < 0)
+		goto fail;
+
+	for (i = 0; done < blks; i++) {
+		cmd = &cmds[i % USB_STOR_QUEUE_CMDS];
+		csw = cmd->csw;
+		ret = usb_stor_wait_queue(udev, queue, (void *)cmd->addr);
+		if (ret != cmd->blks * blksz)
+			goto fail;
+		ret = usb_stor_wait_queue(udev, queue, csw);
+		if (ret != UMASS_BBB_CSW_SIZE)
+			goto fail;
+		usb_show_progress();
+
+		/* Send the next command before checking the status */
+		if (done + cmd->blks < blks) {
+			next = &cmds[(i + 1) % USB_STOR_QUEUE_CMDS];
+			srb->pdata = (unsigned char *)next->addr;
+			srb->datalen = next->blks * blksz;
+			usb_setup_read_10(srb, start + done + cmd->blks,
+					  next->blks);
+			next->tag = CBWTag;
+			if (usb_stor_BBB_comdat(srb, ss) < 0)
+				goto fail;
+		}
+
+		if (le32_to_cpu(csw->dCSWSignature) != CSWSIGNATURE ||
+		    le32_to_cpu(csw->dCSWTag) != cmd->tag ||
+		    csw->bCSWStatus != CSWSTATUS_GOOD ||
+		    csw->dCSWDataResidue) {
+			debug("%s: bad CSW\n", __func__);
+			goto fail;
+		}
+		done += cmd->blks;
+
+		/* Reuse this command's buffers for the one after next */
+		if (queued < blks) {
+			cmd->addr = buf_addr + queued * blksz;
+			cmd->blks = min_t(lbaint_t, blks - queued,
+					  ss->max_xfer_blk);
+			queued += cmd->blks;
+			if (submit_bulk_queue(udev, queue, (void *)cmd->addr,
+					      cmd->blks * blksz) ||
+			    submit_bulk_queue(udev, queue, cmd->csw,
+					      UMASS_BBB_CSW_SIZE))
+				goto fail;
+		}
+	}
+	destroy_bulk_queue(udev, queue);
+
+	return done;
+
+fail:
+	debug("%s: failed after " LBAF " blocks\n", __func__, done);
+	destroy_bulk_queue(udev, queue);
+	usb_stor_BBB_reset(ss);
+
+	return done;
+}
+
 #if CONFIG_IS_ENABLED(BLK)
 static unsigned long usb_stor_read(struct udevice *dev, lbaint_t blknr,
 				   lbaint_t blkcnt, void *buffer)
@@ -1134,11 +1304,12 @@ static unsigned long usb_stor_read(struct blk_desc *block_dev, lbaint_t blknr,
 {
 	lbaint_t start, blks;
 	uintptr_t buf_addr;
-	unsigned short smallblks;
+	unsigned short smallblks = 0;
 	struct usb_device *udev;
 	struct us_data *ss;
 	int retry;
 	struct scsi_cmd *srb = &usb_ccb;
+	bool full;
 #if CONFIG_IS_ENABLED(BLK)
 	struct blk_desc *block_dev;
 #endif
@@ -1170,7 +1341,20 @@ static unsigned long usb_stor_read(struct blk_desc *block_dev, lbaint_t blknr,
 	debug("\nusb_read: dev %d startblk " LBAF ", blccnt " LBAF " buffer %lx\n",
 	      block_dev->devnum, start, blks, buf_addr);
 
-	do {
+	full = blks >= ss->max_xfer_blk;
+	if (IS_ENABLED(CONFIG_USB_STORAGE_QUEUE) &&
+	    ss->transport == usb_stor_BBB_transport &&
+	    blks > ss->max_xfer_blk) {
+		lbaint_t done;
+
+		done = usb_stor_BBB_read_queued(ss, srb, block_dev, start, blks,
+						buf_addr);
+		start += done;
+		blks -= done;
+		buf_addr += done * block_dev->blksz;
+	}
+
+	while (blks != 0) {
 		/* XXX need some comment here */
 		retry = 2;
 		srb->pdata = (unsigned char *)buf_addr;
@@ -1187,6 +1371,17 @@ retry_it:
 			debug("Read ERROR\n");
 			ss->flags &= ~USB_READY;
 			usb_request_sense(srb, ss);
+			/*
+			 * The device may not cope with transfers this large.
+			 * Shrinking always ends, so it does not use up a retry.
+			 */
+			if (smallblks > USB_STOR_SAFE_XFER_BLK) {
+				smallblks = max_t(unsigned short, smallblks / 2,
+						  USB_STOR_SAFE_XFER_BLK);
+				ss->max_xfer_blk = smallblks;
+				ss->max_xfer_limit = smallblks;
+				goto retry_it;
+			}
 			if (retry--)
 				goto retry_it;
 			blkcnt -= blks;
@@ -1195,11 +1390,18 @@ retry_it:
 		start += smallblks;
 		blks -= smallblks;
 		buf_addr += srb->datalen;
-	} while (blks != 0);
+	}
 
 	debug("usb_read: end startblk " LBAF ", blccnt %x buffer %lx\n",
 	      start, smallblks, buf_addr);
 
+	/* Try larger transfers once this size has worked */
+	if (!blks && full && ss->max_xfer_blk < ss->max_xfer_limit) {
+		ss->max_xfer_blk = min_t(uint, ss->max_xfer_blk * 2,
+					 ss->max_xfer_limit);
+		debug("usb_read: max_xfer_blk now %u\n", ss->max_xfer_blk);
+	}
+
 	usb_lock_async(udev, 0);
 	usb_disable_asynch(0); /* asynch transfer allowed */
 	if (blkcnt >= ss->max_xfer_blk)
@@ -1274,6 +1476,14 @@ retry_it:
 			debug("Write ERROR\n");
 			ss->flags &= ~USB_READY;
 			usb_request_sense(srb, ss);
+			/* A size which worked for reads may be too large here */
+			if (smallblks > USB_STOR_SAFE_XFER_BLK) {
+				smallblks = max_t(unsigned short, smallblks / 2,
+						  USB_STOR_SAFE_XFER_BLK);
+				ss->max_xfer_blk = smallblks;
+				ss->max_xfer_limit = smallblks;
+				goto retry_it;
+			}
 			if (retry--)
 				goto retry_it;
 			blkcnt -= blks;
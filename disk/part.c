@@ -239,6 +239,7 @@ void part_init(struct blk_desc *dev_desc)
 	struct part_driver *entry;
 
 	blkcache_invalidate(dev_desc->if_type, dev_desc->devnum);
+	part_cache_invalidate(dev_desc);
 
 	dev_desc->part_type = PART_TYPE_UNKNOWN;
 	for (entry = drv; entry != drv + n_ents; entry++) {
@@ -348,10 +349,15 @@ int part_get_info(struct blk_desc *dev_desc, int part,
 		       drv->name);
 		return -ENOSYS;
 	}
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	if (part_cache_get_info(dev_desc, drv, part, info) == 0)
+		return 0;
+#else
 	if (drv->get_info(dev_desc, part, info) == 0) {
 		PRINTF("## Valid %s partition found ##\n", drv->name);
 		return 0;
 	}
+#endif
 #endif /* CONFIG_HAVE_BLOCK_DEVICE */
 
 	return -1;
@@ -424,9 +430,11 @@ int blk_get_device_by_str(const char *ifname, const char *dev_hwpart_str,
 	/*
 	 * Updates the partition table for the specified hw partition.
 	 * Always should be done, otherwise hw partition 0 will return stale
-	 * data after displaying a non-zero hw partition.
+	 * data after displaying a non-zero hw partition. A table still in the
+	 * partition cache is up to date, since writes to it drop it.
 	 */
-	part_init(*dev_desc);
+	if (part_cache_restore(*dev_desc))
+		part_init(*dev_desc);
 #endif
 
 cleanup:
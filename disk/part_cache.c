@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Cache of the partitions of each block device
+ *
+ * Without this, every part_get_info() call reads the partition table again
+ * and, for GPT, checks the CRCs of the header and of all the entries. A boot
+ * looks up the same few partitions dozens of times, so keep the results for
+ * each device until it is rescanned or its partition table may have changed.
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <log.h>
+#include <malloc.h>
+#include <part.h>
+#include <linux/list.h>
+
+enum part_cache_state {
+	PART_CACHE_UNKNOWN = 0,	/* not looked up yet */
+	PART_CACHE_VALID,
+	PART_CACHE_INVALID,	/* no such partition */
+};
+
+/**
+ * struct part_cache_node - Cached partitions of one block device
+ *
+ * @lh: List node
+ * @if_type: Interface type of the block device
+ * @devnum: Device number of the block device
+ * @hwpart: Hardware partition the table was read from
+ * @lba: Size of the device when the table was read
+ * @part_type: Partition table type (PART_TYPE_...)
+ * @complete: true if the whole table was read with get_info_all(), so that
+ *	no partition is in PART_CACHE_UNKNOWN state
+ * @state: State of each partition, indexed by partition number - 1
+ * @info: Information about each partition in PART_CACHE_VALID state
+ */
+struct part_cache_node {
+	struct list_head lh;
+	enum if_type if_type;
+	int devnum;
+	int hwpart;
+	lbaint_t lba;
+	int part_type;
+	bool complete;
+	u8 state[MAX_SEARCH_PARTITIONS];
+	struct disk_partition info[MAX_SEARCH_PARTITIONS];
+};
+
+/* This is set up on first use, so it does not need relocating */
+static struct list_head part_cache;
+
+static struct part_cache_node *part_cache_find(struct blk_desc *dev_desc)
+{
+	struct part_cache_node *node;
+
+	if (!part_cache.next)
+		return NULL;
+	list_for_each_entry(node, &part_cache, lh) {
+		if (node->if_type == dev_desc->if_type &&
+		    node->devnum == dev_desc->devnum &&
+		    node->hwpart == dev_desc->hwpart)
+			return node;
+	}
+
+	return NULL;
+}
+
+static void part_cache_free(struct part_cache_node *node)
+{
+	list_del(&node->lh);
+	free(node);
+}
+
+static struct part_cache_node *part_cache_fill(struct blk_desc *dev_desc,
+					       struct part_driver *drv)
+{
+	struct part_cache_node *node;
+	int i;
+
+	node = calloc(1, sizeof(*node));
+	if (!node)
+		return NULL;
+	node->if_type = dev_desc->if_type;
+	node->devnum = dev_desc->devnum;
+	node->hwpart = dev_desc->hwpart;
+	node->lba = dev_desc->lba;
+	node->part_type = drv->part_type;
+
+	/*
+	 * If the table cannot be read, remember that too, so that each lookup
+	 * does not read it and complain about it again
+	 */
+	if (drv->get_info_all) {
+		if (drv->get_info_all(dev_desc, node->info,
+				      MAX_SEARCH_PARTITIONS))
+			memset(node->info, '\0', sizeof(node->info));
+		for (i = 0; i < MAX_SEARCH_PARTITIONS; i++)
+			node->state[i] = node->info[i].size ?
+				PART_CACHE_VALID : PART_CACHE_INVALID;
+		node->complete = true;
+	}
+
+	if (!part_cache.next)
+		INIT_LIST_HEAD(&part_cache);
+	list_add(&node->lh, &part_cache);
+	log_debug("%s %d: cached %s table\n",
+		  blk_get_if_type_name(dev_desc->if_type), dev_desc->devnum,
+		  drv->name);
+
+	return node;
+}
+
+int part_cache_get_info(struct blk_desc *dev_desc, struct part_driver *drv,
+			int part, struct disk_partition *info)
+{
+	struct part_cache_node *node;
+	int slot = part - 1;
+
+	/* Partitions beyond the cache go straight to the device */
+	if (part < 1 || part > MAX_SEARCH_PARTITIONS)
+		return drv->get_info(dev_desc, part, info);
+
+	node = part_cache_find(dev_desc);
+	if (node && (node->lba != dev_desc->lba ||
+		     node->part_type != drv->part_type)) {
+		part_cache_free(node);
+		node = NULL;
+	}
+	if (!node) {
+		node = part_cache_fill(dev_desc, drv);
+		if (!node)
+			return drv->get_info(dev_desc, part, info);
+	}
+
+	if (node->state[slot] == PART_CACHE_UNKNOWN) {
+		if (drv->get_info(dev_desc, part, &node->info[slot]))
+			node->state[slot] = PART_CACHE_INVALID;
+		else
+			node->state[slot] = PART_CACHE_VALID;
+	}
+	if (node->state[slot] != PART_CACHE_VALID)
+		return -ENOENT;
+	*info = node->info[slot];
+
+	return 0;
+}
+
+int part_cache_restore(struct blk_desc *dev_desc)
+{
+	struct part_cache_node *node;
+
+	node = part_cache_find(dev_desc);
+	if (!node || node->lba != dev_desc->lba)
+		return -ENOENT;
+	dev_desc->part_type = node->part_type;
+
+	return 0;
+}
+
+void part_cache_invalidate(struct blk_desc *dev_desc)
+{
+	struct part_cache_node *node, *tmp;
+
+	if (!part_cache.next)
+		return;
+	list_for_each_entry_safe(node, tmp, &part_cache, lh) {
+		if (node->if_type == dev_desc->if_type &&
+		    node->devnum == dev_desc->devnum)
+			part_cache_free(node);
+	}
+}
+
+void part_cache_write(struct blk_desc *dev_desc, lbaint_t start,
+		      lbaint_t blkcnt)
+{
+	struct part_cache_node *node;
+	int i;
+
+	node = part_cache_find(dev_desc);
+	if (!node)
+		return;
+
+	/*
+	 * A write inside a partition cannot touch the table. This is only
+	 * known to be true if all the partitions are known.
+	 */
+	if (node->complete) {
+		for (i = 0; i < MAX_SEARCH_PARTITIONS; i++) {
+			struct disk_partition *info = &node->info[i];
+
+			if (node->state[i] == PART_CACHE_VALID &&
+			    start >= info->start &&
+			    start + blkcnt <= info->start + info->size)
+				return;
+		}
+	}
+	log_debug("%s %d: write to " LBAF " drops cached table\n",
+		  blk_get_if_type_name(dev_desc->if_type), dev_desc->devnum,
+		  start);
+	part_cache_free(node);
+}
@@ -261,6 +261,30 @@ void part_print_efi(struct blk_desc *dev_desc)
 	return;
 }
 
+/* Fill in the partition information for a GPT entry */
+static void part_efi_fill_info(struct blk_desc *dev_desc, gpt_entry *pte,
+			       struct disk_partition *info)
+{
+	/* The 'lbaint_t' casting may limit the maximum disk size to 2 TB */
+	info->start = (lbaint_t)le64_to_cpu(pte->starting_lba);
+	/* The ending LBA is inclusive, to calculate size, add 1 to it */
+	info->size = (lbaint_t)le64_to_cpu(pte->ending_lba) + 1 - info->start;
+	info->blksz = dev_desc->blksz;
+
+	snprintf((char *)info->name, sizeof(info->name), "%s",
+		 print_efiname(pte));
+	strcpy((char *)info->type, "U-Boot");
+	info->bootable = get_bootable(pte);
+#if CONFIG_IS_ENABLED(PARTITION_UUIDS)
+	uuid_bin_to_str(pte->unique_partition_guid.b, info->uuid,
+			UUID_STR_FORMAT_GUID);
+#endif
+#ifdef CONFIG_PARTITION_TYPE_GUID
+	uuid_bin_to_str(pte->partition_type_guid.b, info->type_guid,
+			UUID_STR_FORMAT_GUID);
+#endif
+}
+
 int part_get_info_efi(struct blk_desc *dev_desc, int part,
 		      struct disk_partition *info)
 {
@@ -285,25 +309,7 @@ int part_get_info_efi(struct blk_desc *dev_desc, int part,
 		return -1;
 	}
 
-	/* The 'lbaint_t' casting may limit the maximum disk size to 2 TB */
-	info->start = (lbaint_t)le64_to_cpu(gpt_pte[part - 1].starting_lba);
-	/* The ending LBA is inclusive, to calculate size, add 1 to it */
-	info->size = (lbaint_t)le64_to_cpu(gpt_pte[part - 1].ending_lba) + 1
-		     - info->start;
-	info->blksz = dev_desc->blksz;
-
-	snprintf((char *)info->name, sizeof(info->name), "%s",
-		 print_efiname(&gpt_pte[part - 1]));
-	strcpy((char *)info->type, "U-Boot");
-	info->bootable = get_bootable(&gpt_pte[part - 1]);
-#if CONFIG_IS_ENABLED(PARTITION_UUIDS)
-	uuid_bin_to_str(gpt_pte[part - 1].unique_partition_guid.b, info->uuid,
-			UUID_STR_FORMAT_GUID);
-#endif
-#ifdef CONFIG_PARTITION_TYPE_GUID
-	uuid_bin_to_str(gpt_pte[part - 1].partition_type_guid.b,
-			info->type_guid, UUID_STR_FORMAT_GUID);
-#endif
+	part_efi_fill_info(dev_desc, &gpt_pte[part - 1], info);
 
 	debug("%s: start 0x" LBAF ", size 0x" LBAF ", name %s\n", __func__,
 	      info->start, info->size, info->name);
@@ -313,6 +319,30 @@ int part_get_info_efi(struct blk_desc *dev_desc, int part,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+static int part_get_info_all_efi(struct blk_desc *dev_desc,
+				 struct disk_partition *info, int max)
+{
+	ALLOC_CACHE_ALIGN_BUFFER_PAD(gpt_header, gpt_head, 1, dev_desc->blksz);
+	gpt_entry *gpt_pte = NULL;
+	int count, i;
+
+	/* This function validates AND fills in the GPT header and PTE */
+	if (find_valid_gpt(dev_desc, gpt_head, &gpt_pte) != 1)
+		return -EINVAL;
+
+	count = min_t(int, le32_to_cpu(gpt_head->num_partition_entries), max);
+	for (i = 0; i < count; i++) {
+		if (is_pte_valid(&gpt_pte[i]))
+			part_efi_fill_info(dev_desc, &gpt_pte[i], &info[i]);
+	}
+
+	/* Remember to free pte */
+	free(gpt_pte);
+	return 0;
+}
+#endif
+
 static int part_test_efi(struct blk_desc *dev_desc)
 {
 	ALLOC_CACHE_ALIGN_BUFFER_PAD(legacy_mbr, legacymbr, 1, dev_desc->blksz);
@@ -1109,6 +1139,9 @@ U_BOOT_PART_TYPE(a_efi) = {
 	.part_type	= PART_TYPE_EFI,
 	.max_entries	= GPT_ENTRY_NUMBERS,
 	.get_info	= part_get_info_ptr(part_get_info_efi),
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	.get_info_all	= part_get_info_all_efi,
+#endif
 	.print		= part_print_ptr(part_print_efi),
 	.test		= part_test_efi,
 };
@@ -24,6 +24,7 @@
 #include <dm/pinctrl.h>
 #include <dm/platdata.h>
 #include <dm/read.h>
+#include <dm/root.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
@@ -462,6 +463,7 @@ int device_probe(struct udevice *dev)
 		goto fail;
 	}
 	dev->seq = seq;
+	uclass_index_seq(dev);
 
 	dev->flags |= DM_FLAG_ACTIVATED;
 
@@ -744,6 +746,7 @@ static struct udevice *_device_find_global_by_ofnode(struct udevice *parent,
 
 int device_find_global_by_ofnode(ofnode ofnode, struct udevice **devp)
 {
+	dm_lazy_bind_all();
 	*devp = _device_find_global_by_ofnode(gd->dm_root, ofnode);
 
 	return *devp ? 0 : -ENOENT;
@@ -753,6 +756,7 @@ int device_get_global_by_ofnode(ofnode ofnode, struct udevice **devp)
 {
 	struct udevice *dev;
 
+	dm_lazy_bind_all();
 	dev = _device_find_global_by_ofnode(gd->dm_root, ofnode);
 	return device_get_device_tail(dev, dev ? 0 : -ENOENT, devp);
 }
@@ -981,6 +985,19 @@ bool device_is_last_sibling(const struct udevice *dev)
 	return list_is_last(&dev->sibling_node, &parent->child_head);
 }
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+void dev_set_ofnode(struct udevice *dev, ofnode node)
+{
+	dev->node = node;
+	uclass_index_update(dev);
+}
+
+void dev_set_of_offset(struct udevice *dev, int of_offset)
+{
+	dev_set_ofnode(dev, offset_to_ofnode(of_offset));
+}
+#endif
+
 void device_set_name_alloced(struct udevice *dev)
 {
 	dev->flags |= DM_FLAG_NAME_ALLOCED;
@@ -993,6 +1010,7 @@ int device_set_name(struct udevice *dev, const char *name)
 		return -ENOMEM;
 	dev->name = name;
 	device_set_name_alloced(dev);
+	uclass_index_update(dev);
 
 	return 0;
 }
@@ -6,10 +6,13 @@
 #include <common.h>
 #include <dm.h>
 #include <mapmem.h>
+#include <dm/lists.h>
 #include <dm/root.h>
 #include <dm/util.h>
 #include <dm/uclass-internal.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static void show_devices(struct udevice *dev, int depth, int last_flag)
 {
 	int i, is_last;
@@ -47,6 +50,8 @@ void dm_dump_all(void)
 {
 	struct udevice *root;
 
+	/* Show every device, not just those which have been used */
+	dm_lazy_bind_all();
 	root = dm_root();
 	if (root) {
 		printf(" Class     Index  Probed  Driver                Name\n");
@@ -173,3 +178,30 @@ void dm_dump_static_driver_info(void)
 		       (ulong)map_to_sysmem(entry->platdata));
 	}
 }
+
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+void dm_dump_stats(void)
+{
+	struct dm_compat_index *idx = lists_compat_index();
+
+	printf("Bind time before relocation: %lu us\n", gd->dm_bind_us[0]);
+	printf("Bind time after relocation:  %lu us\n", gd->dm_bind_us[1]);
+	if (!idx) {
+		puts("No compatible-string index\n");
+		return;
+	}
+	printf("Compatible strings: %u in %u slots (%lu bytes), max probes %u\n",
+	       idx->count, idx->mask + 1,
+	       (ulong)(sizeof(*idx) + (idx->mask + 1) * sizeof(idx->entry[0])),
+	       idx->max_probes);
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+	{
+		uint deferred, bound, pending;
+
+		dm_lazy_get_stats(&deferred, &bound, &pending);
+		printf("Lazy binding: %u nodes deferred, %u bound since, %u pending\n",
+		       deferred, bound, pending);
+	}
+#endif
+}
+#endif
@@ -0,0 +1,234 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Lazy binding of device-tree nodes
+ *
+ * When enabled, the post-relocation scan of the device tree does not bind
+ * leaf nodes below the root or a simple bus. Instead each node is recorded
+ * with the uclass of the driver which would be bound to it. The first time
+ * that uclass is used (through uclass_get(), which underlies all of the
+ * uclass_get_device_by_...() and phandle lookups), all of its recorded
+ * nodes are bound, in device-tree order. Anything which walks the whole
+ * tree, such as 'dm tree', binds everything first.
+ *
+ * Nodes with subnodes which have a compatible string are always bound
+ * during the scan, so that every device node ends up either bound or
+ * recorded here. So are nodes whose compatible strings match drivers in more
+ * than one uclass, since the driver which binds is only known by binding.
+ */
+
+#define LOG_CATEGORY LOGC_DM
+
+#include <common.h>
+#include <dm.h>
+#include <log.h>
+#include <malloc.h>
+#include <dm/device-internal.h>
+#include <dm/lists.h>
+#include <dm/root.h>
+#include <dm/uclass-internal.h>
+#include <dm/util.h>
+#include <linux/list.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/**
+ * struct dm_lazy_node - a device-tree node which has not been bound yet
+ *
+ * @sibling: Position in the list of pending nodes
+ * @parent: Device to bind the node under
+ * @node: Device-tree node
+ * @id: Uclass of the driver which matches @node
+ */
+struct dm_lazy_node {
+	struct list_head sibling;
+	struct udevice *parent;
+	ofnode node;
+	enum uclass_id id;
+};
+
+/**
+ * struct dm_lazy_state - state of lazy binding
+ *
+ * @pending: List of struct dm_lazy_node, in device-tree order
+ * @deferred: Number of nodes which were deferred by the scan
+ * @bound: Number of deferred nodes which have since been bound
+ * @done: true for each uclass whose nodes have been bound
+ */
+struct dm_lazy_state {
+	struct list_head pending;
+	uint deferred;
+	uint bound;
+	bool done[UCLASS_COUNT];
+};
+
+int dm_lazy_start(void)
+{
+	struct dm_lazy_state *st;
+
+	if (gd->dm_lazy)
+		return 0;
+	st = calloc(1, sizeof(*st));
+	if (!st)
+		return -ENOMEM;
+	INIT_LIST_HEAD(&st->pending);
+	gd->dm_lazy = st;
+
+	return 0;
+}
+
+void dm_lazy_stop(void)
+{
+	struct dm_lazy_state *st = gd->dm_lazy;
+	struct dm_lazy_node *ln, *next;
+
+	if (!st)
+		return;
+	list_for_each_entry_safe(ln, next, &st->pending, sibling)
+		free(ln);
+	free(st);
+	gd->dm_lazy = NULL;
+}
+
+/* Check whether any subnode of @node describes a device */
+static bool dm_lazy_has_devices(ofnode node)
+{
+	ofnode subnode;
+
+	ofnode_for_each_subnode(subnode, node) {
+		if (ofnode_get_property(subnode, "compatible", NULL))
+			return true;
+	}
+
+	return false;
+}
+
+bool dm_lazy_defer(struct udevice *parent, ofnode node)
+{
+	struct dm_lazy_state *st = gd->dm_lazy;
+	struct dm_lazy_node *ln;
+	const struct udevice_id *of_id;
+	struct driver *drv = NULL, *other;
+	const char *compat;
+	int i;
+
+	if (!st)
+		return false;
+	if (parent != gd->dm_root &&
+	    device_get_uclass_id(parent) != UCLASS_SIMPLE_BUS)
+		return false;
+	if (dm_lazy_has_devices(node))
+		return false;
+
+	for (i = 0; !drv; i++) {
+		if (ofnode_read_string_index(node, "compatible", i, &compat))
+			return false;
+		drv = lists_driver_lookup_compat(compat, &of_id);
+	}
+
+	/*
+	 * If that driver refuses to bind, lists_bind_fdt() tries the later
+	 * compatible strings. Bind now if that could put the device in another
+	 * uclass, since we cannot tell which uclass_get() should bind it.
+	 */
+	while (!ofnode_read_string_index(node, "compatible", i++, &compat)) {
+		other = lists_driver_lookup_compat(compat, &of_id);
+		if (other && other->id != drv->id)
+			return false;
+	}
+	if (st->done[drv->id])
+		return false;
+
+	ln = malloc(sizeof(*ln));
+	if (!ln)
+		return false;
+	ln->parent = parent;
+	ln->node = node;
+	ln->id = drv->id;
+	list_add_tail(&ln->sibling, &st->pending);
+	st->deferred++;
+	log_debug("deferring '%s'\n", ofnode_get_name(node));
+
+	return true;
+}
+
+/* Bind the first pending node for which @all is true or the uclass is @id */
+static bool dm_lazy_bind_one(struct dm_lazy_state *st, enum uclass_id id,
+			     bool all)
+{
+	struct dm_lazy_node *ln;
+	int ret;
+
+	list_for_each_entry(ln, &st->pending, sibling) {
+		if (!all && ln->id != id)
+			continue;
+
+		/* Binding may add or remove nodes, so take this one off first */
+		list_del(&ln->sibling);
+		st->bound++;
+		ret = lists_bind_fdt(ln->parent, ln->node, NULL, false);
+		if (ret)
+			dm_warn("Failed to bind '%s': %d\n",
+				ofnode_get_name(ln->node), ret);
+		free(ln);
+
+		return true;
+	}
+
+	return false;
+}
+
+void dm_lazy_bind_uclass(enum uclass_id id)
+{
+	struct dm_lazy_state *st = gd->dm_lazy;
+
+	/* Mark the uclass first since binding calls uclass_get() again */
+	if (!st || id < 0 || id >= UCLASS_COUNT || st->done[id])
+		return;
+	st->done[id] = true;
+	while (dm_lazy_bind_one(st, id, false))
+		;
+}
+
+void dm_lazy_bind_all(void)
+{
+	struct dm_lazy_state *st = gd->dm_lazy;
+	int id;
+
+	if (!st)
+		return;
+	for (id = 0; id < UCLASS_COUNT; id++)
+		st->done[id] = true;
+	while (dm_lazy_bind_one(st, 0, true))
+		;
+}
+
+void dm_lazy_forget(struct udevice *parent)
+{
+	struct dm_lazy_state *st = gd->dm_lazy;
+	struct dm_lazy_node *ln, *next;
+
+	if (!st)
+		return;
+	list_for_each_entry_safe(ln, next, &st->pending, sibling) {
+		if (ln->parent == parent) {
+			list_del(&ln->sibling);
+			free(ln);
+		}
+	}
+}
+
+void dm_lazy_get_stats(uint *deferredp, uint *boundp, uint *pendingp)
+{
+	struct dm_lazy_state *st = gd->dm_lazy;
+	struct dm_lazy_node *ln;
+
+	*deferredp = 0;
+	*boundp = 0;
+	*pendingp = 0;
+	if (!st)
+		return;
+	*deferredp = st->deferred;
+	*boundp = st->bound;
+	list_for_each_entry(ln, &st->pending, sibling)
+		(*pendingp)++;
+}
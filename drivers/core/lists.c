@@ -11,6 +11,7 @@
 #include <common.h>
 #include <errno.h>
 #include <log.h>
+#include <malloc.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -20,6 +21,8 @@
 #include <fdtdec.h>
 #include <linux/compiler.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 struct driver *lists_driver_lookup_name(const char *name)
 {
 	struct driver *drv =
@@ -155,6 +158,111 @@ int device_bind_driver_to_node(struct udevice *parent, const char *drv_name,
 }
 
 #if CONFIG_IS_ENABLED(OF_CONTROL) && !CONFIG_IS_ENABLED(OF_PLATDATA)
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+static uint compat_hash(const char *str)
+{
+	uint hash = 2166136261U;
+
+	while (*str)
+		hash = (hash ^ (u8)*str++) * 16777619U;
+
+	return hash;
+}
+
+/**
+ * compat_index_build() - Build the compatible-string hash table
+ *
+ * Where several drivers claim the same compatible string, the first one in
+ * the linker list is kept, matching the order of the linear search.
+ *
+ * @return pointer to table, or NULL if out of memory
+ */
+static struct dm_compat_index *compat_index_build(void)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *id;
+	struct dm_compat_index *idx;
+	struct driver *entry;
+	uint count = 0;
+	uint size;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++)
+			count++;
+	}
+	for (size = 16; size < count * 2; size <<= 1)
+		;
+	idx = calloc(1, sizeof(*idx) + size * sizeof(idx->entry[0]));
+	if (!idx)
+		return NULL;
+	idx->mask = size - 1;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++) {
+			struct dm_compat_entry *slot;
+			uint i, probes;
+
+			i = compat_hash(id->compatible);
+			for (probes = 1; ; probes++, i++) {
+				slot = &idx->entry[i & idx->mask];
+				if (!slot->compat ||
+				    !strcmp(slot->compat, id->compatible))
+					break;
+			}
+			if (slot->compat)
+				continue;
+			slot->compat = id->compatible;
+			slot->drv = entry;
+			slot->id = id;
+			idx->count++;
+			idx->max_probes = max(idx->max_probes, probes);
+		}
+	}
+	log_debug("compat index: %u strings in %u slots\n", idx->count, size);
+
+	return idx;
+}
+
+/**
+ * compat_index_lookup() - Look up a compatible string in the hash table
+ *
+ * @idx: Table to search
+ * @compat: Compatible string to find
+ * @of_idp: Returns the matching driver ID entry
+ * @return driver which handles @compat, or NULL if none
+ */
+static struct driver *compat_index_lookup(struct dm_compat_index *idx,
+					  const char *compat,
+					  const struct udevice_id **of_idp)
+{
+	uint i = compat_hash(compat);
+
+	for (;; i++) {
+		struct dm_compat_entry *slot = &idx->entry[i & idx->mask];
+
+		if (!slot->compat)
+			return NULL;
+		if (!strcmp(slot->compat, compat)) {
+			*of_idp = slot->id;
+			return slot->drv;
+		}
+	}
+}
+
+struct dm_compat_index *lists_compat_index(void)
+{
+	/*
+	 * Only a few nodes are bound before relocation, so keep the table out
+	 * of the small pre-relocation heap and use a linear search there
+	 */
+	if (!gd->dm_compat_index && (gd->flags & GD_FLG_RELOC))
+		gd->dm_compat_index = compat_index_build();
+
+	return gd->dm_compat_index;
+}
+#endif /* DM_COMPAT_INDEX */
+
 /**
  * driver_check_compatible() - Check if a driver matches a compatible string
  *
@@ -181,11 +289,30 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
-		   bool pre_reloc_only)
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **of_idp)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver *entry;
+
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+	struct dm_compat_index *idx = lists_compat_index();
+
+	if (idx)
+		return compat_index_lookup(idx, compat, of_idp);
+#endif
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, of_idp, compat))
+			return entry;
+	}
+
+	return NULL;
+}
+
+int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
+		   bool pre_reloc_only)
+{
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
@@ -222,13 +349,8 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 		log_debug("   - attempt to match compatible string '%s'\n",
 			  compat);
 
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		entry = lists_driver_lookup_compat(compat, &id);
+		if (!entry)
 			continue;
 
 		if (pre_reloc_only) {
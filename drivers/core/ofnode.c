@@ -43,8 +43,8 @@ int ofnode_read_u32_index(ofnode node, const char *propname, int index,
 		return of_read_u32_index(ofnode_to_np(node), propname, index,
 					 outp);
 
-	cell = fdt_getprop(gd->fdt_blob, ofnode_to_offset(node), propname,
-			   &len);
+	cell = fdtdec_index_getprop(gd->fdt_blob, ofnode_to_offset(node),
+				    propname, &len);
 	if (!cell) {
 		debug("(not found)\n");
 		return -EINVAL;
@@ -89,8 +89,8 @@ int ofnode_read_u64(ofnode node, const char *propname, u64 *outp)
 	if (ofnode_is_np(node))
 		return of_read_u64(ofnode_to_np(node), propname, outp);
 
-	cell = fdt_getprop(gd->fdt_blob, ofnode_to_offset(node), propname,
-			   &len);
+	cell = fdtdec_index_getprop(gd->fdt_blob, ofnode_to_offset(node),
+				    propname, &len);
 	if (!cell || len < sizeof(*cell)) {
 		debug("(not found)\n");
 		return -EINVAL;
@@ -141,8 +141,9 @@ const void *ofnode_read_prop(ofnode node, const char *propname, int *sizep)
 			len = prop->length;
 		}
 	} else {
-		val = fdt_getprop(gd->fdt_blob, ofnode_to_offset(node),
-				  propname, &len);
+		val = fdtdec_index_getprop(gd->fdt_blob,
+					   ofnode_to_offset(node), propname,
+					   &len);
 	}
 	if (!val) {
 		debug("<not found>\n");
@@ -254,8 +255,8 @@ ofnode ofnode_get_parent(ofnode node)
 	if (ofnode_is_np(node))
 		parent = np_to_ofnode(of_get_parent(ofnode_to_np(node)));
 	else
-		parent.of_offset = fdt_parent_offset(gd->fdt_blob,
-						     ofnode_to_offset(node));
+		parent.of_offset = fdtdec_index_parent_offset(gd->fdt_blob,
+						ofnode_to_offset(node));
 
 	return parent;
 }
@@ -280,7 +281,8 @@ ofnode ofnode_get_by_phandle(uint phandle)
 	if (of_live_active())
 		node = np_to_ofnode(of_find_node_by_phandle(phandle));
 	else
-		node.of_offset = fdt_node_offset_by_phandle(gd->fdt_blob,
+		node.of_offset =
+			fdtdec_index_node_offset_by_phandle(gd->fdt_blob,
 							    phandle);
 
 	return node;
@@ -448,7 +450,8 @@ ofnode ofnode_path(const char *path)
 	if (of_live_active())
 		return np_to_ofnode(of_find_node_by_path(path));
 	else
-		return offset_to_ofnode(fdt_path_offset(gd->fdt_blob, path));
+		return offset_to_ofnode(fdtdec_index_path_offset(gd->fdt_blob,
+								 path));
 }
 
 const void *ofnode_read_chosen_prop(const char *propname, int *sizep)
@@ -602,8 +605,9 @@ const void *ofnode_get_property(ofnode node, const char *propname, int *lenp)
 	if (ofnode_is_np(node))
 		return of_get_property(ofnode_to_np(node), propname, lenp);
 	else
-		return fdt_getprop(gd->fdt_blob, ofnode_to_offset(node),
-				   propname, lenp);
+		return fdtdec_index_getprop(gd->fdt_blob,
+					    ofnode_to_offset(node), propname,
+					    lenp);
 }
 
 int ofnode_get_first_property(ofnode node, struct ofprop *prop)
@@ -802,8 +806,8 @@ int ofnode_read_addr_cells(ofnode node)
 	if (ofnode_is_np(node)) {
 		return of_n_addr_cells(ofnode_to_np(node));
 	} else {
-		int parent = fdt_parent_offset(gd->fdt_blob,
-					       ofnode_to_offset(node));
+		int parent = fdtdec_index_parent_offset(gd->fdt_blob,
+						ofnode_to_offset(node));
 
 		return fdt_address_cells(gd->fdt_blob, parent);
 	}
@@ -814,8 +818,8 @@ int ofnode_read_size_cells(ofnode node)
 	if (ofnode_is_np(node)) {
 		return of_n_size_cells(ofnode_to_np(node));
 	} else {
-		int parent = fdt_parent_offset(gd->fdt_blob,
-					       ofnode_to_offset(node));
+		int parent = fdtdec_index_parent_offset(gd->fdt_blob,
+						ofnode_to_offset(node));
 
 		return fdt_size_cells(gd->fdt_blob, parent);
 	}
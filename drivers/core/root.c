@@ -7,6 +7,7 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <errno.h>
 #include <fdtdec.h>
 #include <log.h>
@@ -137,6 +138,14 @@ int dm_init(bool of_live)
 		return -EINVAL;
 	}
 	INIT_LIST_HEAD(&DM_UCLASS_ROOT_NON_CONST);
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+	/* Rebuilt on first use, after the driver fix-ups below */
+	free(gd->dm_compat_index);
+	gd->dm_compat_index = NULL;
+#endif
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+	gd->dm_lazy = NULL;
+#endif
 
 	if (IS_ENABLED(CONFIG_NEEDS_MANUAL_RELOC)) {
 		fix_drivers();
@@ -149,9 +158,9 @@ int dm_init(bool of_live)
 		return ret;
 #if CONFIG_IS_ENABLED(OF_CONTROL)
 	if (CONFIG_IS_ENABLED(OF_LIVE) && of_live)
-		DM_ROOT_NON_CONST->node = np_to_ofnode(gd_of_root());
+		dev_set_ofnode(DM_ROOT_NON_CONST, np_to_ofnode(gd_of_root()));
 	else
-		DM_ROOT_NON_CONST->node = offset_to_ofnode(0);
+		dev_set_ofnode(DM_ROOT_NON_CONST, offset_to_ofnode(0));
 #endif
 	ret = device_probe(DM_ROOT_NON_CONST);
 	if (ret)
@@ -165,6 +174,7 @@ int dm_uninit(void)
 	device_remove(dm_root(), DM_REMOVE_NORMAL);
 	device_unbind(dm_root());
 	gd->dm_root = NULL;
+	dm_lazy_stop();
 
 	return 0;
 }
@@ -216,6 +226,8 @@ static int dm_scan_fdt_live(struct udevice *parent,
 			pr_debug("   - ignoring disabled device\n");
 			continue;
 		}
+		if (!pre_reloc_only && dm_lazy_defer(parent, np_to_ofnode(np)))
+			continue;
 		err = lists_bind_fdt(parent, np_to_ofnode(np), NULL,
 				     pre_reloc_only);
 		if (err && !ret) {
@@ -257,6 +269,9 @@ static int dm_scan_fdt_node(struct udevice *parent, const void *blob,
 			pr_debug("   - ignoring disabled device\n");
 			continue;
 		}
+		if (!pre_reloc_only &&
+		    dm_lazy_defer(parent, offset_to_ofnode(offset)))
+			continue;
 		err = lists_bind_fdt(parent, offset_to_ofnode(offset), NULL,
 				     pre_reloc_only);
 		if (err && !ret) {
@@ -355,6 +370,11 @@ int dm_init_and_scan(bool pre_reloc_only)
 		debug("dm_init() failed: %d\n", ret);
 		return ret;
 	}
+	if (CONFIG_IS_ENABLED(DM_LAZY_BIND) && !pre_reloc_only) {
+		ret = dm_lazy_start();
+		if (ret)
+			return ret;
+	}
 	ret = dm_scan_platdata(pre_reloc_only);
 	if (ret) {
 		debug("dm_scan_platdata() failed: %d\n", ret);
@@ -362,7 +382,15 @@ int dm_init_and_scan(bool pre_reloc_only)
 	}
 
 	if (CONFIG_IS_ENABLED(OF_CONTROL) && !CONFIG_IS_ENABLED(OF_PLATDATA)) {
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+		ulong start = timer_get_boot_us();
+#endif
+
 		ret = dm_extended_scan_fdt(gd->fdt_blob, pre_reloc_only);
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+		gd->dm_bind_us[pre_reloc_only ? 0 : 1] =
+			timer_get_boot_us() - start;
+#endif
 		if (ret) {
 			debug("dm_extended_scan_dt() failed: %d\n", ret);
 			return ret;
@@ -16,12 +16,289 @@
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
+#include <dm/root.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+/**
+ * struct uclass_index - lookup tables for the devices in a uclass
+ *
+ * The index is built by the first lookup and then kept up to date as
+ * devices are bound, unbound, probed and removed. It is dropped if it
+ * becomes too full or memory runs out, and rebuilt by the next lookup.
+ * Devices are added at the end of each hash chain, so where two devices
+ * share a name, the first one in the uclass is found, as with a list walk.
+ *
+ * @bits: log2 of the number of hash buckets
+ * @count: Number of devices in the index
+ * @seq_size: Number of entries in @seq_dev
+ * @seq_dev: Device holding each sequence number, or NULL if none
+ * @name_hash: Hash buckets for device names
+ * @node_hash: Hash buckets for device-tree nodes
+ */
+struct uclass_index {
+	uint bits;
+	uint count;
+	int seq_size;
+	struct udevice **seq_dev;
+	struct hlist_head *name_hash;
+	struct hlist_head *node_hash;
+};
+
+enum {
+	UCLASS_INDEX_MIN_BITS	= 3,
+	UCLASS_INDEX_MIN_SEQS	= 8,
+};
+
+static uint uclass_hash_name(const char *name, uint bits)
+{
+	uint hash = 2166136261U;
+
+	while (*name)
+		hash = (hash ^ (u8)*name++) * 16777619U;
+
+	return hash & ((1U << bits) - 1);
+}
+
+static uint uclass_hash_node(ofnode node, uint bits)
+{
+	/* Both node pointers and offsets are 4-byte aligned */
+	return ((u32)((ulong)node.of_offset >> 2) * 0x9e3779b1U) >> (32 - bits);
+}
+
+static void uclass_hlist_add_tail(struct hlist_node *n, struct hlist_head *h)
+{
+	struct hlist_node *pos = h->first;
+
+	if (!pos) {
+		hlist_add_head(n, h);
+		return;
+	}
+	while (pos->next)
+		pos = pos->next;
+	hlist_add_after(pos, n);
+}
+
+static void uclass_index_drop(struct uclass *uc)
+{
+	struct uclass_index *idx = uc->index;
+
+	if (!idx)
+		return;
+	free(idx->seq_dev);
+	free(idx);
+	uc->index = NULL;
+}
+
+static int uclass_index_set_seq(struct uclass_index *idx, struct udevice *dev)
+{
+	if (dev->seq >= idx->seq_size) {
+		struct udevice **seq_dev;
+		int size;
+
+		size = max(max(dev->seq + 1, idx->seq_size * 2),
+			   (int)UCLASS_INDEX_MIN_SEQS);
+		seq_dev = realloc(idx->seq_dev, size * sizeof(*seq_dev));
+		if (!seq_dev)
+			return -ENOMEM;
+		memset(seq_dev + idx->seq_size, '\0',
+		       (size - idx->seq_size) * sizeof(*seq_dev));
+		idx->seq_dev = seq_dev;
+		idx->seq_size = size;
+	}
+	idx->seq_dev[dev->seq] = dev;
+
+	return 0;
+}
+
+static int uclass_index_link(struct uclass_index *idx, struct udevice *dev)
+{
+	INIT_HLIST_NODE(&dev->name_hnode);
+	INIT_HLIST_NODE(&dev->node_hnode);
+	uclass_hlist_add_tail(&dev->name_hnode,
+			      &idx->name_hash[uclass_hash_name(dev->name,
+							       idx->bits)]);
+	if (ofnode_valid(dev->node))
+		uclass_hlist_add_tail(&dev->node_hnode,
+				      &idx->node_hash[uclass_hash_node(dev->node,
+								       idx->bits)]);
+	idx->count++;
+	if (dev->seq >= 0)
+		return uclass_index_set_seq(idx, dev);
+
+	return 0;
+}
+
+static void uclass_index_unlink(struct uclass_index *idx, struct udevice *dev)
+{
+	int i;
+
+	hlist_del_init(&dev->name_hnode);
+	hlist_del_init(&dev->node_hnode);
+	idx->count--;
+
+	/*
+	 * dev->seq is reset to -1 when the device is removed, and the device
+	 * may have held other numbers before that, so look for every entry
+	 * pointing at it rather than trusting dev->seq
+	 */
+	for (i = 0; i < idx->seq_size; i++) {
+		if (idx->seq_dev[i] == dev)
+			idx->seq_dev[i] = NULL;
+	}
+}
+
+static struct uclass_index *uclass_index_get(struct uclass *uc)
+{
+	struct uclass_index *idx = uc->index;
+	struct udevice *dev;
+	uint count = 0;
+	uint bits;
+
+	if (idx)
+		return idx;
+	list_for_each_entry(dev, &uc->dev_head, uclass_node)
+		count++;
+	for (bits = UCLASS_INDEX_MIN_BITS; (1U << bits) < count; bits++)
+		;
+	idx = calloc(1, sizeof(*idx) + (2U << bits) * sizeof(struct hlist_head));
+	if (!idx)
+		return NULL;
+	idx->bits = bits;
+	idx->name_hash = (struct hlist_head *)(idx + 1);
+	idx->node_hash = idx->name_hash + (1U << bits);
+	uc->index = idx;
+
+	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
+		if (uclass_index_link(idx, dev)) {
+			uclass_index_drop(uc);
+			return NULL;
+		}
+	}
+
+	return idx;
+}
+
+static void uclass_index_add(struct udevice *dev)
+{
+	struct uclass *uc = dev->uclass;
+	struct uclass_index *idx = uc->index;
+
+	if (!idx)
+		return;
+
+	/* Rebuild with more buckets once the chains get long */
+	if (idx->count >= (2U << idx->bits) || uclass_index_link(idx, dev))
+		uclass_index_drop(uc);
+}
+
+static void uclass_index_remove(struct udevice *dev)
+{
+	struct uclass_index *idx = dev->uclass->index;
+
+	if (idx)
+		uclass_index_unlink(idx, dev);
+}
+
+static struct udevice *uclass_index_find_name(struct uclass_index *idx,
+					      const char *name)
+{
+	struct hlist_node *pos;
+	struct udevice *dev;
+
+	hlist_for_each_entry(dev, pos,
+			     &idx->name_hash[uclass_hash_name(name, idx->bits)],
+			     name_hnode) {
+		if (!strcmp(dev->name, name))
+			return dev;
+	}
+
+	return NULL;
+}
+
+static struct udevice *uclass_index_find_node(struct uclass_index *idx,
+					      ofnode node)
+{
+	struct hlist_node *pos;
+	struct udevice *dev;
+
+	hlist_for_each_entry(dev, pos,
+			     &idx->node_hash[uclass_hash_node(node, idx->bits)],
+			     node_hnode) {
+		if (ofnode_equal(dev_ofnode(dev), node))
+			return dev;
+	}
+
+	return NULL;
+}
+
+static struct udevice *uclass_index_find_seq(struct uclass_index *idx, int seq)
+{
+	struct udevice *dev;
+
+	if (seq < 0 || seq >= idx->seq_size)
+		return NULL;
+	dev = idx->seq_dev[seq];
+
+	/* The entry is stale if the device has since been removed */
+	return dev && dev->seq == seq ? dev : NULL;
+}
+
+void uclass_index_update(struct udevice *dev)
+{
+	struct uclass_index *idx = dev->uclass->index;
+
+	/* Nothing to do if the device is not in its uclass yet */
+	if (!idx || list_empty(&dev->uclass_node))
+		return;
+	uclass_index_unlink(idx, dev);
+	if (uclass_index_link(idx, dev))
+		uclass_index_drop(dev->uclass);
+}
+
+void uclass_index_seq(struct udevice *dev)
+{
+	struct uclass_index *idx = dev->uclass->index;
+
+	/*
+	 * Entries are checked against dev->seq on lookup, so removal need not
+	 * clear them. They are cleared when the device is unbound.
+	 */
+	if (idx && dev->seq >= 0 && uclass_index_set_seq(idx, dev))
+		uclass_index_drop(dev->uclass);
+}
+#else
+static inline struct uclass_index *uclass_index_get(struct uclass *uc)
+{
+	return NULL;
+}
+
+static inline struct udevice *uclass_index_find_name(struct uclass_index *idx,
+						     const char *name)
+{
+	return NULL;
+}
+
+static inline struct udevice *uclass_index_find_node(struct uclass_index *idx,
+						     ofnode node)
+{
+	return NULL;
+}
+
+static inline struct udevice *uclass_index_find_seq(struct uclass_index *idx,
+						    int seq)
+{
+	return NULL;
+}
+
+static inline void uclass_index_add(struct udevice *dev) {}
+static inline void uclass_index_remove(struct udevice *dev) {}
+#endif
+
 struct uclass *uclass_find(enum uclass_id key)
 {
 	struct uclass *uc;
@@ -133,6 +410,9 @@ int uclass_destroy(struct uclass *uc)
 	list_del(&uc->sibling_node);
 	if (uc_drv->priv_auto_alloc_size)
 		free(uc->priv);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	uclass_index_drop(uc);
+#endif
 	free(uc);
 
 	return 0;
@@ -143,6 +423,7 @@ int uclass_get(enum uclass_id id, struct uclass **ucp)
 	struct uclass *uc;
 
 	*ucp = NULL;
+	dm_lazy_bind_uclass(id);
 	uc = uclass_find(id);
 	if (!uc)
 		return uclass_add(id, ucp);
@@ -162,16 +443,26 @@ const char *uclass_get_name(enum uclass_id id)
 
 enum uclass_id uclass_get_by_name(const char *name)
 {
-	int i;
+	struct uclass_driver *uclass =
+		ll_entry_start(struct uclass_driver, uclass);
+	const int n_ents = ll_entry_count(struct uclass_driver, uclass);
+	enum uclass_id found = UCLASS_INVALID;
+	struct uclass_driver *entry;
 
-	for (i = 0; i < UCLASS_COUNT; i++) {
-		struct uclass_driver *uc_drv = lists_uclass_lookup(i);
-
-		if (uc_drv && !strcmp(uc_drv->name, name))
-			return i;
+	/*
+	 * Walk the uclass drivers once rather than looking up each uclass ID
+	 * in turn. Only the first driver for an ID is used for that ID, and
+	 * the lowest ID wins if two uclasses have the same name.
+	 */
+	for (entry = uclass; entry != uclass + n_ents; entry++) {
+		if (strcmp(entry->name, name) ||
+		    lists_uclass_lookup(entry->id) != entry)
+			continue;
+		if (found == UCLASS_INVALID || entry->id < found)
+			found = entry->id;
 	}
 
-	return UCLASS_INVALID;
+	return found;
 }
 
 int dev_get_uclass_index(struct udevice *dev, struct uclass **ucp)
@@ -251,6 +542,7 @@ int uclass_find_next_device(struct udevice **devp)
 int uclass_find_device_by_name(enum uclass_id id, const char *name,
 			       struct udevice **devp)
 {
+	struct uclass_index *idx;
 	struct uclass *uc;
 	struct udevice *dev;
 	int ret;
@@ -262,6 +554,13 @@ int uclass_find_device_by_name(enum uclass_id id, const char *name,
 	if (ret)
 		return ret;
 
+	idx = uclass_index_get(uc);
+	if (idx) {
+		*devp = uclass_index_find_name(idx, name);
+
+		return *devp ? 0 : -ENODEV;
+	}
+
 	uclass_foreach_dev(dev, uc) {
 		if (!strcmp(dev->name, name)) {
 			*devp = dev;
@@ -297,6 +596,7 @@ int uclass_find_next_free_req_seq(enum uclass_id id)
 int uclass_find_device_by_seq(enum uclass_id id, int seq_or_req_seq,
 			      bool find_req_seq, struct udevice **devp)
 {
+	struct uclass_index *idx;
 	struct uclass *uc;
 	struct udevice *dev;
 	int ret;
@@ -309,6 +609,14 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq_or_req_seq,
 	if (ret)
 		return ret;
 
+	idx = find_req_seq ? NULL : uclass_index_get(uc);
+	if (idx) {
+		*devp = uclass_index_find_seq(idx, seq_or_req_seq);
+		log_debug("   - %s\n", *devp ? "found" : "not found");
+
+		return *devp ? 0 : -ENODEV;
+	}
+
 	uclass_foreach_dev(dev, uc) {
 		log_debug("   - %d %d '%s'\n",
 			  dev->req_seq, dev->seq, dev->name);
@@ -351,6 +659,7 @@ int uclass_find_device_by_of_offset(enum uclass_id id, int node,
 int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 				 struct udevice **devp)
 {
+	struct uclass_index *idx;
 	struct uclass *uc;
 	struct udevice *dev;
 	int ret;
@@ -363,6 +672,14 @@ int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 	if (ret)
 		return ret;
 
+	idx = uclass_index_get(uc);
+	if (idx) {
+		*devp = uclass_index_find_node(idx, node);
+		if (!*devp)
+			ret = -ENODEV;
+		goto done;
+	}
+
 	uclass_foreach_dev(dev, uc) {
 		log(LOGC_DM, LOGL_DEBUG_CONTENT, "      - checking %s\n",
 		    dev->name);
@@ -650,6 +967,7 @@ int uclass_bind_device(struct udevice *dev)
 
 	uc = dev->uclass;
 	list_add_tail(&dev->uclass_node, &uc->dev_head);
+	uclass_index_add(dev);
 
 	if (dev->parent) {
 		struct uclass_driver *uc_drv = dev->parent->uclass->uc_drv;
@@ -664,6 +982,7 @@ int uclass_bind_device(struct udevice *dev)
 	return 0;
 err:
 	/* There is no need to undo the parent's post_bind call */
+	uclass_index_remove(dev);
 	list_del(&dev->uclass_node);
 
 	return ret;
@@ -682,6 +1001,7 @@ int uclass_unbind_device(struct udevice *dev)
 			return ret;
 	}
 
+	uclass_index_remove(dev);
 	list_del(&dev->uclass_node);
 	return 0;
 }
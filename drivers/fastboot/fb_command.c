@@ -29,6 +29,11 @@ static u32 fastboot_bytes_received;
  */
 static u32 fastboot_bytes_expected;
 
+/**
+ * fastboot_streaming - true if the current download is written as it arrives
+ */
+static bool fastboot_streaming;
+
 static void okay(char *, char *);
 static void getvar(char *, char *);
 static void download(char *, char *);
@@ -42,6 +47,9 @@ static void reboot_recovery(char *, char *);
 #if CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_FORMAT)
 static void oem_format(char *, char *);
 #endif
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC_STREAM)
+static void oem_stream(char *, char *);
+#endif
 
 static const struct {
 	const char *command;
@@ -99,6 +107,12 @@ static const struct {
 		.dispatch = oem_format,
 	},
 #endif
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC_STREAM)
+	[FASTBOOT_COMMAND_OEM_STREAM] = {
+		.command = "oem stream",
+		.dispatch = oem_stream,
+	},
+#endif
 };
 
 /**
@@ -180,13 +194,17 @@ static void download(char *cmd_parameter, char *response)
 		fastboot_fail("Expected nonzero image size", response);
 		return;
 	}
+	if (CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC_STREAM))
+		fastboot_streaming =
+			!fastboot_mmc_stream_start(fastboot_bytes_expected);
 	/*
 	 * Nothing to download yet. Response is of the form:
 	 * [DATA|FAIL]$cmd_parameter
 	 *
 	 * where cmd_parameter is an 8 digit hexadecimal number
 	 */
-	if (fastboot_bytes_expected > fastboot_buf_size) {
+	if (fastboot_bytes_expected > fastboot_buf_size &&
+	    !fastboot_streaming) {
 		fastboot_fail(cmd_parameter, response);
 	} else {
 		printf("Starting download of %d bytes\n",
@@ -205,6 +223,23 @@ u32 fastboot_data_remaining(void)
 	return fastboot_bytes_expected - fastboot_bytes_received;
 }
 
+/**
+ * fastboot_data_next() - return where the next download data is stored
+ *
+ * @received: Returns the number of bytes downloaded so far, which lie just
+ *	below
+ * Return: Pointer into fastboot_buf_addr, or NULL if the data is written out
+ * as it arrives instead
+ */
+void *fastboot_data_next(u32 *received)
+{
+	*received = fastboot_bytes_received;
+	if (CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC_STREAM) && fastboot_streaming)
+		return NULL;
+
+	return fastboot_buf_addr + fastboot_bytes_received;
+}
+
 /**
  * fastboot_data_download() - Copy image data to fastboot_buf_addr.
  *
@@ -212,9 +247,10 @@ u32 fastboot_data_remaining(void)
  * @fastboot_data_len: Length of received fastboot data
  * @response: Pointer to fastboot response buffer
  *
- * Copies image data from fastboot_data to fastboot_buf_addr. Writes to
- * response. fastboot_bytes_received is updated to indicate the number
- * of bytes that have been transferred.
+ * Copies image data from fastboot_data to fastboot_buf_addr, or writes it
+ * straight to the partition given to "oem stream". Writes to response.
+ * fastboot_bytes_received is updated to indicate the number of bytes that
+ * have been transferred.
  *
  * On completion sets image_size and ${filesize} to the total size of the
  * downloaded image.
@@ -233,9 +269,15 @@ void fastboot_data_download(const void *fastboot_data,
 			      response);
 		return;
 	}
-	/* Download data to fastboot_buf_addr */
-	memcpy(fastboot_buf_addr + fastboot_bytes_received,
-	       fastboot_data, fastboot_data_len);
+	/*
+	 * Download data to fastboot_buf_addr, or write it out. It may have
+	 * been received in place already.
+	 */
+	if (CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC_STREAM) && fastboot_streaming)
+		fastboot_mmc_stream_write(fastboot_data, fastboot_data_len);
+	else if (fastboot_data != fastboot_buf_addr + fastboot_bytes_received)
+		memcpy(fastboot_buf_addr + fastboot_bytes_received,
+		       fastboot_data, fastboot_data_len);
 
 	pre_dot_num = fastboot_bytes_received / BYTES_PER_DOT;
 	fastboot_bytes_received += fastboot_data_len;
@@ -258,9 +300,14 @@ void fastboot_data_download(const void *fastboot_data,
  */
 void fastboot_data_complete(char *response)
 {
-	/* Download complete. Respond with "OKAY" */
+	/* Download complete. Respond with "OKAY" unless streaming failed */
 	fastboot_okay(NULL, response);
 	printf("\ndownloading of %d bytes finished\n", fastboot_bytes_received);
+	if (CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC_STREAM) &&
+	    fastboot_streaming) {
+		fastboot_streaming = false;
+		fastboot_mmc_stream_finish(response);
+	}
 	image_size = fastboot_bytes_received;
 	env_set_hex("filesize", image_size);
 	fastboot_bytes_expected = 0;
@@ -275,11 +322,15 @@ void fastboot_data_complete(char *response)
  * @response: Pointer to fastboot response buffer
  *
  * Writes the previously downloaded image to the partition indicated by
- * cmd_parameter. Writes to response.
+ * cmd_parameter. Writes to response. If the image was written as it was
+ * downloaded, this just reports how that went.
  */
 static void flash(char *cmd_parameter, char *response)
 {
 #if CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC)
+	if (CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC_STREAM) &&
+	    fastboot_mmc_stream_flash(cmd_parameter, response))
+		return;
 	fastboot_mmc_flash_write(cmd_parameter, fastboot_buf_addr, image_size,
 				 response);
 #endif
@@ -374,3 +425,20 @@ static void oem_format(char *cmd_parameter, char *response)
 	}
 }
 #endif
+
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC_STREAM)
+/**
+ * oem_stream() - Execute the OEM stream command
+ *
+ * @cmd_parameter: Pointer to partition name, or NULL to disarm
+ * @response: Pointer to fastboot response buffer
+ *
+ * Arrange for the next download to be written to the partition indicated by
+ * cmd_parameter as it arrives. The following "flash" command for that
+ * partition then only reports the result.
+ */
+static void oem_stream(char *cmd_parameter, char *response)
+{
+	fastboot_mmc_stream_arm(cmd_parameter, response);
+}
+#endif
@@ -14,6 +14,7 @@
 #include <command.h>
 #include <env.h>
 #include <fastboot.h>
+#include <mapmem.h>
 #include <net/fastboot.h>
 
 /**
@@ -165,7 +166,8 @@ void fastboot_set_progress_callback(void (*progress)(const char *msg))
 void fastboot_init(void *buf_addr, u32 buf_size)
 {
 	fastboot_buf_addr = buf_addr ? buf_addr :
-				       (void *)CONFIG_FASTBOOT_BUF_ADDR;
+			    map_sysmem(CONFIG_FASTBOOT_BUF_ADDR,
+				       CONFIG_FASTBOOT_BUF_SIZE);
 	fastboot_buf_size = buf_size ? buf_size : CONFIG_FASTBOOT_BUF_SIZE;
 	fastboot_set_progress_callback(NULL);
 }
@@ -137,7 +137,12 @@ static void getvar_version_bootloader(char *var_parameter, char *response)
 
 static void getvar_downloadsize(char *var_parameter, char *response)
 {
-	fastboot_response("OKAY", response, "0x%08x", fastboot_buf_size);
+	u32 size = fastboot_buf_size;
+
+	/* A streamed image need not fit in the download buffer */
+	if (CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC_STREAM))
+		size = max(size, fastboot_mmc_stream_limit());
+	fastboot_response("OKAY", response, "0x%08x", size);
 }
 
 static void getvar_serialno(char *var_parameter, char *response)
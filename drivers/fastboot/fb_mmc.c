@@ -6,6 +6,7 @@
 #include <config.h>
 #include <common.h>
 #include <blk.h>
+#include <display_options.h>
 #include <env.h>
 #include <fastboot.h>
 #include <fastboot-internal.h>
@@ -16,8 +17,11 @@
 #include <log.h>
 #include <part.h>
 #include <mmc.h>
+#include <time.h>
 #include <div64.h>
 #include <linux/compat.h>
+#include <linux/math64.h>
+#include <linux/sizes.h>
 #include <android_image.h>
 
 #define FASTBOOT_MAX_BLK_WRITE 16384
@@ -568,6 +572,479 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 	}
 }
 
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC_STREAM)
+/* Largest write made while streaming, so that the transfer is not held up */
+#define FASTBOOT_STREAM_WRITE_SIZE	SZ_1M
+
+enum fb_mmc_stream_state {
+	STREAM_IDLE = 0,	/* not armed */
+	STREAM_ARMED,		/* waiting for the next download */
+	STREAM_FILE_HDR,	/* collecting the sparse file header */
+	STREAM_CHUNK_HDR,	/* collecting a sparse chunk header */
+	STREAM_FILL,		/* collecting the value of a fill chunk */
+	STREAM_DATA,		/* writing raw data */
+	STREAM_DONE,		/* download finished, waiting for "flash" */
+};
+
+/**
+ * struct fb_mmc_stream - State of an image written as it is downloaded
+ *
+ * @state: Current state
+ * @name: Partition name given to "oem stream"
+ * @dev_desc: Block device holding the partition
+ * @info: Partition being written
+ * @mmcpart: Hardware partition to select, or -1 to leave it alone
+ * @size: Size of the download in bytes
+ * @sparse: true if the image is a sparse image
+ * @err: Message describing the first failure, or NULL if none
+ * @hdr: Header being collected
+ * @hdr_len: Number of bytes in @hdr
+ * @hdr_need: Number of bytes needed in @hdr
+ * @skip: Number of bytes to drop before going on in @state
+ * @remain: Number of bytes left in the current raw chunk or raw image
+ * @blk_sz: Block size of the sparse image
+ * @chunk_hdr_sz: Size of each chunk header in the sparse image
+ * @chunks: Number of sparse chunks not yet started
+ * @total_blks: Number of sparse blocks the image should cover
+ * @blocks: Number of sparse blocks covered so far
+ * @fill_blks: Number of device blocks in the current fill chunk
+ * @blk: Next device block to write
+ * @buf: Staging buffer for data not yet written
+ * @buf_size: Size of @buf in bytes, a multiple of the block size
+ * @buf_len: Number of bytes in @buf
+ * @written: Number of bytes written to the device
+ * @start_time: Time when the download started, from get_timer()
+ */
+struct fb_mmc_stream {
+	enum fb_mmc_stream_state state;
+	char name[PART_NAME_LEN + 1];
+	struct blk_desc *dev_desc;
+	struct disk_partition info;
+	int mmcpart;
+	u32 size;
+	bool sparse;
+	const char *err;
+	union {
+		sparse_header_t file;
+		chunk_header_t chunk;
+		u32 fill;
+		u8 bytes[sizeof(sparse_header_t)];
+	} hdr;
+	u32 hdr_len;
+	u32 hdr_need;
+	u32 skip;
+	u32 remain;
+	u32 blk_sz;
+	u32 chunk_hdr_sz;
+	u32 chunks;
+	u32 total_blks;
+	u32 blocks;
+	lbaint_t fill_blks;
+	lbaint_t blk;
+	u8 *buf;
+	u32 buf_size;
+	u32 buf_len;
+	u64 written;
+	ulong start_time;
+};
+
+static struct fb_mmc_stream fb_mmc_stream;
+
+/* Write the whole blocks held in the staging buffer */
+static int fb_mmc_stream_flush(struct fb_mmc_stream *s)
+{
+	lbaint_t blkcnt = s->buf_len / s->info.blksz;
+	u32 bytes = blkcnt * s->info.blksz;
+
+	if (!blkcnt)
+		return 0;
+	if (s->blk + blkcnt > s->info.start + s->info.size) {
+		s->err = "too large for partition";
+		return -EFBIG;
+	}
+	if (fb_mmc_blk_write(s->dev_desc, s->blk, blkcnt, s->buf) != blkcnt) {
+		s->err = "failed writing to device";
+		return -EIO;
+	}
+	s->blk += blkcnt;
+	s->written += bytes;
+	s->buf_len -= bytes;
+	memmove(s->buf, s->buf + bytes, s->buf_len);
+
+	return 0;
+}
+
+/* Add data to the staging buffer, writing it out each time it fills up */
+static int fb_mmc_stream_copy(struct fb_mmc_stream *s, const u8 *data,
+			      u32 len)
+{
+	u32 n;
+	int ret;
+
+	while (len) {
+		n = min(len, s->buf_size - s->buf_len);
+		memcpy(s->buf + s->buf_len, data, n);
+		s->buf_len += n;
+		data += n;
+		len -= n;
+		if (s->buf_len == s->buf_size) {
+			ret = fb_mmc_stream_flush(s);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+static int fb_mmc_stream_fill(struct fb_mmc_stream *s)
+{
+	u32 *fill_buf = (u32 *)s->buf;
+	lbaint_t blkcnt;
+	int ret;
+	int i;
+
+	for (i = 0; i < s->buf_size / sizeof(u32); i++)
+		fill_buf[i] = s->hdr.fill;
+	while (s->fill_blks) {
+		blkcnt = min_t(lbaint_t, s->fill_blks,
+			       s->buf_size / s->info.blksz);
+		s->buf_len = blkcnt * s->info.blksz;
+		ret = fb_mmc_stream_flush(s);
+		if (ret)
+			return ret;
+		s->fill_blks -= blkcnt;
+	}
+
+	return 0;
+}
+
+static void fb_mmc_stream_next_chunk(struct fb_mmc_stream *s)
+{
+	s->state = s->chunks ? STREAM_CHUNK_HDR : STREAM_DONE;
+	s->hdr_need = sizeof(chunk_header_t);
+}
+
+/* Act on a sparse chunk header, which is complete in s->hdr */
+static int fb_mmc_stream_chunk(struct fb_mmc_stream *s)
+{
+	chunk_header_t *chunk = &s->hdr.chunk;
+	lbaint_t blkcnt;
+
+	s->chunks--;
+	s->skip = s->chunk_hdr_sz - sizeof(*chunk);
+	s->blocks += chunk->chunk_sz;
+	blkcnt = (lbaint_t)chunk->chunk_sz * (s->blk_sz / s->info.blksz);
+	if (s->blk + blkcnt > s->info.start + s->info.size) {
+		s->err = "Request would exceed partition size!";
+		return -EFBIG;
+	}
+
+	switch (chunk->chunk_type) {
+	case CHUNK_TYPE_RAW:
+		if (chunk->total_sz !=
+		    s->chunk_hdr_sz + (u64)blkcnt * s->info.blksz) {
+			s->err = "Bogus chunk size for chunk type Raw";
+			return -EINVAL;
+		}
+		s->remain = chunk->total_sz - s->chunk_hdr_sz;
+		if (s->remain) {
+			s->state = STREAM_DATA;
+			return 0;
+		}
+		break;
+	case CHUNK_TYPE_FILL:
+		if (chunk->total_sz != s->chunk_hdr_sz + sizeof(u32)) {
+			s->err = "Bogus chunk size for chunk type FILL";
+			return -EINVAL;
+		}
+		s->fill_blks = blkcnt;
+		s->state = STREAM_FILL;
+		s->hdr_need = sizeof(u32);
+		return 0;
+	case CHUNK_TYPE_DONT_CARE:
+		s->blk += blkcnt;
+		break;
+	case CHUNK_TYPE_CRC32:
+		if (chunk->total_sz < s->chunk_hdr_sz) {
+			s->err = "Bogus chunk size for chunk type CRC32";
+			return -EINVAL;
+		}
+		s->skip += chunk->total_sz - s->chunk_hdr_sz;
+		break;
+	default:
+		printf("%s: Unknown chunk type: %x\n", __func__,
+		       chunk->chunk_type);
+		s->err = "Unknown chunk type";
+		return -EINVAL;
+	}
+	fb_mmc_stream_next_chunk(s);
+
+	return 0;
+}
+
+/* Act on a header, which is complete in s->hdr */
+static int fb_mmc_stream_header(struct fb_mmc_stream *s)
+{
+	sparse_header_t *file = &s->hdr.file;
+	int ret;
+
+	switch (s->state) {
+	case STREAM_FILE_HDR:
+		if (s->hdr_len < sizeof(*file) || !is_sparse_image(file)) {
+			if (lldiv(s->size + s->info.blksz - 1, s->info.blksz) >
+			    s->info.size) {
+				s->err = "too large for partition";
+				return -EFBIG;
+			}
+			puts("Flashing Raw Image\n");
+			s->state = STREAM_DATA;
+			s->remain = s->size - s->hdr_len;
+			return fb_mmc_stream_copy(s, s->hdr.bytes, s->hdr_len);
+		}
+		if (file->blk_sz % s->info.blksz ||
+		    file->file_hdr_sz < sizeof(*file) ||
+		    file->chunk_hdr_sz < sizeof(chunk_header_t)) {
+			s->err = "sparse image header issue";
+			return -EINVAL;
+		}
+		puts("Flashing Sparse Image\n");
+		s->sparse = true;
+		s->skip = file->file_hdr_sz - sizeof(*file);
+		s->blk_sz = file->blk_sz;
+		s->chunk_hdr_sz = file->chunk_hdr_sz;
+		s->chunks = file->total_chunks;
+		s->total_blks = file->total_blks;
+		fb_mmc_stream_next_chunk(s);
+		return 0;
+	case STREAM_CHUNK_HDR:
+		return fb_mmc_stream_chunk(s);
+	case STREAM_FILL:
+		ret = fb_mmc_stream_fill(s);
+		if (ret)
+			return ret;
+		fb_mmc_stream_next_chunk(s);
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+/**
+ * fastboot_mmc_stream_arm() - Write the next download to a partition
+ *
+ * @cmd: Named partition to write the next image to, or "" to disarm
+ * @response: Pointer to fastboot response buffer
+ */
+void fastboot_mmc_stream_arm(const char *cmd, char *response)
+{
+	struct fb_mmc_stream *s = &fb_mmc_stream;
+	int mmcpart = 0;
+
+	s->state = STREAM_IDLE;
+	if (!cmd || !*cmd) {
+		fastboot_okay(NULL, response);
+		return;
+	}
+
+	s->dev_desc = blk_get_dev("mmc", CONFIG_FASTBOOT_FLASH_MMC_DEV);
+	if (!s->dev_desc || s->dev_desc->type == DEV_TYPE_UNKNOWN) {
+		pr_err("invalid mmc device\n");
+		fastboot_fail("invalid mmc device", response);
+		return;
+	}
+	if (raw_part_get_info_by_name(s->dev_desc, cmd, &s->info,
+				      &mmcpart) == 0) {
+		s->mmcpart = mmcpart;
+	} else if (part_get_info_by_name_or_alias(s->dev_desc, cmd,
+						  &s->info) < 0) {
+		pr_err("cannot find partition: '%s'\n", cmd);
+		fastboot_fail("cannot find partition", response);
+		return;
+	} else {
+		s->mmcpart = -1;
+	}
+
+	strlcpy(s->name, cmd, sizeof(s->name));
+	s->state = STREAM_ARMED;
+	fastboot_okay(NULL, response);
+}
+
+/**
+ * fastboot_mmc_stream_limit() - Get the largest download that can be streamed
+ *
+ * Return: Size of the armed partition in bytes, or 0 if not armed
+ */
+u32 fastboot_mmc_stream_limit(void)
+{
+	struct fb_mmc_stream *s = &fb_mmc_stream;
+
+	if (s->state != STREAM_ARMED)
+		return 0;
+
+	return min_t(u64, (u64)s->info.size * s->info.blksz, U32_MAX);
+}
+
+/**
+ * fastboot_mmc_stream_start() - Start writing a download as it arrives
+ *
+ * @size: Size of the download in bytes
+ * Return: 0 if the download is to be streamed, -ENOENT if not armed
+ */
+int fastboot_mmc_stream_start(u32 size)
+{
+	struct fb_mmc_stream *s = &fb_mmc_stream;
+
+	if (s->state != STREAM_ARMED) {
+		/* A streamed image not flashed is forgotten */
+		s->state = STREAM_IDLE;
+		return -ENOENT;
+	}
+
+	s->state = STREAM_FILE_HDR;
+	s->size = size;
+	s->sparse = false;
+	s->err = NULL;
+	s->hdr_len = 0;
+	s->hdr_need = min_t(u32, size, sizeof(sparse_header_t));
+	s->skip = 0;
+	s->blocks = 0;
+	s->blk = s->info.start;
+	s->buf = fastboot_buf_addr;
+	s->buf_size = min_t(u32, fastboot_buf_size, FASTBOOT_STREAM_WRITE_SIZE);
+	s->buf_size -= s->buf_size % s->info.blksz;
+	s->buf_len = 0;
+	s->written = 0;
+	s->start_time = get_timer(0);
+	if (s->mmcpart >= 0 && blk_dselect_hwpart(s->dev_desc, s->mmcpart))
+		s->err = "Failed to select hwpart";
+	printf("Streaming %u bytes to '%s'\n", size, s->name);
+
+	return 0;
+}
+
+/**
+ * fastboot_mmc_stream_write() - Write the next part of a streamed download
+ *
+ * @data: Pointer to received data
+ * @len: Length of received data
+ *
+ * Any failure is recorded and reported by fastboot_mmc_stream_finish(), so
+ * that the rest of the download is still accepted.
+ */
+void fastboot_mmc_stream_write(const void *data, u32 len)
+{
+	struct fb_mmc_stream *s = &fb_mmc_stream;
+	const u8 *p = data;
+	u32 n;
+	int ret = 0;
+
+	while (len && !s->err) {
+		if (s->skip) {
+			n = min(len, s->skip);
+			s->skip -= n;
+		} else if (s->state == STREAM_DATA) {
+			n = min(len, s->remain);
+			ret = fb_mmc_stream_copy(s, p, n);
+			s->remain -= n;
+			if (!ret && !s->remain && s->sparse) {
+				ret = fb_mmc_stream_flush(s);
+				fb_mmc_stream_next_chunk(s);
+			}
+		} else if (s->state == STREAM_DONE) {
+			s->err = "data after end of sparse image";
+			break;
+		} else {
+			n = min(len, s->hdr_need - s->hdr_len);
+			memcpy(s->hdr.bytes + s->hdr_len, p, n);
+			s->hdr_len += n;
+			if (s->hdr_len == s->hdr_need) {
+				ret = fb_mmc_stream_header(s);
+				s->hdr_len = 0;
+			}
+		}
+		if (ret)
+			break;
+		p += n;
+		len -= n;
+	}
+}
+
+/**
+ * fastboot_mmc_stream_finish() - Finish writing a streamed download
+ *
+ * @response: Pointer to fastboot response buffer, set on failure
+ * Return: 0 if OK, -EIO if the image could not be written
+ */
+int fastboot_mmc_stream_finish(char *response)
+{
+	struct fb_mmc_stream *s = &fb_mmc_stream;
+	u32 n;
+
+	if (!s->err && !s->sparse && s->buf_len % s->info.blksz) {
+		/* Pad the last block of a raw image */
+		n = s->info.blksz - s->buf_len % s->info.blksz;
+		memset(s->buf + s->buf_len, '\0', n);
+		s->buf_len += n;
+	}
+	if (!s->err)
+		fb_mmc_stream_flush(s);
+	if (!s->err && s->sparse &&
+	    (s->state != STREAM_DONE || s->blocks != s->total_blks))
+		s->err = "sparse image write failure";
+	s->state = STREAM_DONE;
+	if (s->err) {
+		pr_err("streaming to '%s' failed: %s\n", s->name, s->err);
+		fastboot_fail(s->err, response);
+		return -EIO;
+	}
+	printf("........ wrote %llu bytes to '%s'\n", s->written, s->name);
+
+	return 0;
+}
+
+/**
+ * fastboot_mmc_stream_flash() - Complete the "flash" of a streamed image
+ *
+ * @cmd: Named partition given to the "flash" command
+ * @response: Pointer to fastboot response buffer
+ * Return: true if the last download was streamed and this has dealt with
+ *	the command, false if the download buffer should be written as usual
+ */
+bool fastboot_mmc_stream_flash(const char *cmd, char *response)
+{
+	struct fb_mmc_stream *s = &fb_mmc_stream;
+	ulong time;
+
+	if (s->state != STREAM_DONE)
+		return false;
+	s->state = STREAM_IDLE;
+	if (!cmd || strcmp(cmd, s->name)) {
+		pr_err("image was streamed to '%s', not '%s'\n", s->name, cmd);
+		fastboot_fail("image was streamed to another partition",
+			      response);
+		return true;
+	}
+	if (s->err) {
+		fastboot_fail(s->err, response);
+		return true;
+	}
+
+	time = get_timer(s->start_time);
+	printf("........ streamed %llu bytes to '%s' in %lu ms", s->written,
+	       s->name, time);
+	if (time) {
+		puts(" (");
+		print_size(div_u64(s->written * 1000, time), "/s");
+		puts(")");
+	}
+	puts("\n");
+	fastboot_okay(NULL, response);
+
+	return true;
+}
+#endif
+
 /**
  * fastboot_mmc_flash_erase() - Erase eMMC for fastboot
  *
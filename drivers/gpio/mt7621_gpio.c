@@ -162,7 +162,7 @@ static int gpio_mediatek_bind(struct udevice *parent)
 		if (ret)
 			return ret;
 
-		dev->node = node;
+		dev_set_ofnode(dev, node);
 		bank++;
 	}
 
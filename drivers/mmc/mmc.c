@@ -709,6 +709,10 @@ static int mmc_send_op_cond(struct mmc *mmc)
 		if (mmc->ocr & OCR_BUSY)
 			break;
 
+		/* mmc_poll_init() sends the rest as it is called */
+		if (mmc->op_cond_nowait)
+			break;
+
 		if (get_timer(start) > timeout)
 			return -ETIMEDOUT;
 		udelay(100);
@@ -2906,6 +2910,39 @@ static int mmc_complete_init(struct mmc *mmc)
 	return err;
 }
 
+int mmc_poll_init(struct mmc *mmc)
+{
+	int err;
+#if CONFIG_IS_ENABLED(DM_MMC)
+	struct mmc_uclass_priv *upriv = dev_get_uclass_priv(mmc->dev);
+
+	upriv->mmc = mmc;
+#endif
+	if (mmc->has_init)
+		return 0;
+
+	if (!mmc->init_in_progress) {
+		mmc->op_cond_nowait = 1;
+		err = mmc_start_init(mmc);
+		mmc->op_cond_nowait = 0;
+		if (err)
+			return err;
+	}
+
+	/* Send one op-cond command each time until the card is ready */
+	if (mmc->op_cond_pending && !(mmc->ocr & OCR_BUSY)) {
+		err = mmc_send_op_cond_iter(mmc, 1);
+		if (err) {
+			mmc->init_in_progress = 0;
+			return err;
+		}
+		if (!(mmc->ocr & OCR_BUSY))
+			return -EAGAIN;
+	}
+
+	return mmc_complete_init(mmc);
+}
+
 int mmc_init(struct mmc *mmc)
 {
 	int err = 0;
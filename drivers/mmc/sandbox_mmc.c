@@ -11,21 +11,53 @@
 #include <log.h>
 #include <mmc.h>
 #include <asm/test.h>
+#include <linux/sizes.h>
+
+/* The CSD gives a high-capacity card with a C_SIZE of 0, which is 1MiB */
+#define MMC_CAPACITY	SZ_1M
+#define MMC_BLKSZ	512
 
 struct sandbox_mmc_plat {
 	struct mmc_config cfg;
 	struct mmc mmc;
 };
 
+/**
+ * struct sandbox_mmc_priv - Contents of the emulated card
+ *
+ * @buf: Data held by the card
+ * @erase_start: First block to erase, as set by SD_CMD_ERASE_WR_BLK_START
+ * @erase_end: Last block to erase, as set by SD_CMD_ERASE_WR_BLK_END
+ * @blocks_written: Number of blocks written since the card was probed
+ */
+struct sandbox_mmc_priv {
+	u8 buf[MMC_CAPACITY];
+	uint erase_start;
+	uint erase_end;
+	uint blocks_written;
+};
+
+/* Check that a transfer or erase falls within the card */
+static int sandbox_mmc_check(uint start, uint count)
+{
+	if (start >= MMC_CAPACITY / MMC_BLKSZ ||
+	    count > MMC_CAPACITY / MMC_BLKSZ - start)
+		return -EINVAL;
+
+	return 0;
+}
+
 /**
  * sandbox_mmc_send_cmd() - Emulate SD commands
  *
- * This emulate an SD card version 2. Single-block reads result in zero data.
- * Multiple-block reads return a test string.
+ * This emulate an SD card version 2, holding its data in memory. The card
+ * starts with a test string in its first block.
  */
 static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 				struct mmc_data *data)
 {
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
 	switch (cmd->cmdidx) {
 	case MMC_CMD_ALL_SEND_CID:
 		memset(cmd->response, '\0', sizeof(cmd->response));
@@ -59,10 +91,33 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		break;
 	}
 	case MMC_CMD_READ_SINGLE_BLOCK:
-		memset(data->dest, '\0', data->blocksize);
-		break;
 	case MMC_CMD_READ_MULTIPLE_BLOCK:
-		strcpy(data->dest, "this is a test");
+		if (sandbox_mmc_check(cmd->cmdarg, data->blocks))
+			return -EINVAL;
+		memcpy(data->dest, priv->buf + cmd->cmdarg * MMC_BLKSZ,
+		       data->blocks * MMC_BLKSZ);
+		break;
+	case MMC_CMD_WRITE_SINGLE_BLOCK:
+	case MMC_CMD_WRITE_MULTIPLE_BLOCK:
+		if (sandbox_mmc_check(cmd->cmdarg, data->blocks))
+			return -EINVAL;
+		memcpy(priv->buf + cmd->cmdarg * MMC_BLKSZ, data->src,
+		       data->blocks * MMC_BLKSZ);
+		priv->blocks_written += data->blocks;
+		break;
+	case SD_CMD_ERASE_WR_BLK_START:
+		priv->erase_start = cmd->cmdarg;
+		break;
+	case SD_CMD_ERASE_WR_BLK_END:
+		priv->erase_end = cmd->cmdarg;
+		break;
+	case MMC_CMD_ERASE:
+		if (priv->erase_end < priv->erase_start ||
+		    sandbox_mmc_check(priv->erase_start,
+				      priv->erase_end - priv->erase_start + 1))
+			return -EINVAL;
+		memset(priv->buf + priv->erase_start * MMC_BLKSZ, '\0',
+		       (priv->erase_end - priv->erase_start + 1) * MMC_BLKSZ);
 		break;
 	case MMC_CMD_STOP_TRANSMISSION:
 		break;
@@ -109,10 +164,20 @@ static const struct dm_mmc_ops sandbox_mmc_ops = {
 int sandbox_mmc_probe(struct udevice *dev)
 {
 	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	strcpy((char *)priv->buf, "this is a test");
 
 	return mmc_init(&plat->mmc);
 }
 
+uint sandbox_mmc_get_blocks_written(struct udevice *dev)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	return priv->blocks_written;
+}
+
 int sandbox_mmc_bind(struct udevice *dev)
 {
 	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
@@ -148,5 +213,6 @@ U_BOOT_DRIVER(mmc_sandbox) = {
 	.bind		= sandbox_mmc_bind,
 	.unbind		= sandbox_mmc_unbind,
 	.probe		= sandbox_mmc_probe,
+	.priv_auto_alloc_size = sizeof(struct sandbox_mmc_priv),
 	.platdata_auto_alloc_size = sizeof(struct sandbox_mmc_plat),
 };
@@ -161,6 +161,54 @@ int sandbox_eth_ping_req_to_reply(struct udevice *dev, void *packet,
 	return 0;
 }
 
+/*
+ * sandbox_eth_queue_udp()
+ *
+ * Queue a UDP packet from the fake host, leaving the payload to be filled in
+ *
+ * returns pointer to the payload, or NULL if there is no room
+ */
+void *sandbox_eth_queue_udp(struct udevice *dev, int pos, int sport,
+			    int dport, int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth_recv;
+	struct ip_udp_hdr *ipr;
+	int i;
+
+	/* Don't allow the buffer to overrun */
+	if (priv->recv_packets >= PKTBUFSRX ||
+	    ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + len > PKTSIZE)
+		return NULL;
+	if (pos < 0 || pos > priv->recv_packets)
+		pos = priv->recv_packets;
+
+	for (i = priv->recv_packets; i > pos; i--) {
+		memcpy(priv->recv_packet_buffer[i],
+		       priv->recv_packet_buffer[i - 1],
+		       priv->recv_packet_length[i - 1]);
+		priv->recv_packet_length[i] = priv->recv_packet_length[i - 1];
+	}
+
+	eth_recv = (void *)priv->recv_packet_buffer[pos];
+	memcpy(eth_recv->et_dest, net_ethaddr, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	net_set_ip_header((uchar *)ipr, net_ip, priv->fake_host_ipaddr,
+			  IP_UDP_HDR_SIZE + len, IPPROTO_UDP);
+	ipr->udp_src = htons(sport);
+	ipr->udp_dst = htons(dport);
+	ipr->udp_len = htons(UDP_HDR_SIZE + len);
+	ipr->udp_xsum = 0;
+
+	priv->recv_packet_length[pos] = ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + len;
+	++priv->recv_packets;
+
+	return (void *)ipr + IP_UDP_HDR_SIZE;
+}
+
 /*
  * sandbox_eth_recv_arp_req()
  *
@@ -299,6 +347,30 @@ void sandbox_eth_set_tx_handler(int index, sandbox_eth_tx_hand_f *handler)
 		priv->tx_handler = sb_default_handler;
 }
 
+/*
+ * sandbox_eth_set_start_handler()
+ *
+ * Set a function to queue received packets when the sandbox eth test driver
+ *	is started
+ *
+ * index - interface to set the handler for
+ * handler - The func ptr to call on start, or NULL for none
+ */
+void sandbox_eth_set_start_handler(int index,
+				   sandbox_eth_start_hand_f *handler)
+{
+	struct udevice *dev;
+	struct eth_sandbox_priv *priv;
+	int ret;
+
+	ret = uclass_get_device(UCLASS_ETH, index, &dev);
+	if (ret)
+		return;
+
+	priv = dev_get_priv(dev);
+	priv->start_handler = handler;
+}
+
 /*
  * Set priv ptr
  *
@@ -319,6 +391,29 @@ void sandbox_eth_set_priv(int index, void *priv)
 	dev_priv->priv = priv;
 }
 
+/*
+ * sandbox_eth_set_link()
+ *
+ * Set the link state reported by the device
+ *
+ * index - interface to set the link state of
+ * link - 1 if up, 0 if down, -ENOSYS to report that it cannot tell
+ */
+void sandbox_eth_set_link(int index, int link)
+{
+	struct udevice *dev;
+	struct eth_sandbox_priv *priv;
+	int ret;
+
+	ret = uclass_get_device(UCLASS_ETH, index, &dev);
+	if (ret)
+		return;
+
+	priv = dev_get_priv(dev);
+	priv->has_link = link >= 0;
+	priv->link_up = link > 0;
+}
+
 static int sb_eth_start(struct udevice *dev)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
@@ -331,6 +426,9 @@ static int sb_eth_start(struct udevice *dev)
 		priv->recv_packet_length[i] = 0;
 	}
 
+	if (priv->start_handler)
+		return priv->start_handler(dev);
+
 	return 0;
 }
 
@@ -357,10 +455,20 @@ static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 
 	if (priv->recv_packets) {
 		int lcl_recv_packet_length = priv->recv_packet_length[0];
+		uchar *lent;
 
 		debug("eth_sandbox: received packet[%d], %d waiting\n",
 		      lcl_recv_packet_length, priv->recv_packets - 1);
-		*packetp = priv->recv_packet_buffer[0];
+		/* Act like hardware which copies frames out of its own buffer */
+		lent = eth_rx_borrow(priv->recv_packet_buffer[0],
+				     lcl_recv_packet_length);
+		if (lent) {
+			memcpy(lent, priv->recv_packet_buffer[0],
+			       lcl_recv_packet_length);
+			*packetp = lent;
+		} else {
+			*packetp = priv->recv_packet_buffer[0];
+		}
 		return lcl_recv_packet_length;
 	}
 	return 0;
@@ -400,6 +508,16 @@ static int sb_eth_write_hwaddr(struct udevice *dev)
 	return 0;
 }
 
+static int sb_eth_get_link(struct udevice *dev)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+
+	if (!priv->has_link)
+		return -ENOSYS;
+
+	return priv->link_up;
+}
+
 static const struct eth_ops sb_eth_ops = {
 	.start			= sb_eth_start,
 	.send			= sb_eth_send,
@@ -407,6 +525,7 @@ static const struct eth_ops sb_eth_ops = {
 	.free_pkt		= sb_eth_free_pkt,
 	.stop			= sb_eth_stop,
 	.write_hwaddr		= sb_eth_write_hwaddr,
+	.get_link		= sb_eth_get_link,
 };
 
 static int sb_eth_remove(struct udevice *dev)
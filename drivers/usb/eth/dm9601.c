@@ -538,9 +538,21 @@ static int dm9601_eth_start(struct udevice *udev)
     return dm9601_init(dev);
 }
 
+static int dm9601_eth_get_link(struct udevice *udev)
+{
+    struct dm9601_private *priv = dev_get_priv(udev);
+    struct ueth_data *dev = &priv->ueth;
+
+    return !!(dm9601_mdio_read(dev, dev->phy_id, MII_BMSR) & BMSR_LSTATUS);
+}
+
 void dm9601_eth_stop(struct udevice *udev)
 {
+    struct dm9601_private *priv = dev_get_priv(udev);
+
 	debug("\n----> %s()\n", __func__);
+
+    usb_ether_rx_stop(&priv->ueth);
 }
 
 int dm9601_eth_send(struct udevice *udev, void *packet, int length)
@@ -591,14 +603,14 @@ int dm9601_eth_recv(struct udevice *udev, int flags, uchar **packetp)
     int len = 0;
     uint8_t status = 0;
     uint16_t packet_len = 0;
-    ALLOC_CACHE_ALIGN_BUFFER(unsigned char, pkt, PKTSIZE);
 
 	debug("\n----> %s()\n", __func__);
 
     len = usb_ether_get_rx_bytes(ueth, &ptr);
     debug("----> %s: first try, len=%d\n", __func__, len);
     if (!len) {
-        if (!(flags & ETH_RECV_CHECK_DEVICE))
+        /* Queued transfers can be collected without waiting */
+        if (!(flags & ETH_RECV_CHECK_DEVICE) && !ueth->rxqueue)
             return -EAGAIN;
         ret = usb_ether_receive(ueth, DM9601_RX_URB_SIZE);
         if (ret == -EAGAIN)
@@ -639,16 +651,20 @@ int dm9601_eth_recv(struct udevice *udev, int flags, uchar **packetp)
     }
 
     debug("---> packet_len = %d, len = %d\n", packet_len, len);
-    memcpy(pkt, ptr + 3, packet_len);   /* 3 bytes header */
-    memcpy(ptr, pkt, packet_len);       /* copy to dev->rxbuf */
 
     /*
      * MUST RETURN ALIGNED MEMORY, because checksum use LDRH !!!
-     * DO NOT return `ptr` allocated by ALLOC_CACHE_ALIGN_BUFFER,
-     * which expand to an array on stack.
-     * Here ptr --> dev->rxbuf (not array on stack).
+     * The frame follows a 3-byte header. Copy it straight to where
+     * the protocol wants it if it has lent memory for it, or else
+     * move it back over the header, within dev->rxbuf.
      */
-    *packetp = ptr;
+    *packetp = eth_rx_borrow(ptr + 3, packet_len);
+    if (*packetp) {
+        memcpy(*packetp, ptr + 3, packet_len);
+    } else {
+        memmove(ptr, ptr + 3, packet_len);  /* 3 bytes header */
+        *packetp = ptr;
+    }
     return packet_len;
 
 err:
@@ -722,6 +738,7 @@ static const struct eth_ops dm9601_eth_ops = {
     .free_pkt       = dm9601_free_pkt,
     .stop           = dm9601_eth_stop,
     .write_hwaddr   = dm9601_write_hwaddr,
+    .get_link       = dm9601_eth_get_link,
 };
 
 U_BOOT_DRIVER(dm9601_eth) = {
@@ -377,7 +377,11 @@ int lan7x_basic_reset(struct usb_device *udev,
 
 void lan7x_eth_stop(struct udevice *dev)
 {
+	struct lan7x_private *priv = dev_get_priv(dev);
+
 	debug("** %s()\n", __func__);
+
+	usb_ether_rx_stop(&priv->ueth);
 }
 
 int lan7x_eth_send(struct udevice *dev, void *packet, int length)
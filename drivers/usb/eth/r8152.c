@@ -1730,6 +1730,7 @@ void r8152_eth_stop(struct udevice *dev)
 
 	debug("** %s (%d)\n", __func__, __LINE__);
 
+	usb_ether_rx_stop(&tp->ueth);
 	tp->rtl_ops.disable(tp);
 }
 
@@ -947,7 +947,11 @@ static int smsc95xx_eth_start(struct udevice *dev)
 
 void smsc95xx_eth_stop(struct udevice *dev)
 {
+	struct smsc95xx_private *priv = dev_get_priv(dev);
+
 	debug("** %s()\n", __func__);
+
+	usb_ether_rx_stop(&priv->ueth);
 }
 
 int smsc95xx_eth_send(struct udevice *dev, void *packet, int length)
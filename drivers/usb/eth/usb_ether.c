@@ -19,6 +19,15 @@
 
 #define USB_BULK_RECV_TIMEOUT 500
 
+#ifdef CONFIG_USB_ETHER_RX_QUEUE
+#define USB_ETHER_RX_QUEUE	CONFIG_USB_ETHER_RX_QUEUE
+#else
+#define USB_ETHER_RX_QUEUE	1
+#endif
+
+/* Receive buffers are kept in one block, each starting cache-aligned */
+#define USB_ETHER_RX_STRIDE(ueth)	ALIGN((ueth)->rxsize, ARCH_DMA_MINALIGN)
+
 int usb_ether_register(struct udevice *dev, struct ueth_data *ueth, int rxsize)
 {
 	struct usb_device *udev = dev_get_parent_priv(dev);
@@ -75,9 +84,11 @@ int usb_ether_register(struct udevice *dev, struct ueth_data *ueth, int rxsize)
 	}
 
 	ueth->rxsize = rxsize;
-	ueth->rxbuf = memalign(ARCH_DMA_MINALIGN, rxsize);
-	if (!ueth->rxbuf)
+	ueth->rxbufs = memalign(ARCH_DMA_MINALIGN,
+				USB_ETHER_RX_STRIDE(ueth) * USB_ETHER_RX_QUEUE);
+	if (!ueth->rxbufs)
 		return -ENOMEM;
+	ueth->rxbuf = ueth->rxbufs;
 
 	ret = usb_set_interface(udev, iface_desc->bInterfaceNumber, ifnum);
 	if (ret) {
@@ -92,6 +103,72 @@ int usb_ether_register(struct udevice *dev, struct ueth_data *ueth, int rxsize)
 
 int usb_ether_deregister(struct ueth_data *ueth)
 {
+	usb_ether_rx_stop(ueth);
+
+	return 0;
+}
+
+void usb_ether_rx_stop(struct ueth_data *ueth)
+{
+	if (!ueth->rxqueue)
+		return;
+
+	destroy_bulk_queue(ueth->pusb_dev, ueth->rxqueue);
+	ueth->rxqueue = NULL;
+	ueth->rxbuf = ueth->rxbufs;
+	ueth->rxlen = 0;
+}
+
+/* Queue a bulk-in transfer into each receive buffer */
+static int usb_ether_rx_start(struct ueth_data *ueth, int rxsize)
+{
+	struct usb_device *udev = ueth->pusb_dev;
+	int ret, i;
+
+	ueth->rxqueue = create_bulk_queue(udev,
+					  usb_rcvbulkpipe(udev, ueth->ep_in),
+					  USB_ETHER_RX_QUEUE, rxsize);
+	if (!ueth->rxqueue)
+		return -ENOSYS;
+	ueth->rxqsize = rxsize;
+
+	for (i = 0; i < USB_ETHER_RX_QUEUE; i++) {
+		ret = submit_bulk_queue(udev, ueth->rxqueue,
+					ueth->rxbufs + i * USB_ETHER_RX_STRIDE(ueth),
+					rxsize);
+		if (ret) {
+			usb_ether_rx_stop(ueth);
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+/* Collect the oldest queued transfer, without waiting for it */
+static int usb_ether_rx_poll(struct ueth_data *ueth)
+{
+	void *buf;
+	int ret;
+
+	ret = poll_bulk_queue(ueth->pusb_dev, ueth->rxqueue, &buf);
+	if (ret == -EAGAIN)
+		return ret;
+	debug("Rx: len = %d, actual = %d\n", ueth->rxqsize, ret);
+	if (ret < 0) {
+		printf("Rx: failed to receive: %d\n", ret);
+		usb_ether_rx_stop(ueth);
+		return ret;
+	}
+	if (!ret) {
+		submit_bulk_queue(ueth->pusb_dev, ueth->rxqueue, buf,
+				  ueth->rxqsize);
+		return -EAGAIN;
+	}
+	ueth->rxbuf = buf;
+	ueth->rxlen = ret;
+	ueth->rxptr = 0;
+
 	return 0;
 }
 
@@ -102,6 +179,20 @@ int usb_ether_receive(struct ueth_data *ueth, int rxsize)
 
 	if (rxsize > ueth->rxsize)
 		return -EINVAL;
+	if (USB_ETHER_RX_QUEUE > 1 && !ueth->rxnoqueue) {
+		if (!ueth->rxqueue) {
+			ret = usb_ether_rx_start(ueth, rxsize);
+			if (ret == -ENOSYS || ret == -EINVAL) {
+				debug("Rx: cannot queue transfers: %d\n", ret);
+				ueth->rxnoqueue = true;
+			} else if (ret) {
+				return ret;
+			}
+		}
+		if (ueth->rxqueue)
+			return usb_ether_rx_poll(ueth);
+	}
+
 	ret = usb_bulk_msg(ueth->pusb_dev,
 			   usb_rcvbulkpipe(ueth->pusb_dev, ueth->ep_in),
 			   ueth->rxbuf, rxsize, &actual_len,
@@ -123,9 +214,20 @@ int usb_ether_receive(struct ueth_data *ueth, int rxsize)
 
 void usb_ether_advance_rxbuf(struct ueth_data *ueth, int num_bytes)
 {
+	int ret;
+
 	ueth->rxptr += num_bytes;
-	if (num_bytes < 0 || ueth->rxptr >= ueth->rxlen)
+	if (num_bytes < 0 || ueth->rxptr >= ueth->rxlen) {
+		/* Hand a used buffer back to the controller */
+		if (ueth->rxqueue && ueth->rxlen) {
+			ret = submit_bulk_queue(ueth->pusb_dev, ueth->rxqueue,
+						ueth->rxbuf, ueth->rxqsize);
+			if (ret)
+				debug("Rx: failed to queue transfer: %d\n",
+				      ret);
+		}
 		ueth->rxlen = 0;
+	}
 }
 
 int usb_ether_get_rx_bytes(struct ueth_data *ueth, uint8_t **ptrp)
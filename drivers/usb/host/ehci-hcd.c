@@ -327,7 +327,7 @@ static int ehci_disable_async(struct ehci_ctrl *ctrl)
 	u32 cmd;
 	int ret;
 
-	if (ctrl->async_locked)
+	if (ctrl->async_locked || ctrl->bulk_queues)
 		return 0;
 
 	/* Disable async schedule. */
@@ -346,6 +346,60 @@ static int ehci_disable_async(struct ehci_ctrl *ctrl)
 	return ret;
 }
 
+/*
+ * Wait until the controller holds no pointer to a QH which has just been
+ * unlinked from the asynchronous schedule, so that it can be freed (4.8.2 in
+ * ehci-r10.pdf). This is only needed while the schedule stays enabled.
+ */
+static int ehci_async_doorbell(struct ehci_ctrl *ctrl)
+{
+	u32 cmd;
+	int ret;
+
+	cmd = ehci_readl(&ctrl->hcor->or_usbcmd);
+	if (!(cmd & CMD_ASE))
+		return 0;
+
+	ehci_writel(&ctrl->hcor->or_usbcmd, cmd | CMD_IAAD);
+	ret = handshake((uint32_t *)&ctrl->hcor->or_usbsts, STS_IAA, STS_IAA,
+			100 * 1000);
+	if (ret < 0)
+		printf("EHCI fail timeout STS_IAA set\n");
+	ehci_writel(&ctrl->hcor->or_usbsts, STS_IAA);
+
+	return ret;
+}
+
+/*
+ * Setup QH (3.6 in ehci-r10.pdf)
+ *
+ *   qh_endpt1 ............... 07-04 H
+ *   qh_endpt2 ............... 0B-08 H
+ */
+static void ehci_setup_qh(struct ehci_ctrl *ctrl, struct usb_device *dev,
+			  unsigned long pipe, struct QH *qh, int dtc)
+{
+	uint32_t endpt, c;
+
+	c = (dev->speed != USB_SPEED_HIGH) && !usb_pipeendpoint(pipe);
+	endpt = QH_ENDPT1_RL(8) | QH_ENDPT1_C(c) |
+		QH_ENDPT1_MAXPKTLEN(usb_maxpacket(dev, pipe)) | QH_ENDPT1_H(0) |
+		QH_ENDPT1_DTC(dtc) |
+		QH_ENDPT1_ENDPT(usb_pipeendpoint(pipe)) | QH_ENDPT1_I(0) |
+		QH_ENDPT1_DEVADDR(usb_pipedevice(pipe));
+
+	/* Force FS for fsl HS quirk */
+	if (!ctrl->has_fsl_erratum_a005275)
+		endpt |= QH_ENDPT1_EPS(ehci_encode_speed(dev->speed));
+	else
+		endpt |= QH_ENDPT1_EPS(ehci_encode_speed(QH_FULL_SPEED));
+
+	qh->qh_endpt1 = cpu_to_hc32(endpt);
+	endpt = QH_ENDPT2_MULT(1) | QH_ENDPT2_UFCMASK(0) | QH_ENDPT2_UFSMASK(0);
+	qh->qh_endpt2 = cpu_to_hc32(endpt);
+	ehci_update_endpt2_dev_n_port(dev, qh);
+}
+
 static int
 ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		   int length, struct devrequest *req)
@@ -357,8 +411,8 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	volatile struct qTD *vtd;
 	unsigned long ts;
 	uint32_t *tdp;
-	uint32_t endpt, maxpacket, token, usbsts, qhtoken;
-	uint32_t c, toggle;
+	uint32_t maxpacket, token, usbsts, qhtoken;
+	uint32_t toggle;
 	int timeout;
 	int ret = 0;
 	struct ehci_ctrl *ctrl = ehci_get_ctrl(dev);
@@ -451,26 +505,12 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	 * - qh_curtd
 	 *   qh_overlay.qt_next ...... 13-10 H
 	 * - qh_overlay.qt_altnext
+	 *
+	 * Any bulk queues stay in the schedule, after this QH.
 	 */
-	qh->qh_link = cpu_to_hc32(virt_to_phys(&ctrl->qh_list) | QH_LINK_TYPE_QH);
-	c = (dev->speed != USB_SPEED_HIGH) && !usb_pipeendpoint(pipe);
+	qh->qh_link = ctrl->qh_list.qh_link;
 	maxpacket = usb_maxpacket(dev, pipe);
-	endpt = QH_ENDPT1_RL(8) | QH_ENDPT1_C(c) |
-		QH_ENDPT1_MAXPKTLEN(maxpacket) | QH_ENDPT1_H(0) |
-		QH_ENDPT1_DTC(QH_ENDPT1_DTC_DT_FROM_QTD) |
-		QH_ENDPT1_ENDPT(usb_pipeendpoint(pipe)) | QH_ENDPT1_I(0) |
-		QH_ENDPT1_DEVADDR(usb_pipedevice(pipe));
-
-	/* Force FS for fsl HS quirk */
-	if (!ctrl->has_fsl_erratum_a005275)
-		endpt |= QH_ENDPT1_EPS(ehci_encode_speed(dev->speed));
-	else
-		endpt |= QH_ENDPT1_EPS(ehci_encode_speed(QH_FULL_SPEED));
-
-	qh->qh_endpt1 = cpu_to_hc32(endpt);
-	endpt = QH_ENDPT2_MULT(1) | QH_ENDPT2_UFCMASK(0) | QH_ENDPT2_UFSMASK(0);
-	qh->qh_endpt2 = cpu_to_hc32(endpt);
-	ehci_update_endpt2_dev_n_port(dev, qh);
+	ehci_setup_qh(ctrl, dev, pipe, qh, QH_ENDPT1_DTC_DT_FROM_QTD);
 	qh->qh_overlay.qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
 	qh->qh_overlay.qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
 
@@ -627,9 +667,11 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	} while (get_timer(ts) < timeout);
 	qhtoken = hc32_to_cpu(qh->qh_overlay.qt_token);
 
-	ctrl->qh_list.qh_link = cpu_to_hc32(virt_to_phys(&ctrl->qh_list) | QH_LINK_TYPE_QH);
+	ctrl->qh_list.qh_link = qh->qh_link;
 	flush_dcache_range((unsigned long)&ctrl->qh_list,
 		ALIGN_END_ADDR(struct QH, &ctrl->qh_list, 1));
+	if (ctrl->bulk_queues)
+		ehci_async_doorbell(ctrl);
 
 	/*
 	 * Invalidate the memory area occupied by buffer
@@ -1656,6 +1698,296 @@ static int ehci_destroy_int_queue(struct udevice *dev, struct usb_device *udev,
 	return _ehci_destroy_int_queue(udev, queue);
 }
 
+/*
+ * A bulk queue is a QH which stays in the asynchronous schedule, with a ring of
+ * qTDs. The controller stops at the first qTD which is not active, so a
+ * transfer is queued by filling in the qTDs after the last one queued and then
+ * activating them. A transfer longer than one qTD can hold uses several of
+ * them, split as in ehci_submit_async(). The data toggle is kept in the QH,
+ * since the qTDs do not know about each other's transfer lengths.
+ *
+ * A short packet ends a transfer early: the alternate next pointer of each
+ * of its qTDs except the last points to the first qTD of the next transfer,
+ * and the qTDs skipped over are cleared when the transfer is collected.
+ */
+struct bulk_queue_td {
+	void *buffer;	/* buffer of the transfer starting at this qTD */
+	int ntds;	/* number of qTDs in that transfer */
+	int length;	/* number of bytes in this qTD */
+};
+
+struct bulk_queue {
+	unsigned long pipe;
+	int queuesize;		/* maximum number of transfers in the queue */
+	int xfers;		/* number of transfers in the queue */
+	int maxlen;
+	int ntds;		/* number of qTDs in the ring */
+	int head;		/* first qTD of the oldest transfer */
+	int count;		/* number of qTDs in use */
+	bool halted;
+	struct QH *qh;
+	struct qTD *tds;
+	struct bulk_queue_td *info;
+};
+
+/* Get the maximum number of qTDs needed for a transfer of @length bytes */
+static int ehci_bulk_queue_tds(int length)
+{
+	/* Any buffer alignment leaves at least this many bytes per qTD */
+	int xfr_sz = (QT_BUFFER_CNT - 1) * EHCI_PAGE_SIZE;
+
+	return max(1, DIV_ROUND_UP(length, xfr_sz));
+}
+
+static int ehci_destroy_bulk_queue(struct udevice *dev,
+				   struct usb_device *udev,
+				   struct bulk_queue *queue);
+
+static struct bulk_queue *ehci_create_bulk_queue(struct udevice *dev,
+		struct usb_device *udev, unsigned long pipe, int queuesize,
+		int maxlen)
+{
+	struct ehci_ctrl *ctrl = ehci_get_ctrl(udev);
+	struct bulk_queue *queue;
+	struct QH *qh;
+	uint32_t toggle;
+	int ntds, i;
+
+	debug("%s: dev='%s', udev=%p\n", __func__, dev->name, udev);
+	if (usb_pipetype(pipe) != PIPE_BULK || queuesize < 1 || maxlen < 0)
+		return NULL;
+	/* Transfers split into several qTDs rely on this, as above */
+	if (PKT_ALIGN % usb_maxpacket(udev, pipe))
+		return NULL;
+
+	ntds = queuesize * ehci_bulk_queue_tds(maxlen);
+	queue = calloc(1, sizeof(*queue));
+	if (!queue)
+		return NULL;
+	queue->pipe = pipe;
+	queue->queuesize = queuesize;
+	queue->maxlen = maxlen;
+	queue->ntds = ntds;
+	queue->info = calloc(ntds, sizeof(*queue->info));
+	queue->qh = memalign(USB_DMA_MINALIGN, sizeof(struct QH));
+	queue->tds = memalign(USB_DMA_MINALIGN, ntds * sizeof(struct qTD));
+	if (!queue->info || !queue->qh || !queue->tds) {
+		printf("unable to allocate bulk queue\n");
+		goto fail;
+	}
+
+	memset(queue->tds, 0, ntds * sizeof(struct qTD));
+	for (i = 0; i < ntds; i++) {
+		struct qTD *td = &queue->tds[i];
+
+		td->qt_next = cpu_to_hc32(virt_to_phys(
+					&queue->tds[(i + 1) % ntds]));
+		td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+	}
+	flush_dcache_range((unsigned long)queue->tds,
+			   ALIGN_END_ADDR(struct qTD, queue->tds, ntds));
+
+	qh = queue->qh;
+	memset(qh, 0, sizeof(struct QH));
+	ehci_setup_qh(ctrl, udev, pipe, qh, QH_ENDPT1_DTC_IGNORE_QTD_TD);
+	qh->qh_overlay.qt_next = cpu_to_hc32(virt_to_phys(queue->tds));
+	qh->qh_overlay.qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+	toggle = usb_gettoggle(udev, usb_pipeendpoint(pipe), usb_pipeout(pipe));
+	qh->qh_overlay.qt_token = cpu_to_hc32(QT_TOKEN_DT(toggle));
+
+	/* Link the QH in just after the head of the schedule */
+	qh->qh_link = ctrl->qh_list.qh_link;
+	flush_dcache_range((unsigned long)qh, ALIGN_END_ADDR(struct QH, qh, 1));
+	ctrl->qh_list.qh_link = cpu_to_hc32(virt_to_phys(qh) | QH_LINK_TYPE_QH);
+	flush_dcache_range((unsigned long)&ctrl->qh_list,
+			   ALIGN_END_ADDR(struct QH, &ctrl->qh_list, 1));
+	ctrl->bulk_queues++;
+
+	if (ehci_enable_async(ctrl)) {
+		ehci_destroy_bulk_queue(dev, udev, queue);
+		return NULL;
+	}
+
+	return queue;
+
+fail:
+	free(queue->tds);
+	free(queue->qh);
+	free(queue->info);
+	free(queue);
+
+	return NULL;
+}
+
+static int ehci_submit_bulk_queue(struct udevice *dev, struct usb_device *udev,
+				  struct bulk_queue *queue, void *buffer,
+				  int length)
+{
+	unsigned long pipe = queue->pipe;
+	uint8_t *buf_ptr = buffer;
+	int left_length = length;
+	int first, idx, ntds;
+	uint32_t token, altnext;
+	struct qTD *td;
+
+	if (queue->halted)
+		return -EIO;
+	if (length > queue->maxlen)
+		return -EINVAL;
+	if (queue->xfers == queue->queuesize)
+		return -ENOSPC;
+
+	/* Work out the qTD transfer sizes as ehci_submit_async() does */
+	first = (queue->head + queue->count) % queue->ntds;
+	ntds = 0;
+	do {
+		int xfr_bytes = QT_BUFFER_CNT * EHCI_PAGE_SIZE;
+
+		xfr_bytes -= (unsigned long)buf_ptr & (EHCI_PAGE_SIZE - 1);
+		xfr_bytes &= ~(PKT_ALIGN - 1);
+		xfr_bytes = min(xfr_bytes, left_length);
+
+		idx = (first + ntds++) % queue->ntds;
+		if (ehci_td_buffer(&queue->tds[idx], buf_ptr, xfr_bytes))
+			return -EINVAL;
+		queue->info[idx].length = xfr_bytes;
+		buf_ptr += xfr_bytes;
+		left_length -= xfr_bytes;
+	} while (left_length > 0);
+
+	/*
+	 * Fill in the qTDs before activating them, since the controller may be
+	 * looking at the first one already. Activate that one last.
+	 */
+	altnext = cpu_to_hc32(virt_to_phys(
+			&queue->tds[(first + ntds) % queue->ntds]));
+	token = QT_TOKEN_DT(0) | QT_TOKEN_IOC(0) | QT_TOKEN_CPAGE(0) |
+		QT_TOKEN_CERR(3) |
+		QT_TOKEN_PID(usb_pipein(pipe) ?
+			QT_TOKEN_PID_IN : QT_TOKEN_PID_OUT);
+	for (idx = ntds - 1; idx >= 0; idx--) {
+		int i = (first + idx) % queue->ntds;
+
+		td = &queue->tds[i];
+		td->qt_altnext = idx == ntds - 1 ?
+			cpu_to_hc32(QT_NEXT_TERMINATE) : altnext;
+		td->qt_token = cpu_to_hc32(token |
+				QT_TOKEN_TOTALBYTES(queue->info[i].length));
+		flush_dcache_range((unsigned long)td,
+				   ALIGN_END_ADDR(struct qTD, td, 1));
+		td->qt_token |= cpu_to_hc32(
+				QT_TOKEN_STATUS(QT_TOKEN_STATUS_ACTIVE));
+		flush_dcache_range((unsigned long)td,
+				   ALIGN_END_ADDR(struct qTD, td, 1));
+	}
+
+	queue->info[first].buffer = buffer;
+	queue->info[first].ntds = ntds;
+	queue->count += ntds;
+	queue->xfers++;
+
+	return 0;
+}
+
+static int ehci_poll_bulk_queue(struct udevice *dev, struct usb_device *udev,
+				struct bulk_queue *queue, void **bufferp)
+{
+	struct bulk_queue_td *info = &queue->info[queue->head];
+	int length = 0, actual = 0;
+	bool done = false;
+	unsigned long addr;
+	uint32_t token;
+	int i, idx;
+
+	if (!queue->xfers)
+		return -ENOENT;
+	if (queue->halted)
+		return -EIO;
+
+	for (i = 0; i < info->ntds; i++) {
+		struct qTD *td;
+
+		idx = (queue->head + i) % queue->ntds;
+		td = &queue->tds[idx];
+		length += queue->info[idx].length;
+		if (done) {
+			/* Skipped after a short packet */
+			td->qt_token = 0;
+			flush_dcache_range((unsigned long)td,
+					   ALIGN_END_ADDR(struct qTD, td, 1));
+			continue;
+		}
+
+		invalidate_dcache_range((unsigned long)td,
+					ALIGN_END_ADDR(struct qTD, td, 1));
+		token = hc32_to_cpu(td->qt_token);
+		if (QT_TOKEN_GET_STATUS(token) & QT_TOKEN_STATUS_ACTIVE)
+			return -EAGAIN;
+		if (QT_TOKEN_GET_STATUS(token) &
+		    ~(QT_TOKEN_STATUS_SPLITXSTATE | QT_TOKEN_STATUS_PERR)) {
+			debug("%s: TOKEN=%#x\n", __func__, token);
+			queue->halted = true;
+			return -EIO;
+		}
+		actual += queue->info[idx].length -
+			QT_TOKEN_GET_TOTALBYTES(token);
+		if (QT_TOKEN_GET_TOTALBYTES(token))
+			done = true;
+	}
+
+	*bufferp = info->buffer;
+	queue->head = (queue->head + info->ntds) % queue->ntds;
+	queue->count -= info->ntds;
+	queue->xfers--;
+
+	addr = (unsigned long)*bufferp;
+	if (usb_pipein(queue->pipe) && length)
+		invalidate_dcache_range(addr,
+					ALIGN(addr + length, ARCH_DMA_MINALIGN));
+
+	return actual;
+}
+
+static int ehci_destroy_bulk_queue(struct udevice *dev,
+				   struct usb_device *udev,
+				   struct bulk_queue *queue)
+{
+	struct ehci_ctrl *ctrl = ehci_get_ctrl(udev);
+	unsigned long pipe = queue->pipe;
+	struct QH *cur = &ctrl->qh_list;
+	uint32_t token;
+	int ret;
+
+	debug("%s: dev='%s', udev=%p\n", __func__, dev->name, udev);
+	while (NEXT_QH(cur) != &ctrl->qh_list) {
+		if (NEXT_QH(cur) == queue->qh) {
+			cur->qh_link = queue->qh->qh_link;
+			flush_dcache_range((unsigned long)cur,
+					   ALIGN_END_ADDR(struct QH, cur, 1));
+			break;
+		}
+		cur = NEXT_QH(cur);
+	}
+	ctrl->bulk_queues--;
+
+	ret = ehci_async_doorbell(ctrl);
+	if (!ret)
+		ret = ehci_disable_async(ctrl);
+
+	invalidate_dcache_range((unsigned long)queue->qh,
+				ALIGN_END_ADDR(struct QH, queue->qh, 1));
+	token = hc32_to_cpu(queue->qh->qh_overlay.qt_token);
+	usb_settoggle(udev, usb_pipeendpoint(pipe), usb_pipeout(pipe),
+		      QT_TOKEN_GET_DT(token));
+
+	free(queue->tds);
+	free(queue->qh);
+	free(queue->info);
+	free(queue);
+
+	return ret;
+}
+
 static int ehci_get_max_xfer_size(struct udevice *dev, size_t *size)
 {
 	/*
@@ -1739,6 +2071,10 @@ struct dm_usb_ops ehci_usb_ops = {
 	.create_int_queue = ehci_create_int_queue,
 	.poll_int_queue = ehci_poll_int_queue,
 	.destroy_int_queue = ehci_destroy_int_queue,
+	.create_bulk_queue = ehci_create_bulk_queue,
+	.submit_bulk_queue = ehci_submit_bulk_queue,
+	.poll_bulk_queue = ehci_poll_bulk_queue,
+	.destroy_bulk_queue = ehci_destroy_bulk_queue,
 	.get_max_xfer_size  = ehci_get_max_xfer_size,
 	.lock_async = ehci_lock_async,
 };
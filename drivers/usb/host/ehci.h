@@ -44,6 +44,7 @@ struct ehci_hcor {
 #define STS_ASS		(1 << 15)
 #define	STS_PSS		(1 << 14)
 #define STS_HALT	(1 << 12)
+#define STS_IAA		(1 << 5)		/* interrupted on async advance */
 	uint32_t or_usbintr;
 #define INTR_UE         (1 << 0)                /* USB interrupt enable */
 #define INTR_UEE        (1 << 1)                /* USB error interrupt enable */
@@ -253,6 +254,7 @@ struct ehci_ctrl {
 	struct QH periodic_queue __aligned(USB_DMA_MINALIGN);
 	uint32_t *periodic_list;
 	int periodic_schedules;
+	int bulk_queues;	/* number of bulk queues in the async schedule */
 	int ntds;
 	bool has_fsl_erratum_a005275;	/* Freescale HS silicon quirk */
 	bool async_locked;
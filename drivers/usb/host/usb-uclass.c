@@ -126,6 +126,54 @@ int destroy_int_queue(struct usb_device *udev, struct int_queue *queue)
 	return ops->destroy_int_queue(bus, udev, queue);
 }
 
+struct bulk_queue *create_bulk_queue(struct usb_device *udev,
+				     unsigned long pipe, int queuesize,
+				     int maxlen)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+
+	if (!ops->create_bulk_queue)
+		return NULL;
+
+	return ops->create_bulk_queue(bus, udev, pipe, queuesize, maxlen);
+}
+
+int submit_bulk_queue(struct usb_device *udev, struct bulk_queue *queue,
+		      void *buffer, int length)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+
+	if (!ops->submit_bulk_queue)
+		return -ENOSYS;
+
+	return ops->submit_bulk_queue(bus, udev, queue, buffer, length);
+}
+
+int poll_bulk_queue(struct usb_device *udev, struct bulk_queue *queue,
+		    void **bufferp)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+
+	if (!ops->poll_bulk_queue)
+		return -ENOSYS;
+
+	return ops->poll_bulk_queue(bus, udev, queue, bufferp);
+}
+
+int destroy_bulk_queue(struct usb_device *udev, struct bulk_queue *queue)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+
+	if (!ops->destroy_bulk_queue)
+		return -ENOSYS;
+
+	return ops->destroy_bulk_queue(bus, udev, queue);
+}
+
 int usb_alloc_device(struct usb_device *udev)
 {
 	struct udevice *bus = udev->controller_dev;
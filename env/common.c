@@ -13,6 +13,8 @@
 #include <env.h>
 #include <env_internal.h>
 #include <log.h>
+#include <malloc_arena.h>
+#include <memprof.h>
 #include <sort.h>
 #include <linux/stddef.h>
 #include <search.h>
@@ -113,6 +115,8 @@ int env_set_default_vars(int nvars, char * const vars[], int flags)
 int env_import(const char *buf, int check, int flags)
 {
 	env_t *ep = (env_t *)buf;
+	ulong mark;
+	int ret;
 
 	if (check) {
 		uint32_t crc;
@@ -125,8 +129,16 @@ int env_import(const char *buf, int check, int flags)
 		}
 	}
 
-	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', flags, 0,
-			0, NULL)) {
+	/* himport_r() only needs its copy of the data while it parses */
+	mark = arena_push();
+	if (IS_ENABLED(CONFIG_ENV_BINARY) && env_is_binary(ep->data))
+		ret = himport_bin_r(&env_htab, (char *)ep->data, ENV_SIZE,
+				    flags);
+	else
+		ret = himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0',
+				flags, 0, 0, NULL);
+	arena_pop(mark);
+	if (ret) {
 		gd->flags |= GD_FLG_ENV_READY;
 		return 0;
 	}
@@ -234,7 +246,10 @@ int env_export(env_t *env_out)
 	ssize_t	len;
 
 	res = (char *)env_out->data;
-	len = hexport_r(&env_htab, '\0', 0, &res, ENV_SIZE, 0, NULL);
+	if (IS_ENABLED(CONFIG_ENV_BINARY))
+		len = hexport_bin_r(&env_htab, res, ENV_SIZE);
+	else
+		len = hexport_r(&env_htab, '\0', 0, &res, ENV_SIZE, 0, NULL);
 	if (len < 0) {
 		pr_err("Cannot export environment: errno = %d\n", errno);
 		return 1;
@@ -251,6 +266,8 @@ int env_export(env_t *env_out)
 
 void env_relocate(void)
 {
+	const char *prev = memprof_push("env");
+
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
 	env_reloc();
 	env_fix_drivers();
@@ -267,6 +284,7 @@ void env_relocate(void)
 	} else {
 		env_load();
 	}
+	memprof_pop(prev);
 }
 
 #ifdef CONFIG_AUTO_COMPLETE
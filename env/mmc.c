@@ -11,6 +11,7 @@
 #include <env.h>
 #include <env_internal.h>
 #include <fdtdec.h>
+#include <log.h>
 #include <linux/stddef.h>
 #include <malloc.h>
 #include <memalign.h>
@@ -170,6 +171,20 @@ static void fini_mmc_for_env(struct mmc *mmc)
 #endif
 }
 
+static inline int read_env(struct mmc *mmc, unsigned long size,
+			   unsigned long offset, const void *buffer)
+{
+	uint blk_start, blk_cnt, n;
+	struct blk_desc *desc = mmc_get_blk_desc(mmc);
+
+	blk_start	= ALIGN(offset, mmc->read_bl_len) / mmc->read_bl_len;
+	blk_cnt		= ALIGN(size, mmc->read_bl_len) / mmc->read_bl_len;
+
+	n = blk_dread(desc, blk_start, blk_cnt, (uchar *)buffer);
+
+	return (n == blk_cnt) ? 0 : -1;
+}
+
 #if defined(CONFIG_CMD_SAVEENV) && !defined(CONFIG_SPL_BUILD)
 static inline int write_env(struct mmc *mmc, unsigned long size,
 			    unsigned long offset, const void *buffer)
@@ -185,6 +200,65 @@ static inline int write_env(struct mmc *mmc, unsigned long size,
 	return (n == blk_cnt) ? 0 : -1;
 }
 
+#ifdef CONFIG_ENV_MMC_DELTA_SAVE
+/*
+ * Write only the blocks which differ from what the copy holds. The copy is
+ * read back first, since 'mmc write', fastboot or 'gpt write' may have
+ * changed it since it was loaded or saved. If it cannot be read, write the
+ * whole environment.
+ */
+static int write_env_delta(struct mmc *mmc, unsigned long offset,
+			   const void *buffer)
+{
+	struct blk_desc *desc = mmc_get_blk_desc(mmc);
+	uint bl_len = mmc->write_bl_len;
+	uint blk_start, blk_cnt, start, end, n;
+	const u_char *buf = buffer;
+	u_char *old;
+	int ret = 0;
+
+	if (CONFIG_ENV_SIZE % bl_len)
+		return write_env(mmc, CONFIG_ENV_SIZE, offset, buffer);
+	old = malloc_cache_aligned(CONFIG_ENV_SIZE);
+	if (!old || read_env(mmc, CONFIG_ENV_SIZE, offset, old)) {
+		free(old);
+		return write_env(mmc, CONFIG_ENV_SIZE, offset, buffer);
+	}
+
+	blk_start	= ALIGN(offset, bl_len) / bl_len;
+	blk_cnt		= CONFIG_ENV_SIZE / bl_len;
+
+	for (start = 0; start < blk_cnt; start = end) {
+		if (!memcmp(buf + start * bl_len, old + start * bl_len,
+			    bl_len)) {
+			end = start + 1;
+			continue;
+		}
+		for (end = start + 1; end < blk_cnt; end++) {
+			if (!memcmp(buf + end * bl_len, old + end * bl_len,
+				    bl_len))
+				break;
+		}
+		debug("%s: writing blocks %u-%u\n", __func__, start, end - 1);
+		n = blk_dwrite(desc, blk_start + start, end - start,
+			       buf + start * bl_len);
+		if (n != end - start) {
+			ret = -1;
+			break;
+		}
+	}
+	free(old);
+
+	return ret;
+}
+#else
+static inline int write_env_delta(struct mmc *mmc, unsigned long offset,
+				  const void *buffer)
+{
+	return write_env(mmc, CONFIG_ENV_SIZE, offset, buffer);
+}
+#endif
+
 static int env_mmc_save(void)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(env_t, env_new, 1);
@@ -215,7 +289,7 @@ static int env_mmc_save(void)
 	}
 
 	printf("Writing to %sMMC(%d)... ", copy ? "redundant " : "", dev);
-	if (write_env(mmc, CONFIG_ENV_SIZE, offset, (u_char *)env_new)) {
+	if (write_env_delta(mmc, offset, env_new)) {
 		puts("failed\n");
 		ret = 1;
 		goto fini;
@@ -281,20 +355,6 @@ static int env_mmc_erase(void)
 #endif /* CONFIG_CMD_ERASEENV */
 #endif /* CONFIG_CMD_SAVEENV && !CONFIG_SPL_BUILD */
 
-static inline int read_env(struct mmc *mmc, unsigned long size,
-			   unsigned long offset, const void *buffer)
-{
-	uint blk_start, blk_cnt, n;
-	struct blk_desc *desc = mmc_get_blk_desc(mmc);
-
-	blk_start	= ALIGN(offset, mmc->read_bl_len) / mmc->read_bl_len;
-	blk_cnt		= ALIGN(size, mmc->read_bl_len) / mmc->read_bl_len;
-
-	n = blk_dread(desc, blk_start, blk_cnt, (uchar *)buffer);
-
-	return (n == blk_cnt) ? 0 : -1;
-}
-
 #ifdef CONFIG_ENV_OFFSET_REDUND
 static int env_mmc_load(void)
 {
@@ -27,6 +27,7 @@
 #include "ext4_common.h"
 #include <div64.h>
 #include <malloc.h>
+#include <malloc_arena.h>
 #include <part.h>
 #include <uuid.h>
 
@@ -281,7 +282,7 @@ void ext_cache_init(struct ext_block_cache *cache)
 
 void ext_cache_fini(struct ext_block_cache *cache)
 {
-	free(cache->buf);
+	arena_free(cache->buf);
 	ext_cache_init(cache);
 }
 
@@ -291,7 +292,8 @@ int ext_cache_read(struct ext_block_cache *cache, lbaint_t block, int size)
 	if (cache->buf && cache->block == block && cache->size == size)
 		return 1;
 	ext_cache_fini(cache);
-	cache->buf = memalign(ARCH_DMA_MINALIGN, size);
+	/* Block buffers are short-lived, so keep them out of the heap */
+	cache->buf = arena_alloc(size);
 	if (!cache->buf)
 		return 0;
 	if (!ext4fs_devread(block, 0, size, cache->buf)) {
@@ -18,6 +18,7 @@
 #include <asm/byteorder.h>
 #include <part.h>
 #include <malloc.h>
+#include <malloc_arena.h>
 #include <memalign.h>
 #include <asm/cache.h>
 #include <linux/compiler.h>
@@ -366,7 +367,7 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 		__u8 *tmp_buffer;
 
 		actsize = min(filesize, (loff_t)bytesperclust);
-		tmp_buffer = malloc_cache_aligned(actsize);
+		tmp_buffer = arena_alloc(actsize);
 		if (!tmp_buffer) {
 			debug("Error: allocating buffer\n");
 			return -1;
@@ -374,13 +375,13 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 
 		if (get_cluster(mydata, curclust, tmp_buffer, actsize) != 0) {
 			printf("Error reading cluster\n");
-			free(tmp_buffer);
+			arena_free(tmp_buffer);
 			return -1;
 		}
 		filesize -= actsize;
 		actsize -= pos;
 		memcpy(buffer, tmp_buffer + pos, actsize);
-		free(tmp_buffer);
+		arena_free(tmp_buffer);
 		*gotsize += actsize;
 		if (!filesize)
 			return 0;
@@ -501,7 +502,7 @@ read_bootsectandvi(boot_sector *bs, volume_info *volinfo, int *fatsize)
 		return -1;
 	}
 
-	block = malloc_cache_aligned(cur_dev->blksz);
+	block = arena_alloc(cur_dev->blksz);
 	if (block == NULL) {
 		debug("Error: allocating block\n");
 		return -1;
@@ -553,7 +554,7 @@ read_bootsectandvi(boot_sector *bs, volume_info *volinfo, int *fatsize)
 fail:
 	ret = -1;
 exit:
-	free(block);
+	arena_free(block);
 	return ret;
 }
 
@@ -1143,7 +1144,7 @@ int fat_exists(const char *filename)
 	fat_itr *itr;
 	int ret;
 
-	itr = malloc_cache_aligned(sizeof(fat_itr));
+	itr = arena_alloc(sizeof(fat_itr));
 	if (!itr)
 		return 0;
 	ret = fat_itr_root(itr, &fsdata);
@@ -1153,7 +1154,7 @@ int fat_exists(const char *filename)
 	ret = fat_itr_resolve(itr, filename, TYPE_ANY);
 	free(fsdata.fatbuf);
 out:
-	free(itr);
+	arena_free(itr);
 	return ret == 0;
 }
 
@@ -1163,7 +1164,7 @@ int fat_size(const char *filename, loff_t *size)
 	fat_itr *itr;
 	int ret;
 
-	itr = malloc_cache_aligned(sizeof(fat_itr));
+	itr = arena_alloc(sizeof(fat_itr));
 	if (!itr)
 		return -ENOMEM;
 	ret = fat_itr_root(itr, &fsdata);
@@ -1190,7 +1191,7 @@ int fat_size(const char *filename, loff_t *size)
 out_free_both:
 	free(fsdata.fatbuf);
 out_free_itr:
-	free(itr);
+	arena_free(itr);
 	return ret;
 }
 
@@ -1201,7 +1202,7 @@ int file_fat_read_at(const char *filename, loff_t pos, void *buffer,
 	fat_itr *itr;
 	int ret;
 
-	itr = malloc_cache_aligned(sizeof(fat_itr));
+	itr = arena_alloc(sizeof(fat_itr));
 	if (!itr)
 		return -ENOMEM;
 	ret = fat_itr_root(itr, &fsdata);
@@ -1222,7 +1223,7 @@ int file_fat_read_at(const char *filename, loff_t pos, void *buffer,
 out_free_both:
 	free(fsdata.fatbuf);
 out_free_itr:
-	free(itr);
+	arena_free(itr);
 	return ret;
 }
 
@@ -12,7 +12,9 @@
 #include <env.h>
 #include <lmb.h>
 #include <log.h>
+#include <malloc_arena.h>
 #include <mapmem.h>
+#include <memprof.h>
 #include <part.h>
 #include <ext4fs.h>
 #include <fat.h>
@@ -450,6 +452,8 @@ int fs_uuid(char *uuid_str)
 
 int fs_ls(const char *dirname)
 {
+	const char *prev = memprof_push("fs");
+	ulong mark = arena_push();
 	int ret;
 
 	struct fstype_info *info = fs_get_info(fs_type);
@@ -457,12 +461,16 @@ int fs_ls(const char *dirname)
 	ret = info->ls(dirname);
 
 	fs_close();
+	arena_pop(mark);
+	memprof_pop(prev);
 
 	return ret;
 }
 
 int fs_exists(const char *filename)
 {
+	const char *prev = memprof_push("fs");
+	ulong mark = arena_push();
 	int ret;
 
 	struct fstype_info *info = fs_get_info(fs_type);
@@ -470,12 +478,16 @@ int fs_exists(const char *filename)
 	ret = info->exists(filename);
 
 	fs_close();
+	arena_pop(mark);
+	memprof_pop(prev);
 
 	return ret;
 }
 
 int fs_size(const char *filename, loff_t *size)
 {
+	const char *prev = memprof_push("fs");
+	ulong mark = arena_push();
 	int ret;
 
 	struct fstype_info *info = fs_get_info(fs_type);
@@ -483,6 +495,8 @@ int fs_size(const char *filename, loff_t *size)
 	ret = info->size(filename, size);
 
 	fs_close();
+	arena_pop(mark);
+	memprof_pop(prev);
 
 	return ret;
 }
@@ -526,14 +540,19 @@ static int _fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 		    int do_lmb_check, loff_t *actread)
 {
 	struct fstype_info *info = fs_get_info(fs_type);
+	const char *prev = memprof_push("fs");
+	ulong mark = arena_push();
 	void *buf;
 	int ret;
 
 #ifdef CONFIG_LMB
 	if (do_lmb_check) {
 		ret = fs_read_lmb_check(filename, addr, offset, len, info);
-		if (ret)
+		if (ret) {
+			arena_pop(mark);
+			memprof_pop(prev);
 			return ret;
+		}
 	}
 #endif
 
@@ -549,6 +568,8 @@ static int _fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	if (ret == 0 && len && *actread != len)
 		log_debug("** %s shorter than offset + len **\n", filename);
 	fs_close();
+	arena_pop(mark);
+	memprof_pop(prev);
 
 	return ret;
 }
@@ -703,6 +724,7 @@ int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	loff_t len_read;
 	int ret;
 	unsigned long time;
+	bool auto_addr = false;
 	char *ep;
 
 	if (argc < 2)
@@ -713,7 +735,9 @@ int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	if (fs_set_blk_dev(argv[1], (argc >= 3) ? argv[2] : NULL, fstype))
 		return 1;
 
-	if (argc >= 4) {
+	if (argc >= 4 && lmb_auto_requested(argv[3])) {
+		auto_addr = true;
+	} else if (argc >= 4) {
 		addr = simple_strtoul(argv[3], &ep, 16);
 		if (ep == argv[3] || *ep != '\0')
 			return CMD_RET_USAGE;
@@ -742,9 +766,28 @@ int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	else
 		pos = 0;
 
+	if (auto_addr) {
+		loff_t size;
+
+		/* fs_size() closes the filesystem, so open it again */
+		if (fs_size(filename, &size) < 0) {
+			log_err("Failed to load '%s'\n", filename);
+			return 1;
+		}
+		if (fs_set_blk_dev(argv[1], argv[2], fstype))
+			return 1;
+		size = size > pos ? size - pos : 0;
+		if (bytes && bytes < size)
+			size = bytes;
+		if (lmb_auto_alloc(argv[3], size, &addr))
+			return 1;
+	}
+
 	time = get_timer(0);
 	ret = _fs_read(filename, addr, pos, bytes, 1, &len_read);
 	time = get_timer(time);
+	if (auto_addr)
+		lmb_auto_done(addr, ret < 0 ? 0 : len_read);
 	if (ret < 0) {
 		log_err("Failed to load '%s'\n", filename);
 		return 1;
@@ -199,6 +199,25 @@ struct global_data {
 	/** @dm_driver_rt: Dynamic info about the driver */
 	struct driver_rt *dm_driver_rt;
 # endif
+# if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+	/**
+	 * @dm_compat_index: hash table of driver compatible strings, built
+	 * on first use
+	 */
+	struct dm_compat_index *dm_compat_index;
+	/**
+	 * @dm_bind_us: time taken by dm_init_and_scan() before ([0]) and
+	 * after ([1]) relocation, in microseconds
+	 */
+	ulong dm_bind_us[2];
+# endif
+# if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+	/**
+	 * @dm_lazy: device-tree nodes waiting to be bound, or NULL if lazy
+	 * binding is not active
+	 */
+	struct dm_lazy_state *dm_lazy;
+# endif
 #endif
 #ifdef CONFIG_TIMER
 	/**
@@ -224,6 +243,12 @@ struct global_data {
 	 */
 	struct device_node *of_root;
 #endif
+#if CONFIG_IS_ENABLED(OF_FDT_INDEX)
+	/**
+	 * @fdtdec_index: lookup index for @fdt_blob, built on first use
+	 */
+	struct fdtdec_index *fdtdec_index;
+#endif
 
 #if CONFIG_IS_ENABLED(MULTI_DTB_FIT)
 	/**
@@ -279,6 +304,12 @@ struct global_data {
 	 */
 	unsigned long malloc_ptr;
 #endif
+#if CONFIG_IS_ENABLED(MALLOC_ARENA)
+	/**
+	 * @arena_base: base address of the arena allocator region
+	 */
+	unsigned long arena_base;
+#endif
 #ifdef CONFIG_PCI
 	/**
 	 * @hose: PCI hose for early use
@@ -205,6 +205,7 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ACCUM_FSP_M,
 	BOOTSTAGE_ID_ACCUM_FSP_S,
 	BOOTSTAGE_ID_ACCUM_MMAP_SPI,
+	BOOTSTAGE_ID_ACCUM_FDT_FIXUP,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -20,6 +20,13 @@ int set_local_var(const char *s, int flg_export);
 void unset_local_var(const char *name);
 char *get_local_var(const char *s);
 
+/**
+ * hush_cache_flush() - Drop the cached parse trees of scripts
+ *
+ * Trees of scripts that are running are kept.
+ */
+void hush_cache_flush(void);
+
 #if defined(CONFIG_HUSH_INIT_VAR)
 extern int hush_init_var (void);
 #endif
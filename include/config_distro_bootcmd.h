@@ -404,6 +404,17 @@
 	BOOT_TARGET_DEVICES_references_PXE_without_CONFIG_CMD_DHCP_or_PXE
 #endif
 
+#ifdef CONFIG_CMD_BOOTSCAN
+/* If the scan fails, e.g. with too many targets, try them all in order */
+#define BOOTENV_RUN_BOOTSCAN \
+	"bootscan boot_targets_ready ${boot_targets} || " \
+		"setenv boot_targets_ready ${boot_targets}; "
+#define BOOTENV_TARGETS "${boot_targets_ready}"
+#else
+#define BOOTENV_RUN_BOOTSCAN
+#define BOOTENV_TARGETS "${boot_targets}"
+#endif
+
 #define BOOTENV_DEV_NAME(devtypeu, devtypel, instance) \
 	BOOTENV_DEV_NAME_##devtypeu(devtypeu, devtypel, instance)
 #define BOOTENV_BOOT_TARGETS \
@@ -487,7 +498,8 @@
 		BOOTENV_SET_NVME_NEED_INIT                                \
 		BOOTENV_SET_IDE_NEED_INIT                                 \
 		BOOTENV_SET_VIRTIO_NEED_INIT                              \
-		"for target in ${boot_targets}; do "                      \
+		BOOTENV_RUN_BOOTSCAN                                      \
+		"for target in " BOOTENV_TARGETS "; do "                  \
 			"run bootcmd_${target}; "                         \
 		"done\0"
 
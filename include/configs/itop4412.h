@@ -25,9 +25,6 @@
 #define PHYS_SDRAM_1            CONFIG_SYS_SDRAM_BASE
 #define SDRAM_BANK_SIZE         (256 << 20) /* 256 MB */
 
-/* memtest works on */
-#define CONFIG_SYS_MEMTEST_START    CONFIG_SYS_SDRAM_BASE
-#define CONFIG_SYS_MEMTEST_END      (CONFIG_SYS_SDRAM_BASE + 0x6000000)
 #define CONFIG_SYS_LOAD_ADDR        (CONFIG_SYS_SDRAM_BASE + 0x00100000)
 
 //#define CONFIG_SYS_TEXT_BASE        0x43E00000
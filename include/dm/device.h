@@ -138,6 +138,8 @@ enum {
  *		When CONFIG_DEVRES is enabled, devm_kmalloc() and friends will
  *		add to this list. Memory so-allocated will be freed
  *		automatically when the device is removed / unbound
+ * @name_hnode: Links the device into its uclass's name index
+ * @node_hnode: Links the device into its uclass's device-tree node index
  */
 struct udevice {
 	const struct driver *driver;
@@ -161,6 +163,10 @@ struct udevice {
 #ifdef CONFIG_DEVRES
 	struct list_head devres_head;
 #endif
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	struct hlist_node name_hnode;
+	struct hlist_node node_hnode;
+#endif
 };
 
 /* Maximum sequence number supported */
@@ -177,10 +183,21 @@ static inline int dev_of_offset(const struct udevice *dev)
 	return ofnode_to_offset(dev->node);
 }
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+/* These must update the uclass index, see uclass_index_update() */
+void dev_set_ofnode(struct udevice *dev, ofnode node);
+void dev_set_of_offset(struct udevice *dev, int of_offset);
+#else
+static inline void dev_set_ofnode(struct udevice *dev, ofnode node)
+{
+	dev->node = node;
+}
+
 static inline void dev_set_of_offset(struct udevice *dev, int of_offset)
 {
 	dev->node = offset_to_ofnode(of_offset);
 }
+#endif
 
 static inline bool dev_has_of_node(struct udevice *dev)
 {
@@ -12,6 +12,39 @@
 #include <dm/ofnode.h>
 #include <dm/uclass-id.h>
 
+struct udevice_id;
+
+/**
+ * struct dm_compat_entry - a slot in the compatible-string index
+ *
+ * @compat: Compatible string, or NULL if the slot is empty
+ * @drv: First driver in the linker list which matches @compat
+ * @id: Entry in @drv's of_match table which matches @compat
+ */
+struct dm_compat_entry {
+	const char *compat;
+	struct driver *drv;
+	const struct udevice_id *id;
+};
+
+/**
+ * struct dm_compat_index - hash table of driver compatible strings
+ *
+ * This uses open addressing with linear probing. The number of slots is a
+ * power of two and at least twice the number of strings.
+ *
+ * @mask: Number of slots minus one
+ * @count: Number of compatible strings stored
+ * @max_probes: Longest probe sequence needed to insert a string
+ * @entry: Slots
+ */
+struct dm_compat_index {
+	uint mask;
+	uint count;
+	uint max_probes;
+	struct dm_compat_entry entry[];
+};
+
 /**
  * lists_driver_lookup_name() - Return u_boot_driver corresponding to name
  *
@@ -61,6 +94,27 @@ int lists_bind_drivers(struct udevice *parent, bool pre_reloc_only);
 int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 		   bool pre_reloc_only);
 
+/**
+ * lists_driver_lookup_compat() - Find the driver for a compatible string
+ *
+ * @compat: Compatible string to search for
+ * @of_idp: Returns the matching entry in the driver's of_match table
+ * @return first driver in the linker list which matches, or NULL if none
+ */
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **of_idp);
+
+/**
+ * lists_compat_index() - Get the compatible-string index
+ *
+ * The index is built on the first call after dm_init(), once U-Boot has
+ * relocated.
+ *
+ * @return pointer to index, or NULL if not relocated yet or if there is not
+ *	enough memory
+ */
+struct dm_compat_index *lists_compat_index(void);
+
 /**
  * device_bind_driver() - bind a device to a driver
  *
@@ -9,6 +9,9 @@
 #ifndef _DM_ROOT_H_
 #define _DM_ROOT_H_
 
+#include <dm/ofnode.h>
+#include <dm/uclass-id.h>
+
 struct udevice;
 
 /**
@@ -114,6 +117,74 @@ int dm_init(bool of_live);
  */
 int dm_uninit(void);
 
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+/**
+ * dm_lazy_start() - Start deferring the binding of device-tree nodes
+ *
+ * This is called by dm_init_and_scan() after relocation. Deferral stops
+ * when dm_init() or dm_uninit() is called.
+ *
+ * @return 0 if OK, -ENOMEM if out of memory
+ */
+int dm_lazy_start(void);
+
+/**
+ * dm_lazy_stop() - Stop deferring and drop any nodes not yet bound
+ */
+void dm_lazy_stop(void);
+
+/**
+ * dm_lazy_defer() - Record a device-tree node instead of binding it
+ *
+ * @parent: Device which the node would be bound under
+ * @node: Device-tree node
+ * @return true if the node was recorded, false if it must be bound now
+ */
+bool dm_lazy_defer(struct udevice *parent, ofnode node);
+
+/**
+ * dm_lazy_bind_uclass() - Bind all recorded nodes for a uclass
+ *
+ * Nodes recorded for this uclass after this call are bound immediately.
+ *
+ * @id: Uclass ID
+ */
+void dm_lazy_bind_uclass(enum uclass_id id);
+
+/**
+ * dm_lazy_bind_all() - Bind all recorded nodes
+ *
+ * This must be called before looking at the whole device tree.
+ */
+void dm_lazy_bind_all(void);
+
+/**
+ * dm_lazy_forget() - Drop recorded nodes whose parent is being unbound
+ *
+ * @parent: Device being unbound
+ */
+void dm_lazy_forget(struct udevice *parent);
+
+/**
+ * dm_lazy_get_stats() - Get lazy-binding statistics
+ *
+ * @deferredp: Returns the number of nodes recorded by the scan
+ * @boundp: Returns the number of those nodes which have been bound since
+ * @pendingp: Returns the number of nodes not yet bound
+ */
+void dm_lazy_get_stats(uint *deferredp, uint *boundp, uint *pendingp);
+#else
+static inline int dm_lazy_start(void) { return 0; }
+static inline void dm_lazy_stop(void) {}
+static inline bool dm_lazy_defer(struct udevice *parent, ofnode node)
+{
+	return false;
+}
+static inline void dm_lazy_bind_uclass(enum uclass_id id) {}
+static inline void dm_lazy_bind_all(void) {}
+static inline void dm_lazy_forget(struct udevice *parent) {}
+#endif
+
 #if CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)
 /**
  * dm_remove_devices_flags - Call remove function of all drivers with
@@ -196,6 +196,31 @@ int uclass_unbind_device(struct udevice *dev);
 static inline int uclass_unbind_device(struct udevice *dev) { return 0; }
 #endif
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+/**
+ * uclass_index_update() - Update the uclass index after a change to a device
+ *
+ * This must be called after the name or device-tree node of a bound device
+ * is changed.
+ *
+ * @dev:	Pointer to the device
+ */
+void uclass_index_update(struct udevice *dev);
+
+/**
+ * uclass_index_seq() - Record a device's new sequence number in the index
+ *
+ * This must be called after dev->seq is set to a sequence number. There is
+ * no need to call it when dev->seq is set back to -1.
+ *
+ * @dev:	Pointer to the device
+ */
+void uclass_index_seq(struct udevice *dev);
+#else
+static inline void uclass_index_update(struct udevice *dev) {}
+static inline void uclass_index_seq(struct udevice *dev) {}
+#endif
+
 /**
  * uclass_pre_probe_device() - Deal with a device that is about to be probed
  *
@@ -48,4 +48,7 @@ void dm_dump_driver_compat(void);
 /* Dump out a list of drivers with static platform data */
 void dm_dump_static_driver_info(void);
 
+/* Dump out the bind times and compatible-string index statistics */
+void dm_dump_stats(void);
+
 #endif
@@ -38,6 +38,9 @@ enum {
 #if CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_FORMAT)
 	FASTBOOT_COMMAND_OEM_FORMAT,
 #endif
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC_STREAM)
+	FASTBOOT_COMMAND_OEM_STREAM,
+#endif
 
 	FASTBOOT_COMMAND_COUNT
 };
@@ -149,6 +152,16 @@ int fastboot_handle_command(char *cmd_string, char *response);
  */
 u32 fastboot_data_remaining(void);
 
+/**
+ * fastboot_data_next() - return where the next download data is stored
+ *
+ * @received: Returns the number of bytes downloaded so far, which lie just
+ *	below
+ * Return: Pointer into fastboot_buf_addr, or NULL if the data is written out
+ * as it arrives instead
+ */
+void *fastboot_data_next(u32 *received);
+
 /**
  * fastboot_data_download() - Copy image data to fastboot_buf_addr.
  *
@@ -39,4 +39,56 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
  * @response: Pointer to fastboot response buffer
  */
 void fastboot_mmc_erase(const char *cmd, char *response);
+
+/**
+ * fastboot_mmc_stream_arm() - Write the next download to a partition
+ *
+ * The next download is then written to the partition as it arrives, instead
+ * of being held in the download buffer until the "flash" command.
+ *
+ * @cmd: Named partition to write the next image to, or "" to disarm
+ * @response: Pointer to fastboot response buffer
+ */
+void fastboot_mmc_stream_arm(const char *cmd, char *response);
+
+/**
+ * fastboot_mmc_stream_limit() - Get the largest download that can be streamed
+ *
+ * Return: Size of the armed partition in bytes, or 0 if not armed
+ */
+u32 fastboot_mmc_stream_limit(void);
+
+/**
+ * fastboot_mmc_stream_start() - Start writing a download as it arrives
+ *
+ * @size: Size of the download in bytes
+ * Return: 0 if the download is to be streamed, -ENOENT if not armed
+ */
+int fastboot_mmc_stream_start(u32 size);
+
+/**
+ * fastboot_mmc_stream_write() - Write the next part of a streamed download
+ *
+ * @data: Pointer to received data
+ * @len: Length of received data
+ */
+void fastboot_mmc_stream_write(const void *data, u32 len);
+
+/**
+ * fastboot_mmc_stream_finish() - Finish writing a streamed download
+ *
+ * @response: Pointer to fastboot response buffer, set on failure
+ * Return: 0 if OK, -EIO if the image could not be written
+ */
+int fastboot_mmc_stream_finish(char *response);
+
+/**
+ * fastboot_mmc_stream_flash() - Complete the "flash" of a streamed image
+ *
+ * @cmd: Named partition given to the "flash" command
+ * @response: Pointer to fastboot response buffer
+ * Return: true if the last download was streamed and this has dealt with
+ *	the command, false if the download buffer should be written as usual
+ */
+bool fastboot_mmc_stream_flash(const char *cmd, char *response);
 #endif
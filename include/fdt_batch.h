@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Batched device-tree edits
+ *
+ * Each fdt_setprop() or fdt_add_subnode() that changes the size of the
+ * tree moves everything after the edit point, so a series of fixups on a
+ * large tree costs one memmove() of most of the blob per property. While
+ * a batch is open on a blob, the fdt_batch_...() functions below queue
+ * their edits instead. fdt_batch_end() then works out the final size once
+ * and rebuilds the structure block in a single pass, moving the strings
+ * block at most once.
+ *
+ * Reads during a batch see the tree as it was when the batch was opened.
+ * The blob must not be changed with other libfdt functions while a batch
+ * is open, since queued edits refer to offsets in the original tree.
+ */
+
+#ifndef __FDT_BATCH_H
+#define __FDT_BATCH_H
+
+#include <linux/libfdt.h>
+
+/*
+ * Nodes added during a batch are given handles from this value upwards.
+ * They may only be passed to the fdt_batch_...() functions.
+ */
+#define FDT_BATCH_NODE_BASE	0x40000000
+
+#if CONFIG_IS_ENABLED(OF_FDT_BATCH)
+
+/**
+ * fdt_batch_begin() - Start queueing edits to a device tree
+ *
+ * Calls may be nested on the same blob; the edits are applied when the
+ * outermost batch ends.
+ *
+ * @fdt: Device tree to edit
+ * @return 0 if OK, -FDT_ERR_BADSTATE if a batch is already open on another
+ *	blob, other -FDT_ERR_... if the blob is not valid
+ */
+int fdt_batch_begin(void *fdt);
+
+/**
+ * fdt_batch_end() - Apply the queued edits and close the batch
+ *
+ * If the edits do not fit in the space available (fdt_totalsize()), the
+ * tree is left unchanged. The queued edits are discarded in any case.
+ *
+ * @fdt: Device tree passed to fdt_batch_begin()
+ * @return 0 if OK, -FDT_ERR_NOSPACE if there is not enough room,
+ *	-FDT_ERR_BADSTATE if the tree was changed behind the batch's back
+ */
+int fdt_batch_end(void *fdt);
+
+/**
+ * fdt_batch_setprop() - Set a property, queueing it if a batch is open
+ *
+ * @fdt: Device tree to edit
+ * @nodeoffset: Offset of node, or a handle from
+ *	fdt_batch_find_or_add_subnode()
+ * @name: Property name
+ * @val: Property value
+ * @len: Length of value in bytes
+ * @return 0 if OK, -ve FDT_ERR_... on error
+ */
+int fdt_batch_setprop(void *fdt, int nodeoffset, const char *name,
+		      const void *val, int len);
+
+/**
+ * fdt_batch_find_or_add_subnode() - Find a subnode, queueing it if missing
+ *
+ * With no batch open this is the same as fdt_find_or_add_subnode().
+ *
+ * @fdt: Device tree to edit
+ * @parentoffset: Offset of parent node, or a handle for a new node
+ * @name: Name of subnode
+ * @return offset of the subnode (or a handle if it is new), or -ve
+ *	FDT_ERR_... on error
+ */
+int fdt_batch_find_or_add_subnode(void *fdt, int parentoffset,
+				  const char *name);
+
+#else
+
+#include <fdt_support.h>
+
+static inline int fdt_batch_begin(void *fdt)
+{
+	return 0;
+}
+
+static inline int fdt_batch_end(void *fdt)
+{
+	return 0;
+}
+
+static inline int fdt_batch_setprop(void *fdt, int nodeoffset,
+				    const char *name, const void *val,
+				    int len)
+{
+	return fdt_setprop(fdt, nodeoffset, name, val, len);
+}
+
+static inline int fdt_batch_find_or_add_subnode(void *fdt, int parentoffset,
+						const char *name)
+{
+	return fdt_find_or_add_subnode(fdt, parentoffset, name);
+}
+
+#endif /* OF_FDT_BATCH */
+
+static inline int fdt_batch_setprop_u32(void *fdt, int nodeoffset,
+					const char *name, u32 val)
+{
+	fdt32_t tmp = cpu_to_fdt32(val);
+
+	return fdt_batch_setprop(fdt, nodeoffset, name, &tmp, sizeof(tmp));
+}
+
+static inline int fdt_batch_setprop_u64(void *fdt, int nodeoffset,
+					const char *name, u64 val)
+{
+	fdt64_t tmp = cpu_to_fdt64(val);
+
+	return fdt_batch_setprop(fdt, nodeoffset, name, &tmp, sizeof(tmp));
+}
+
+static inline int fdt_batch_setprop_string(void *fdt, int nodeoffset,
+					   const char *name, const char *str)
+{
+	return fdt_batch_setprop(fdt, nodeoffset, name, str, strlen(str) + 1);
+}
+
+#endif /* __FDT_BATCH_H */
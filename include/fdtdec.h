@@ -1215,4 +1215,53 @@ int fdtdec_decode_ram_size(const void *blob, const char *area, int board_id,
 			   phys_addr_t *basep, phys_size_t *sizep,
 			   struct bd_info *bd);
 
+/*
+ * The following work like the libfdt functions of the same name without the
+ * fdtdec_index_ prefix. When CONFIG_OF_FDT_INDEX is enabled and @blob is the
+ * control device tree, they use an index built after relocation so that
+ * they take constant time.
+ */
+#if CONFIG_IS_ENABLED(OF_FDT_INDEX)
+const void *fdtdec_index_getprop(const void *blob, int node, const char *name,
+				 int *lenp);
+int fdtdec_index_node_offset_by_phandle(const void *blob, u32 phandle);
+int fdtdec_index_parent_offset(const void *blob, int node);
+int fdtdec_index_path_offset(const void *blob, const char *path);
+
+/**
+ * fdtdec_index_reset() - Drop the control device-tree index
+ *
+ * The index is rebuilt on next use. This is only needed if the control
+ * device tree is changed without changing the size of its structure or
+ * strings block.
+ */
+void fdtdec_index_reset(void);
+#else
+static inline const void *fdtdec_index_getprop(const void *blob, int node,
+					       const char *name, int *lenp)
+{
+	return fdt_getprop(blob, node, name, lenp);
+}
+
+static inline int fdtdec_index_node_offset_by_phandle(const void *blob,
+						      u32 phandle)
+{
+	return fdt_node_offset_by_phandle(blob, phandle);
+}
+
+static inline int fdtdec_index_parent_offset(const void *blob, int node)
+{
+	return fdt_parent_offset(blob, node);
+}
+
+static inline int fdtdec_index_path_offset(const void *blob, const char *path)
+{
+	return fdt_path_offset(blob, path);
+}
+
+static inline void fdtdec_index_reset(void)
+{
+}
+#endif
+
 #endif
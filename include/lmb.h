@@ -5,6 +5,7 @@
 
 #include <asm/types.h>
 #include <asm/u-boot.h>
+#include <linux/errno.h>
 
 /*
  * Logical memory blocks.
@@ -60,6 +61,96 @@ lmb_size_bytes(struct lmb_region *type, unsigned long region_nr)
 void board_lmb_reserve(struct lmb *lmb);
 void arch_lmb_reserve(struct lmb *lmb);
 
+#if CONFIG_IS_ENABLED(LMB_AUTO)
+/**
+ * lmb_auto_requested() - Check if a load address asks for auto allocation
+ *
+ * @arg: Address argument given to a load command
+ * @return true if @arg is "auto" or starts with "auto:"
+ */
+bool lmb_auto_requested(const char *arg);
+
+/**
+ * lmb_auto_alloc() - Allocate a load region for an 'auto' address
+ *
+ * @arg is "auto[:<var>[:<size>]]". Any region previously allocated for
+ * <var> (default "loadaddr") is dropped and a new one of at least @size
+ * bytes (or <size>, in hex, whichever is larger) is allocated from the
+ * top of free memory below the bootm mapping limit. If neither is given,
+ * the 'autoload_size' variable or CONFIG_LMB_AUTO_DEFAULT_SIZE is used.
+ * The address is written to <var>.
+ *
+ * The region is not reserved by lmb_init_and_reserve() until
+ * lmb_auto_done() is called, so the loader may check it against LMB.
+ *
+ * @arg: Address argument given to the load command
+ * @size: Expected size of the image in bytes, 0 if not known
+ * @addrp: Returns the address to load to
+ * @return 0 if OK, -ENOSPC if all regions are in use, -ENOMEM if there is
+ *	not enough free memory
+ */
+int lmb_auto_alloc(const char *arg, phys_size_t size, ulong *addrp);
+
+/**
+ * lmb_auto_done() - Finish loading into an 'auto' region
+ *
+ * @addr: Address returned by lmb_auto_alloc()
+ * @size: Number of bytes loaded, or 0 if the load failed, in which case
+ *	the region is released
+ */
+void lmb_auto_done(ulong addr, phys_size_t size);
+
+/**
+ * lmb_auto_reserve() - Reserve all 'auto' regions
+ *
+ * This is called by lmb_init_and_reserve() and friends.
+ *
+ * @lmb: LMB to update
+ */
+void lmb_auto_reserve(struct lmb *lmb);
+
+/**
+ * lmb_auto_fits() - Check if an image lies inside an 'auto' region
+ *
+ * This is used by bootm to use images in place instead of relocating them.
+ *
+ * @addr: Start address of the image
+ * @size: Size of the image in bytes, including any padding required
+ * @limit: Address the image must end below, or 0 for no limit
+ * @return true if the image fits inside a single 'auto' region
+ */
+bool lmb_auto_fits(ulong addr, ulong size, ulong limit);
+
+/**
+ * lmb_auto_show() - Show the 'auto' regions
+ */
+void lmb_auto_show(void);
+#else
+static inline bool lmb_auto_requested(const char *arg)
+{
+	return false;
+}
+
+static inline int lmb_auto_alloc(const char *arg, phys_size_t size,
+				 ulong *addrp)
+{
+	return -ENOSYS;
+}
+
+static inline void lmb_auto_done(ulong addr, phys_size_t size)
+{
+}
+
+static inline void lmb_auto_reserve(struct lmb *lmb)
+{
+}
+
+static inline bool lmb_auto_fits(ulong addr, ulong size, ulong limit)
+{
+	return false;
+}
+#endif
+
 #endif /* __KERNEL__ */
 
 #endif /* _LINUX_LMB_H */
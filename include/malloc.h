@@ -978,6 +978,15 @@ extern ulong mem_malloc_brk;
 
 void mem_malloc_init(ulong start, ulong size);
 
+/**
+ * malloc_get_usage() - Get the current state of the malloc() region
+ *
+ * @size: Returns the size of the region in bytes
+ * @used: Returns the number of bytes in use by allocations
+ * @peak: Returns the highest amount of the region ever taken by the heap
+ */
+void malloc_get_usage(ulong *size, ulong *used, ulong *peak);
+
 #ifdef __cplusplus
 };  /* end of extern "C" */
 #endif
@@ -0,0 +1,160 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Scoped arena (bump) allocator for short-lived boot-time buffers
+ *
+ * The arena lives in its own region just below the malloc() pool. Callers
+ * take a mark with arena_push(), allocate with arena_alloc() and release
+ * everything allocated since the mark in one go with arena_pop(). This
+ * keeps transient buffers (filesystem block buffers, environment import
+ * copies, etc.) out of dlmalloc, which avoids fragmenting the main heap and
+ * the per-call bookkeeping cost.
+ *
+ * If no mark is held, or the arena is not available or is full,
+ * arena_alloc() falls back to malloc(). Always release with arena_free() so
+ * that such fallback allocations are freed correctly.
+ */
+
+#ifndef __MALLOC_ARENA_H
+#define __MALLOC_ARENA_H
+
+#include <malloc.h>
+#include <memalign.h>
+
+/**
+ * struct arena_stats - arena usage statistics
+ *
+ * @size: Total size of the arena region in bytes
+ * @used: Number of bytes currently allocated
+ * @peak: Highest value of @used seen so far
+ * @allocs: Number of allocations served from the arena
+ * @fallbacks: Number of allocations within a mark which had to fall back to
+ *	malloc() since the arena was full
+ * @bytes: Total number of bytes served from the arena
+ */
+struct arena_stats {
+	ulong size;
+	ulong used;
+	ulong peak;
+	ulong allocs;
+	ulong fallbacks;
+	ulong bytes;
+};
+
+#if CONFIG_IS_ENABLED(MALLOC_ARENA)
+
+/**
+ * arena_init() - Set up the arena region
+ *
+ * @base: Start of region
+ * @size: Size of region in bytes
+ * @return 0 if OK, -EINVAL if the region is empty
+ */
+int arena_init(void *base, ulong size);
+
+/**
+ * arena_push() - Take a mark of the current arena position
+ *
+ * @return mark to pass to arena_pop()
+ */
+ulong arena_push(void);
+
+/**
+ * arena_pop() - Release all arena allocations made since a mark
+ *
+ * Marks must be popped in the reverse order to which they were pushed.
+ *
+ * @mark: Value returned by arena_push()
+ */
+void arena_pop(ulong mark);
+
+/**
+ * arena_alloc() - Allocate a transient buffer
+ *
+ * The buffer is aligned to ARCH_DMA_MINALIGN so that it may be used for
+ * block-device transfers. If no mark is held, or the arena cannot satisfy
+ * the request, the buffer is allocated with malloc() instead.
+ *
+ * @size: Number of bytes to allocate
+ * @return pointer to buffer, or NULL if out of memory
+ */
+void *arena_alloc(size_t size);
+
+/**
+ * arena_calloc() - Allocate a zeroed transient buffer
+ *
+ * @nmemb: Number of elements
+ * @size: Size of each element in bytes
+ * @return pointer to buffer, or NULL if out of memory
+ */
+void *arena_calloc(size_t nmemb, size_t size);
+
+/**
+ * arena_free() - Release a buffer obtained from arena_alloc()
+ *
+ * Buffers inside the arena are reclaimed by arena_pop(), except that the
+ * most recent allocation is returned to the arena straight away. Buffers
+ * which fell back to malloc() are passed to free().
+ *
+ * @ptr: Buffer to free (may be NULL)
+ */
+void arena_free(void *ptr);
+
+/**
+ * arena_contains() - Check whether a pointer is inside the arena
+ *
+ * @ptr: Pointer to check
+ * @return true if @ptr lies within the arena region
+ */
+bool arena_contains(const void *ptr);
+
+/**
+ * arena_get_stats() - Obtain arena usage statistics
+ *
+ * @stats: Returns the statistics
+ */
+void arena_get_stats(struct arena_stats *stats);
+
+/**
+ * arena_info() - Show arena usage statistics on the console
+ */
+void arena_info(void);
+
+#else
+
+static inline ulong arena_push(void)
+{
+	return 0;
+}
+
+static inline void arena_pop(ulong mark)
+{
+}
+
+static inline void *arena_alloc(size_t size)
+{
+	return malloc_cache_aligned(size);
+}
+
+static inline void *arena_calloc(size_t nmemb, size_t size)
+{
+	void *ptr = malloc_cache_aligned(nmemb * size);
+
+	if (ptr)
+		memset(ptr, '\0', nmemb * size);
+
+	return ptr;
+}
+
+static inline void arena_free(void *ptr)
+{
+	free(ptr);
+}
+
+static inline bool arena_contains(const void *ptr)
+{
+	return false;
+}
+
+#endif /* MALLOC_ARENA */
+
+#endif /* __MALLOC_ARENA_H */
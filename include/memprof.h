@@ -0,0 +1,183 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Heap and LMB usage profiler
+ *
+ * This records malloc()/free() call sites, attributes heap use to the
+ * subsystem which is currently active, tracks the peak heap use and keeps
+ * a timeline of LMB reservations. The results can be shown with the
+ * 'memprof' command and are passed to the OS in the device tree (and
+ * bloblist, if enabled) so that CONFIG_SYS_MALLOC_LEN and the load
+ * addresses can be sized from real data.
+ */
+
+#ifndef __MEMPROF_H
+#define __MEMPROF_H
+
+#include <linux/types.h>
+
+struct lmb;
+
+/* Kinds of LMB event recorded by memprof_lmb() */
+enum memprof_lmb_kind {
+	MEMPROF_LMB_RESERVE,
+	MEMPROF_LMB_ALLOC,
+	MEMPROF_LMB_FREE,
+};
+
+/**
+ * struct memprof_export - summary passed on to the OS
+ *
+ * This is stored in the bloblist with tag BLOBLISTT_U_BOOT_MEMPROF. All
+ * sizes are in bytes.
+ *
+ * @malloc_size: Size of the malloc() region
+ * @malloc_peak: Peak amount of the region taken by the heap (sbrk level)
+ * @malloc_used: Heap in use when the summary was taken
+ * @live_peak: Peak of the sum of live allocation sizes
+ * @lmb_low: Lowest address reserved/allocated through LMB (0 if none)
+ * @lmb_high: Highest address (exclusive) reserved/allocated through LMB
+ * @arena_size: Size of the arena region (0 if not enabled)
+ * @arena_peak: Peak arena use
+ */
+struct memprof_export {
+	u32 malloc_size;
+	u32 malloc_peak;
+	u32 malloc_used;
+	u32 live_peak;
+	u64 lmb_low;
+	u64 lmb_high;
+	u32 arena_size;
+	u32 arena_peak;
+};
+
+#if CONFIG_IS_ENABLED(MEMPROF)
+
+/**
+ * memprof_alloc() - Record an allocation
+ *
+ * @ptr: Pointer returned by the allocator (NULL if it failed)
+ * @size: Usable size of the allocation in bytes
+ * @caller: Return address of the caller of malloc() etc.
+ */
+void memprof_alloc(void *ptr, size_t size, void *caller);
+
+/**
+ * memprof_free() - Record a free
+ *
+ * This is charged to the subsystem which made the allocation. Pointers which
+ * memprof_alloc() did not record are ignored.
+ *
+ * @ptr: Pointer being freed
+ * @caller: Return address of the caller of free()
+ */
+void memprof_free(void *ptr, void *caller);
+
+/**
+ * memprof_get_live() - Get the heap still in use by a subsystem
+ *
+ * @subsys: Subsystem name
+ * @return bytes allocated by @subsys and not yet freed
+ */
+long memprof_get_live(const char *subsys);
+
+/**
+ * memprof_push() - Attribute subsequent allocations to a subsystem
+ *
+ * @subsys: Subsystem name; this must be a string constant
+ * @return the previous subsystem, to pass to memprof_pop()
+ */
+const char *memprof_push(const char *subsys);
+
+/**
+ * memprof_pop() - Restore the previous subsystem
+ *
+ * @prev: Value returned by the matching memprof_push()
+ */
+void memprof_pop(const char *prev);
+
+/**
+ * memprof_lmb() - Record an LMB event
+ *
+ * @kind: Kind of event
+ * @base: Base address of region
+ * @size: Size of region in bytes
+ */
+void memprof_lmb(enum memprof_lmb_kind kind, phys_addr_t base,
+		 phys_size_t size);
+
+/**
+ * memprof_get_export() - Fill in a summary of the profile
+ *
+ * @exp: Returns the summary
+ */
+void memprof_get_export(struct memprof_export *exp);
+
+/**
+ * memprof_fdt_fixup() - Add the profile summary to an OS device tree
+ *
+ * This adds u-boot,memprof-* properties to the /chosen node and, if
+ * bloblists are enabled, updates the BLOBLISTT_U_BOOT_MEMPROF record.
+ *
+ * @blob: Device tree to update
+ * @return 0 if OK, -ve on error
+ */
+int memprof_fdt_fixup(void *blob);
+
+/**
+ * memprof_reset() - Clear the call-site, subsystem and LMB records
+ */
+void memprof_reset(void);
+
+/**
+ * memprof_save() - Take a copy of the profile
+ *
+ * @return copy, to pass to memprof_restore(), or NULL if out of memory
+ */
+void *memprof_save(void);
+
+/**
+ * memprof_restore() - Put back a profile copied by memprof_save()
+ *
+ * @save: Copy to restore; this is freed
+ */
+void memprof_restore(void *save);
+
+/**
+ * memprof_show_info() - Show the summary and per-subsystem figures
+ */
+void memprof_show_info(void);
+
+/**
+ * memprof_show_sites() - Show the busiest allocation call sites
+ */
+void memprof_show_sites(void);
+
+/**
+ * memprof_show_lmb() - Show the LMB reservation timeline
+ */
+void memprof_show_lmb(void);
+
+#else
+
+static inline const char *memprof_push(const char *subsys)
+{
+	return NULL;
+}
+
+static inline void memprof_pop(const char *prev)
+{
+}
+
+static inline void memprof_lmb(enum memprof_lmb_kind kind, phys_addr_t base,
+			       phys_size_t size)
+{
+}
+
+static inline int memprof_fdt_fixup(void *blob)
+{
+	return 0;
+}
+
+#endif /* MEMPROF */
+
+#endif /* __MEMPROF_H */
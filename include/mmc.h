@@ -714,6 +714,7 @@ struct mmc {
 #endif
 	char op_cond_pending;	/* 1 if we are waiting on an op_cond command */
 	char init_in_progress;	/* 1 if we have done mmc_start_init() */
+	char op_cond_nowait;	/* 1 to leave the op_cond wait to the caller */
 	char preinit;		/* start init as early as possible */
 	int ddr_mode;
 #if CONFIG_IS_ENABLED(DM_MMC)
@@ -905,6 +906,20 @@ int mmc_get_op_cond(struct mmc *mmc);
  */
 int mmc_start_init(struct mmc *mmc);
 
+/**
+ * mmc_poll_init() - Initialise a device without waiting for it to power up
+ *
+ * The first call starts initialisation. An eMMC device may then take
+ * hundreds of milliseconds to power up: each later call sends it one
+ * op-cond command and completes the initialisation once it is ready. An SD
+ * card is still waited for by the first call.
+ *
+ * @mmc: MMC device to initialise
+ * @return 0 once the device is initialised, -EAGAIN if it is still powering
+ *	up, other -ve on error
+ */
+int mmc_poll_init(struct mmc *mmc);
+
 /**
  * Set preinit flag of mmc device.
  *
@@ -142,7 +142,8 @@ enum eth_recv_flags {
  *	 packet buffer in the packetp parameter. If not, return an error or 0 to
  *	 indicate that the hardware receive FIFO is empty. If 0 is returned, the
  *	 network stack will not process the empty packet, but free_pkt() will be
- *	 called if supplied
+ *	 called if supplied. A driver which copies each frame out of its own
+ *	 buffers should offer it to eth_rx_borrow() first
  * free_pkt: Give the driver an opportunity to manage its packet buffer memory
  *	     when the network stack is finished processing it. This will only be
  *	     called when no error was returned from recv - optional
@@ -158,6 +159,8 @@ enum eth_recv_flags {
  *		    ROM on the board. This is how the driver should expose it
  *		    to the network stack. This function should fill in the
  *		    eth_pdata::enetaddr field - optional
+ * get_link: Check whether the link is up, without waiting for it. Returns 1
+ *	     if up, 0 if down, -ve on error - optional
  */
 struct eth_ops {
 	int (*start)(struct udevice *dev);
@@ -168,6 +171,7 @@ struct eth_ops {
 	int (*mcast)(struct udevice *dev, const u8 *enetaddr, int join);
 	int (*write_hwaddr)(struct udevice *dev);
 	int (*read_rom_hwaddr)(struct udevice *dev);
+	int (*get_link)(struct udevice *dev);
 };
 
 #define eth_get_ops(dev) ((struct eth_ops *)(dev)->driver->ops)
@@ -180,6 +184,15 @@ struct udevice *eth_get_dev(void); /* get the current device */
 struct udevice *eth_get_dev_by_name(const char *devname);
 unsigned char *eth_get_ethaddr(void); /* get the current device MAC */
 
+/**
+ * eth_get_link() - Check whether a device has a link, without waiting
+ *
+ * @dev: Ethernet device, which must be probed
+ * @return 1 if the link is up, 0 if it is down, -ENOSYS if the driver cannot
+ *	tell, other -ve on error
+ */
+int eth_get_link(struct udevice *dev);
+
 /* Used only when NetConsole is enabled */
 int eth_is_active(struct udevice *dev); /* Test device for active state */
 int eth_init_state_only(void); /* Set active state */
@@ -309,6 +322,68 @@ void eth_halt(void);			/* stop SCC */
 const char *eth_get_name(void);		/* get name of current device */
 int eth_mcast_join(struct in_addr mcast_addr, int join);
 
+/**
+ * struct eth_rx_lend - Where the payload of the next expected packet goes
+ *
+ * A protocol which knows which UDP packet it expects next, and where its
+ * payload is to be stored, can lend that memory with eth_rx_lend(). A driver
+ * which copies each frame out of its own buffers then copies that packet
+ * straight there, so the protocol finds its payload already in place. The
+ * frame headers go just below @buf; the bytes they cover are put back once
+ * the packet has been processed.
+ *
+ * @buf: Where the payload should go
+ * @len: Largest payload which may be stored at @buf
+ * @below: Number of bytes below @buf which the frame headers may cover
+ * @dport: UDP destination port of the packet
+ * @hdr_len: Number of bytes between the UDP header and the payload
+ * @match_len: Number of bytes in @match, at most @hdr_len
+ * @match: Bytes which the packet must start with after the UDP header
+ */
+struct eth_rx_lend {
+	void *buf;
+	int len;
+	ulong below;
+	u16 dport;
+	int hdr_len;
+	int match_len;
+	u8 match[8];
+};
+
+#if defined(CONFIG_DM_ETH) && defined(CONFIG_NET_RX_LEND)
+/**
+ * eth_rx_lend() - Lend memory for the next expected packet to be received into
+ *
+ * The memory is used for one packet at most. Lending again replaces any
+ * memory lent before.
+ *
+ * @lend: Memory to lend, or NULL to take back any memory lent before
+ */
+void eth_rx_lend(const struct eth_rx_lend *lend);
+
+/**
+ * eth_rx_borrow() - Find where a driver should put a received frame
+ *
+ * A driver which copies frames out of its own buffers calls this with each
+ * frame before copying it. If it returns a buffer, the driver copies the frame
+ * there and returns that buffer from its recv() method.
+ *
+ * @frame: Received frame, still in the driver's buffer
+ * @len: Length of the frame
+ * @return where to copy the frame, or NULL to use the driver's buffer as usual
+ */
+uchar *eth_rx_borrow(const uchar *frame, int len);
+#else
+static inline void eth_rx_lend(const struct eth_rx_lend *lend)
+{
+}
+
+static inline uchar *eth_rx_borrow(const uchar *frame, int len)
+{
+	return NULL;
+}
+#endif
+
 /**********************************************************************/
 /*
  *	Protocol headers.
@@ -554,7 +629,7 @@ extern int		net_restart_wrap;	/* Tried all network devices */
 
 enum proto_t {
 	BOOTP, RARP, ARP, TFTPGET, DHCP, PING, DNS, NFS, CDP, NETCONS, SNTP,
-	TFTPSRV, TFTPPUT, LINKLOCAL, FASTBOOT, WOL, UDP
+	TFTPSRV, TFTPPUT, LINKLOCAL, FASTBOOT, WOL, UDP, TFTPSERVE
 };
 
 extern char	net_boot_file_name[1024];/* Boot File name */
@@ -22,6 +22,33 @@ void tftp_start(enum proto_t protocol);	/* Begin TFTP get/put */
 void tftp_start_server(void);	/* Wait for incoming TFTP put */
 #endif
 
+#ifdef CONFIG_CMD_TFTPSERVE
+struct blk_desc;
+struct disk_partition;
+
+/**
+ * tftp_serve_setup() - Choose what to serve to TFTP clients
+ *
+ * This must be called before net_loop(TFTPSERVE).
+ *
+ * @desc: Block device to serve
+ * @part: Partition number, or 0 for the whole device
+ * @info: Information about the partition, as from blk_get_device_part_str()
+ * @count: Number of transfers to complete before returning, or 0 to serve
+ *	until Ctrl-C is pressed
+ */
+void tftp_serve_setup(struct blk_desc *desc, int part,
+		      struct disk_partition *info, int count);
+void tftp_start_serve(void);	/* Serve TFTP read requests */
+
+/**
+ * tftp_serve_get_done() - Get the number of transfers completed
+ *
+ * @return number of transfers completed since net_loop(TFTPSERVE) started
+ */
+int tftp_serve_get_done(void);
+#endif
+
 extern ulong tftp_timeout_ms;
 extern int tftp_timeout_count_max;
 
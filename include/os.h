@@ -407,4 +407,19 @@ void *os_find_text_base(void);
  */
 void os_relaunch(char *argv[]);
 
+/**
+ * os_initjmp() - Set up a context which runs a function on a new stack
+ *
+ * This implements initjmp() for sandbox. A later longjmp() to @jmp calls
+ * @func on the new stack.
+ *
+ * @jmp:	Context to set up, a jmp_buf
+ * @func:	Function to call, which must not return
+ * @stack_base:	Lowest address of the stack
+ * @stack_sz:	Size of the stack in bytes
+ * Return:	0 if OK, -ve on error
+ */
+int os_initjmp(void *jmp, void (*func)(void), void *stack_base,
+	       size_t stack_sz);
+
 #endif
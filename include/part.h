@@ -305,6 +305,22 @@ struct part_driver {
 	int (*get_info)(struct blk_desc *dev_desc, int part,
 			struct disk_partition *info);
 
+	/**
+	 * get_info_all() - Get information about all partitions at once
+	 *
+	 * This is optional. It lets the partition cache read the whole table
+	 * once, instead of calling get_info() for each partition.
+	 *
+	 * @dev_desc:	Block device descriptor
+	 * @info:	Returns partition information, indexed by partition
+	 *		number - 1. Entries for unused partitions are left with a
+	 *		size of 0
+	 * @max:	Number of entries in @info
+	 * @return 0 if OK, -ve if the partition table could not be read
+	 */
+	int (*get_info_all)(struct blk_desc *dev_desc,
+			    struct disk_partition *info, int max);
+
 	/**
 	 * print() - Print partition information
 	 *
@@ -326,6 +342,69 @@ struct part_driver {
 #define U_BOOT_PART_TYPE(__name)					\
 	ll_entry_declare(struct part_driver, __name, part_driver)
 
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+/* disk/part_cache.c */
+/**
+ * part_cache_get_info() - Get information about a partition, using the cache
+ *
+ * The first lookup on a device reads the whole partition table if the driver
+ * supports it; otherwise each partition is read from the device the first
+ * time it is looked up.
+ *
+ * @dev_desc:	Block device descriptor
+ * @drv:	Partition driver for the device
+ * @part:	Partition number (1 = first)
+ * @info:	Returns partition information
+ * @return 0 if OK, -ve if the partition does not exist or cannot be read
+ */
+int part_cache_get_info(struct blk_desc *dev_desc, struct part_driver *drv,
+			int part, struct disk_partition *info);
+
+/**
+ * part_cache_invalidate() - Drop the cached partitions of a block device
+ *
+ * This drops the partitions of all hardware partitions of the device.
+ *
+ * @dev_desc:	Block device descriptor
+ */
+void part_cache_invalidate(struct blk_desc *dev_desc);
+
+/**
+ * part_cache_restore() - Use the cached partition table of a block device
+ *
+ * This sets the partition type of the device from the cache, so that it does
+ * not need to be detected again.
+ *
+ * @dev_desc:	Block device descriptor
+ * @return 0 if OK, -ENOENT if the table of the device's current hardware
+ *	partition is not cached
+ */
+int part_cache_restore(struct blk_desc *dev_desc);
+
+/**
+ * part_cache_write() - Note that blocks of a device are being changed
+ *
+ * This drops the cached partitions of the device unless all of the blocks
+ * are inside a single known partition, since the partition table itself
+ * cannot be there.
+ *
+ * @dev_desc:	Block device descriptor
+ * @start:	First block being written or erased
+ * @blkcnt:	Number of blocks
+ */
+void part_cache_write(struct blk_desc *dev_desc, lbaint_t start,
+		      lbaint_t blkcnt);
+#else
+static inline int part_cache_restore(struct blk_desc *dev_desc)
+{
+	return -ENOENT;
+}
+
+static inline void part_cache_invalidate(struct blk_desc *dev_desc) {}
+static inline void part_cache_write(struct blk_desc *dev_desc, lbaint_t start,
+				    lbaint_t blkcnt) {}
+#endif
+
 #include <part_efi.h>
 
 #if CONFIG_IS_ENABLED(EFI_PARTITION)
@@ -16,6 +16,8 @@
 
 #include <env.h>
 #include <stddef.h>
+#include <linux/string.h>
+#include <linux/types.h>
 
 #define set_errno(val) do { errno = val; } while (0)
 
@@ -94,6 +96,74 @@ int himport_r(struct hsearch_data *htab, const char *env, size_t size,
 	      const char sep, int flag, int crlf_is_lf, int nvars,
 	      char * const vars[]);
 
+/*
+ * Binary environment format
+ *
+ * This is an alternative to the list of "name=value" strings. It starts
+ * with a struct env_bin_hdr, followed by one struct env_bin_entry for each
+ * variable, in order of name. Each entry is followed by the name and
+ * value, both NUL-terminated, and padded to a multiple of 4 bytes. The hash
+ * of the name is stored so that it need not be worked out on import. All
+ * fields are little-endian and may be unaligned.
+ */
+#define ENV_BIN_MAGIC		"\0UBE"	/* never valid as text */
+#define ENV_BIN_MAGIC_LEN	4
+#define ENV_BIN_VERSION		1
+
+/**
+ * struct env_bin_hdr - header of a binary environment
+ *
+ * @magic: ENV_BIN_MAGIC
+ * @version: ENV_BIN_VERSION
+ * @reserved: Must be zero
+ * @count: Number of entries
+ * @size: Total size of the entries in bytes
+ */
+struct env_bin_hdr {
+	char magic[ENV_BIN_MAGIC_LEN];
+	u8 version;
+	u8 reserved;
+	__le16 count;
+	__le32 size;
+} __packed;
+
+/**
+ * struct env_bin_entry - an entry in a binary environment
+ *
+ * @hash: Hash of the name, as used by hsearch_r()
+ * @name_len: Length of the name, excluding the terminator
+ * @reserved: Must be zero
+ * @value_len: Length of the value, excluding the terminator
+ */
+struct env_bin_entry {
+	__le32 hash;
+	__le16 name_len;
+	__le16 reserved;
+	__le32 value_len;
+} __packed;
+
+/* Size of an entry with its name and value, including padding */
+#define ENV_BIN_ENTRY_SIZE(name_len, value_len) \
+	ALIGN(sizeof(struct env_bin_entry) + (name_len) + (value_len) + 2, 4)
+
+static inline bool env_is_binary(const void *env)
+{
+	return !memcmp(env, ENV_BIN_MAGIC, ENV_BIN_MAGIC_LEN);
+}
+
+/*
+ * Export the whole table in binary form to a buffer of "size" bytes. Unused
+ * bytes are zeroed. Returns the number of bytes used, or -1 on error.
+ */
+ssize_t hexport_bin_r(struct hsearch_data *htab, char *buf, size_t size);
+
+/*
+ * Import a binary environment, with the same handling of H_NOCLEAR as
+ * himport_r(). Returns 1 if OK, 0 on error.
+ */
+int himport_bin_r(struct hsearch_data *htab, const char *env, size_t size,
+		  int flag);
+
 /* Walk the whole table calling the callback on each element */
 int hwalk_r(struct hsearch_data *htab,
 	    int (*callback)(struct env_entry *entry));
@@ -155,6 +155,7 @@ struct usb_device {
 };
 
 struct int_queue;
+struct bulk_queue;
 
 /*
  * You can initialize platform's USB host or device
@@ -194,6 +195,15 @@ int destroy_int_queue(struct usb_device *dev, struct int_queue *queue);
 void *poll_int_queue(struct usb_device *dev, struct int_queue *queue);
 #endif
 
+struct bulk_queue *create_bulk_queue(struct usb_device *dev,
+				     unsigned long pipe, int queuesize,
+				     int maxlen);
+int submit_bulk_queue(struct usb_device *dev, struct bulk_queue *queue,
+		      void *buffer, int length);
+int poll_bulk_queue(struct usb_device *dev, struct bulk_queue *queue,
+		    void **bufferp);
+int destroy_bulk_queue(struct usb_device *dev, struct bulk_queue *queue);
+
 /* Defines */
 #define USB_UHCI_VEND_ID	0x8086
 #define USB_UHCI_DEV_ID		0x7112
@@ -762,6 +772,73 @@ struct dm_usb_ops {
 	int (*destroy_int_queue)(struct udevice *bus, struct usb_device *udev,
 				 struct int_queue *queue);
 
+	/**
+	 * create_bulk_queue() - Create a queue of transfers on a bulk endpoint
+	 *
+	 * Transfers added to the queue with submit_bulk_queue() are carried
+	 * out in order by the controller, without the caller waiting for
+	 * them. The caller collects them with poll_bulk_queue(). No other
+	 * transfers may be sent to the endpoint while the queue exists.
+	 *
+	 * The endpoint stays set up in the controller until the queue is
+	 * destroyed, so each transfer only costs filling in its descriptors.
+	 *
+	 * @queuesize: Maximum number of transfers in the queue at once
+	 * @maxlen: Maximum length of each transfer in bytes
+	 *
+	 * @return A pointer to the created queue or NULL on error
+	 */
+	struct bulk_queue * (*create_bulk_queue)(struct udevice *bus,
+				struct usb_device *udev, unsigned long pipe,
+				int queuesize, int maxlen);
+
+	/**
+	 * submit_bulk_queue() - Add a transfer to a bulk queue
+	 *
+	 * @queue: queue to add to
+	 * @buffer: Data to send, or space for the data received. This should
+	 *	be cache-aligned. If not, the caller must not write to the
+	 *	rest of its first and last cache lines until the transfer is
+	 *	collected
+	 * @length: Length of the transfer in bytes, at most the maximum given
+	 *	to create_bulk_queue()
+	 *
+	 * @return 0 if OK, -ENOSPC if the queue is full, -EINVAL if the
+	 *	transfer is too long, other -ve on error
+	 */
+	int (*submit_bulk_queue)(struct udevice *bus, struct usb_device *udev,
+				 struct bulk_queue *queue, void *buffer,
+				 int length);
+
+	/**
+	 * poll_bulk_queue() - Collect the oldest transfer in a bulk queue
+	 *
+	 * @queue: queue to poll
+	 * @bufferp: Returns the buffer passed to submit_bulk_queue() for the
+	 *	transfer
+	 *
+	 * @return number of bytes transferred, which is less than the length
+	 *	submitted if the device ended the transfer with a short
+	 *	packet, -EAGAIN if the oldest transfer has not finished,
+	 *	-ENOENT if the queue is empty, -EIO if the transfer failed
+	 *	(the queue then accepts no more transfers)
+	 */
+	int (*poll_bulk_queue)(struct udevice *bus, struct usb_device *udev,
+			       struct bulk_queue *queue, void **bufferp);
+
+	/**
+	 * destroy_bulk_queue() - Destroy a bulk queue
+	 *
+	 * Destroy a queue created by create_bulk_queue(). Any transfers
+	 * still in the queue are abandoned.
+	 *
+	 * @queue: queue to destroy
+	 *
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*destroy_bulk_queue)(struct udevice *bus, struct usb_device *udev,
+				  struct bulk_queue *queue);
+
 	/**
 	 * alloc_device() - Allocate a new device context (XHCI)
 	 *
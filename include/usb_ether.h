@@ -16,6 +16,10 @@ struct ueth_data {
 	int rxsize;
 	int rxlen;			/* Total bytes available in rxbuf */
 	int rxptr;			/* Current position in rxbuf */
+	uint8_t *rxbufs;		/* Receive buffers for rxqueue */
+	struct bulk_queue *rxqueue;	/* Queued bulk-in transfers, or NULL */
+	int rxqsize;			/* Length of each queued transfer */
+	bool rxnoqueue;			/* Cannot queue bulk-in transfers */
 #else
 	struct eth_device eth_dev;	/* used with eth_register */
 	/* driver private */
@@ -58,7 +62,9 @@ int usb_ether_deregister(struct ueth_data *ueth);
 /**
  * usb_ether_receive() - recieve a packet from the bulk in endpoint
  *
- * The packet is stored in the internal buffer ready for processing.
+ * The packet is stored in the internal buffer ready for processing. With
+ * CONFIG_USB_ETHER_RX_QUEUE > 1 this does not wait for a transfer, but
+ * collects the oldest of those kept queued on the host controller.
  *
  * @ueth:	USB Ethernet device
  * @rxsize:	Maximum size to receive
@@ -67,6 +73,16 @@ int usb_ether_deregister(struct ueth_data *ueth);
  */
 int usb_ether_receive(struct ueth_data *ueth, int rxsize);
 
+/**
+ * usb_ether_rx_stop() - stop receiving packets
+ *
+ * If usb_ether_receive() has queued bulk-in transfers, this abandons them.
+ * Call it when the device is stopped.
+ *
+ * @ueth:	USB Ethernet device
+ */
+void usb_ether_rx_stop(struct ueth_data *ueth);
+
 /**
  * usb_ether_get_rx_bytes() - obtain bytes from the internal packet buffer
  *
@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Cooperative threads
+ *
+ * Each thread runs on its own stack until it yields with uthread_schedule()
+ * or waits with uthread_wait(). Threads only switch at those points, so no
+ * locking is needed, but a thread must not yield while it is in the middle
+ * of using a device which another thread may use.
+ */
+
+#ifndef __UTHREAD_H
+#define __UTHREAD_H
+
+#include <linux/types.h>
+
+#ifdef CONFIG_UTHREAD
+#include <asm/setjmp.h>
+#include <linux/list.h>
+
+/**
+ * struct uthread - A cooperative thread
+ *
+ * @fn: Function run by the thread
+ * @arg: Argument passed to @fn
+ * @ctx: Context saved when the thread last yielded
+ * @stack: Stack of the thread, allocated by uthread_create()
+ * @done: true once @fn has returned
+ * @allocated: true if this structure was allocated by uthread_create()
+ * @sibling: Node in the list of threads
+ */
+struct uthread {
+	void (*fn)(void *arg);
+	void *arg;
+	jmp_buf ctx;
+	void *stack;
+	bool done;
+	bool allocated;
+	struct list_head sibling;
+};
+
+/**
+ * uthread_create() - Create a thread, ready to run
+ *
+ * The thread first runs the next time the main thread calls
+ * uthread_schedule(). Its stack is freed once @fn returns.
+ *
+ * @uthr: Thread to set up, or NULL to allocate one which is freed when the
+ *	thread finishes
+ * @fn: Function to run
+ * @arg: Argument to pass to @fn
+ * @stack_sz: Stack size in bytes, or 0 for CONFIG_UTHREAD_STACK_SIZE
+ * @return 0 if OK, -ENOMEM if out of memory
+ */
+int uthread_create(struct uthread *uthr, void (*fn)(void *arg), void *arg,
+		   size_t stack_sz);
+
+/**
+ * uthread_schedule() - Let other threads run
+ *
+ * In the main thread this runs each thread which is ready once, until it
+ * yields or finishes. In any other thread it goes back to the main thread,
+ * returning the next time the main thread calls this function.
+ *
+ * @return true if another thread ran, false if there was none
+ */
+bool uthread_schedule(void);
+
+/**
+ * uthread_done() - Check whether a thread has finished
+ *
+ * @uthr: Thread to check, as passed to uthread_create()
+ * @return true if its function has returned
+ */
+bool uthread_done(struct uthread *uthr);
+
+/**
+ * uthread_wait() - Let other threads run until a condition holds
+ *
+ * This is meant for waiting on I/O: @cond checks a device or a flag set by
+ * another thread, and the other threads run in between each check.
+ *
+ * @cond: Function returning true once the wait is over
+ * @arg: Argument to pass to @cond
+ * @timeout_ms: Time to wait in milliseconds, or 0 to wait for ever
+ * @return 0 if @cond became true, -ETIMEDOUT if the time ran out first
+ */
+int uthread_wait(bool (*cond)(void *arg), void *arg, ulong timeout_ms);
+
+/**
+ * uthread_count() - Get the number of threads which have not finished
+ *
+ * @return number of threads, not counting the main thread
+ */
+int uthread_count(void);
+#else
+/* Not every architecture has setjmp(), so nothing here may need it */
+static inline bool uthread_schedule(void)
+{
+	return false;
+}
+#endif
+
+#endif /* __UTHREAD_H */
@@ -96,7 +96,7 @@ fdt_addr_t fdtdec_get_addr_size_fixed(const void *blob, int node,
 
 	debug("%s: %s: ", __func__, prop_name);
 
-	prop = fdt_getprop(blob, node, prop_name, &len);
+	prop = fdtdec_index_getprop(blob, node, prop_name, &len);
 	if (!prop) {
 		debug("(not found)\n");
 		return FDT_ADDR_T_NONE;
@@ -166,7 +166,7 @@ fdt_addr_t fdtdec_get_addr_size_auto_noparent(const void *blob, int node,
 
 	debug("%s: ", __func__);
 
-	parent = fdt_parent_offset(blob, node);
+	parent = fdtdec_index_parent_offset(blob, node);
 	if (parent < 0) {
 		debug("(no parent found)\n");
 		return FDT_ADDR_T_NONE;
@@ -267,7 +267,7 @@ uint64_t fdtdec_get_uint64(const void *blob, int node, const char *prop_name,
 	const unaligned_fdt64_t *cell64;
 	int length;
 
-	cell64 = fdt_getprop(blob, node, prop_name, &length);
+	cell64 = fdtdec_index_getprop(blob, node, prop_name, &length);
 	if (!cell64 || length < sizeof(*cell64))
 		return default_val;
 
@@ -285,7 +285,7 @@ int fdtdec_get_is_enabled(const void *blob, int node)
 	 *
 	 * http://www.mail-archive.com/u-boot@lists.denx.de/msg71598.html
 	 */
-	cell = fdt_getprop(blob, node, "status", NULL);
+	cell = fdtdec_index_getprop(blob, node, "status", NULL);
 	if (cell)
 		return strcmp(cell, "okay") == 0;
 	return 1;
@@ -609,11 +609,12 @@ int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 	int lookup;
 
 	debug("%s: %s\n", __func__, prop_name);
-	phandle = fdt_getprop(blob, node, prop_name, NULL);
+	phandle = fdtdec_index_getprop(blob, node, prop_name, NULL);
 	if (!phandle)
 		return -FDT_ERR_NOTFOUND;
 
-	lookup = fdt_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
+	lookup = fdtdec_index_node_offset_by_phandle(blob,
+						     fdt32_to_cpu(*phandle));
 	return lookup;
 }
 
@@ -636,7 +637,7 @@ static const void *get_prop_check_min_len(const void *blob, int node,
 	int len;
 
 	debug("%s: %s\n", __func__, prop_name);
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = fdtdec_index_getprop(blob, node, prop_name, &len);
 	if (!cell)
 		*err = -FDT_ERR_NOTFOUND;
 	else if (len < min_len)
@@ -672,7 +673,7 @@ int fdtdec_get_int_array_count(const void *blob, int node,
 	int i;
 
 	debug("%s: %s\n", __func__, prop_name);
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = fdtdec_index_getprop(blob, node, prop_name, &len);
 	if (!cell)
 		return -FDT_ERR_NOTFOUND;
 	elems = len / sizeof(u32);
@@ -701,7 +702,7 @@ int fdtdec_get_bool(const void *blob, int node, const char *prop_name)
 	int len;
 
 	debug("%s: %s\n", __func__, prop_name);
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = fdtdec_index_getprop(blob, node, prop_name, &len);
 	return cell != NULL;
 }
 
@@ -718,7 +719,7 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 	int phandle;
 
 	/* Retrieve the phandle list property */
-	list = fdt_getprop(blob, src_node, list_name, &size);
+	list = fdtdec_index_getprop(blob, src_node, list_name, &size);
 	if (!list)
 		return -ENOENT;
 	list_end = list + size / sizeof(*list);
@@ -744,8 +745,8 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 			 * below.
 			 */
 			if (cells_name || cur_index == index) {
-				node = fdt_node_offset_by_phandle(blob,
-								  phandle);
+				node = fdtdec_index_node_offset_by_phandle(
+						blob, phandle);
 				if (node < 0) {
 					debug("%s: could not find phandle\n",
 					      fdt_get_name(blob, src_node,
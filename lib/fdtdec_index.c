@@ -0,0 +1,387 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Lookup index for the flat control device tree
+ *
+ * libfdt finds a property by walking the properties of its node, a node
+ * by phandle by walking the whole tree, a node by path by walking the
+ * siblings at each level, and the parent of a node by walking down from
+ * the root. Without a live tree these walks are repeated for every read
+ * through the ofnode and fdtdec functions.
+ *
+ * After relocation, the first such read builds hash tables over the
+ * control FDT so that each of these lookups takes constant time. The
+ * index is rebuilt if gd->fdt_blob moves or the size of its structure or
+ * strings block changes, which happens whenever a node or property is
+ * added, removed or resized.
+ */
+
+#include <common.h>
+#include <fdtdec.h>
+#include <log.h>
+#include <malloc.h>
+#include <linux/libfdt.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+enum {
+	FDTDEC_INDEX_MAX_DEPTH	= 32,
+};
+
+/**
+ * struct fdtdec_index_node - information about a node
+ *
+ * @offset: Offset of node
+ * @parent: Offset of parent node, or -FDT_ERR_NOTFOUND for the root
+ * @phandle: Phandle of node, or 0 if none
+ */
+struct fdtdec_index_node {
+	int offset;
+	int parent;
+	u32 phandle;
+};
+
+/**
+ * struct fdtdec_index_prop - a slot in the property hash table
+ *
+ * @node: Offset of node containing the property
+ * @prop: Offset of property, or 0 if the slot is empty
+ */
+struct fdtdec_index_prop {
+	int node;
+	int prop;
+};
+
+/**
+ * struct fdtdec_index - index of the control FDT
+ *
+ * All hash tables use open addressing with linear probing, with at least
+ * twice as many slots as entries. Entries are added in tree order, so the
+ * first match found is the one libfdt would return. The node tables hold
+ * (index into @nodes) + 1, or 0 for an empty slot.
+ *
+ * @blob: Device tree that was indexed
+ * @struct_size: Size of its structure block when indexed
+ * @strings_size: Size of its strings block when indexed
+ * @failed: true if the index could not be built for this tree
+ * @node_count: Number of nodes
+ * @node_bits: log2 of the number of slots in each node table
+ * @prop_bits: log2 of the number of slots in the property table
+ * @nodes: Information about each node, in tree order
+ * @by_offset: Node table keyed by node offset
+ * @by_name: Node table keyed by parent offset and name without unit address
+ * @by_phandle: Node table keyed by phandle
+ * @props: Property table keyed by node offset and property name
+ */
+struct fdtdec_index {
+	const void *blob;
+	uint struct_size;
+	uint strings_size;
+	bool failed;
+	uint node_count;
+	uint node_bits;
+	uint prop_bits;
+	struct fdtdec_index_node *nodes;
+	u32 *by_offset;
+	u32 *by_name;
+	u32 *by_phandle;
+	struct fdtdec_index_prop *props;
+};
+
+static uint hash_int(u32 val, uint bits)
+{
+	return (val * 0x9e3779b1U) >> (32 - bits);
+}
+
+static u32 hash_str(const char *str, int len)
+{
+	u32 hash = 2166136261U;
+
+	while (len-- > 0 && *str)
+		hash = (hash ^ (u8)*str++) * 16777619U;
+
+	return hash;
+}
+
+/* Hash a node name or path component, ignoring any unit address */
+static uint hash_name(int parent, const char *name, int len, uint bits)
+{
+	const char *at = memchr(name, '@', len);
+
+	if (at)
+		len = at - name;
+
+	return hash_int(hash_str(name, len) ^ parent, bits);
+}
+
+static uint hash_prop(int node, const char *name, uint bits)
+{
+	return hash_int(hash_str(name, INT_MAX) ^ node, bits);
+}
+
+static void table_add(u32 *table, uint bits, uint slot, u32 val)
+{
+	uint mask = (1U << bits) - 1;
+
+	while (table[slot])
+		slot = (slot + 1) & mask;
+	table[slot] = val;
+}
+
+static uint table_bits(uint count)
+{
+	uint bits = 4;
+
+	while ((1U << bits) < count * 2)
+		bits++;
+
+	return bits;
+}
+
+static int fdtdec_index_build(struct fdtdec_index *idx, const void *blob)
+{
+	int stack[FDTDEC_INDEX_MAX_DEPTH];
+	uint node_count = 0, prop_count = 0;
+	uint node_slots, prop_slots, mask;
+	int node, prop, depth;
+	void *buf;
+
+	for (node = 0, depth = 0; node >= 0 && depth >= 0;
+	     node = fdt_next_node(blob, node, &depth)) {
+		if (depth >= FDTDEC_INDEX_MAX_DEPTH)
+			return -E2BIG;
+		node_count++;
+		fdt_for_each_property_offset(prop, blob, node)
+			prop_count++;
+	}
+
+	idx->node_bits = table_bits(node_count);
+	idx->prop_bits = table_bits(prop_count);
+	node_slots = 1U << idx->node_bits;
+	prop_slots = 1U << idx->prop_bits;
+	buf = calloc(1, node_count * sizeof(*idx->nodes) +
+		     3 * node_slots * sizeof(u32) +
+		     prop_slots * sizeof(*idx->props));
+	if (!buf)
+		return -ENOMEM;
+	idx->props = buf;
+	idx->nodes = (struct fdtdec_index_node *)(idx->props + prop_slots);
+	idx->by_offset = (u32 *)(idx->nodes + node_count);
+	idx->by_name = idx->by_offset + node_slots;
+	idx->by_phandle = idx->by_name + node_slots;
+
+	mask = prop_slots - 1;
+	for (node = 0, depth = 0; node >= 0 && depth >= 0;
+	     node = fdt_next_node(blob, node, &depth)) {
+		struct fdtdec_index_node *inode = &idx->nodes[idx->node_count];
+		u32 val = ++idx->node_count;
+
+		stack[depth] = node;
+		inode->offset = node;
+		inode->parent = depth ? stack[depth - 1] : -FDT_ERR_NOTFOUND;
+		inode->phandle = fdt_get_phandle(blob, node);
+		if (inode->phandle == (u32)-1)
+			inode->phandle = 0;
+
+		table_add(idx->by_offset, idx->node_bits,
+			  hash_int(node, idx->node_bits), val);
+		if (depth) {
+			const char *name;
+			int len;
+
+			name = fdt_get_name(blob, node, &len);
+			table_add(idx->by_name, idx->node_bits,
+				  hash_name(inode->parent, name, len,
+					    idx->node_bits), val);
+		}
+		if (inode->phandle)
+			table_add(idx->by_phandle, idx->node_bits,
+				  hash_int(inode->phandle, idx->node_bits),
+				  val);
+
+		fdt_for_each_property_offset(prop, blob, node) {
+			const char *name;
+			uint slot;
+
+			fdt_getprop_by_offset(blob, prop, &name, NULL);
+			slot = hash_prop(node, name, idx->prop_bits);
+			while (idx->props[slot].prop)
+				slot = (slot + 1) & mask;
+			idx->props[slot].node = node;
+			idx->props[slot].prop = prop;
+		}
+	}
+	log_debug("indexed %u nodes, %u properties\n", node_count, prop_count);
+
+	return 0;
+}
+
+void fdtdec_index_reset(void)
+{
+	struct fdtdec_index *idx = gd->fdtdec_index;
+
+	if (idx) {
+		free(idx->props);
+		free(idx);
+		gd->fdtdec_index = NULL;
+	}
+}
+
+/* Get the index for @blob, building it if needed; NULL if not available */
+static struct fdtdec_index *fdtdec_index_get(const void *blob)
+{
+	struct fdtdec_index *idx = gd->fdtdec_index;
+
+	if (!blob || blob != gd->fdt_blob || !(gd->flags & GD_FLG_RELOC))
+		return NULL;
+	if (idx && idx->blob == blob &&
+	    idx->struct_size == fdt_size_dt_struct(blob) &&
+	    idx->strings_size == fdt_size_dt_strings(blob))
+		return idx->failed ? NULL : idx;
+
+	fdtdec_index_reset();
+	idx = calloc(1, sizeof(*idx));
+	if (!idx)
+		return NULL;
+	idx->blob = blob;
+	idx->struct_size = fdt_size_dt_struct(blob);
+	idx->strings_size = fdt_size_dt_strings(blob);
+	gd->fdtdec_index = idx;
+	if (fdtdec_index_build(idx, blob)) {
+		/* Don't try again until the tree changes */
+		log_warning("Cannot index device tree\n");
+		free(idx->props);
+		idx->props = NULL;
+		idx->failed = true;
+		return NULL;
+	}
+
+	return idx;
+}
+
+static struct fdtdec_index_node *find_node(struct fdtdec_index *idx, int node)
+{
+	uint mask = (1U << idx->node_bits) - 1;
+	uint slot = hash_int(node, idx->node_bits);
+	u32 val;
+
+	for (; (val = idx->by_offset[slot]); slot = (slot + 1) & mask) {
+		if (idx->nodes[val - 1].offset == node)
+			return &idx->nodes[val - 1];
+	}
+
+	return NULL;
+}
+
+const void *fdtdec_index_getprop(const void *blob, int node, const char *name,
+				 int *lenp)
+{
+	struct fdtdec_index *idx = fdtdec_index_get(blob);
+	const struct fdtdec_index_prop *entry;
+	uint slot, mask;
+
+	if (!idx || node < 0)
+		return fdt_getprop(blob, node, name, lenp);
+
+	mask = (1U << idx->prop_bits) - 1;
+	slot = hash_prop(node, name, idx->prop_bits);
+	for (; (entry = &idx->props[slot])->prop; slot = (slot + 1) & mask) {
+		const char *pname;
+		const void *val;
+
+		if (entry->node != node)
+			continue;
+		val = fdt_getprop_by_offset(blob, entry->prop, &pname, lenp);
+		if (!strcmp(pname, name))
+			return val;
+	}
+
+	/* Let libfdt report the error if this is not a node */
+	if (!find_node(idx, node))
+		return fdt_getprop(blob, node, name, lenp);
+	if (lenp)
+		*lenp = -FDT_ERR_NOTFOUND;
+
+	return NULL;
+}
+
+int fdtdec_index_node_offset_by_phandle(const void *blob, u32 phandle)
+{
+	struct fdtdec_index *idx = fdtdec_index_get(blob);
+	uint slot, mask;
+	u32 val;
+
+	if (!idx || !phandle || phandle == (u32)-1)
+		return fdt_node_offset_by_phandle(blob, phandle);
+
+	mask = (1U << idx->node_bits) - 1;
+	slot = hash_int(phandle, idx->node_bits);
+	for (; (val = idx->by_phandle[slot]); slot = (slot + 1) & mask) {
+		if (idx->nodes[val - 1].phandle == phandle)
+			return idx->nodes[val - 1].offset;
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+int fdtdec_index_parent_offset(const void *blob, int node)
+{
+	struct fdtdec_index *idx = fdtdec_index_get(blob);
+	struct fdtdec_index_node *inode;
+
+	inode = idx && node >= 0 ? find_node(idx, node) : NULL;
+	if (!inode)
+		return fdt_parent_offset(blob, node);
+
+	return inode->parent;
+}
+
+/* Find a subnode, matching names in the same way as libfdt */
+static int find_subnode(struct fdtdec_index *idx, int parent,
+			const char *name, int len)
+{
+	uint mask = (1U << idx->node_bits) - 1;
+	uint slot = hash_name(parent, name, len, idx->node_bits);
+	u32 val;
+
+	for (; (val = idx->by_name[slot]); slot = (slot + 1) & mask) {
+		struct fdtdec_index_node *inode = &idx->nodes[val - 1];
+		const char *nname;
+		int nlen;
+
+		if (inode->parent != parent)
+			continue;
+		nname = fdt_get_name(idx->blob, inode->offset, &nlen);
+		if (nlen < len || memcmp(nname, name, len))
+			continue;
+		if (!nname[len] ||
+		    (nname[len] == '@' && !memchr(name, '@', len)))
+			return inode->offset;
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+int fdtdec_index_path_offset(const void *blob, const char *path)
+{
+	struct fdtdec_index *idx = fdtdec_index_get(blob);
+	const char *end;
+	int node = 0;
+
+	/* Leave aliases and options to libfdt */
+	if (!idx || *path != '/' || strchr(path, ':'))
+		return fdt_path_offset(blob, path);
+
+	while (*path) {
+		while (*path == '/')
+			path++;
+		if (!*path)
+			break;
+		end = strchrnul(path, '/');
+		node = find_subnode(idx, node, path, end - path);
+		if (node < 0)
+			return node;
+		path = end;
+	}
+
+	return node;
+}
@@ -31,10 +31,17 @@
 # endif
 #else				/* U-Boot build */
 # include <common.h>
+# include <malloc_arena.h>
+# include <asm/unaligned.h>
 # include <linux/string.h>
 # include <linux/ctype.h>
 #endif
 
+#ifdef USE_HOSTCC
+# define arena_alloc(size)	malloc(size)
+# define arena_free(ptr)	free(ptr)
+#endif
+
 #ifndef	CONFIG_ENV_MIN_ENTRIES	/* minimum number of entries */
 #define	CONFIG_ENV_MIN_ENTRIES 64
 #endif
@@ -288,24 +295,29 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 	return -1;
 }
 
-int hsearch_r(struct env_entry item, enum env_action action,
-	      struct env_entry **retval, struct hsearch_data *htab, int flag)
+/* Compute an value for the given string. Perhaps use a better method. */
+static unsigned int hash_key(const char *key, unsigned int len)
 {
-	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
-	unsigned int idx;
-	unsigned int first_deleted = 0;
-	int ret;
+	unsigned int hval = len;
+	unsigned int count = len;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
 	while (count-- > 0) {
 		hval <<= 4;
-		hval += item.key[count];
+		hval += key[count];
 	}
 
+	return hval;
+}
+
+/* hsearch_r() with the hash of item.key supplied by the caller */
+static int hsearch_hashed_r(struct env_entry item, unsigned int hval,
+			    enum env_action action, struct env_entry **retval,
+			    struct hsearch_data *htab, int flag)
+{
+	unsigned int idx;
+	unsigned int first_deleted = 0;
+	int ret;
+
 	/*
 	 * First hash function:
 	 * simply take the modul but prevent zero.
@@ -436,6 +448,13 @@ int hsearch_r(struct env_entry item, enum env_action action,
 	return 0;
 }
 
+int hsearch_r(struct env_entry item, enum env_action action,
+	      struct env_entry **retval, struct hsearch_data *htab, int flag)
+{
+	return hsearch_hashed_r(item, hash_key(item.key, strlen(item.key)),
+				action, retval, htab, flag);
+}
+
 
 /*
  * hdelete()
@@ -724,6 +743,70 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 
 	return size;
 }
+
+#ifdef CONFIG_ENV_BINARY
+/*
+ * Export the data stored in the hash table in binary form (see struct
+ * env_bin_hdr). As with hexport_r(), entries are sorted by key, so that
+ * saving an unchanged environment gives the same result.
+ */
+ssize_t hexport_bin_r(struct hsearch_data *htab, char *buf, size_t size)
+{
+	struct env_entry *list[htab->size];
+	struct env_bin_hdr *hdr = (struct env_bin_hdr *)buf;
+	size_t totlen;
+	char *p;
+	int i, n;
+
+	for (i = 1, n = 0, totlen = sizeof(*hdr); i <= htab->size; ++i) {
+		if (htab->table[i].used > 0) {
+			struct env_entry *ep = &htab->table[i].entry;
+			size_t name_len = strlen(ep->key);
+
+			if (name_len > U16_MAX) {
+				__set_errno(EINVAL);
+				return -1;
+			}
+			list[n++] = ep;
+			totlen += ENV_BIN_ENTRY_SIZE(name_len, strlen(ep->data));
+		}
+	}
+	if (n > U16_MAX) {
+		__set_errno(EINVAL);
+		return -1;
+	}
+
+	qsort(list, n, sizeof(struct env_entry *), cmpkey);
+
+	if (size < totlen) {
+		printf("Env export buffer too small: %lu, but need %lu\n",
+		       (ulong)size, (ulong)totlen);
+		__set_errno(ENOMEM);
+		return -1;
+	}
+	memset(buf, '\0', size);
+	memcpy(hdr->magic, ENV_BIN_MAGIC, ENV_BIN_MAGIC_LEN);
+	hdr->version = ENV_BIN_VERSION;
+	put_unaligned_le16(n, &hdr->count);
+	put_unaligned_le32(totlen - sizeof(*hdr), &hdr->size);
+
+	for (i = 0, p = (char *)(hdr + 1); i < n; ++i) {
+		struct env_bin_entry *be = (struct env_bin_entry *)p;
+		size_t name_len = strlen(list[i]->key);
+		size_t value_len = strlen(list[i]->data);
+
+		put_unaligned_le32(hash_key(list[i]->key, name_len), &be->hash);
+		put_unaligned_le16(name_len, &be->name_len);
+		put_unaligned_le32(value_len, &be->value_len);
+		memcpy(be + 1, list[i]->key, name_len);
+		memcpy((char *)(be + 1) + name_len + 1, list[i]->data,
+		       value_len);
+		p += ENV_BIN_ENTRY_SIZE(name_len, value_len);
+	}
+
+	return totlen;
+}
+#endif
 #endif
 
 
@@ -811,8 +894,11 @@ int himport_r(struct hsearch_data *htab,
 		return 0;
 	}
 
-	/* we allocate new space to make sure we can write to the array */
-	if ((data = malloc(size + 1)) == NULL) {
+	/*
+	 * we allocate new space to make sure we can write to the array; it is
+	 * only needed while parsing, so take it from the arena
+	 */
+	if ((data = arena_alloc(size + 1)) == NULL) {
 		debug("himport_r: can't malloc %lu bytes\n", (ulong)size + 1);
 		__set_errno(ENOMEM);
 		return 0;
@@ -864,13 +950,13 @@ int himport_r(struct hsearch_data *htab,
 		debug("Create Hash Table: N=%d\n", nent);
 
 		if (hcreate_r(nent, htab) == 0) {
-			free(data);
+			arena_free(data);
 			return 0;
 		}
 	}
 
 	if (!size) {
-		free(data);
+		arena_free(data);
 		return 1;		/* everything OK */
 	}
 	if(crlf_is_lf) {
@@ -936,7 +1022,7 @@ int himport_r(struct hsearch_data *htab,
 		if (*name == 0) {
 			debug("INSERT: unable to use an empty key\n");
 			__set_errno(EINVAL);
-			free(data);
+			arena_free(data);
 			return 0;
 		}
 
@@ -962,7 +1048,7 @@ int himport_r(struct hsearch_data *htab,
 	} while ((dp < data + size) && *dp);	/* size check needed for text */
 						/* without '\0' termination */
 	debug("INSERT: free(data = %p)\n", data);
-	free(data);
+	arena_free(data);
 
 	if (flag & H_NOCLEAR)
 		goto end;
@@ -990,6 +1076,83 @@ end:
 	return 1;		/* everything OK */
 }
 
+#ifdef CONFIG_ENV_BINARY
+/*
+ * Import a binary environment (see struct env_bin_hdr). Names and values
+ * are used where they are, without copying the buffer or parsing it, and
+ * the stored hashes are used to find their slots.
+ */
+int himport_bin_r(struct hsearch_data *htab, const char *env, size_t size,
+		  int flag)
+{
+	const struct env_bin_hdr *hdr = (const struct env_bin_hdr *)env;
+	const char *p, *end;
+	uint count, i;
+
+	if (htab == NULL || size < sizeof(*hdr) || !env_is_binary(env) ||
+	    hdr->version != ENV_BIN_VERSION ||
+	    get_unaligned_le32(&hdr->size) > size - sizeof(*hdr)) {
+		__set_errno(EINVAL);
+		return 0;
+	}
+	count = get_unaligned_le16(&hdr->count);
+	p = (const char *)(hdr + 1);
+	end = p + get_unaligned_le32(&hdr->size);
+
+#if CONFIG_IS_ENABLED(ENV_APPEND)
+	flag |= H_NOCLEAR;
+#endif
+
+	if ((flag & H_NOCLEAR) == 0 && htab->table)
+		hdestroy_r(htab);
+
+	/* Size the table as himport_r() does */
+	if (!htab->table) {
+		int nent = CONFIG_ENV_MIN_ENTRIES + size / 8;
+
+		if (nent > CONFIG_ENV_MAX_ENTRIES)
+			nent = CONFIG_ENV_MAX_ENTRIES;
+		if (hcreate_r(nent, htab) == 0)
+			return 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		const struct env_bin_entry *be = (const void *)p;
+		uint name_len, value_len;
+		struct env_entry e, *rv;
+
+		if (end - p < sizeof(*be))
+			break;
+		name_len = get_unaligned_le16(&be->name_len);
+		value_len = get_unaligned_le32(&be->value_len);
+		if (!name_len || value_len > end - p ||
+		    end - p < ENV_BIN_ENTRY_SIZE(name_len, value_len))
+			break;
+		e.key = (const char *)(be + 1);
+		e.data = (char *)e.key + name_len + 1;
+		if (e.key[name_len] || e.data[value_len])
+			break;
+
+		hsearch_hashed_r(e, get_unaligned_le32(&be->hash), ENV_ENTER,
+				 &rv, htab, flag);
+#if !CONFIG_IS_ENABLED(ENV_WRITEABLE_LIST)
+		if (rv == NULL) {
+			printf("himport_bin_r: can't insert \"%s=%s\" into hash table\n",
+			       e.key, e.data);
+		}
+#endif
+		p += ENV_BIN_ENTRY_SIZE(name_len, value_len);
+	}
+	if (i != count) {
+		debug("himport_bin_r: bad entry %u\n", i);
+		__set_errno(EINVAL);
+		return 0;
+	}
+
+	return 1;		/* everything OK */
+}
+#endif
+
 /*
  * hwalk_r()
  */
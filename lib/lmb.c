@@ -11,6 +11,7 @@
 #include <lmb.h>
 #include <log.h>
 #include <malloc.h>
+#include <memprof.h>
 
 #define LMB_ALLOC_ANYWHERE	0
 
@@ -109,6 +110,7 @@ static void lmb_reserve_common(struct lmb *lmb, void *fdt_blob)
 {
 	arch_lmb_reserve(lmb);
 	board_lmb_reserve(lmb);
+	lmb_auto_reserve(lmb);
 
 	if (IMAGE_ENABLE_OF_LIBFDT && fdt_blob)
 		boot_fdt_add_mem_rsv_regions(lmb, fdt_blob);
@@ -239,6 +241,7 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	/* Didn't find the region */
 	if (i == rgn->cnt)
 		return -1;
+	memprof_lmb(MEMPROF_LMB_FREE, base, size);
 
 	/* Check to see if we are removing entire region */
 	if ((rgnbegin == base) && (rgnend == end)) {
@@ -270,8 +273,13 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 {
 	struct lmb_region *_rgn = &(lmb->reserved);
+	long ret;
 
-	return lmb_add_region(_rgn, base, size);
+	ret = lmb_add_region(_rgn, base, size);
+	if (ret >= 0)
+		memprof_lmb(MEMPROF_LMB_RESERVE, base, size);
+
+	return ret;
 }
 
 static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
@@ -342,6 +350,7 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phy
 				if (lmb_add_region(&lmb->reserved, base,
 						   size) < 0)
 					return 0;
+				memprof_lmb(MEMPROF_LMB_ALLOC, base, size);
 				return base;
 			}
 			res_base = lmb->reserved.region[rgn].base;
@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Automatic load-address allocation using LMB
+ *
+ * Commands which load an image (load, fatload, tftpboot, ...) can be given
+ * the address "auto[:<var>[:<size>]]" instead of a fixed address. A region
+ * is then taken from free memory below the bootm mapping limit and its
+ * address is written to <var> (default "loadaddr"). Regions stay reserved
+ * until the same variable is allocated again, so the kernel, device tree
+ * and ramdisk never overlap and bootm can use them where they are.
+ */
+
+#define LOG_CATEGORY LOGC_BOOT
+
+#include <common.h>
+#include <env.h>
+#include <image.h>
+#include <lmb.h>
+#include <log.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#ifndef CONFIG_SYS_FDT_PAD
+#define CONFIG_SYS_FDT_PAD 0x3000
+#endif
+
+enum {
+	LMB_AUTO_MAX_REGIONS	= 4,
+	LMB_AUTO_ALIGN		= SZ_4K,
+	LMB_AUTO_NAME_LEN	= 32,
+};
+
+/**
+ * struct lmb_auto_region - an automatically allocated load region
+ *
+ * @name: Name of the environment variable holding the address ("" if free)
+ * @base: Base address of region
+ * @size: Size of region in bytes
+ */
+struct lmb_auto_region {
+	char name[LMB_AUTO_NAME_LEN];
+	phys_addr_t base;
+	phys_size_t size;
+};
+
+static struct lmb_auto_region lmb_auto_regions[LMB_AUTO_MAX_REGIONS];
+
+/* Region currently being filled, which must not be reserved */
+static struct lmb_auto_region *lmb_auto_loading;
+
+static struct lmb_auto_region *lmb_auto_find_name(const char *name)
+{
+	int i;
+
+	for (i = 0; i < LMB_AUTO_MAX_REGIONS; i++) {
+		if (!strcmp(lmb_auto_regions[i].name, name))
+			return &lmb_auto_regions[i];
+	}
+
+	return NULL;
+}
+
+static phys_size_t lmb_auto_round(phys_size_t size)
+{
+	/* Leave room for fixups in case this is a device tree */
+	return ALIGN(size + CONFIG_SYS_FDT_PAD, LMB_AUTO_ALIGN);
+}
+
+bool lmb_auto_requested(const char *arg)
+{
+	return !strncmp(arg, "auto", 4) && (!arg[4] || arg[4] == ':');
+}
+
+void lmb_auto_reserve(struct lmb *lmb)
+{
+	int i;
+
+	for (i = 0; i < LMB_AUTO_MAX_REGIONS; i++) {
+		struct lmb_auto_region *rgn = &lmb_auto_regions[i];
+
+		if (*rgn->name && rgn != lmb_auto_loading)
+			lmb_reserve(lmb, rgn->base, rgn->size);
+	}
+}
+
+int lmb_auto_alloc(const char *arg, phys_size_t size, ulong *addrp)
+{
+	struct lmb_auto_region *rgn;
+	char name[LMB_AUTO_NAME_LEN];
+	const char *p, *q;
+	phys_addr_t base;
+	struct lmb lmb;
+
+	/* Parse "auto[:<var>[:<size>]]" */
+	strlcpy(name, "loadaddr", sizeof(name));
+	p = arg + 4;
+	if (*p == ':') {
+		p++;
+		q = strchr(p, ':');
+		if (!q)
+			q = p + strlen(p);
+		if (q != p)
+			strlcpy(name, p, min((int)(q - p) + 1, (int)sizeof(name)));
+		if (*q == ':')
+			size = max(size, (phys_size_t)simple_strtoul(q + 1,
+								     NULL, 16));
+	}
+	if (!size)
+		size = env_get_hex("autoload_size", CONFIG_LMB_AUTO_DEFAULT_SIZE);
+
+	/* Drop the previous allocation for this variable, if any */
+	rgn = lmb_auto_find_name(name);
+	if (!rgn)
+		rgn = lmb_auto_find_name("");
+	if (!rgn) {
+		log_err("No free auto-load slot for '%s'\n", name);
+		return -ENOSPC;
+	}
+	*rgn->name = '\0';
+	lmb_auto_loading = NULL;
+
+	size = lmb_auto_round(size);
+	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+	base = __lmb_alloc_base(&lmb, size, LMB_AUTO_ALIGN,
+				env_get_bootm_low() + env_get_bootm_mapsize());
+	if (!base) {
+		log_err("Cannot find %llx bytes for '%s'\n",
+			(unsigned long long)size, name);
+		return -ENOMEM;
+	}
+
+	strlcpy(rgn->name, name, sizeof(rgn->name));
+	rgn->base = base;
+	rgn->size = size;
+	lmb_auto_loading = rgn;
+	env_set_hex(name, base);
+	log_debug("%s: %llx bytes at %llx\n", name, (unsigned long long)size,
+		  (unsigned long long)base);
+	*addrp = base;
+
+	return 0;
+}
+
+void lmb_auto_done(ulong addr, phys_size_t size)
+{
+	struct lmb_auto_region *rgn = lmb_auto_loading;
+
+	if (!rgn || rgn->base != addr)
+		return;
+	lmb_auto_loading = NULL;
+	if (!size) {
+		/* The load failed, so release the region */
+		*rgn->name = '\0';
+		return;
+	}
+
+	/*
+	 * Trim (or grow, if the transfer ran past the size hint) the region
+	 * to what was actually loaded. Growing is safe since the loader was
+	 * limited to free memory.
+	 */
+	rgn->size = lmb_auto_round(size);
+}
+
+bool lmb_auto_fits(ulong addr, ulong size, ulong limit)
+{
+	int i;
+
+	for (i = 0; i < LMB_AUTO_MAX_REGIONS; i++) {
+		struct lmb_auto_region *rgn = &lmb_auto_regions[i];
+
+		if (!*rgn->name)
+			continue;
+		if (addr < rgn->base || addr + size > rgn->base + rgn->size)
+			continue;
+
+		return !limit || addr + size <= limit;
+	}
+
+	return false;
+}
+
+void lmb_auto_show(void)
+{
+	int i;
+
+	for (i = 0; i < LMB_AUTO_MAX_REGIONS; i++) {
+		struct lmb_auto_region *rgn = &lmb_auto_regions[i];
+
+		if (*rgn->name)
+			printf("%-16s %08llx %08llx\n", rgn->name,
+			       (unsigned long long)rgn->base,
+			       (unsigned long long)rgn->size);
+	}
+}
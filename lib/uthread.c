@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Cooperative threads
+ *
+ * The main thread runs the others in turn from uthread_schedule(). A thread
+ * always yields back to the main thread, never straight to another thread,
+ * so each switch is a single setjmp()/longjmp() pair.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <time.h>
+#include <uthread.h>
+#include <watchdog.h>
+#include <linux/errno.h>
+
+static LIST_HEAD(uthread_list);
+/* Context of the main thread, saved while another thread runs */
+static jmp_buf uthread_main_ctx;
+/* Thread which is running, or NULL for the main thread */
+static struct uthread *uthread_current;
+
+static void uthread_entry(void)
+{
+	struct uthread *uthr = uthread_current;
+
+	uthr->fn(uthr->arg);
+	uthr->done = true;
+	longjmp(uthread_main_ctx, 1);
+}
+
+int uthread_create(struct uthread *uthr, void (*fn)(void *arg), void *arg,
+		   size_t stack_sz)
+{
+	bool allocated = !uthr;
+	int ret;
+
+	if (!stack_sz)
+		stack_sz = CONFIG_UTHREAD_STACK_SIZE;
+	stack_sz = ALIGN(stack_sz, 16);
+
+	if (allocated) {
+		uthr = malloc(sizeof(*uthr));
+		if (!uthr)
+			return -ENOMEM;
+	}
+	memset(uthr, '\0', sizeof(*uthr));
+	uthr->fn = fn;
+	uthr->arg = arg;
+	uthr->allocated = allocated;
+	uthr->stack = memalign(16, stack_sz);
+	if (!uthr->stack) {
+		ret = -ENOMEM;
+		goto err;
+	}
+
+	ret = initjmp(uthr->ctx, uthread_entry, uthr->stack, stack_sz);
+	if (ret)
+		goto err_stack;
+	list_add_tail(&uthr->sibling, &uthread_list);
+
+	return 0;
+
+err_stack:
+	free(uthr->stack);
+err:
+	if (allocated)
+		free(uthr);
+	return ret;
+}
+
+bool uthread_schedule(void)
+{
+	struct uthread *uthr, *next;
+	bool ran = false;
+
+	if (uthread_current) {
+		/* Go back to the main thread, which resumes us later */
+		if (!setjmp(uthread_current->ctx))
+			longjmp(uthread_main_ctx, 1);
+		return true;
+	}
+
+	list_for_each_entry_safe(uthr, next, &uthread_list, sibling) {
+		uthread_current = uthr;
+		if (!setjmp(uthread_main_ctx))
+			longjmp(uthr->ctx, 1);
+		uthread_current = NULL;
+		ran = true;
+
+		/* The thread's stack is no longer in use once it is done */
+		if (uthr->done) {
+			list_del(&uthr->sibling);
+			free(uthr->stack);
+			if (uthr->allocated)
+				free(uthr);
+		}
+	}
+
+	return ran;
+}
+
+bool uthread_done(struct uthread *uthr)
+{
+	return uthr->done;
+}
+
+int uthread_wait(bool (*cond)(void *arg), void *arg, ulong timeout_ms)
+{
+	ulong start = get_timer(0);
+
+	while (!cond(arg)) {
+		if (timeout_ms && get_timer(start) >= timeout_ms)
+			return -ETIMEDOUT;
+		WATCHDOG_RESET();
+		uthread_schedule();
+	}
+
+	return 0;
+}
+
+int uthread_count(void)
+{
+	struct uthread *uthr;
+	int count = 0;
+
+	list_for_each_entry(uthr, &uthread_list, sibling)
+		count++;
+
+	return count;
+}
@@ -40,6 +40,30 @@ ulong		arp_wait_timer_start;
 int		arp_wait_try;
 uchar	       *arp_tx_packet; /* THE ARP transmit packet */
 static uchar	arp_tx_packet_buf[PKTSIZE_ALIGN + PKTALIGN];
+ulong		arp_wait_total;
+int		arp_cache_hits;
+
+#ifdef CONFIG_NET_ARP_CACHE
+#define ARP_CACHE_SIZE		4
+#define ARP_CACHE_TTL		(CONFIG_NET_ARP_CACHE_TTL * 1000UL)
+
+/**
+ * struct arp_cache_entry - An address learnt from ARP
+ *
+ * @ip: IP address, or 0 if the entry is free
+ * @ethaddr: Ethernet address of @ip
+ * @time: Time at which it was learnt, in milliseconds
+ */
+struct arp_cache_entry {
+	struct in_addr ip;
+	uchar ethaddr[ARP_HLEN];
+	ulong time;
+};
+
+static struct arp_cache_entry arp_cache[ARP_CACHE_SIZE];
+/* Ethernet device which the cached addresses were learnt on */
+static void *arp_cache_dev;
+#endif
 
 void arp_init(void)
 {
@@ -99,6 +123,81 @@ void arp_request(void)
 	arp_raw_request(net_ip, net_null_ethaddr, net_arp_wait_reply_ip);
 }
 
+#ifdef CONFIG_NET_ARP_CACHE
+void arp_cache_flush(void)
+{
+	memset(arp_cache, '\0', sizeof(arp_cache));
+}
+
+/* Find @ip in the cache, emptying it first if the device has changed */
+static struct arp_cache_entry *arp_cache_find(struct in_addr ip)
+{
+	int i;
+
+	if (arp_cache_dev != eth_get_dev()) {
+		arp_cache_flush();
+		arp_cache_dev = eth_get_dev();
+		return NULL;
+	}
+	for (i = 0; i < ARP_CACHE_SIZE; i++) {
+		if (arp_cache[i].ip.s_addr == ip.s_addr)
+			return &arp_cache[i];
+	}
+
+	return NULL;
+}
+
+static void arp_cache_add(struct in_addr ip, const uchar *ethaddr)
+{
+	struct arp_cache_entry *entry;
+	int i;
+
+	if (!ip.s_addr || !is_valid_ethaddr(ethaddr))
+		return;
+	entry = arp_cache_find(ip);
+	for (i = 0; !entry && i < ARP_CACHE_SIZE; i++) {
+		/* Use a free entry if there is one, else the oldest */
+		if (!arp_cache[i].ip.s_addr)
+			entry = &arp_cache[i];
+	}
+	if (!entry) {
+		entry = &arp_cache[0];
+		for (i = 1; i < ARP_CACHE_SIZE; i++) {
+			if (get_timer(arp_cache[i].time) >
+			    get_timer(entry->time))
+				entry = &arp_cache[i];
+		}
+	}
+	entry->ip = ip;
+	memcpy(entry->ethaddr, ethaddr, ARP_HLEN);
+	entry->time = get_timer(0);
+}
+
+bool arp_cache_lookup(struct in_addr ip, uchar *ethaddr)
+{
+	struct arp_cache_entry *entry;
+
+	/* Off-subnet hosts are reached through the gateway, as arp_request() */
+	if ((ip.s_addr & net_netmask.s_addr) !=
+	    (net_ip.s_addr & net_netmask.s_addr) && net_gateway.s_addr)
+		ip = net_gateway;
+
+	entry = arp_cache_find(ip);
+	if (!entry)
+		return false;
+	if (get_timer(entry->time) > ARP_CACHE_TTL) {
+		entry->ip.s_addr = 0;
+		return false;
+	}
+	debug_cond(DEBUG_DEV_PKT, "ARP cache has %pI4 at %pM\n", &ip,
+		   entry->ethaddr);
+	memcpy(ethaddr, entry->ethaddr, ARP_HLEN);
+	arp_cache_hits++;
+
+	return true;
+}
+#endif
+
 int arp_timeout_check(void)
 {
 	ulong t;
@@ -172,6 +271,10 @@ void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 		net_copy_ip(&arp->ar_tpa, &arp->ar_spa);
 		memcpy(&arp->ar_sha, net_ethaddr, ARP_HLEN);
 		net_copy_ip(&arp->ar_spa, &net_ip);
+#ifdef CONFIG_NET_ARP_CACHE
+		/* The asker will most likely be talked to next */
+		arp_cache_add(net_read_ip(&arp->ar_tpa), &arp->ar_tha);
+#endif
 
 #ifdef CONFIG_CMD_LINK_LOCAL
 		/*
@@ -216,6 +319,12 @@ void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 			if (arp_wait_packet_ethaddr != NULL)
 				memcpy(arp_wait_packet_ethaddr,
 				       &arp->ar_sha, ARP_HLEN);
+#ifdef CONFIG_NET_ARP_CACHE
+			arp_cache_add(reply_ip_addr, &arp->ar_sha);
+#endif
+			/* each earlier try waited ARP_TIMEOUT for nothing */
+			arp_wait_total += get_timer(arp_wait_timer_start) +
+				(arp_wait_try - 1) * ARP_TIMEOUT;
 
 			net_get_arp_handler()((uchar *)arp, 0, reply_ip_addr,
 					      0, len);
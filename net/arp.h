@@ -21,6 +21,9 @@ extern int arp_wait_tx_packet_size;
 extern ulong arp_wait_timer_start;
 extern int arp_wait_try;
 extern uchar *arp_tx_packet;
+/* Time spent waiting for ARP replies and cache hits, for net_loop() stats */
+extern ulong arp_wait_total;
+extern int arp_cache_hits;
 
 void arp_init(void);
 void arp_request(void);
@@ -29,4 +32,30 @@ void arp_raw_request(struct in_addr source_ip, const uchar *targetEther,
 int arp_timeout_check(void);
 void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len);
 
+#ifdef CONFIG_NET_ARP_CACHE
+/**
+ * arp_cache_lookup() - Look up the Ethernet address to send a packet to
+ *
+ * @ip: Destination IP address, which may be reached through the gateway
+ * @ethaddr: Returns the Ethernet address of @ip or of the gateway
+ * @return true if the address was found in the cache, false if an ARP
+ *	request is needed
+ */
+bool arp_cache_lookup(struct in_addr ip, uchar *ethaddr);
+
+/**
+ * arp_cache_flush() - Forget every address in the ARP cache
+ */
+void arp_cache_flush(void);
+#else
+static inline bool arp_cache_lookup(struct in_addr ip, uchar *ethaddr)
+{
+	return false;
+}
+
+static inline void arp_cache_flush(void)
+{
+}
+#endif
+
 #endif /* __ARP_H__ */
@@ -14,6 +14,7 @@
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
 #include <net/pcap.h>
+#include "arp.h"
 #include "eth_internal.h"
 #include <eth_phy.h>
 
@@ -331,6 +332,16 @@ void eth_halt(void)
 		priv->state = ETH_STATE_PASSIVE;
 }
 
+int eth_get_link(struct udevice *dev)
+{
+	struct eth_ops *ops = eth_get_ops(dev);
+
+	if (!ops->get_link)
+		return -ENOSYS;
+
+	return ops->get_link(dev);
+}
+
 int eth_is_active(struct udevice *dev)
 {
 	struct eth_device_priv *priv;
@@ -366,6 +377,77 @@ int eth_send(void *packet, int length)
 	return ret;
 }
 
+#ifdef CONFIG_NET_RX_LEND
+/* Largest number of header bytes which may go below lent memory */
+#define ETH_RX_LEND_HDR		256
+
+/* Memory lent for the next expected packet; rx_lend.buf is NULL if none */
+static struct eth_rx_lend rx_lend;
+/* Frame put in lent memory and still being processed, or NULL */
+static uchar *rx_borrowed;
+/* What the frame headers covered, to be put back after processing */
+static uchar rx_saved[ETH_RX_LEND_HDR];
+static int rx_saved_len;
+
+void eth_rx_lend(const struct eth_rx_lend *lend)
+{
+	rx_lend.buf = NULL;
+	if (!lend || lend->len <= 0 || lend->match_len > lend->hdr_len ||
+	    lend->match_len > sizeof(lend->match) ||
+	    ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + lend->hdr_len > ETH_RX_LEND_HDR)
+		return;
+	rx_lend = *lend;
+}
+
+uchar *eth_rx_borrow(const uchar *frame, int len)
+{
+	const struct ethernet_hdr *et = (const void *)frame;
+	const struct ip_udp_hdr *ip = (const void *)frame + ETHER_HDR_SIZE;
+	int hdr_len = ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + rx_lend.hdr_len;
+	uchar *dest;
+
+	if (!rx_lend.buf || rx_borrowed)
+		return NULL;
+
+	/* Only a whole UDP datagram without VLAN tag or IP options will do */
+	if (len < ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + rx_lend.match_len ||
+	    len > hdr_len + rx_lend.len)
+		return NULL;
+	if (et->et_protlen != htons(PROT_IP) || ip->ip_hl_v != 0x45 ||
+	    ip->ip_p != IPPROTO_UDP ||
+	    (ip->ip_off & htons(IP_OFFS | IP_FLAGS_MFRAG)) ||
+	    ip->udp_dst != htons(rx_lend.dport) ||
+	    memcmp((void *)ip + IP_UDP_HDR_SIZE, rx_lend.match,
+		   rx_lend.match_len))
+		return NULL;
+
+	/* The IP header must be 16-bit aligned, as in net_rx_packets[] */
+	dest = rx_lend.buf - hdr_len;
+	if (hdr_len > rx_lend.below || ((ulong)dest & 1))
+		return NULL;
+
+	memcpy(rx_saved, dest, hdr_len);
+	rx_saved_len = hdr_len;
+	rx_borrowed = dest;
+	rx_lend.buf = NULL;
+
+	return dest;
+}
+
+/* Put back what the headers of a frame put in lent memory covered */
+static void eth_rx_restore(void)
+{
+	if (!rx_borrowed)
+		return;
+	memcpy(rx_borrowed, rx_saved, rx_saved_len);
+	rx_borrowed = NULL;
+}
+#else
+static inline void eth_rx_restore(void)
+{
+}
+#endif
+
 int eth_rx(void)
 {
 	struct udevice *current;
@@ -390,6 +472,7 @@ int eth_rx(void)
 			net_process_received_packet(packet, ret);
 		if (ret >= 0 && eth_get_ops(current)->free_pkt)
 			eth_get_ops(current)->free_pkt(current, packet, ret);
+		eth_rx_restore();
 		if (ret <= 0)
 			break;
 	}
@@ -590,6 +673,9 @@ static int eth_pre_remove(struct udevice *dev)
 	/* clear the MAC address */
 	memset(pdata->enetaddr, 0, ARP_HLEN);
 
+	/* a device probed later may be on another network */
+	arp_cache_flush();
+
 	return 0;
 }
 
@@ -6,8 +6,11 @@
 #include <common.h>
 #include <command.h>
 #include <fastboot.h>
+#include <malloc.h>
 #include <net.h>
 #include <net/fastboot.h>
+#include <asm/unaligned.h>
+#include <linux/kernel.h>
 
 /* Fastboot port # defined in spec */
 #define WELL_KNOWN_PORT 5554
@@ -19,24 +22,68 @@ enum {
 	FASTBOOT_FASTBOOT = 3,
 };
 
+/* Set by the host on every packet of a message but the last */
+#define FASTBOOT_FLAG_CONTINUATION 0x01
+
 struct __packed fastboot_header {
 	uchar id;
 	uchar flags;
 	unsigned short seq;
 };
 
-#define PACKET_SIZE 1024
+/* Largest packet which arrives in one piece, see IP_DEFRAG */
+#ifdef CONFIG_IP_DEFRAG
+#define LINK_PACKET_SIZE (CONFIG_NET_MAXDEFRAG - IP_UDP_HDR_SIZE)
+#else
+#define LINK_PACKET_SIZE (1500 - IP_UDP_HDR_SIZE)
+#endif
+
+#define OUR_PACKET_SIZE CONFIG_UDP_FUNCTION_FASTBOOT_PACKET_SIZE
+#define PACKET_SIZE (OUR_PACKET_SIZE < LINK_PACKET_SIZE ? \
+		     OUR_PACKET_SIZE : LINK_PACKET_SIZE)
 #define DATA_SIZE (PACKET_SIZE - sizeof(struct fastboot_header))
 
+/* Largest packet we send */
+#define RESPONSE_SIZE (sizeof(struct fastboot_header) + FASTBOOT_RESPONSE_LEN)
+
+#define WINDOW_SIZE CONFIG_UDP_FUNCTION_FASTBOOT_WINDOW
+
 /* Sequence number sent for every packet */
 static unsigned short sequence_number = 1;
 static const unsigned short packet_size = PACKET_SIZE;
 static const unsigned short udp_version = 1;
 
 /* Keep track of last packet for resubmission */
-static uchar last_packet[PACKET_SIZE];
+static uchar last_packet[RESPONSE_SIZE];
 static unsigned int last_packet_len;
 
+/* Command being run, or -1 if none */
+static int current_cmd = -1;
+
+/**
+ * struct fastboot_ahead - A download packet which arrived ahead of its turn
+ *
+ * @seq: Sequence number of the packet
+ * @len: Length of @data, or 0 if this slot is free
+ * @data: Data from the packet
+ */
+struct fastboot_ahead {
+	unsigned short seq;
+	unsigned short len;
+	uchar data[DATA_SIZE];
+};
+
+/*
+ * Number of download packets the host may have in flight, agreed when the
+ * session starts. A stock host does not ask, so sends one at a time.
+ */
+static unsigned short window = 1;
+
+/* Packets held until those before them arrive, WINDOW_SIZE - 1 of them */
+static struct fastboot_ahead *ahead_packets;
+/* Number of bytes of download data held in ahead_packets */
+static unsigned int ahead_bytes;
+
 static struct in_addr fastboot_remote_ip;
 /* The UDP port at their end */
 static int fastboot_remote_port;
@@ -44,6 +91,7 @@ static int fastboot_remote_port;
 static int fastboot_our_port;
 
 static void boot_downloaded_image(void);
+static void fastboot_ahead_reset(void);
 
 #if CONFIG_IS_ENABLED(FASTBOOT_FLASH)
 /**
@@ -127,7 +175,6 @@ static void fastboot_send(struct fastboot_header header, char *fastboot_data,
 	short tmp;
 	struct fastboot_header response_header = header;
 	static char command[FASTBOOT_COMMAND_LEN];
-	static int cmd = -1;
 	static bool pending_command;
 	char response[FASTBOOT_RESPONSE_LEN] = {0};
 
@@ -164,13 +211,28 @@ static void fastboot_send(struct fastboot_header header, char *fastboot_data,
 		tmp = htons(packet_size);
 		memcpy(packet, &tmp, sizeof(tmp));
 		packet += sizeof(tmp);
+		/*
+		 * A host which adds a window size to its version and packet
+		 * size is told how many packets it may send ahead
+		 */
+		window = 1;
+		if (fastboot_data_len >= 3 * sizeof(tmp)) {
+			memcpy(&tmp, fastboot_data + 2 * sizeof(tmp),
+			       sizeof(tmp));
+			window = clamp_t(unsigned short, ntohs(tmp), 1,
+					 ahead_packets ? WINDOW_SIZE : 1);
+			tmp = htons(window);
+			memcpy(packet, &tmp, sizeof(tmp));
+			packet += sizeof(tmp);
+		}
+		fastboot_ahead_reset();
 		break;
 	case FASTBOOT_ERROR:
 		memcpy(packet, error_msg, strlen(error_msg));
 		packet += strlen(error_msg);
 		break;
 	case FASTBOOT_FASTBOOT:
-		if (cmd == FASTBOOT_COMMAND_DOWNLOAD) {
+		if (current_cmd == FASTBOOT_COMMAND_DOWNLOAD) {
 			if (!fastboot_data_len && !fastboot_data_remaining()) {
 				fastboot_data_complete(response);
 			} else {
@@ -179,12 +241,14 @@ static void fastboot_send(struct fastboot_header header, char *fastboot_data,
 						       response);
 			}
 		} else if (!pending_command) {
-			strlcpy(command, fastboot_data,
-				min((size_t)fastboot_data_len + 1,
-				    sizeof(command)));
+			len = min_t(size_t, fastboot_data_len,
+				    sizeof(command) - 1);
+			memcpy(command, fastboot_data, len);
+			command[len] = '\0';
 			pending_command = true;
 		} else {
-			cmd = fastboot_handle_command(command, response);
+			current_cmd = fastboot_handle_command(command,
+							      response);
 			pending_command = false;
 		}
 		/*
@@ -216,7 +280,7 @@ static void fastboot_send(struct fastboot_header header, char *fastboot_data,
 
 	/* Continue boot process after sending response */
 	if (!strncmp("OKAY", response, 4)) {
-		switch (cmd) {
+		switch (current_cmd) {
 		case FASTBOOT_COMMAND_BOOT:
 			boot_downloaded_image();
 			break;
@@ -235,7 +299,97 @@ static void fastboot_send(struct fastboot_header header, char *fastboot_data,
 	}
 
 	if (!strncmp("OKAY", response, 4) || !strncmp("FAIL", response, 4))
-		cmd = -1;
+		current_cmd = -1;
+}
+
+/**
+ * fastboot_ahead_reset() - Drop any packets held for later
+ */
+static void fastboot_ahead_reset(void)
+{
+	int i;
+
+	for (i = 0; ahead_packets && i < WINDOW_SIZE - 1; i++)
+		ahead_packets[i].len = 0;
+	ahead_bytes = 0;
+}
+
+/**
+ * fastboot_ahead_store() - Hold a download packet until its turn comes
+ *
+ * @seq: Sequence number of the packet, ahead of sequence_number but inside
+ *	the window
+ * @data: Pointer to received data
+ * @len: Length of received data
+ *
+ * The packet is dropped if it is not download data or is already held. The
+ * host sends it again if need be.
+ */
+static void fastboot_ahead_store(unsigned short seq, uchar *data,
+				 unsigned int len)
+{
+	struct fastboot_ahead *slot = NULL;
+	int i;
+
+	if (current_cmd != FASTBOOT_COMMAND_DOWNLOAD || !len ||
+	    ahead_bytes + len > fastboot_data_remaining())
+		return;
+	for (i = 0; i < WINDOW_SIZE - 1; i++) {
+		if (!ahead_packets[i].len)
+			slot = &ahead_packets[i];
+		else if (ahead_packets[i].seq == seq)
+			return;
+	}
+	if (!slot)
+		return;
+	slot->seq = seq;
+	slot->len = len;
+	memcpy(slot->data, data, len);
+	ahead_bytes += len;
+}
+
+/**
+ * fastboot_ahead_drain() - Handle held packets whose turn has come
+ *
+ * @header: Header of the packet just handled
+ */
+static void fastboot_ahead_drain(struct fastboot_header header)
+{
+	struct fastboot_ahead *pkt;
+	int i;
+
+	for (i = 0; ahead_bytes && i < WINDOW_SIZE - 1; i++) {
+		pkt = &ahead_packets[i];
+		if (!pkt->len || pkt->seq != sequence_number)
+			continue;
+		header.seq = sequence_number;
+		ahead_bytes -= pkt->len;
+		fastboot_send(header, (char *)pkt->data, pkt->len, 0);
+		pkt->len = 0;
+		sequence_number++;
+		/* Start again, since the next one may be in any slot */
+		i = -1;
+	}
+}
+
+/**
+ * fastboot_send_ack() - Send an empty reply to a download packet again
+ *
+ * @header: Header of the download packet
+ *
+ * This is used when the host sends a packet again which was handled before
+ * the last one, so its reply cannot be in last_packet. Replies to download
+ * packets are always empty.
+ */
+static void fastboot_send_ack(struct fastboot_header header)
+{
+	uchar *packet = net_tx_packet + net_eth_hdr_size() + IP_UDP_HDR_SIZE;
+
+	header.seq = htons(header.seq);
+	memcpy(packet, &header, sizeof(header));
+	net_send_udp_packet(net_server_ethaddr, fastboot_remote_ip,
+			    fastboot_remote_port, fastboot_our_port,
+			    sizeof(header));
 }
 
 /**
@@ -247,6 +401,43 @@ static void boot_downloaded_image(void)
 	net_set_state(NETLOOP_SUCCESS);
 }
 
+/**
+ * fastboot_lend_next() - Lend the place of the next download data
+ *
+ * The packet must carry the next sequence number. The host sets the
+ * continuation flag on each packet but the last of what it writes at once,
+ * so the flag is guessed from what remains; a packet sent otherwise is just
+ * not received in place. Anything lent before is taken back first, since a
+ * packet which was not received in place (e.g. one sent in fragments) has
+ * been stored there since.
+ */
+static void fastboot_lend_next(void)
+{
+	struct eth_rx_lend lend = {
+		.dport = fastboot_our_port,
+		.hdr_len = sizeof(struct fastboot_header),
+		.match_len = sizeof(struct fastboot_header),
+	};
+	u32 received, remaining;
+
+	eth_rx_lend(NULL);
+	if (!IS_ENABLED(CONFIG_NET_RX_LEND) ||
+	    current_cmd != FASTBOOT_COMMAND_DOWNLOAD)
+		return;
+	remaining = fastboot_data_remaining();
+	if (!remaining)
+		return;
+	lend.buf = fastboot_data_next(&received);
+	if (!lend.buf)
+		return;
+	lend.len = min_t(u32, remaining, DATA_SIZE);
+	lend.below = received;
+	lend.match[0] = FASTBOOT_FASTBOOT;
+	lend.match[1] = remaining > DATA_SIZE ? FASTBOOT_FLAG_CONTINUATION : 0;
+	put_unaligned_be16(sequence_number, lend.match + 2);
+	eth_rx_lend(&lend);
+}
+
 /**
  * fastboot_handler() - Incoming UDP packet handler.
  *
@@ -261,8 +452,7 @@ static void fastboot_handler(uchar *packet, unsigned int dport,
 			     unsigned int len)
 {
 	struct fastboot_header header;
-	char fastboot_data[DATA_SIZE] = {0};
-	unsigned int fastboot_data_len = 0;
+	unsigned short pos;
 
 	if (dport != fastboot_our_port)
 		return;
@@ -280,27 +470,36 @@ static void fastboot_handler(uchar *packet, unsigned int dport,
 
 	switch (header.id) {
 	case FASTBOOT_QUERY:
-		fastboot_send(header, fastboot_data, 0, 0);
+		fastboot_send(header, (char *)packet, 0, 0);
 		break;
 	case FASTBOOT_INIT:
 	case FASTBOOT_FASTBOOT:
-		fastboot_data_len = len;
-		if (len > 0)
-			memcpy(fastboot_data, packet, len);
-		if (header.seq == sequence_number) {
-			fastboot_send(header, fastboot_data,
-				      fastboot_data_len, 0);
+		/* Position of the packet relative to the one expected */
+		pos = header.seq - sequence_number;
+		if (!pos) {
+			fastboot_send(header, (char *)packet, len, 0);
 			sequence_number++;
-		} else if (header.seq == sequence_number - 1) {
+			if (header.id == FASTBOOT_FASTBOOT) {
+				fastboot_ahead_drain(header);
+				fastboot_lend_next();
+			}
+		} else if (pos == (unsigned short)-1) {
 			/* Retransmit last sent packet */
-			fastboot_send(header, fastboot_data,
-				      fastboot_data_len, 1);
+			fastboot_send(header, (char *)packet, len, 1);
+		} else if (window == 1 || header.id != FASTBOOT_FASTBOOT) {
+			break;
+		} else if (pos < window) {
+			fastboot_ahead_store(header.seq, packet, len);
+		} else if ((unsigned short)-pos <= window &&
+			   current_cmd == FASTBOOT_COMMAND_DOWNLOAD) {
+			/* Our reply to an earlier download packet was lost */
+			fastboot_send_ack(header);
 		}
 		break;
 	default:
 		pr_err("ID %d not implemented.\n", header.id);
 		header.id = FASTBOOT_ERROR;
-		fastboot_send(header, fastboot_data, 0, 0);
+		fastboot_send(header, (char *)packet, 0, 0);
 		break;
 	}
 }
@@ -311,6 +510,11 @@ void fastboot_start_server(void)
 	printf("Listening for fastboot command on %pI4\n", &net_ip);
 
 	fastboot_our_port = WELL_KNOWN_PORT;
+	window = 1;
+	if (WINDOW_SIZE > 1 && !ahead_packets)
+		ahead_packets = calloc(WINDOW_SIZE - 1,
+				       sizeof(struct fastboot_ahead));
+	fastboot_ahead_reset();
 
 #if CONFIG_IS_ENABLED(FASTBOOT_FLASH)
 	fastboot_set_progress_callback(fastboot_timed_send_info);
@@ -101,6 +101,7 @@
 #include <miiphy.h>
 #include <status_led.h>
 #endif
+#include <uthread.h>
 #include <watchdog.h>
 #include <linux/compiler.h>
 #include "arp.h"
@@ -160,6 +161,8 @@ int		net_restart_wrap;
 static int	net_restarted;
 /* At least one device configured */
 static int	net_dev_exists;
+/* Device left running by the last command, for CONFIG_NET_WARM_LINK */
+static void	*net_warm_dev;
 
 /* XXX in both little & big endian machines 0xFFFF == ntohs(-1) */
 /* default is without VLAN */
@@ -358,6 +361,7 @@ static void net_clear_handlers(void)
 	net_set_udp_handler(NULL);
 	net_set_arp_handler(NULL);
 	net_set_timeout_handler(0, NULL);
+	eth_rx_lend(NULL);
 }
 
 static void net_cleanup_loop(void)
@@ -396,10 +400,30 @@ int net_init(void)
  *	Main network processing loop.
  */
 
+/*
+ * Check whether the device left running by the last command can be used
+ * without starting it again: it must still be running and still be the one
+ * that 'ethact' names.
+ */
+static bool net_link_is_warm(void)
+{
+	const char *act = env_get("ethact");
+
+	if (!IS_ENABLED(CONFIG_NET_WARM_LINK) || !net_warm_dev ||
+	    net_warm_dev != eth_get_dev())
+		return false;
+	if (!act || strcmp(act, eth_get_name()))
+		return false;
+
+	return eth_is_active(eth_get_dev()) && is_valid_ethaddr(net_ethaddr);
+}
+
 int net_loop(enum proto_t protocol)
 {
 	int ret = -EINVAL;
 	enum net_loop_state prev_net_state = net_state;
+	ulong link_start, link_time;
+	bool warm;
 
 #if defined(CONFIG_CMD_PING)
 	if (protocol != PING)
@@ -412,7 +436,15 @@ int net_loop(enum proto_t protocol)
 
 	bootstage_mark_name(BOOTSTAGE_ID_ETH_START, "eth_start");
 	net_init();
-	if (eth_is_on_demand_init() || protocol != NETCONS) {
+	link_start = get_timer(0);
+	arp_wait_total = 0;
+	arp_cache_hits = 0;
+	warm = net_link_is_warm();
+	net_warm_dev = NULL;
+	if (warm) {
+		debug_cond(DEBUG_INT_STATE, "--- net_loop %s still running\n",
+			   eth_get_name());
+	} else if (eth_is_on_demand_init() || protocol != NETCONS) {
 		eth_halt();
 		eth_set_current();
 		ret = eth_init();
@@ -423,6 +455,7 @@ int net_loop(enum proto_t protocol)
 	} else {
 		eth_init_state_only();
 	}
+	link_time = get_timer(link_start);
 restart:
 #ifdef CONFIG_USB_KEYBOARD
 	net_busy_flag = 0;
@@ -466,6 +499,11 @@ restart:
 			tftp_start_server();
 			break;
 #endif
+#ifdef CONFIG_CMD_TFTPSERVE
+		case TFTPSERVE:
+			tftp_start_serve();
+			break;
+#endif
 #ifdef CONFIG_UDP_FUNCTION_FASTBOOT
 		case FASTBOOT:
 			fastboot_start_server();
@@ -560,6 +598,7 @@ restart:
 	 */
 	for (;;) {
 		WATCHDOG_RESET();
+		uthread_schedule();
 		if (arp_timeout_check() > 0)
 			time_start = get_timer(0);
 
@@ -577,6 +616,7 @@ restart:
 		if (ctrlc()) {
 			/* cancel any ARP that may not have completed */
 			net_arp_wait_packet_ip.s_addr = 0;
+			arp_cache_flush();
 
 			net_cleanup_loop();
 			eth_halt();
@@ -637,10 +677,12 @@ restart:
 				env_set_hex("filesize", net_boot_file_size);
 				env_set_hex("fileaddr", image_load_addr);
 			}
-			if (protocol != NETCONS)
-				eth_halt();
-			else
+			if (protocol == NETCONS)
 				eth_halt_state_only();
+			else if (IS_ENABLED(CONFIG_NET_WARM_LINK))
+				net_warm_dev = eth_get_dev();
+			else
+				eth_halt();
 
 			eth_set_last_protocol(protocol);
 
@@ -652,6 +694,8 @@ restart:
 			net_cleanup_loop();
 			/* Invalidate the last protocol */
 			eth_set_last_protocol(BOOTP);
+			/* A host may have moved; ask for it again next time */
+			arp_cache_flush();
 			debug_cond(DEBUG_INT_STATE, "--- net_loop Fail!\n");
 			ret = -ENONET;
 			goto done;
@@ -672,6 +716,11 @@ done:
 #endif
 	net_set_state(prev_net_state);
 
+	if (IS_ENABLED(CONFIG_NET_SETUP_STATS) && protocol != NETCONS)
+		printf("Setup: link %lu ms (%s), ARP %lu ms, %d cached\n",
+		       link_time, warm ? "warm" : "cold", arp_wait_total,
+		       arp_cache_hits);
+
 #if defined(CONFIG_CMD_PCAP)
 	if (pcap_active())
 		pcap_print_status();
@@ -837,6 +886,10 @@ int net_send_ip_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 	if (dest.s_addr == 0xFFFFFFFF)
 		ether = (uchar *)net_bcast_ethaddr;
 
+	/* if MAC address was not discovered yet, try the ARP cache */
+	if (memcmp(ether, net_null_ethaddr, 6) == 0)
+		arp_cache_lookup(dest, ether);
+
 	pkt = (uchar *)net_tx_packet;
 
 	eth_hdr_size = net_set_ether(pkt, ether, PROT_IP);
@@ -1372,6 +1425,7 @@ common:
 	case NETCONS:
 	case FASTBOOT:
 	case TFTPSRV:
+	case TFTPSERVE:
 		if (net_ip.s_addr == 0) {
 			puts("*** ERROR: `ipaddr' not set\n");
 			return 1;
@@ -26,6 +26,12 @@
  * NFSv2 is still used by default. But if server does not support NFSv2, then
  * NFSv3 is used, if available on NFS server. */
 
+/* NOTE 5: Up to CONFIG_NFS_READ_WINDOW READ calls may be outstanding. Each
+ * has its own slot, found from the xid of the reply, and its data is stored
+ * at the offset it was asked for, so replies may arrive in any order. The
+ * download is complete once the end of the file is known and every READ
+ * below it has been answered. */
+
 #include <common.h>
 #include <command.h>
 #include <flash.h>
@@ -37,6 +43,7 @@
 #include "nfs.h"
 #include "bootp.h"
 #include <time.h>
+#include <linux/bug.h>
 
 #define HASHES_PER_LINE 65	/* Number of "loading" hashes per line	*/
 #define NFS_RETRY_COUNT 30
@@ -46,13 +53,34 @@
 # define NFS_TIMEOUT CONFIG_NFS_TIMEOUT
 #endif
 
+#ifdef CONFIG_NFS_READ_WINDOW
+# define NFS_READ_WINDOW CONFIG_NFS_READ_WINDOW
+#else
+# define NFS_READ_WINDOW 1
+#endif
+
 #define NFS_RPC_ERR	1
 #define NFS_RPC_DROP	124
 
+/**
+ * struct nfs_read_slot - An outstanding NFS READ call
+ *
+ * @id: RPC transaction ID (xid) of the call, or 0 if the slot is free
+ * @offset: Offset in the file of the data asked for
+ * @len: Number of bytes asked for
+ */
+struct nfs_read_slot {
+	unsigned long id;
+	int offset;
+	int len;
+};
+
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
-static int nfs_len;
+static int nfs_offset = -1;	/* offset of the next block to ask for */
+static int nfs_len;		/* bytes to ask for in each READ call */
+static int nfs_eof;		/* size of the file, once known */
+static struct nfs_read_slot nfs_read_slots[NFS_READ_WINDOW];
 static ulong nfs_timeout = NFS_TIMEOUT;
 
 static char dirfh[NFS_FHSIZE];	/* NFSv2 / NFSv3 file handle of directory */
@@ -108,7 +136,13 @@ static inline int store_block(uchar *src, unsigned offset, unsigned len)
 	{
 		void *ptr = map_sysmem(image_load_addr + offset, len);
 
-		memcpy(ptr, src, len);
+		/*
+		 * The block may have been received in place, or close to it
+		 * if the reply was laid out differently from what
+		 * nfs_read_lend() expected
+		 */
+		if (ptr != src)
+			memmove(ptr, src, len);
 		unmap_sysmem(ptr);
 	}
 
@@ -175,7 +209,8 @@ static uint32_t *rpc_add_credentials(uint32_t *p)
 /**************************************************************************
 RPC_LOOKUP - Lookup RPC Port numbers
 **************************************************************************/
-static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
+static unsigned long rpc_req(int rpc_prog, int rpc_proc, uint32_t *data,
+			     int datalen)
 {
 	struct rpc_t rpc_pkt;
 	unsigned long id;
@@ -220,6 +255,8 @@ static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
 
 	net_send_udp_packet(net_server_ethaddr, nfs_server_ip, sport,
 			    nfs_our_port, pktlen);
+
+	return id;
 }
 
 /**************************************************************************
@@ -361,7 +398,7 @@ static void nfs_lookup_req(char *fname)
 /**************************************************************************
 NFS_READ - Read File on NFS Server
 **************************************************************************/
-static void nfs_read_req(int offset, int readlen)
+static unsigned long nfs_read_req(int offset, int readlen)
 {
 	uint32_t data[1024];
 	uint32_t *p;
@@ -388,7 +425,106 @@ static void nfs_read_req(int offset, int readlen)
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
-	rpc_req(PROG_NFS, NFS_READ, data, len);
+	return rpc_req(PROG_NFS, NFS_READ, data, len);
+}
+
+/**************************************************************************
+NFS_READ window - Keep up to NFS_READ_WINDOW READ calls outstanding
+**************************************************************************/
+static void nfs_read_start(void)
+{
+	nfs_offset = 0;
+	nfs_eof = INT_MAX;
+	nfs_len = NFS_READ_SIZE;
+	if ((supported_nfs_versions & NFSV2_FLAG) && nfs_len > NFS2_MAXDATA)
+		nfs_len = NFS2_MAXDATA;
+	memset(nfs_read_slots, '\0', sizeof(nfs_read_slots));
+}
+
+/* Lend the place of the earliest block asked for to the Ethernet driver */
+static void nfs_read_lend(void)
+{
+#ifndef CONFIG_SYS_DIRECT_FLASH_NFS
+	struct nfs_read_slot *slot = NULL;
+	struct eth_rx_lend lend = {
+		.dport = nfs_our_port,
+		.match_len = sizeof(u32),
+	};
+	u32 id;
+	int i;
+
+	if (!IS_ENABLED(CONFIG_NET_RX_LEND))
+		return;
+	for (i = 0; i < NFS_READ_WINDOW; i++) {
+		if (nfs_read_slots[i].id && (!slot ||
+		    nfs_read_slots[i].offset < slot->offset))
+			slot = &nfs_read_slots[i];
+	}
+	if (!slot)
+		return;
+
+	/* An NFSv3 server is expected to send the file attributes */
+	lend.hdr_len = offsetof(struct rpc_t, u.reply.data);
+	if (supported_nfs_versions & NFSV2_FLAG)
+		lend.hdr_len += 19 * sizeof(u32);
+	else
+		lend.hdr_len += (4 + 22) * sizeof(u32);
+	id = htonl(slot->id);
+	memcpy(lend.match, &id, sizeof(id));
+	lend.buf = map_sysmem(image_load_addr + slot->offset, slot->len);
+	lend.len = slot->len;
+	lend.below = slot->offset;
+	eth_rx_lend(&lend);
+#endif
+}
+
+/* Ask for the next blocks of the file in any free slots */
+static void nfs_read_fill(void)
+{
+	struct nfs_read_slot *slot;
+	int i;
+
+	for (i = 0; i < NFS_READ_WINDOW && nfs_offset < nfs_eof; i++) {
+		slot = &nfs_read_slots[i];
+		if (slot->id)
+			continue;
+		slot->offset = nfs_offset;
+		slot->len = nfs_len;
+		slot->id = nfs_read_req(slot->offset, slot->len);
+		nfs_offset += nfs_len;
+	}
+	nfs_read_lend();
+}
+
+/* Send the READ calls still outstanding again, then fill the free slots */
+static void nfs_read_send(void)
+{
+	struct nfs_read_slot *slot;
+	int i;
+
+	for (i = 0; i < NFS_READ_WINDOW; i++) {
+		slot = &nfs_read_slots[i];
+		if (slot->id && slot->offset < nfs_eof)
+			slot->id = nfs_read_req(slot->offset, slot->len);
+		else
+			slot->id = 0;
+	}
+	nfs_read_fill();
+}
+
+/* Check whether every READ below the end of the file has been answered */
+static bool nfs_read_done(void)
+{
+	int i;
+
+	if (nfs_eof == INT_MAX)
+		return false;
+	for (i = 0; i < NFS_READ_WINDOW; i++) {
+		if (nfs_read_slots[i].id && nfs_read_slots[i].offset < nfs_eof)
+			return false;
+	}
+
+	return true;
 }
 
 /**************************************************************************
@@ -421,7 +557,7 @@ static void nfs_send(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		nfs_read_send();
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -664,19 +800,33 @@ static int nfs_readlink_reply(uchar *pkt, unsigned len)
 	return 0;
 }
 
+static struct nfs_read_slot *nfs_read_find_slot(unsigned long id)
+{
+	int i;
+
+	for (i = 0; i < NFS_READ_WINDOW; i++) {
+		if (nfs_read_slots[i].id && nfs_read_slots[i].id == id)
+			return &nfs_read_slots[i];
+	}
+
+	return NULL;
+}
+
 static int nfs_read_reply(uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
+	struct nfs_read_slot *slot;
 	int rlen;
+	bool eof = false;
 	uchar *data_ptr;
 
 	debug("%s\n", __func__);
 
-	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt.u.reply));
+	/* Only the header is copied; the data is stored straight from pkt */
+	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt) - NFS_READ_SIZE);
 
-	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
-		return -NFS_RPC_ERR;
-	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
+	slot = nfs_read_find_slot(ntohl(rpc_pkt.u.reply.id));
+	if (!slot)
 		return -NFS_RPC_DROP;
 
 	if (rpc_pkt.u.reply.rstatus  ||
@@ -690,10 +840,10 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
+	if ((slot->offset != 0) && !((slot->offset) %
 			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
 		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
+	if (!(slot->offset % ((NFS_READ_SIZE / 2) * 10)))
 		putc('#');
 
 	if (supported_nfs_versions & NFSV2_FLAG) {
@@ -705,6 +855,7 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 
 		/* count value */
 		rlen = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
+		eof = rpc_pkt.u.reply.data[2 + nfsv3_data_offset];
 		/* Skip unused values :
 			EOF:		32 bits value,
 			data_size:	32 bits value,
@@ -712,14 +863,36 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 		data_ptr = (uchar *)
 			&(rpc_pkt.u.reply.data[4 + nfsv3_data_offset]);
 	}
+	data_ptr = pkt + (data_ptr - (uchar *)&rpc_pkt);
 
-	if (((uchar *)&(rpc_pkt.u.reply.data[0]) - (uchar *)(&rpc_pkt) + rlen) > len)
-			return -9999;
+	if (rlen < 0 || rlen > slot->len || data_ptr + rlen > pkt + len)
+		return -9999;
 
-	if (store_block(data_ptr, nfs_offset, rlen))
-			return -9999;
+	if (rlen && store_block(data_ptr, slot->offset, rlen))
+		return -9999;
+
+	if (eof)
+		nfs_eof = min(nfs_eof, slot->offset + rlen);
+	else if (!rlen)
+		nfs_eof = min(nfs_eof, slot->offset);
 
-	return rlen;
+	if (rlen == slot->len || slot->offset + rlen >= nfs_eof) {
+		slot->id = 0;
+		return 0;
+	}
+
+	/*
+	 * The server sent less than was asked for, so ask for the rest. An
+	 * NFSv3 server does this when asked for more than its maximum read
+	 * size, so use that size from now on.
+	 */
+	if (!(supported_nfs_versions & NFSV2_FLAG) && slot->len == nfs_len)
+		nfs_len = rlen;
+	slot->offset += rlen;
+	slot->len -= rlen;
+	slot->id = nfs_read_req(slot->offset, slot->len);
+
+	return 0;
 }
 
 /**************************************************************************
@@ -814,8 +987,7 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			nfs_send();
 		} else {
 			nfs_state = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
+			nfs_read_start();
 			nfs_send();
 		}
 		break;
@@ -843,9 +1015,8 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (rlen == -NFS_RPC_DROP)
 			break;
 		net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
-		if (rlen > 0) {
-			nfs_offset += rlen;
-			nfs_send();
+		if (!rlen && !nfs_read_done()) {
+			nfs_read_fill();
 		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
 			nfs_state = STATE_READLINK_REQ;
@@ -920,6 +1091,12 @@ void nfs_start(void)
 	net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
 	net_set_udp_handler(nfs_handler);
 
+#ifdef CONFIG_IP_DEFRAG
+	/* A READ reply must fit in the reassembly buffer */
+	BUILD_BUG_ON(sizeof(struct rpc_t) + IP_UDP_HDR_SIZE >
+		     CONFIG_NET_MAXDEFRAG);
+#endif
+
 	nfs_timeout_count = 0;
 	nfs_state = STATE_PRCLOOKUP_PROG_MOUNT_REQ;
 
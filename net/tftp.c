@@ -6,15 +6,20 @@
  *                Luca Ceresoli <luca.ceresoli@comelit.it>
  */
 #include <common.h>
+#include <blk.h>
 #include <command.h>
+#include <div64.h>
 #include <efi_loader.h>
 #include <env.h>
+#include <fs.h>
 #include <image.h>
 #include <lmb.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <net.h>
 #include <net/tftp.h>
+#include <part.h>
 #include "bootp.h"
 #ifdef CONFIG_SYS_DIRECT_FLASH_TFTP
 #include <flash.h>
@@ -201,7 +206,9 @@ static inline int store_block(int block, uchar *src, unsigned int len)
 		}
 #endif
 		ptr = map_sysmem(store_addr, len);
-		memcpy(ptr, src, len);
+		/* The block may have been received in place */
+		if (ptr != src)
+			memcpy(ptr, src, len);
 		unmap_sysmem(ptr);
 	}
 
@@ -211,6 +218,30 @@ static inline int store_block(int block, uchar *src, unsigned int len)
 	return 0;
 }
 
+/* Lend the place of the next block to the Ethernet driver */
+static void tftp_lend_next(void)
+{
+#ifndef CONFIG_SYS_DIRECT_FLASH_TFTP
+	ulong offset = tftp_cur_block * tftp_block_size +
+			tftp_block_wrap_offset;
+	ushort block = tftp_cur_block + 1;
+	struct eth_rx_lend lend = {
+		.len = tftp_block_size,
+		.dport = tftp_our_port,
+		.hdr_len = 4,
+		.match_len = 4,
+		.match = { 0, TFTP_DATA, block >> 8, block & 0xff },
+	};
+
+	if (!IS_ENABLED(CONFIG_NET_RX_LEND) ||
+	    (tftp_load_size && offset + tftp_block_size > tftp_load_size))
+		return;
+	lend.buf = map_sysmem(tftp_load_addr + offset, tftp_block_size);
+	lend.below = offset;
+	eth_rx_lend(&lend);
+#endif
+}
+
 /* Clear our state ready for a new transfer */
 static void new_transfer(void)
 {
@@ -659,6 +690,8 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			net_set_state(NETLOOP_FAIL);
 			break;
 		}
+		if (len == tftp_block_size)
+			tftp_lend_next();
 
 		/*
 		 *	Acknowledge the block just received, which will prompt
@@ -922,3 +955,496 @@ void tftp_start_server(void)
 }
 #endif /* CONFIG_CMD_TFTPSRV */
 
+
+#ifdef CONFIG_CMD_TFTPSERVE
+/* Largest block which fits in an Ethernet frame, as we do not fragment */
+#define TFTP_SERVE_MAX_BLOCK_SIZE	(1500 - IP_UDP_HDR_SIZE - 4)
+/* Millisecs between checks of the sessions for lost packets */
+#define TFTP_SERVE_TICK			250
+
+/* Options to acknowledge in the OACK */
+#define TFTP_OPT_BLKSIZE	BIT(0)
+#define TFTP_OPT_WINDOWSIZE	BIT(1)
+#define TFTP_OPT_TIMEOUT	BIT(2)
+#define TFTP_OPT_TSIZE		BIT(3)
+
+/**
+ * struct tftp_session - A read request being served
+ *
+ * Blocks are numbered from 1 as in the protocol, but without wrapping at
+ * 65536. The data is read from storage a window at a time, into @buf.
+ *
+ * @active: true if the session is in use
+ * @ip: IP address of the client
+ * @ethaddr: Ethernet address to reach the client
+ * @port: UDP port of the client
+ * @our_port: UDP port used for this session
+ * @name: Name requested by the client
+ * @file: true to read @name from the filesystem, false to read blocks
+ * @start: First block on the device or partition, if !@file
+ * @size: Number of bytes to send
+ * @block_size: Negotiated block size
+ * @window: Negotiated window size
+ * @timeout_ms: Negotiated timeout
+ * @opts: Options to acknowledge, TFTP_OPT_...
+ * @oack: true while waiting for the OACK to be acknowledged
+ * @acked: Last block acknowledged
+ * @sent: Last block sent
+ * @last: Final block, which is shorter than @block_size
+ * @sent_at: Time of the last transmission, for timeouts
+ * @timeouts: Number of timeouts since the last acknowledgement
+ * @start_time: Time at which the request was received
+ * @buf: Buffer for data read from storage
+ * @buf_size: Size of @buf
+ * @buf_pos: Offset in the data of the first byte in @buf
+ * @buf_len: Number of valid bytes in @buf
+ */
+struct tftp_session {
+	bool active;
+	struct in_addr ip;
+	uchar ethaddr[ARP_HLEN];
+	int port;
+	int our_port;
+	char name[MAX_LEN];
+	bool file;
+	lbaint_t start;
+	u64 size;
+	ushort block_size;
+	ushort window;
+	ulong timeout_ms;
+	uint opts;
+	bool oack;
+	ulong acked;
+	ulong sent;
+	ulong last;
+	ulong sent_at;
+	int timeouts;
+	ulong start_time;
+	uchar *buf;
+	ulong buf_size;
+	u64 buf_pos;
+	ulong buf_len;
+};
+
+static struct tftp_session tftp_sessions[CONFIG_TFTP_SERVE_SESSIONS];
+static struct blk_desc *tftp_serve_desc;
+static int tftp_serve_part;
+static struct disk_partition tftp_serve_info;
+/* Number of transfers to serve, or 0 to serve until Ctrl-C */
+static int tftp_serve_count;
+/* Number of transfers completed */
+static int tftp_serve_done;
+static int tftp_serve_next_port;
+
+void tftp_serve_setup(struct blk_desc *desc, int part,
+		      struct disk_partition *info, int count)
+{
+	tftp_serve_desc = desc;
+	tftp_serve_part = part;
+	tftp_serve_info = *info;
+	tftp_serve_count = count;
+}
+
+int tftp_serve_get_done(void)
+{
+	return tftp_serve_done;
+}
+
+static uchar *tftp_serve_pkt(void)
+{
+	return net_tx_packet + net_eth_hdr_size() + IP_UDP_HDR_SIZE;
+}
+
+static void tftp_serve_error(struct in_addr ip, uchar *ethaddr, int port,
+			     int our_port, int code, const char *msg)
+{
+	uchar *pkt = tftp_serve_pkt();
+	ushort *s = (ushort *)pkt;
+
+	s[0] = htons(TFTP_ERROR);
+	s[1] = htons(code);
+	strcpy((char *)pkt + 4, msg);
+	net_send_udp_packet(ethaddr, ip, port, our_port, 4 + strlen(msg) + 1);
+}
+
+/* Finish a session, which succeeded if @ok */
+static void tftp_serve_end(struct tftp_session *sess, bool ok)
+{
+	ulong ms = get_timer(sess->start_time);
+
+	if (ok) {
+		printf("Sent '%s' to %pI4: ", sess->name, &sess->ip);
+		print_size(sess->size, "");
+		if (ms) {
+			puts(", ");
+			print_size(lldiv(sess->size * 1000, ms), "/s");
+		}
+		putc('\n');
+		tftp_serve_done++;
+	}
+	free(sess->buf);
+	sess->buf = NULL;
+	sess->active = false;
+
+	/* No more requests are accepted than are needed to reach the count */
+	if (tftp_serve_count && tftp_serve_done == tftp_serve_count)
+		net_set_state(NETLOOP_SUCCESS);
+}
+
+/*
+ * Work out what a request is for. A name of the form <start>+<count>, in
+ * hex, asks for blocks of the device or partition; <count> may be left out
+ * to read to its end. Anything else is a file in its filesystem.
+ */
+static int tftp_serve_open(struct tftp_session *sess)
+{
+	struct blk_desc *desc = tftp_serve_desc;
+	lbaint_t size = tftp_serve_info.size;
+	lbaint_t start, count;
+	loff_t fsize;
+	char *end;
+
+	start = simple_strtoul(sess->name, &end, 16);
+	if (end != sess->name && *end == '+') {
+		if (start > size)
+			return -EINVAL;
+		count = size - start;
+		if (end[1])
+			count = simple_strtoul(end + 1, &end, 16);
+		else
+			end++;
+		if (*end || count > size - start)
+			return -EINVAL;
+		sess->file = false;
+		sess->start = tftp_serve_info.start + start;
+		sess->size = (u64)count * desc->blksz;
+		return 0;
+	}
+
+	if (fs_set_blk_dev_with_part(desc, tftp_serve_part) ||
+	    fs_size(sess->name, &fsize))
+		return -ENOENT;
+	sess->file = true;
+	sess->size = fsize;
+
+	return 0;
+}
+
+/* Make sure that bytes @pos to @pos + @len of the data are in the buffer */
+static int tftp_serve_fill(struct tftp_session *sess, u64 pos, ulong len)
+{
+	struct blk_desc *desc = tftp_serve_desc;
+	lbaint_t first, count;
+	loff_t actread;
+
+	if (pos >= sess->buf_pos && pos + len <= sess->buf_pos + sess->buf_len)
+		return 0;
+
+	if (sess->file) {
+		count = min_t(u64, sess->buf_size, sess->size - pos);
+		if (fs_set_blk_dev_with_part(desc, tftp_serve_part) ||
+		    fs_read(sess->name, map_to_sysmem(sess->buf), pos, count,
+			    &actread) || actread != count)
+			return -EIO;
+		sess->buf_pos = pos;
+		sess->buf_len = count;
+		return 0;
+	}
+
+	/* Read whole device blocks, starting with the one holding @pos */
+	first = lldiv(pos, desc->blksz);
+	count = min_t(u64, sess->buf_size / desc->blksz,
+		      lldiv(sess->size + desc->blksz - 1, desc->blksz) - first);
+	if (blk_dread(desc, sess->start + first, count, sess->buf) != count)
+		return -EIO;
+	sess->buf_pos = (u64)first * desc->blksz;
+	sess->buf_len = count * desc->blksz;
+
+	return 0;
+}
+
+/* Send the window of blocks following the last one acknowledged */
+static void tftp_serve_send_window(struct tftp_session *sess)
+{
+	ulong first = sess->acked + 1;
+	ulong end = min(sess->acked + sess->window, sess->last);
+	u64 pos = (u64)(first - 1) * sess->block_size;
+	u64 stop = min((u64)end * sess->block_size, sess->size);
+	ulong block, len;
+	uchar *pkt;
+	ushort *s;
+
+	if (tftp_serve_fill(sess, pos, stop - pos)) {
+		printf("\nTFTP error: cannot read '%s'\n", sess->name);
+		tftp_serve_error(sess->ip, sess->ethaddr, sess->port,
+				 sess->our_port, TFTP_ERR_UNDEFINED,
+				 "Read error");
+		tftp_serve_end(sess, false);
+		return;
+	}
+
+	for (block = first; block <= end; block++, pos += len) {
+		len = min_t(u64, sess->block_size, sess->size - pos);
+		pkt = tftp_serve_pkt();
+		s = (ushort *)pkt;
+		s[0] = htons(TFTP_DATA);
+		s[1] = htons((ushort)block);
+		memcpy(pkt + 4, sess->buf + (pos - sess->buf_pos), len);
+		net_send_udp_packet(sess->ethaddr, sess->ip, sess->port,
+				    sess->our_port, 4 + len);
+	}
+	sess->sent = end;
+	sess->sent_at = get_timer(0);
+}
+
+static void tftp_serve_send_oack(struct tftp_session *sess)
+{
+	uchar *pkt = tftp_serve_pkt();
+	uchar *xp = pkt;
+
+	*(ushort *)pkt = htons(TFTP_OACK);
+	pkt += 2;
+	if (sess->opts & TFTP_OPT_BLKSIZE)
+		pkt += sprintf((char *)pkt, "blksize%c%d%c", 0,
+			       sess->block_size, 0);
+	if (sess->opts & TFTP_OPT_WINDOWSIZE)
+		pkt += sprintf((char *)pkt, "windowsize%c%d%c", 0,
+			       sess->window, 0);
+	if (sess->opts & TFTP_OPT_TIMEOUT)
+		pkt += sprintf((char *)pkt, "timeout%c%lu%c", 0,
+			       sess->timeout_ms / 1000, 0);
+	if (sess->opts & TFTP_OPT_TSIZE)
+		pkt += sprintf((char *)pkt, "tsize%c%llu%c", 0,
+			       (unsigned long long)sess->size, 0);
+	net_send_udp_packet(sess->ethaddr, sess->ip, sess->port,
+			    sess->our_port, pkt - xp);
+	sess->sent_at = get_timer(0);
+}
+
+/* Start serving a read request, answering any options with an OACK */
+static void tftp_serve_rrq(struct in_addr sip, int src, uchar *pkt,
+			   unsigned len)
+{
+	struct tftp_session *sess = NULL;
+	uchar *ethaddr = ((struct ethernet_hdr *)net_rx_packet)->et_src;
+	char *opt, *val, *end = (char *)pkt + len;
+	int i, active = 0;
+	ulong num;
+
+	for (i = 0; i < ARRAY_SIZE(tftp_sessions); i++) {
+		struct tftp_session *cur = &tftp_sessions[i];
+
+		/* Ignore a repeated request, as the timeout will resend */
+		if (cur->active && cur->ip.s_addr == sip.s_addr &&
+		    cur->port == src)
+			return;
+		if (cur->active)
+			active++;
+		else if (!sess)
+			sess = cur;
+	}
+	if (!sess || (tftp_serve_count &&
+		      tftp_serve_done + active >= tftp_serve_count)) {
+		tftp_serve_error(sip, ethaddr, src, WELL_KNOWN_PORT,
+				 TFTP_ERR_UNDEFINED, "Server busy");
+		return;
+	}
+
+	/* The name and the mode, then pairs of option name and value */
+	if (!len || pkt[len - 1] || strlen((char *)pkt) >= MAX_LEN)
+		return;
+	opt = (char *)pkt + strlen((char *)pkt) + 1;
+	if (opt >= end || strcasecmp(opt, "octet")) {
+		tftp_serve_error(sip, ethaddr, src, WELL_KNOWN_PORT,
+				 TFTP_ERR_UNDEFINED, "Only octet mode");
+		return;
+	}
+
+	memset(sess, '\0', sizeof(*sess));
+	strcpy(sess->name, (char *)pkt);
+	sess->ip = sip;
+	memcpy(sess->ethaddr, ethaddr, ARP_HLEN);
+	sess->port = src;
+	sess->block_size = TFTP_BLOCK_SIZE;
+	sess->window = 1;
+	sess->timeout_ms = TIMEOUT;
+
+	for (opt += strlen(opt) + 1; opt < end; opt = val + strlen(val) + 1) {
+		val = opt + strlen(opt) + 1;
+		if (val >= end)
+			break;
+		num = simple_strtoul(val, NULL, 10);
+		if (!strcasecmp(opt, "blksize") && num >= 8) {
+			sess->block_size = min_t(ulong, num,
+						 TFTP_SERVE_MAX_BLOCK_SIZE);
+			sess->opts |= TFTP_OPT_BLKSIZE;
+		} else if (!strcasecmp(opt, "windowsize") && num >= 1) {
+			sess->window = min_t(ulong, num,
+					     CONFIG_TFTP_SERVE_WINDOWSIZE);
+			sess->opts |= TFTP_OPT_WINDOWSIZE;
+		} else if (!strcasecmp(opt, "timeout") && num >= 1 &&
+			   num <= 255) {
+			sess->timeout_ms = num * 1000;
+			sess->opts |= TFTP_OPT_TIMEOUT;
+		} else if (!strcasecmp(opt, "tsize")) {
+			sess->opts |= TFTP_OPT_TSIZE;
+		}
+	}
+
+	if (tftp_serve_open(sess)) {
+		printf("\nTFTP error: '%s' requested by %pI4 not found\n",
+		       sess->name, &sip);
+		tftp_serve_error(sip, ethaddr, src, WELL_KNOWN_PORT,
+				 TFTP_ERR_FILE_NOT_FOUND, "File not found");
+		return;
+	}
+
+	/* Room for a window, plus the device block it may start part-way in */
+	sess->buf_size = ALIGN(sess->window * sess->block_size +
+			       tftp_serve_desc->blksz, tftp_serve_desc->blksz);
+	/*
+	 * Filesystems such as FAT find an offset by walking the file from its
+	 * start, so read files in large pieces to keep the number of reads low
+	 */
+	if (sess->file)
+		sess->buf_size = max_t(ulong, sess->buf_size,
+				       CONFIG_TFTP_SERVE_FILE_BUF_SIZE);
+	sess->buf = malloc(sess->buf_size);
+	if (!sess->buf) {
+		tftp_serve_error(sip, ethaddr, src, WELL_KNOWN_PORT,
+				 TFTP_ERR_UNDEFINED, "Out of memory");
+		return;
+	}
+
+	sess->our_port = tftp_serve_next_port;
+	if (++tftp_serve_next_port >= 4096)
+		tftp_serve_next_port = 1024;
+	sess->last = lldiv(sess->size, sess->block_size) + 1;
+	sess->start_time = get_timer(0);
+	sess->active = true;
+	printf("Serving '%s' to %pI4\n", sess->name, &sip);
+
+	if (sess->opts) {
+		sess->oack = true;
+		tftp_serve_send_oack(sess);
+	} else {
+		tftp_serve_send_window(sess);
+	}
+}
+
+static void tftp_serve_ack(struct tftp_session *sess, ushort block)
+{
+	/* Number of blocks acknowledged by this ACK */
+	ushort ahead = block - (ushort)sess->acked;
+
+	if (sess->oack) {
+		if (block)
+			return;
+		sess->oack = false;
+	} else if (ahead > sess->sent - sess->acked) {
+		return;
+	}
+	sess->acked += ahead;
+	sess->timeouts = 0;
+
+	if (sess->acked == sess->last) {
+		tftp_serve_end(sess, true);
+		return;
+	}
+
+	/*
+	 * Send the next window. If the client acknowledged less than a full
+	 * window, it has missed a block, so this sends the rest again.
+	 */
+	tftp_serve_send_window(sess);
+}
+
+static void tftp_serve_handler(uchar *pkt, unsigned dest, struct in_addr sip,
+			       unsigned src, unsigned len)
+{
+	struct tftp_session *sess = NULL;
+	ushort opcode;
+	int i;
+
+	if (len < 2)
+		return;
+	opcode = ntohs(*(__be16 *)pkt);
+
+	if (dest == WELL_KNOWN_PORT) {
+		if (opcode == TFTP_RRQ)
+			tftp_serve_rrq(sip, src, pkt + 2, len - 2);
+		else if (opcode == TFTP_WRQ)
+			tftp_serve_error(sip,
+				((struct ethernet_hdr *)net_rx_packet)->et_src,
+				src, WELL_KNOWN_PORT, TFTP_ERR_ACCESS_DENIED,
+				"Read only");
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(tftp_sessions); i++) {
+		struct tftp_session *cur = &tftp_sessions[i];
+
+		if (cur->active && cur->our_port == dest &&
+		    cur->ip.s_addr == sip.s_addr && cur->port == src)
+			sess = cur;
+	}
+	if (!sess)
+		return;
+
+	switch (opcode) {
+	case TFTP_ACK:
+		if (len >= 4)
+			tftp_serve_ack(sess, ntohs(*(__be16 *)(pkt + 2)));
+		break;
+	case TFTP_ERROR:
+		printf("\nTFTP error from %pI4: '%s'\n", &sip,
+		       len > 4 ? (char *)pkt + 4 : "");
+		tftp_serve_end(sess, false);
+		break;
+	}
+}
+
+/* Send again whatever has not been acknowledged in time */
+static void tftp_serve_timeout_handler(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tftp_sessions); i++) {
+		struct tftp_session *sess = &tftp_sessions[i];
+
+		if (!sess->active ||
+		    get_timer(sess->sent_at) < sess->timeout_ms)
+			continue;
+		if (++sess->timeouts > tftp_timeout_count_max) {
+			printf("\nTFTP client %pI4 timed out\n", &sess->ip);
+			tftp_serve_end(sess, false);
+		} else if (sess->oack) {
+			tftp_serve_send_oack(sess);
+		} else {
+			tftp_serve_send_window(sess);
+		}
+	}
+	net_set_timeout_handler(TFTP_SERVE_TICK, tftp_serve_timeout_handler);
+}
+
+void tftp_start_serve(void)
+{
+	int i;
+
+	/* Drop any sessions left over from an interrupted run */
+	for (i = 0; i < ARRAY_SIZE(tftp_sessions); i++) {
+		free(tftp_sessions[i].buf);
+		memset(&tftp_sessions[i], '\0', sizeof(tftp_sessions[i]));
+	}
+	tftp_serve_done = 0;
+	tftp_serve_next_port = 1024 + (get_timer(0) % 3072);
+
+	printf("Using %s device\n", eth_get_name());
+	printf("Serving %s %d:%d to TFTP clients on %pI4\n",
+	       blk_get_if_type_name(tftp_serve_desc->if_type),
+	       tftp_serve_desc->devnum, tftp_serve_part, &net_ip);
+
+	net_set_timeout_handler(TFTP_SERVE_TICK, tftp_serve_timeout_handler);
+	net_set_udp_handler(tftp_serve_handler);
+}
+#endif /* CONFIG_CMD_TFTPSERVE */
@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the hush parse cache
+ */
+
+#include <common.h>
+#include <cli_hush.h>
+#include <command.h>
+#include <console.h>
+#include <env.h>
+#include <time.h>
+#include <test/suites.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define ITERATIONS	200
+
+/* Declare a new hush test */
+#define HUSH_TEST(_name, _flags)	UNIT_TEST(_name, _flags, hush_test)
+
+/* Cut-down distro_bootcmd: nested loops, conditions and expansions */
+static const char bench_script[] =
+	"setenv devtype mmc; setenv devnum 0; setenv found; "
+	"for target in mmc0 mmc1 usb0 pxe dhcp; do "
+		"for prefix in / /boot/; do "
+			"for script in boot.scr.uimg boot.scr; do "
+				"if test \"${target}${prefix}${script}\" = "
+				"\"usb0/boot/boot.scr\"; then "
+					"setenv found ${devtype}${devnum}:${target}; "
+				"fi; "
+			"done; "
+		"done; "
+	"done";
+
+/* Check that a cached script gives the same result each time it is run */
+static int hush_test_cache_rerun(struct unit_test_state *uts)
+{
+	hush_cache_flush();
+	ut_assertok(env_set("script",
+			    "for i in a b c; do setenv out ${out}${i}; done; "
+			    "v=${x}3 setenv res ${v}"));
+	ut_assertok(env_set("out", NULL));
+	ut_assertok(env_set("x", "1"));
+	ut_assertok(run_command("run script", 0));
+	ut_asserteq_str("abc", env_get("out"));
+	ut_asserteq_str("13", env_get("res"));
+
+	/* Variables are expanded each time, not when the script is parsed */
+	ut_assertok(env_set("x", "5"));
+	ut_assertok(run_command("run script", 0));
+	ut_asserteq_str("abcabc", env_get("out"));
+	ut_asserteq_str("53", env_get("res"));
+
+	/* Changing the script must not run the old one */
+	ut_assertok(env_set("script", "setenv res changed"));
+	ut_assertok(run_command("run script", 0));
+	ut_asserteq_str("changed", env_get("res"));
+
+	return 0;
+}
+HUSH_TEST(hush_test_cache_rerun, 0);
+
+/* Check that leaving a loop early leaves the cached script intact */
+static int hush_test_cache_exit(struct unit_test_state *uts)
+{
+	hush_cache_flush();
+	ut_assertok(env_set("script",
+			    "for i in a b c; do setenv out ${out}${i}; exit; "
+			    "done"));
+	ut_assertok(env_set("out", NULL));
+	ut_assertok(run_command("run script", 0));
+	ut_asserteq_str("a", env_get("out"));
+	ut_assertok(run_command("run script", 0));
+	ut_asserteq_str("aa", env_get("out"));
+
+	return 0;
+}
+HUSH_TEST(hush_test_cache_exit, 0);
+
+/* Record the argument, then overwrite it as 'fdisk -c' used to */
+static int do_hush_test_argv(struct cmd_tbl *cmdtp, int flag, int argc,
+			     char *const argv[])
+{
+	if (argc != 2)
+		return CMD_RET_USAGE;
+	env_set("res", argv[1]);
+	argv[1][1] = 'p';
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	hush_test_argv,	2,	1,	do_hush_test_argv,
+	"Test command which writes to its argument",
+	"<arg>"
+);
+
+/* Check that a command writing to its arguments does not change the cache */
+static int hush_test_cache_argv(struct unit_test_state *uts)
+{
+	hush_cache_flush();
+	ut_assertok(env_set("script", "hush_test_argv -c"));
+	ut_assertok(run_command("run script", 0));
+	ut_asserteq_str("-c", env_get("res"));
+
+	ut_assertok(env_set("res", NULL));
+	ut_assertok(run_command("run script", 0));
+	ut_asserteq_str("-c", env_get("res"));
+	ut_assertok(env_set("res", NULL));
+
+	return 0;
+}
+HUSH_TEST(hush_test_cache_argv, 0);
+
+/* Check that a syntax error is still reported once, after earlier lines */
+static int hush_test_cache_syntax(struct unit_test_state *uts)
+{
+	hush_cache_flush();
+	ut_assertok(env_set("res", NULL));
+	ut_assertok(console_record_reset_enable());
+	run_command_list("setenv res 1\nif true; then\n", -1, 0);
+	ut_assert_nextline("syntax error");
+	ut_assert_console_end();
+	ut_asserteq_str("1", env_get("res"));
+
+	return 0;
+}
+HUSH_TEST(hush_test_cache_syntax, UT_TESTF_CONSOLE_REC);
+
+/* Compare the time taken to run a boot script with and without the cache */
+static int hush_test_cache_timing(struct unit_test_state *uts)
+{
+	ulong uncached, cached, start;
+	int i;
+
+	start = timer_get_us();
+	for (i = 0; i < ITERATIONS; i++) {
+		hush_cache_flush();
+		ut_assertok(run_command_list(bench_script, -1, 0));
+	}
+	uncached = timer_get_us() - start;
+	ut_asserteq_str("mmc0:usb0", env_get("found"));
+
+	start = timer_get_us();
+	for (i = 0; i < ITERATIONS; i++)
+		ut_assertok(run_command_list(bench_script, -1, 0));
+	cached = timer_get_us() - start;
+	ut_asserteq_str("mmc0:usb0", env_get("found"));
+
+	printf("%d runs: uncached %lu us, cached %lu us\n", ITERATIONS,
+	       uncached, cached);
+
+	return 0;
+}
+HUSH_TEST(hush_test_cache_timing, 0);
+
+int do_ut_hush(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test, hush_test);
+	const int n_ents = ll_entry_count(struct unit_test, hush_test);
+
+	return cmd_ut_category("hush", "hush_test_", tests, n_ents, argc,
+			       argv);
+}
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the 'mw' command on large regions
+ */
+
+#include <common.h>
+#include <command.h>
+#include <mapmem.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+#define BUF_ADDR	0x1000
+#define BUF_SIZE	0x2000
+
+/* Declare a new mem test */
+#define MEM_TEST(_name, _flags)	UNIT_TEST(_name, _flags, mem_test)
+
+/* Test 'mw' with a 32-bit value which is not a repeated byte */
+static int mem_test_mw_bulk_l(struct unit_test_state *uts)
+{
+	u32 *buf;
+	int i;
+
+	buf = map_sysmem(BUF_ADDR, BUF_SIZE);
+	memset(buf, '\0', BUF_SIZE);
+	ut_assertok(run_command("mw.l 1004 12345678 3ff", 0));
+	ut_asserteq(0, buf[0]);
+	for (i = 1; i < 0x400; i++)
+		ut_asserteq(0x12345678, buf[i]);
+	ut_asserteq(0, buf[0x400]);
+	unmap_sysmem(buf);
+
+	return 0;
+}
+MEM_TEST(mem_test_mw_bulk_l, 0);
+
+/* Test 'mw' with 16-bit and byte values, including repeated bytes */
+static int mem_test_mw_bulk_w(struct unit_test_state *uts)
+{
+	u16 *buf;
+	u8 *bbuf;
+	int i;
+
+	buf = map_sysmem(BUF_ADDR, BUF_SIZE);
+	bbuf = (u8 *)buf;
+	memset(buf, '\0', BUF_SIZE);
+	ut_assertok(run_command("mw.w 1002 abcd 801", 0));
+	ut_asserteq(0, buf[0]);
+	for (i = 1; i < 0x802; i++)
+		ut_asserteq(0xabcd, buf[i]);
+	ut_asserteq(0, buf[0x802]);
+
+	ut_assertok(run_command("mw.w 1000 5a5a 200", 0));
+	for (i = 0; i < 0x200; i++)
+		ut_asserteq(0x5a5a, buf[i]);
+	ut_asserteq(0xabcd, buf[0x200]);
+
+	ut_assertok(run_command("mw.b 1001 c3 1ff", 0));
+	ut_asserteq(0x5a, bbuf[0]);
+	for (i = 1; i < 0x200; i++)
+		ut_asserteq(0xc3, bbuf[i]);
+	ut_asserteq(0x5a, bbuf[0x200]);
+	unmap_sysmem(buf);
+
+	return 0;
+}
+MEM_TEST(mem_test_mw_bulk_w, 0);
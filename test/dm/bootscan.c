@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the bootscan command
+ */
+
+#include <common.h>
+#include <command.h>
+#include <dm.h>
+#include <env.h>
+#include <malloc.h>
+#include <os.h>
+#include <sandboxblockdev.h>
+#include <asm/eth.h>
+#include <asm/unaligned.h>
+#include <dm/test.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define BOOTSCAN_TEST_DISK	"bootscan.img"
+#define BOOTSCAN_TEST_BLOCKS	16
+#define BOOTSCAN_TEST_TARGETS	17
+
+/* Check that absent targets are dropped and ready ones moved to the front */
+static int dm_test_bootscan(struct unit_test_state *uts)
+{
+	/*
+	 * The sandbox MMC has no partition table or filesystem, no host
+	 * device is bound and the sandbox Ethernet driver cannot report its
+	 * link, so is taken to be up. Nothing is known about 'foo'.
+	 */
+	env_set("ethact", "eth@10002000");
+	ut_assertok(run_command("bootscan -t 100 scanned foo mmc9 host0 mmc0 "
+				"dhcp", 0));
+	ut_asserteq_str("dhcp foo", env_get("scanned"));
+
+	ut_assertok(run_command("bootscan scanned mmc0 mmc9", 0));
+	ut_assertnull(env_get("scanned"));
+
+	ut_asserteq(1, run_command("bootscan", 0));
+
+	return 0;
+}
+DM_TEST(dm_test_bootscan, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Create a host disk with a DOS partition table, which makes it ready */
+static int bootscan_test_disk(struct unit_test_state *uts)
+{
+	u8 *disk, *part;
+
+	disk = calloc(BOOTSCAN_TEST_BLOCKS, 512);
+	ut_assertnonnull(disk);
+	part = disk + 446;
+	part[4] = 0x83;
+	put_unaligned_le32(1, part + 8);
+	put_unaligned_le32(BOOTSCAN_TEST_BLOCKS - 1, part + 12);
+	disk[510] = 0x55;
+	disk[511] = 0xaa;
+	ut_assertok(os_write_file(BOOTSCAN_TEST_DISK, disk,
+				  BOOTSCAN_TEST_BLOCKS * 512));
+	free(disk);
+	ut_assertok(host_dev_bind(0, BOOTSCAN_TEST_DISK));
+
+	return 0;
+}
+
+/* Check that a target with no link yet is polled and kept, but put last */
+static int dm_test_bootscan_poll(struct unit_test_state *uts)
+{
+	int ret;
+
+	ut_assertok(bootscan_test_disk(uts));
+	env_set("ethact", "eth@10002000");
+
+	/* The network is polled until the timeout, so host0 goes first */
+	sandbox_eth_set_link(0, 0);
+	ret = run_command("bootscan -t 50 scanned dhcp host0", 0);
+	if (!ret && strcmp("host0 dhcp", env_get("scanned")))
+		ret = -EINVAL;
+
+	/* Once the link is up, the network is ready and stays first */
+	sandbox_eth_set_link(0, 1);
+	if (!ret)
+		ret = run_command("bootscan -t 50 scanned dhcp host0", 0);
+	if (!ret && strcmp("dhcp host0", env_get("scanned")))
+		ret = -EINVAL;
+
+	sandbox_eth_set_link(0, -ENOSYS);
+	env_set("scanned", NULL);
+	ut_assertok(host_dev_bind(0, NULL));
+	ut_assertok(os_unlink(BOOTSCAN_TEST_DISK));
+	ut_assertok(ret);
+
+	return 0;
+}
+DM_TEST(dm_test_bootscan_poll, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Check that distro_bootcmd tries every target when bootscan fails */
+static int dm_test_bootscan_fallback(struct unit_test_state *uts)
+{
+	char targets[BOOTSCAN_TEST_TARGETS * 4 + 1] = "";
+	char tried[BOOTSCAN_TEST_TARGETS * 3 + 1] = "";
+	char name[20], cmd[sizeof(targets) + 20];
+	char *old_targets;
+	int i;
+
+	ut_assertnonnull(env_get("distro_bootcmd"));
+	old_targets = strdup(env_get("boot_targets"));
+	ut_assertnonnull(old_targets);
+	for (i = 1; i <= BOOTSCAN_TEST_TARGETS; i++) {
+		snprintf(name, sizeof(name), "bootcmd_t%d", i);
+		snprintf(cmd, sizeof(cmd), "setenv tried ${tried}t%d", i);
+		ut_assertok(env_set(name, cmd));
+	}
+
+	/* Absent targets are skipped when the scan works */
+	env_set("tried", NULL);
+	env_set("boot_targets", "t1 mmc9 t2");
+	ut_assertok(run_command("run distro_bootcmd", 0));
+	ut_asserteq_str("t1t2", env_get("tried"));
+
+	/* There are too many targets for the scan, so all are tried */
+	for (i = 1; i <= BOOTSCAN_TEST_TARGETS; i++) {
+		snprintf(name, sizeof(name), "t%d", i);
+		strcat(targets, name);
+		strcat(tried, name);
+		if (i < BOOTSCAN_TEST_TARGETS)
+			strcat(targets, " ");
+	}
+	snprintf(cmd, sizeof(cmd), "bootscan scanned %s", targets);
+	ut_asserteq(1, run_command(cmd, 0));
+	env_set("tried", NULL);
+	env_set("boot_targets", targets);
+	ut_assertok(run_command("run distro_bootcmd", 0));
+	ut_asserteq_str(tried, env_get("tried"));
+	ut_asserteq_str(targets, env_get("boot_targets_ready"));
+
+	for (i = 1; i <= BOOTSCAN_TEST_TARGETS; i++) {
+		snprintf(name, sizeof(name), "bootcmd_t%d", i);
+		env_set(name, NULL);
+	}
+	env_set("tried", NULL);
+	env_set("boot_targets_ready", NULL);
+	env_set("boot_targets", old_targets);
+	free(old_targets);
+
+	return 0;
+}
+DM_TEST(dm_test_bootscan_fallback, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
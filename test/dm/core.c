@@ -12,6 +12,7 @@
 #include <log.h>
 #include <malloc.h>
 #include <dm/device-internal.h>
+#include <dm/lists.h>
 #include <dm/root.h>
 #include <dm/util.h>
 #include <dm/test.h>
@@ -1029,8 +1030,24 @@ DM_TEST(dm_test_device_get_uclass_id, UT_TESTF_SCAN_PDATA);
 
 static int dm_test_uclass_names(struct unit_test_state *uts)
 {
+	struct uclass_driver *uc_drv;
+	int id;
+
 	ut_asserteq_str("test", uclass_get_name(UCLASS_TEST));
 	ut_asserteq(UCLASS_TEST, uclass_get_by_name("test"));
+	ut_asserteq(UCLASS_INVALID, uclass_get_by_name("no-such-uclass"));
+
+	/* Every uclass name should be found, the lowest ID first */
+	for (id = 0; id < UCLASS_COUNT; id++) {
+		enum uclass_id found;
+
+		uc_drv = lists_uclass_lookup(id);
+		if (!uc_drv)
+			continue;
+		found = uclass_get_by_name(uc_drv->name);
+		ut_assert(found != UCLASS_INVALID && found <= id);
+		ut_asserteq_str(uc_drv->name, lists_uclass_lookup(found)->name);
+	}
 
 	return 0;
 }
@@ -1066,3 +1083,226 @@ static int dm_test_inactive_child(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_inactive_child, UT_TESTF_SCAN_PDATA);
+
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+/* Check that the compatible-string index agrees with a linear search */
+static int dm_test_compat_index(struct unit_test_state *uts)
+{
+	struct driver *drv = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *id, *found_id, *other;
+	struct dm_compat_index *idx;
+	struct driver *entry, *first, *found;
+	int count = 0;
+
+	idx = lists_compat_index();
+	ut_assertnonnull(idx);
+
+	for (entry = drv; entry != drv + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++) {
+			/* The first driver in the list must win */
+			for (first = drv; first != entry; first++) {
+				for (other = first->of_match;
+				     other && other->compatible; other++) {
+					if (!strcmp(other->compatible,
+						    id->compatible))
+						break;
+				}
+				if (other && other->compatible)
+					break;
+			}
+			if (first == entry)
+				count++;
+			found = lists_driver_lookup_compat(id->compatible,
+							   &found_id);
+			ut_asserteq_ptr(first, found);
+			ut_asserteq_str(id->compatible, found_id->compatible);
+		}
+	}
+	ut_asserteq(count, idx->count);
+	ut_assert(idx->mask + 1 >= 2 * idx->count);
+
+	ut_assertnull(lists_driver_lookup_compat("no-such,device", &found_id));
+
+	return 0;
+}
+DM_TEST(dm_test_compat_index, 0);
+#endif
+
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+static int dm_count_devices(struct udevice *parent)
+{
+	struct udevice *dev;
+	int count = 1;
+
+	list_for_each_entry(dev, &parent->child_head, sibling_node)
+		count += dm_count_devices(dev);
+
+	return count;
+}
+
+/* Compare an eager scan with a lazy one and check that they end up equal */
+static int dm_test_lazy_bind(struct unit_test_state *uts)
+{
+	uint deferred, bound, pending;
+	ulong start, eager_us, lazy_us;
+	int eager, lazy;
+	struct udevice *dev;
+
+	start = timer_get_us();
+	ut_assertok(dm_extended_scan_fdt(gd->fdt_blob, false));
+	eager_us = timer_get_us() - start;
+	eager = dm_count_devices(dm_root());
+
+	/* Start again with lazy binding, as dm_init_and_scan() does */
+	ut_assertok(dm_uninit());
+	ut_assertok(dm_init(of_live_active()));
+	ut_assertok(dm_lazy_start());
+	start = timer_get_us();
+	ut_assertok(dm_extended_scan_fdt(gd->fdt_blob, false));
+	lazy_us = timer_get_us() - start;
+	lazy = dm_count_devices(dm_root());
+
+	dm_lazy_get_stats(&deferred, &bound, &pending);
+	ut_assert(deferred > 0);
+	ut_asserteq(0, bound);
+	ut_asserteq(deferred, pending);
+	ut_assert(lazy < eager);
+
+	/* Looking up a device binds its uclass */
+	ut_assertok(uclass_get_device_by_name(UCLASS_TEST_FDT, "a-test", &dev));
+	dm_lazy_get_stats(&deferred, &bound, &pending);
+	ut_assert(bound > 0);
+	ut_asserteq(deferred, bound + pending);
+
+	/* Showing the tree binds everything */
+	dm_dump_all();
+	dm_lazy_get_stats(&deferred, &bound, &pending);
+	ut_asserteq(0, pending);
+	ut_asserteq(eager, dm_count_devices(dm_root()));
+
+	printf("Eager: %d devices in %lu us\n", eager, eager_us);
+	printf("Lazy:  %d devices in %lu us, %u deferred\n", lazy, lazy_us,
+	       deferred);
+	dm_lazy_stop();
+
+	return 0;
+}
+DM_TEST(dm_test_lazy_bind, 0);
+#endif
+
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+/* Check that each indexed lookup finds what a list walk would find */
+static int dm_check_uclass_lookups(struct unit_test_state *uts,
+				   enum uclass_id id)
+{
+	struct udevice *dev, *found, *expect;
+	struct uclass *uc;
+
+	ut_assertok(uclass_get(id, &uc));
+	uclass_foreach_dev(dev, uc) {
+		uclass_foreach_dev(expect, uc) {
+			if (!strcmp(expect->name, dev->name))
+				break;
+		}
+		ut_assertok(uclass_find_device_by_name(id, dev->name, &found));
+		ut_asserteq_ptr(expect, found);
+
+		if (ofnode_valid(dev_ofnode(dev))) {
+			ut_assertok(uclass_find_device_by_ofnode(id,
+							dev_ofnode(dev),
+							&found));
+			ut_asserteq_ptr(dev, found);
+		}
+
+		if (dev->seq != -1) {
+			ut_assertok(uclass_find_device_by_seq(id, dev->seq,
+							      false, &found));
+			ut_asserteq_ptr(dev, found);
+		}
+	}
+
+	return 0;
+}
+
+static int dm_test_uclass_index(struct unit_test_state *uts)
+{
+	struct dm_test_state *dms = uts->priv;
+	struct udevice *dev, *found, *extra[40];
+	char name[20];
+	int seq, i;
+
+	ut_assertok(dm_check_uclass_lookups(uts, UCLASS_TEST_FDT));
+	ut_asserteq(-ENODEV, uclass_find_device_by_name(UCLASS_TEST_FDT,
+							"no-such-device",
+							&found));
+
+	/* Sequence numbers are indexed as devices are probed and removed */
+	ut_assertok(uclass_get_device(UCLASS_TEST_FDT, 1, &dev));
+	seq = dev->seq;
+	ut_assert(seq >= 0);
+	ut_assertok(dm_check_uclass_lookups(uts, UCLASS_TEST_FDT));
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST_FDT, seq,
+						       false, &found));
+	ut_assertok(device_probe(dev));
+	ut_assertok(uclass_find_device_by_seq(UCLASS_TEST_FDT, dev->seq, false,
+					      &found));
+	ut_asserteq_ptr(dev, found);
+
+	/* Renaming a device moves it in the index */
+	strlcpy(name, dev->name, sizeof(name));
+	ut_assertok(device_set_name(dev, "renamed"));
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST_FDT, "renamed",
+					       &found));
+	ut_asserteq_ptr(dev, found);
+	ut_asserteq(-ENODEV, uclass_find_device_by_name(UCLASS_TEST_FDT, name,
+							&found));
+
+	/* Bind enough devices to make the index grow, then unbind them */
+	for (i = 0; i < ARRAY_SIZE(extra); i++) {
+		ut_assertok(device_bind_driver(dms->root, "test_drv", "extra",
+					       &extra[i]));
+		snprintf(name, sizeof(name), "extra%d", i);
+		ut_assertok(device_set_name(extra[i], name));
+		ut_assertok(dm_check_uclass_lookups(uts, UCLASS_TEST));
+	}
+	for (i = 0; i < ARRAY_SIZE(extra); i++) {
+		snprintf(name, sizeof(name), "extra%d", i);
+		ut_assertok(device_unbind(extra[i]));
+		ut_asserteq(-ENODEV, uclass_find_device_by_name(UCLASS_TEST,
+								name, &found));
+	}
+	ut_assertok(dm_check_uclass_lookups(uts, UCLASS_TEST));
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_index, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Check that a sequence lookup after unbinding does not see the old device */
+static int dm_test_uclass_index_unbind(struct unit_test_state *uts)
+{
+	struct dm_test_state *dms = uts->priv;
+	struct udevice *dev, *found;
+	int seq;
+
+	ut_assertok(device_bind_driver(dms->root, "test_drv", "seq-test",
+				       &dev));
+	ut_assertok(device_probe(dev));
+	seq = dev->seq;
+	ut_assert(seq >= 0);
+	ut_assertok(uclass_find_device_by_seq(UCLASS_TEST, seq, false,
+					      &found));
+	ut_asserteq_ptr(dev, found);
+
+	/* Removing resets dev->seq, so the entry must be found by pointer */
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(device_unbind(dev));
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST, seq, false,
+						       &found));
+	ut_assertok(dm_check_uclass_lookups(uts, UCLASS_TEST));
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_index_unbind, UT_TESTF_SCAN_PDATA);
+#endif
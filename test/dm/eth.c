@@ -13,6 +13,7 @@
 #include <log.h>
 #include <malloc.h>
 #include <net.h>
+#include <time.h>
 #include <asm/eth.h>
 #include <dm/test.h>
 #include <dm/device-internal.h>
@@ -431,3 +432,173 @@ static int dm_test_eth_async_ping_reply(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_eth_async_ping_reply, UT_TESTF_SCAN_FDT);
+
+#if defined(CONFIG_NET_ARP_CACHE) && defined(CONFIG_NET_WARM_LINK)
+/**
+ * struct eth_warm_state - What the device saw during the warm link test
+ *
+ * @starts: Number of times the device was started
+ * @arp_requests: Number of ARP requests sent
+ */
+struct eth_warm_state {
+	int starts;
+	int arp_requests;
+};
+
+static int sb_warm_start(struct udevice *dev)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct eth_warm_state *state = priv->priv;
+
+	state->starts++;
+
+	return 0;
+}
+
+static int sb_warm_handler(struct udevice *dev, void *packet,
+			   unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct eth_warm_state *state = priv->priv;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		state->arp_requests++;
+	sandbox_eth_ping_req_to_reply(dev, packet, len);
+
+	return 0;
+}
+
+/* Check that back-to-back commands reuse the running device and ARP reply */
+static int dm_test_eth_warm(struct unit_test_state *uts)
+{
+	struct eth_warm_state state = { 0 };
+
+	net_ping_ip = string_to_ip("1.1.2.2");
+
+	sandbox_eth_set_tx_handler(0, sb_warm_handler);
+	sandbox_eth_set_start_handler(0, sb_warm_start);
+	sandbox_eth_set_priv(0, &state);
+	env_set("ethact", "eth@10002000");
+	ut_assertok(net_loop(PING));
+	ut_assertok(net_loop(PING));
+	ut_asserteq(1, state.starts);
+	ut_asserteq(1, state.arp_requests);
+
+	/* An expired entry is looked up again, on the same link */
+	timer_test_add_offset((CONFIG_NET_ARP_CACHE_TTL + 1) * 1000UL);
+	ut_assertok(net_loop(PING));
+	ut_asserteq(1, state.starts);
+	ut_asserteq(2, state.arp_requests);
+
+	/* A failure stops the device and empties the cache */
+	sandbox_eth_disable_response(0, true);
+	sandbox_eth_skip_timeout();
+	ut_asserteq(-ENONET, net_loop(PING));
+	sandbox_eth_disable_response(0, false);
+	ut_assertok(net_loop(PING));
+	ut_asserteq(2, state.starts);
+	ut_asserteq(3, state.arp_requests);
+
+	sandbox_eth_set_start_handler(0, NULL);
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	return 0;
+}
+DM_TEST(dm_test_eth_warm, UT_TESTF_SCAN_FDT);
+#endif
+
+#ifdef CONFIG_NET_RX_LEND
+#define LEND_TEST_PORT		4321
+#define LEND_TEST_HDR		4
+#define LEND_TEST_LEN		64
+#define LEND_TEST_BELOW		128
+
+/* Where the UDP handler found the payload of the last packet */
+static uchar *lend_test_payload;
+
+static void lend_test_handler(uchar *pkt, unsigned int dport,
+			      struct in_addr sip, unsigned int sport,
+			      unsigned int len)
+{
+	lend_test_payload = pkt + LEND_TEST_HDR;
+}
+
+/* Queue a UDP packet with header byte @id and a payload filled with @fill */
+static void lend_test_send(struct udevice *dev, u8 id, u8 fill)
+{
+	u8 *data;
+
+	data = sandbox_eth_queue_udp(dev, -1, LEND_TEST_PORT, LEND_TEST_PORT,
+				     LEND_TEST_HDR + LEND_TEST_LEN);
+	if (!data)
+		return;
+	memset(data, '\0', LEND_TEST_HDR);
+	data[0] = id;
+	memset(data + LEND_TEST_HDR, fill, LEND_TEST_LEN);
+}
+
+/* Check whether @len bytes at @ptr all have the value @val */
+static bool lend_test_filled(const u8 *ptr, int len, u8 val)
+{
+	while (len--) {
+		if (*ptr++ != val)
+			return false;
+	}
+
+	return true;
+}
+
+/* Check that a packet is received straight into lent memory */
+static int dm_test_eth_rx_lend(struct unit_test_state *uts)
+{
+	u8 buf[LEND_TEST_BELOW + LEND_TEST_LEN + 16] __aligned(4);
+	u8 *dest = buf + LEND_TEST_BELOW;
+	struct eth_rx_lend lend = {
+		.buf = dest,
+		.len = LEND_TEST_LEN,
+		.below = LEND_TEST_BELOW,
+		.dport = LEND_TEST_PORT,
+		.hdr_len = LEND_TEST_HDR,
+		.match_len = 1,
+		.match = { 1 },
+	};
+	struct udevice *dev;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_ETH, "eth@10002000",
+					      &dev));
+	env_set("ethact", "eth@10002000");
+	ut_assertok(net_init());
+	eth_set_current();
+	ut_assertok(eth_init());
+	net_set_udp_handler(lend_test_handler);
+	memset(buf, 0xaa, sizeof(buf));
+	eth_rx_lend(&lend);
+
+	/* A packet which does not match is processed from the ring */
+	lend_test_send(dev, 2, 0x11);
+	eth_rx();
+	ut_assertnonnull(lend_test_payload);
+	ut_assert(lend_test_payload != dest);
+	ut_assert(lend_test_filled(buf, sizeof(buf), 0xaa));
+
+	/* One which does is put in place, and what its headers hid put back */
+	lend_test_send(dev, 1, 0x22);
+	eth_rx();
+	ut_asserteq_ptr(dest, lend_test_payload);
+	ut_assert(lend_test_filled(buf, LEND_TEST_BELOW, 0xaa));
+	ut_assert(lend_test_filled(dest, LEND_TEST_LEN, 0x22));
+	ut_assert(lend_test_filled(dest + LEND_TEST_LEN, 16, 0xaa));
+
+	/* The memory is only lent once */
+	lend_test_send(dev, 1, 0x33);
+	eth_rx();
+	ut_assert(lend_test_payload != dest);
+	ut_assert(lend_test_filled(dest, LEND_TEST_LEN, 0x22));
+
+	net_set_udp_handler(NULL);
+	eth_halt();
+
+	return 0;
+}
+DM_TEST(dm_test_eth_rx_lend, UT_TESTF_SCAN_FDT);
+#endif
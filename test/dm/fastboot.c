@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for fastboot over UDP, against a stand-in host behind the sandbox
+ * Ethernet driver
+ */
+
+#include <common.h>
+#include <command.h>
+#include <dm.h>
+#include <env.h>
+#include <mapmem.h>
+#include <net.h>
+#include <asm/eth.h>
+#include <asm/test.h>
+#include <asm/unaligned.h>
+#include <dm/test.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define FB_TEST_PORT		5554
+#define FB_TEST_HOST_PORT	45678
+/* Packet size and window offered by the host, more than U-Boot allows */
+#define FB_TEST_PACKET_SIZE	8192
+#define FB_TEST_WINDOW		8
+
+#define FB_HDR_SIZE		4
+#define FB_FLAG_CONTINUATION	0x01
+/* Bytes after the image which must be left alone */
+#define FB_TEST_GUARD		64
+
+enum {
+	FB_QUERY = 1,
+	FB_INIT,
+	FB_FASTBOOT,
+};
+
+enum fb_test_stage {
+	FB_STAGE_CMD,		/* waiting for the command to be acknowledged */
+	FB_STAGE_RESPONSE,	/* waiting for the response to the command */
+	FB_STAGE_DATA,		/* sending download data */
+	FB_STAGE_DONE,		/* finished */
+};
+
+/**
+ * struct fb_test_state - State of the stand-in fastboot host
+ *
+ * @uts: Test state, used by the ut_assert macros
+ * @stage: Current stage
+ * @seq: Sequence number of the next packet to send
+ * @expect: Response expected to the current command
+ * @data_seq: Sequence number of the first download packet
+ * @data_size: Amount of data in each download packet
+ * @packets: Number of download packets
+ * @window: Number of download packets U-Boot allows in flight
+ * @sent: Number of download packets sent
+ * @acked: Number of download packets acknowledged
+ * @max_in_flight: Largest number of download packets seen in flight
+ * @continued: true once the "continue" command has been sent
+ */
+struct fb_test_state {
+	struct unit_test_state *uts;
+	enum fb_test_stage stage;
+	u16 seq;
+	const char *expect;
+	u16 data_seq;
+	int data_size;
+	int packets;
+	int window;
+	int sent;
+	int acked;
+	int max_in_flight;
+	bool continued;
+};
+
+/* Queue a packet from the host, after any queued earlier */
+static int sb_fb_send_flags(struct udevice *dev, u8 id, u8 flags, u16 seq,
+			    const void *data, int len)
+{
+	u8 *hdr;
+
+	hdr = sandbox_eth_queue_udp(dev, -1, FB_TEST_HOST_PORT, FB_TEST_PORT,
+				    FB_HDR_SIZE + len);
+	if (!hdr)
+		return -EOVERFLOW;
+	hdr[0] = id;
+	hdr[1] = flags;
+	put_unaligned_be16(seq, hdr + 2);
+	memcpy(hdr + FB_HDR_SIZE, data, len);
+
+	return 0;
+}
+
+static int sb_fb_send(struct udevice *dev, u8 id, u16 seq, const void *data,
+		      int len)
+{
+	return sb_fb_send_flags(dev, id, 0, seq, data, len);
+}
+
+/* Send a command, expecting the given response once it has run */
+static int sb_fb_command(struct udevice *dev, struct fb_test_state *state,
+			 const char *cmd, const char *expect)
+{
+	state->stage = FB_STAGE_CMD;
+	state->expect = expect;
+
+	return sb_fb_send(dev, FB_FASTBOOT, state->seq++, cmd, strlen(cmd));
+}
+
+/*
+ * Send download packet @index of the test image. The host sets the
+ * continuation flag on every packet, as if it had more to write after the
+ * last one. U-Boot expects the flag to be clear on the last packet, so that
+ * one is not received in place and the packets after it must not be either.
+ */
+static int sb_fb_send_data(struct udevice *dev, struct fb_test_state *state,
+			   int index)
+{
+	int offset = index * state->data_size;
+	int len = min(state->data_size, SANDBOX_NET_TEST_SIZE - offset);
+	u8 buf[FB_TEST_PACKET_SIZE];
+	int i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = sandbox_test_byte(offset + i);
+
+	return sb_fb_send_flags(dev, FB_FASTBOOT, FB_FLAG_CONTINUATION,
+				state->data_seq + index, buf, len);
+}
+
+/* Act on a reply from U-Boot, sending whatever the host sends next */
+static int sb_fb_reply(struct udevice *dev, struct fb_test_state *state,
+		       const u8 *hdr, int len)
+{
+	struct unit_test_state *uts = state->uts;
+	const u8 *data = hdr + FB_HDR_SIZE;
+	u16 seq = get_unaligned_be16(hdr + 2);
+	u8 buf[3 * sizeof(u16)];
+	char cmd[20];
+	int i;
+
+	ut_assert(len >= FB_HDR_SIZE);
+	len -= FB_HDR_SIZE;
+
+	switch (hdr[0]) {
+	case FB_QUERY:
+		ut_asserteq(sizeof(u16), len);
+		state->seq = get_unaligned_be16(data);
+		put_unaligned_be16(1, buf);
+		put_unaligned_be16(FB_TEST_PACKET_SIZE, buf + 2);
+		put_unaligned_be16(FB_TEST_WINDOW, buf + 4);
+		return sb_fb_send(dev, FB_INIT, state->seq++, buf, sizeof(buf));
+	case FB_INIT:
+		ut_asserteq(3 * sizeof(u16), len);
+		ut_asserteq((u16)(state->seq - 1), seq);
+		ut_asserteq(1, get_unaligned_be16(data));
+		ut_asserteq(CONFIG_UDP_FUNCTION_FASTBOOT_PACKET_SIZE,
+			    get_unaligned_be16(data + 2));
+		state->data_size = get_unaligned_be16(data + 2) - FB_HDR_SIZE;
+		state->window = get_unaligned_be16(data + 4);
+		ut_asserteq(min(FB_TEST_WINDOW,
+				CONFIG_UDP_FUNCTION_FASTBOOT_WINDOW),
+			    state->window);
+		snprintf(cmd, sizeof(cmd), "download:%08x",
+			 SANDBOX_NET_TEST_SIZE);
+		return sb_fb_command(dev, state, cmd, "DATA");
+	case FB_FASTBOOT:
+		break;
+	default:
+		ut_assertf(false, "Unexpected packet ID %d\n", hdr[0]);
+	}
+
+	switch (state->stage) {
+	case FB_STAGE_CMD:
+		ut_asserteq((u16)(state->seq - 1), seq);
+		ut_asserteq(0, len);
+		state->stage = FB_STAGE_RESPONSE;
+		return sb_fb_send(dev, FB_FASTBOOT, state->seq++, NULL, 0);
+	case FB_STAGE_RESPONSE:
+		ut_asserteq((u16)(state->seq - 1), seq);
+		ut_assert(len >= 4);
+		ut_asserteq_mem(state->expect, data, 4);
+		if (!strcmp(state->expect, "DATA")) {
+			state->stage = FB_STAGE_DATA;
+			state->data_seq = state->seq;
+			state->packets = DIV_ROUND_UP(SANDBOX_NET_TEST_SIZE,
+						      state->data_size);
+			state->sent = min(state->window, state->packets);
+			state->max_in_flight = state->sent;
+
+			/* Send the first window back to front */
+			for (i = state->sent - 1; i >= 0; i--)
+				ut_assertok(sb_fb_send_data(dev, state, i));
+			return 0;
+		}
+		if (!state->continued) {
+			state->continued = true;
+			return sb_fb_command(dev, state, "continue", "OKAY");
+		}
+		state->stage = FB_STAGE_DONE;
+		return 0;
+	case FB_STAGE_DATA:
+		/* Download packets are acknowledged in order */
+		ut_asserteq((u16)(state->data_seq + state->acked), seq);
+		ut_asserteq(0, len);
+		state->acked++;
+		if (state->sent < state->packets) {
+			ut_assertok(sb_fb_send_data(dev, state, state->sent));
+			state->sent++;
+			state->max_in_flight = max(state->max_in_flight,
+						   state->sent - state->acked);
+			return 0;
+		}
+		if (state->acked < state->packets)
+			return 0;
+
+		/* Read the response to the download */
+		state->seq = state->data_seq + state->packets;
+		state->stage = FB_STAGE_RESPONSE;
+		state->expect = "OKAY";
+		return sb_fb_send(dev, FB_FASTBOOT, state->seq++, NULL, 0);
+	default:
+		ut_assertf(false, "Unexpected packet after the end\n");
+	}
+
+	return 0;
+}
+
+static int sb_fb_handler(struct udevice *dev, void *packet, unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct fb_test_state *state = priv->priv;
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return 0;
+
+	/* Stop U-Boot waiting for more packets if anything goes wrong */
+	if (ntohs(ip->udp_dst) != FB_TEST_HOST_PORT ||
+	    sb_fb_reply(dev, state, (void *)ip + IP_UDP_HDR_SIZE,
+			ntohs(ip->udp_len) - UDP_HDR_SIZE))
+		net_set_state(NETLOOP_FAIL);
+
+	return 0;
+}
+
+/* Start the session with a query, as the host speaks first */
+static int sb_fb_start(struct udevice *dev)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+
+	priv->fake_host_ipaddr = string_to_ip("1.2.3.5");
+
+	return sb_fb_send(dev, FB_QUERY, 0, NULL, 0);
+}
+
+/* Check that a download is windowed and that packets may arrive out of order */
+static int dm_test_fastboot_udp(struct unit_test_state *uts)
+{
+	struct fb_test_state state = { .uts = uts };
+	char cmd[50];
+	u8 *ptr;
+	int i;
+
+	sandbox_eth_set_tx_handler(0, sb_fb_handler);
+	sandbox_eth_set_start_handler(0, sb_fb_start);
+	sandbox_eth_set_priv(0, &state);
+	env_set("ethact", "eth@10002000");
+	snprintf(cmd, sizeof(cmd), "fastboot -l %x -s %x udp",
+		 SANDBOX_NET_TEST_ADDR, SANDBOX_NET_TEST_SIZE);
+	ptr = map_sysmem(SANDBOX_NET_TEST_ADDR,
+			 SANDBOX_NET_TEST_SIZE + FB_TEST_GUARD);
+	memset(ptr + SANDBOX_NET_TEST_SIZE, 0xa5, FB_TEST_GUARD);
+	ut_assertok(run_command(cmd, 0));
+	sandbox_eth_set_start_handler(0, NULL);
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	ut_asserteq(FB_STAGE_DONE, state.stage);
+	ut_asserteq(SANDBOX_NET_TEST_SIZE, env_get_hex("filesize", 0));
+	for (i = 0; i < SANDBOX_NET_TEST_SIZE; i++)
+		ut_asserteq(sandbox_test_byte(i), ptr[i]);
+
+	/* Nothing received after the download may land beyond the image */
+	for (i = 0; i < FB_TEST_GUARD; i++)
+		ut_asserteq(0xa5, ptr[SANDBOX_NET_TEST_SIZE + i]);
+	unmap_sysmem(ptr);
+	ut_asserteq(state.window, state.max_in_flight);
+
+	return 0;
+}
+DM_TEST(dm_test_fastboot_udp, UT_TESTF_SCAN_FDT);
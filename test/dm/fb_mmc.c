@@ -0,0 +1,229 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for writing fastboot downloads to MMC as they arrive
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <dm.h>
+#include <env.h>
+#include <fastboot.h>
+#include <fb_mmc.h>
+#include <malloc.h>
+#include <part.h>
+#include <sparse_format.h>
+#include <asm/test.h>
+#include <dm/test.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <linux/stringify.h>
+
+/* Raw partition on the sandbox MMC device, in 512-byte blocks */
+#define FB_MMC_TEST_PART	"fbtest"
+#define FB_MMC_TEST_START	0x100
+#define FB_MMC_TEST_BLOCKS	0x40
+#define FB_MMC_TEST_SIZE	(FB_MMC_TEST_BLOCKS * 512)
+/* Sparse block size; the partition holds eight of these */
+#define FB_MMC_TEST_BLKSZ	4096
+#define FB_MMC_TEST_FILL	0x5a0ff0a5
+/* Staging buffer, smaller than a sparse block and not a whole MMC block */
+#define FB_MMC_TEST_BUF_SIZE	0xb00
+
+/* Length of the pieces the image is fed in, repeated as needed */
+static const u32 fb_mmc_test_pieces[] = { 1, 3, 11, 27, 509, 1001, 4099 };
+
+static u8 *fb_mmc_test_chunk(u8 *ptr, u16 type, u32 blocks, u32 data_len)
+{
+	chunk_header_t *chunk = (chunk_header_t *)ptr;
+
+	chunk->chunk_type = type;
+	chunk->reserved1 = 0;
+	chunk->chunk_sz = blocks;
+	chunk->total_sz = sizeof(*chunk) + data_len;
+
+	return ptr + sizeof(*chunk);
+}
+
+/**
+ * fb_mmc_test_image() - Create a sparse image with one chunk of each type
+ *
+ * @buf: Buffer for the image, at least 4 sparse blocks plus headers
+ * @dont_care: Number of sparse blocks to skip in the middle of the image
+ * @return size of the image in bytes
+ */
+static int fb_mmc_test_image(u8 *buf, u32 dont_care)
+{
+	sparse_header_t *file = (sparse_header_t *)buf;
+	u8 *ptr = buf + sizeof(*file);
+	int i;
+
+	memset(file, '\0', sizeof(*file));
+	file->magic = SPARSE_HEADER_MAGIC;
+	file->major_version = 1;
+	file->file_hdr_sz = sizeof(*file);
+	file->chunk_hdr_sz = sizeof(chunk_header_t);
+	file->blk_sz = FB_MMC_TEST_BLKSZ;
+	file->total_blks = 5 + dont_care;
+	file->total_chunks = 5;
+
+	ptr = fb_mmc_test_chunk(ptr, CHUNK_TYPE_RAW, 2, 2 * FB_MMC_TEST_BLKSZ);
+	for (i = 0; i < 2 * FB_MMC_TEST_BLKSZ; i++)
+		*ptr++ = sandbox_test_byte(i);
+	ptr = fb_mmc_test_chunk(ptr, CHUNK_TYPE_FILL, 2, sizeof(u32));
+	*(u32 *)ptr = FB_MMC_TEST_FILL;
+	ptr += sizeof(u32);
+	ptr = fb_mmc_test_chunk(ptr, CHUNK_TYPE_DONT_CARE, dont_care, 0);
+	ptr = fb_mmc_test_chunk(ptr, CHUNK_TYPE_RAW, 1, FB_MMC_TEST_BLKSZ);
+	for (i = 0; i < FB_MMC_TEST_BLKSZ; i++)
+		*ptr++ = sandbox_test_byte(i + 0x100);
+	/* write_sparse_image() does not accept a checksum after the header */
+	ptr = fb_mmc_test_chunk(ptr, CHUNK_TYPE_CRC32, 0, 0);
+
+	return ptr - buf;
+}
+
+/* Fill the partition with a pattern, for the blocks the image skips */
+static int fb_mmc_test_clear(struct unit_test_state *uts,
+			     struct blk_desc *desc, u8 *part)
+{
+	memset(part, 0xa5, FB_MMC_TEST_SIZE);
+	ut_asserteq(FB_MMC_TEST_BLOCKS, blk_dwrite(desc, FB_MMC_TEST_START,
+						   FB_MMC_TEST_BLOCKS, part));
+
+	return 0;
+}
+
+/**
+ * fb_mmc_test_stream() - Stream an image to the partition in odd pieces
+ *
+ * @uts: Test state
+ * @image: Image to send
+ * @len: Size of the image in bytes
+ * @response: Returns the response to the "flash" command
+ * @return 0 if the test passed, -ve if an assertion failed
+ */
+static int fb_mmc_test_stream(struct unit_test_state *uts, const u8 *image,
+			      u32 len, char *response)
+{
+	u32 n;
+	int i;
+
+	fastboot_mmc_stream_arm(FB_MMC_TEST_PART, response);
+	ut_asserteq_str("OKAY", response);
+	ut_asserteq(FB_MMC_TEST_SIZE, fastboot_mmc_stream_limit());
+	ut_assertok(fastboot_mmc_stream_start(len));
+
+	for (i = 0; len; i++) {
+		n = min(len, fb_mmc_test_pieces[i %
+						ARRAY_SIZE(fb_mmc_test_pieces)]);
+		fastboot_mmc_stream_write(image, n);
+		image += n;
+		len -= n;
+	}
+
+	*response = '\0';
+	fastboot_mmc_stream_finish(response);
+	fastboot_mmc_stream_flash(FB_MMC_TEST_PART, response);
+
+	return 0;
+}
+
+/* Check that a streamed sparse image matches one written in one go */
+static int dm_test_fb_mmc_stream(struct unit_test_state *uts)
+{
+	char response[FASTBOOT_RESPONSE_LEN];
+	u8 *image, *expect, *part, *buf;
+	struct blk_desc *desc;
+	int len;
+
+	desc = blk_get_dev("mmc", CONFIG_FASTBOOT_FLASH_MMC_DEV);
+	ut_assertnonnull(desc);
+	ut_assertok(env_set("fastboot_raw_partition_" FB_MMC_TEST_PART,
+			    __stringify(FB_MMC_TEST_START) " "
+			    __stringify(FB_MMC_TEST_BLOCKS)));
+	image = malloc(FB_MMC_TEST_SIZE);
+	expect = malloc(FB_MMC_TEST_SIZE);
+	part = malloc(FB_MMC_TEST_SIZE);
+	buf = malloc(FB_MMC_TEST_BUF_SIZE);
+	ut_assertnonnull(image);
+	ut_assertnonnull(expect);
+	ut_assertnonnull(part);
+	ut_assertnonnull(buf);
+	fastboot_init(buf, FB_MMC_TEST_BUF_SIZE);
+	len = fb_mmc_test_image(image, 1);
+
+	/* Write the image with write_sparse_image() for comparison */
+	ut_assertok(fb_mmc_test_clear(uts, desc, part));
+	fastboot_mmc_flash_write(FB_MMC_TEST_PART, image, len, response);
+	ut_asserteq_str("OKAY", response);
+	ut_asserteq(FB_MMC_TEST_BLOCKS, blk_dread(desc, FB_MMC_TEST_START,
+						  FB_MMC_TEST_BLOCKS, expect));
+
+	ut_assertok(fb_mmc_test_clear(uts, desc, part));
+	ut_assertok(fb_mmc_test_stream(uts, image, len, response));
+	ut_asserteq_str("OKAY", response);
+	ut_asserteq(FB_MMC_TEST_BLOCKS, blk_dread(desc, FB_MMC_TEST_START,
+						  FB_MMC_TEST_BLOCKS, part));
+	ut_asserteq_mem(expect, part, FB_MMC_TEST_SIZE);
+
+	fastboot_init(NULL, 0);
+	ut_assertok(env_set("fastboot_raw_partition_" FB_MMC_TEST_PART, NULL));
+	free(buf);
+	free(part);
+	free(expect);
+	free(image);
+
+	return 0;
+}
+DM_TEST(dm_test_fb_mmc_stream, UT_TESTF_SCAN_FDT);
+
+/* Check that broken and oversized images are reported */
+static int dm_test_fb_mmc_stream_fail(struct unit_test_state *uts)
+{
+	char response[FASTBOOT_RESPONSE_LEN];
+	u8 *image, *buf;
+	int len;
+
+	ut_assertnonnull(blk_get_dev("mmc", CONFIG_FASTBOOT_FLASH_MMC_DEV));
+	ut_assertok(env_set("fastboot_raw_partition_" FB_MMC_TEST_PART,
+			    __stringify(FB_MMC_TEST_START) " "
+			    __stringify(FB_MMC_TEST_BLOCKS)));
+	image = malloc(FB_MMC_TEST_SIZE + FB_MMC_TEST_BLKSZ);
+	buf = malloc(FB_MMC_TEST_BUF_SIZE);
+	ut_assertnonnull(image);
+	ut_assertnonnull(buf);
+	fastboot_init(buf, FB_MMC_TEST_BUF_SIZE);
+	fb_mmc_test_image(image, 1);
+
+	/* The download ends part-way through the header of the fill chunk */
+	len = sizeof(sparse_header_t) + sizeof(chunk_header_t) +
+		2 * FB_MMC_TEST_BLKSZ + 5;
+	ut_assertok(fb_mmc_test_stream(uts, image, len, response));
+	ut_asserteq_str("FAILsparse image write failure", response);
+
+	/* ...or part-way through the fill value */
+	len += sizeof(chunk_header_t) - 5 + 2;
+	ut_assertok(fb_mmc_test_stream(uts, image, len, response));
+	ut_asserteq_str("FAILsparse image write failure", response);
+
+	/* The skipped blocks take the image past the end of the partition */
+	len = fb_mmc_test_image(image, 4);
+	fastboot_mmc_flash_write(FB_MMC_TEST_PART, image, len, response);
+	ut_asserteq_str("FAILRequest would exceed partition size!", response);
+	ut_assertok(fb_mmc_test_stream(uts, image, len, response));
+	ut_asserteq_str("FAILRequest would exceed partition size!", response);
+
+	/* A raw image which does not fit is refused from its first bytes */
+	memset(image, '\0', FB_MMC_TEST_SIZE + FB_MMC_TEST_BLKSZ);
+	ut_assertok(fb_mmc_test_stream(uts, image, FB_MMC_TEST_SIZE + 1,
+				       response));
+	ut_asserteq_str("FAILtoo large for partition", response);
+
+	fastboot_init(NULL, 0);
+	ut_assertok(env_set("fastboot_raw_partition_" FB_MMC_TEST_PART, NULL));
+	free(buf);
+	free(image);
+
+	return 0;
+}
+DM_TEST(dm_test_fb_mmc_stream_fail, UT_TESTF_SCAN_FDT);
@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for NFS downloads, against a stand-in server in the sandbox Ethernet
+ * driver
+ */
+
+#include <common.h>
+#include <command.h>
+#include <dm.h>
+#include <env.h>
+#include <mapmem.h>
+#include <net.h>
+#include <asm/eth.h>
+#include <asm/test.h>
+#include <dm/test.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include "../../net/nfs.h"
+
+#define NFS_TEST_MOUNT_PORT	635
+#define NFS_TEST_NFS_PORT	2049
+
+/* Words in an NFSv2 fattr structure */
+#define NFS_TEST_FATTR_WORDS	17
+
+/**
+ * struct nfs_test_state - State of the stand-in NFS server
+ *
+ * @uts: Test state, used by the ut_assert macros
+ * @lookup_id: xid of the LOOKUP call
+ * @first_reads: Number of READ calls sent before any READ reply was seen
+ * @reads: Total number of READ calls
+ */
+struct nfs_test_state {
+	struct unit_test_state *uts;
+	u32 lookup_id;
+	int first_reads;
+	int reads;
+};
+
+/*
+ * Queue a reply to the RPC call in @packet. It goes just after the packet
+ * being processed, ahead of any queued earlier, so that the replies to a
+ * window of READ calls arrive in reverse order.
+ */
+static void sb_nfs_reply(struct udevice *dev, void *packet, const u32 *data,
+			 int words, const u8 *buf, int buflen)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	u32 *call = (void *)ip + IP_UDP_HDR_SIZE;
+	u32 *reply;
+
+	reply = sandbox_eth_queue_udp(dev, priv->recv_packets ? 1 : 0,
+				      ntohs(ip->udp_dst), ntohs(ip->udp_src),
+				      (6 + words) * sizeof(u32) +
+				      ALIGN(buflen, 4));
+	if (!reply)
+		return;
+	reply[0] = call[0];
+	reply[1] = htonl(MSG_REPLY);
+	memset(&reply[2], '\0', 4 * sizeof(u32));
+	memcpy(&reply[6], data, words * sizeof(u32));
+	memcpy(&reply[6 + words], buf, buflen);
+}
+
+/* Answer the portmap, mount and NFSv2 calls made by the NFS client */
+static int sb_nfs_handler(struct udevice *dev, void *packet,
+			  unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct nfs_test_state *state = priv->priv;
+	struct unit_test_state *uts = state->uts;
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct rpc_t *rpc = (void *)ip + IP_UDP_HDR_SIZE;
+	u8 buf[NFS_READ_SIZE];
+	u32 data[1 + NFS_FHSIZE / 4 + NFS_TEST_FATTR_WORDS];
+	int offset, count, i;
+	u32 *args, *cur;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return 0;
+
+	ut_asserteq(MSG_CALL, ntohl(rpc->u.call.type));
+	memset(data, '\0', sizeof(data));
+	/* Skip the AUTH_UNIX credential and AUTH_NONE verifier */
+	args = rpc->u.call.data + 9;
+
+	switch (ntohl(rpc->u.call.prog)) {
+	case PROG_PORTMAP:
+		if (ntohl(rpc->u.call.data[4]) == PROG_MOUNT)
+			data[0] = htonl(NFS_TEST_MOUNT_PORT);
+		else
+			data[0] = htonl(NFS_TEST_NFS_PORT);
+		sb_nfs_reply(dev, packet, data, 1, NULL, 0);
+		break;
+	case PROG_MOUNT:
+		/* Status and then a zero file handle, for MOUNT and UMOUNTALL */
+		sb_nfs_reply(dev, packet, data, 1 + NFS_FHSIZE / 4, NULL, 0);
+		break;
+	case PROG_NFS:
+		ut_asserteq(2, ntohl(rpc->u.call.vers));
+		if (ntohl(rpc->u.call.proc) == NFS_LOOKUP) {
+			state->lookup_id = rpc->u.call.id;
+			sb_nfs_reply(dev, packet, data,
+				     1 + NFS_FHSIZE / 4 + NFS_TEST_FATTR_WORDS,
+				     NULL, 0);
+			break;
+		}
+		ut_asserteq(NFS_READ, ntohl(rpc->u.call.proc));
+		cur = (void *)priv->recv_packet_buffer[0] + ETHER_HDR_SIZE +
+			IP_UDP_HDR_SIZE;
+		if (priv->recv_packets && *cur == state->lookup_id)
+			state->first_reads++;
+		state->reads++;
+
+		offset = ntohl(args[NFS_FHSIZE / 4]);
+		count = ntohl(args[NFS_FHSIZE / 4 + 1]);
+		ut_assert(count <= NFS_READ_SIZE);
+		count = max(0, min(count, SANDBOX_NET_TEST_SIZE - offset));
+		for (i = 0; i < count; i++)
+			buf[i] = sandbox_test_byte(offset + i);
+		data[1 + NFS_TEST_FATTR_WORDS] = htonl(count);
+		sb_nfs_reply(dev, packet, data, 2 + NFS_TEST_FATTR_WORDS, buf,
+			     count);
+		break;
+	default:
+		ut_assertf(false, "Unexpected RPC program %x\n",
+			   ntohl(rpc->u.call.prog));
+	}
+
+	return 0;
+}
+
+/* Check that a file is read with a window of READ calls, out of order */
+static int dm_test_nfs_read(struct unit_test_state *uts)
+{
+	struct nfs_test_state state = { .uts = uts };
+	int blocks = DIV_ROUND_UP(SANDBOX_NET_TEST_SIZE, NFS_READ_SIZE);
+	char cmd[50];
+	u8 *ptr;
+	int i;
+
+	sandbox_eth_set_tx_handler(0, sb_nfs_handler);
+	sandbox_eth_set_priv(0, &state);
+	env_set("ethact", "eth@10002000");
+	snprintf(cmd, sizeof(cmd), "nfs %x 1.1.2.2:/export/nfs-test",
+		 SANDBOX_NET_TEST_ADDR);
+	ut_assertok(run_command(cmd, 0));
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	ut_asserteq(SANDBOX_NET_TEST_SIZE, env_get_hex("filesize", 0));
+	ptr = map_sysmem(SANDBOX_NET_TEST_ADDR, SANDBOX_NET_TEST_SIZE);
+	for (i = 0; i < SANDBOX_NET_TEST_SIZE; i++)
+		ut_asserteq(sandbox_test_byte(i), ptr[i]);
+	unmap_sysmem(ptr);
+
+	/* The short final block is followed by one which reads nothing */
+	ut_asserteq(min(blocks, CONFIG_NFS_READ_WINDOW), state.first_reads);
+	ut_assert(state.reads >= blocks + 1);
+
+	return 0;
+}
+DM_TEST(dm_test_nfs_read, UT_TESTF_SCAN_FDT);
@@ -2,12 +2,17 @@
 
 #include <common.h>
 #include <dm.h>
+#include <fdtdec.h>
 #include <log.h>
+#include <malloc.h>
 #include <dm/of_extra.h>
 #include <dm/test.h>
+#include <linux/libfdt.h>
 #include <test/test.h>
 #include <test/ut.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static int dm_test_ofnode_compatible(struct unit_test_state *uts)
 {
 	ofnode root_node = ofnode_path("/");
@@ -249,3 +254,73 @@ static int dm_test_ofnode_get_child_count(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_ofnode_get_child_count,
 	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(OF_FDT_INDEX)
+/* Check that the flat-tree index gives the same answers as libfdt */
+static int dm_test_ofnode_fdt_index(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+	int node, prop, depth, len, ilen, size;
+	const void *val;
+	char path[256];
+	void *copy;
+	u32 phandle;
+
+	for (node = 0, depth = 0; node >= 0 && depth >= 0;
+	     node = fdt_next_node(blob, node, &depth)) {
+		ut_asserteq(fdt_parent_offset(blob, node),
+			    fdtdec_index_parent_offset(blob, node));
+		ut_assertok(fdt_get_path(blob, node, path, sizeof(path)));
+		ut_asserteq(node, fdtdec_index_path_offset(blob, path));
+		phandle = fdt_get_phandle(blob, node);
+		if (phandle) {
+			ut_asserteq(fdt_node_offset_by_phandle(blob, phandle),
+				    fdtdec_index_node_offset_by_phandle(blob,
+									phandle));
+		}
+
+		fdt_for_each_property_offset(prop, blob, node) {
+			const char *name;
+
+			fdt_getprop_by_offset(blob, prop, &name, NULL);
+			val = fdt_getprop(blob, node, name, &len);
+			ut_asserteq_ptr(val, fdtdec_index_getprop(blob, node,
+								  name, &ilen));
+			ut_asserteq(len, ilen);
+		}
+	}
+
+	/* Missing things and unit addresses */
+	ut_assertnull(fdtdec_index_getprop(blob, 0, "no-such-prop", &len));
+	ut_asserteq(-FDT_ERR_NOTFOUND, len);
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdtdec_index_path_offset(blob, "/no-such-node"));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdtdec_index_node_offset_by_phandle(blob, 0xfffff));
+	ut_asserteq(fdt_path_offset(blob, "/spi"),
+		    fdtdec_index_path_offset(blob, "/spi"));
+	ut_asserteq(0, fdtdec_index_path_offset(blob, "/"));
+
+	/* Changing the tree must not leave a stale index */
+	size = fdt_totalsize(blob) + 1024;
+	copy = malloc(size);
+	ut_assertnonnull(copy);
+	ut_assertok(fdt_open_into(blob, copy, size));
+	gd->fdt_blob = copy;
+	node = fdtdec_index_path_offset(copy, "/a-test");
+	ut_assert(node >= 0);
+	ut_assertnull(fdtdec_index_getprop(copy, node, "new-prop", NULL));
+	ut_assertok(fdt_setprop_u32(copy, node, "new-prop", 123));
+	val = fdtdec_index_getprop(copy, node, "new-prop", &len);
+	ut_assertnonnull(val);
+	ut_asserteq(4, len);
+	ut_asserteq(fdt_path_offset(copy, "/b-test"),
+		    fdtdec_index_path_offset(copy, "/b-test"));
+	gd->fdt_blob = blob;
+	fdtdec_index_reset();
+	free(copy);
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_fdt_index, 0);
+#endif
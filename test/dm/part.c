@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the partition table cache
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <malloc.h>
+#include <os.h>
+#include <part.h>
+#include <sandboxblockdev.h>
+#include <dm/test.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define DISK_NAME	"part_cache.img"
+#define DISK_BLOCKS	2048
+#define DISK_GUID	"375a56f7-d6c9-4e81-b5f0-09d41ca89efe"
+
+static struct disk_partition test_parts[] = {
+	{ .start = 64, .size = 512, .name = "boot",
+	  .uuid = "24cfbe8a-9fac-4f55-b3ff-9b9c4a54dbf2" },
+	{ .start = 1024, .size = 512, .name = "rootfs",
+	  .uuid = "c7b97546-3e5b-4b66-8bf5-2a6a2e5c0e0a" },
+};
+
+/* Write a GPT with the given name for the first partition */
+static int write_table(struct unit_test_state *uts, struct blk_desc *desc,
+		       const char *name)
+{
+	strcpy((char *)test_parts[0].name, name);
+	ut_assertok(gpt_restore(desc, DISK_GUID, test_parts,
+				ARRAY_SIZE(test_parts)));
+
+	return 0;
+}
+
+/* Check that lookups use the cache and that writes drop it when needed */
+static int dm_test_part_cache(struct unit_test_state *uts)
+{
+	struct disk_partition info;
+	struct blk_desc *desc;
+	char *buf, *disk;
+	int len;
+
+	disk = calloc(DISK_BLOCKS, 512);
+	ut_assertnonnull(disk);
+	ut_assertok(os_write_file(DISK_NAME, disk, DISK_BLOCKS * 512));
+	free(disk);
+	ut_assertok(host_dev_bind(0, DISK_NAME));
+	ut_asserteq(0, blk_get_device_by_str("host", "0", &desc));
+	ut_assertok(write_table(uts, desc, "boot"));
+	part_init(desc);
+
+	ut_assertok(part_get_info(desc, 1, &info));
+	ut_asserteq_str("boot", (char *)info.name);
+	ut_asserteq(64, info.start);
+	ut_assertok(part_get_info(desc, 2, &info));
+	ut_asserteq_str("rootfs", (char *)info.name);
+	ut_asserteq(-1, part_get_info(desc, 3, &info));
+
+	/*
+	 * Change the table behind the block layer's back: the cached one is
+	 * still used, even after looking the device up again
+	 */
+	ut_assertok(os_read_file(DISK_NAME, (void **)&buf, &len));
+	ut_asserteq(DISK_BLOCKS * 512, len);
+	ut_assertok(host_dev_bind(1, DISK_NAME));
+	ut_assertok(blk_get_device_by_str("host", "1", &desc));
+	ut_assertok(write_table(uts, desc, "other"));
+	ut_assertok(host_dev_bind(1, NULL));
+	ut_assertok(blk_get_device_by_str("host", "0", &desc));
+	ut_assertok(part_get_info(desc, 1, &info));
+	ut_asserteq_str("boot", (char *)info.name);
+
+	/* A write inside a partition keeps the cache */
+	ut_asserteq(1, blk_dwrite(desc, 100, 1, buf));
+	ut_assertok(part_get_info(desc, 1, &info));
+	ut_asserteq_str("boot", (char *)info.name);
+
+	/* A write to the table drops it */
+	ut_asserteq(1, blk_dwrite(desc, 0, 1, buf));
+	ut_assertok(part_get_info(desc, 1, &info));
+	ut_asserteq_str("other", (char *)info.name);
+
+	/* So does rewriting the table through the block layer */
+	ut_assertok(write_table(uts, desc, "new"));
+	ut_assertok(part_get_info(desc, 1, &info));
+	ut_asserteq_str("new", (char *)info.name);
+
+	os_free(buf);
+	ut_assertok(host_dev_bind(0, NULL));
+	ut_assertok(os_unlink(DISK_NAME));
+
+	return 0;
+}
+DM_TEST(dm_test_part_cache, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
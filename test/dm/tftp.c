@@ -0,0 +1,281 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the TFTP server, against a stand-in client behind the sandbox
+ * Ethernet driver
+ */
+
+#include <common.h>
+#include <command.h>
+#include <dm.h>
+#include <env.h>
+#include <malloc.h>
+#include <net.h>
+#include <os.h>
+#include <sandboxblockdev.h>
+#include <asm/eth.h>
+#include <asm/test.h>
+#include <asm/unaligned.h>
+#include <dm/test.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <linux/stringify.h>
+
+#define TFTP_TEST_DISK		"tftp_serve.img"
+#define TFTP_TEST_BLOCKS	64
+/* Range of 512-byte blocks requested by the client */
+#define TFTP_TEST_START		0x10
+#define TFTP_TEST_COUNT		0x20
+#define TFTP_TEST_SIZE		(TFTP_TEST_COUNT * 512)
+#define TFTP_TEST_BLKSIZE	1000
+#define TFTP_TEST_WINDOW	4
+#define TFTP_TEST_PORT		4567
+/* Block which is lost the first time it is sent */
+#define TFTP_TEST_DROP		6
+
+#define TFTP_RRQ	1
+#define TFTP_DATA	3
+#define TFTP_ACK	4
+#define TFTP_OACK	6
+
+/**
+ * struct tftp_test_state - State of the stand-in TFTP client
+ *
+ * @uts: Test state, used by the ut_assert macros
+ * @server_port: Port from which the server answered
+ * @next: Next block expected
+ * @next_ack: Block to acknowledge next, at the end of a window
+ * @acked: Last block acknowledged
+ * @nacked: true once a missing block has been reported
+ * @dropped: true once block TFTP_TEST_DROP has been lost
+ * @max_in_flight: Largest number of blocks seen beyond @acked
+ * @done: true once the final block has been received
+ * @buf: Data received
+ */
+struct tftp_test_state {
+	struct unit_test_state *uts;
+	int server_port;
+	int next;
+	int next_ack;
+	int acked;
+	bool nacked;
+	bool dropped;
+	int max_in_flight;
+	bool done;
+	u8 buf[TFTP_TEST_SIZE];
+};
+
+/* Queue a packet from the client */
+static int sb_tftp_send(struct udevice *dev, int dport, const void *data,
+			int len)
+{
+	void *pkt;
+
+	pkt = sandbox_eth_queue_udp(dev, -1, TFTP_TEST_PORT, dport, len);
+	if (!pkt)
+		return -EOVERFLOW;
+	memcpy(pkt, data, len);
+
+	return 0;
+}
+
+static int sb_tftp_ack(struct udevice *dev, struct tftp_test_state *state,
+		       int block)
+{
+	u8 buf[4];
+
+	put_unaligned_be16(TFTP_ACK, buf);
+	put_unaligned_be16(block, buf + 2);
+	state->acked = block;
+
+	return sb_tftp_send(dev, state->server_port, buf, sizeof(buf));
+}
+
+/* Find the value of an option in an OACK */
+static const char *tftp_test_opt(const u8 *opts, int len, const char *name)
+{
+	const char *opt = (const char *)opts;
+	const char *end = opt + len;
+
+	while (opt < end) {
+		const char *val = opt + strlen(opt) + 1;
+
+		if (!strcmp(opt, name))
+			return val;
+		opt = val + strlen(val) + 1;
+	}
+
+	return NULL;
+}
+
+/* Act on a packet from the server, as U-Boot's own client would */
+static int sb_tftp_reply(struct udevice *dev, struct tftp_test_state *state,
+			 int sport, const u8 *pkt, int len)
+{
+	struct unit_test_state *uts = state->uts;
+	int block, offset;
+
+	ut_assert(len >= 4);
+	block = get_unaligned_be16(pkt + 2);
+	switch (get_unaligned_be16(pkt)) {
+	case TFTP_OACK:
+		ut_asserteq_str("1000", tftp_test_opt(pkt + 2, len - 2,
+						      "blksize"));
+		ut_asserteq_str("4", tftp_test_opt(pkt + 2, len - 2,
+						   "windowsize"));
+		ut_asserteq_str("16384", tftp_test_opt(pkt + 2, len - 2,
+						       "tsize"));
+		state->server_port = sport;
+		return sb_tftp_ack(dev, state, 0);
+	case TFTP_DATA:
+		break;
+	default:
+		ut_assertf(false, "Unexpected opcode %d\n",
+			   get_unaligned_be16(pkt));
+	}
+
+	ut_asserteq(state->server_port, sport);
+	ut_assert(!state->done);
+	len -= 4;
+	state->max_in_flight = max(state->max_in_flight, block - state->acked);
+	if (block == TFTP_TEST_DROP && !state->dropped) {
+		state->dropped = true;
+		return 0;
+	}
+
+	/* Report a missing block once, with the last one received */
+	if (block != state->next) {
+		if (state->nacked)
+			return 0;
+		state->nacked = true;
+		state->next_ack = state->next - 1 + TFTP_TEST_WINDOW;
+		return sb_tftp_ack(dev, state, state->next - 1);
+	}
+	state->nacked = false;
+	state->next++;
+
+	offset = (block - 1) * TFTP_TEST_BLKSIZE;
+	ut_assert(offset + len <= TFTP_TEST_SIZE);
+	memcpy(state->buf + offset, pkt + 4, len);
+	if (len < TFTP_TEST_BLKSIZE) {
+		state->done = true;
+		return sb_tftp_ack(dev, state, block);
+	}
+	if (block == state->next_ack) {
+		state->next_ack += TFTP_TEST_WINDOW;
+		return sb_tftp_ack(dev, state, block);
+	}
+
+	return 0;
+}
+
+static int sb_tftp_handler(struct udevice *dev, void *packet,
+			   unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct tftp_test_state *state = priv->priv;
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return 0;
+
+	/* Stop U-Boot waiting for more packets if anything goes wrong */
+	if (ntohs(ip->udp_dst) != TFTP_TEST_PORT ||
+	    sb_tftp_reply(dev, state, ntohs(ip->udp_src),
+			  (void *)ip + IP_UDP_HDR_SIZE,
+			  ntohs(ip->udp_len) - UDP_HDR_SIZE))
+		net_set_state(NETLOOP_FAIL);
+
+	return 0;
+}
+
+static int tftp_test_add(char *buf, int len, const char *str)
+{
+	strcpy(buf + len, str);
+
+	return len + strlen(str) + 1;
+}
+
+/* Start with a read request for a range of blocks, asking for a window */
+static int sb_tftp_start(struct udevice *dev)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	char rrq[80], name[20];
+	int len = 2;
+
+	priv->fake_host_ipaddr = string_to_ip("1.2.3.5");
+
+	put_unaligned_be16(TFTP_RRQ, rrq);
+	snprintf(name, sizeof(name), "%x+%x", TFTP_TEST_START,
+		 TFTP_TEST_COUNT);
+	len = tftp_test_add(rrq, len, name);
+	len = tftp_test_add(rrq, len, "octet");
+	len = tftp_test_add(rrq, len, "blksize");
+	len = tftp_test_add(rrq, len, __stringify(TFTP_TEST_BLKSIZE));
+	len = tftp_test_add(rrq, len, "windowsize");
+	len = tftp_test_add(rrq, len, __stringify(TFTP_TEST_WINDOW));
+	len = tftp_test_add(rrq, len, "tsize");
+	len = tftp_test_add(rrq, len, "0");
+
+	return sb_tftp_send(dev, 69, rrq, len);
+}
+
+/* The asserts include a return on fail; cleanup in the caller */
+static int _dm_test_tftp_serve(struct unit_test_state *uts,
+			       struct tftp_test_state *state)
+{
+	u8 *disk;
+	int i, ret;
+
+	disk = malloc(TFTP_TEST_BLOCKS * 512);
+	ut_assertnonnull(disk);
+	for (i = 0; i < TFTP_TEST_BLOCKS * 512; i++)
+		disk[i] = sandbox_test_byte(i);
+	ret = os_write_file(TFTP_TEST_DISK, disk, TFTP_TEST_BLOCKS * 512);
+	free(disk);
+	ut_assertok(ret);
+	ut_assertok(host_dev_bind(0, TFTP_TEST_DISK));
+
+	state->uts = uts;
+	state->next = 1;
+	state->next_ack = TFTP_TEST_WINDOW;
+	sandbox_eth_set_tx_handler(0, sb_tftp_handler);
+	sandbox_eth_set_start_handler(0, sb_tftp_start);
+	sandbox_eth_set_priv(0, state);
+	env_set("ethact", "eth@10002000");
+	ut_assertok(run_command("tftpserve host 0:0 1", 0));
+
+	ut_assert(state->done);
+	ut_assert(state->dropped);
+	ut_asserteq(TFTP_TEST_WINDOW, state->max_in_flight);
+	for (i = 0; i < TFTP_TEST_SIZE; i++)
+		ut_asserteq(sandbox_test_byte(TFTP_TEST_START * 512 + i),
+			    state->buf[i]);
+
+	return 0;
+}
+
+/* Check that a range of blocks is served in windows, recovering from a loss */
+static int dm_test_tftp_serve(struct unit_test_state *uts)
+{
+	struct tftp_test_state *state;
+	int retval;
+
+	state = calloc(1, sizeof(*state));
+	ut_assertnonnull(state);
+
+	retval = _dm_test_tftp_serve(uts, state);
+
+	/* Leave nothing behind for the next test, even on failure */
+	sandbox_eth_set_start_handler(0, NULL);
+	sandbox_eth_set_tx_handler(0, NULL);
+	sandbox_eth_set_priv(0, NULL);
+	host_dev_bind(0, NULL);
+	os_unlink(TFTP_TEST_DISK);
+	free(state);
+
+	return retval;
+}
+DM_TEST(dm_test_tftp_serve, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the binary environment format
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <search.h>
+#include <time.h>
+#include <test/env.h>
+#include <test/ut.h>
+#include <asm/unaligned.h>
+
+#define BUF_SIZE	0x2000
+#define NUM_VARS	200
+#define ITERATIONS	100
+
+static const char test_env[] =
+	"arch=sandbox\0"
+	"baudrate=115200\0"
+	"bootcmd=run distro_bootcmd\0"
+	"bootdelay=2\0"
+	"a=1\0"
+	"ethaddr=00:c0:ff:ee:00:01\0"
+	"\0";
+
+/* Check that two tables hold the same variables */
+static int check_same(struct unit_test_state *uts, struct hsearch_data *htab1,
+		      struct hsearch_data *htab2)
+{
+	char *text1 = NULL, *text2 = NULL;
+
+	ut_assert(hexport_r(htab1, '\n', 0, &text1, 0, 0, NULL) > 0);
+	ut_assert(hexport_r(htab2, '\n', 0, &text2, 0, 0, NULL) > 0);
+	ut_asserteq_str(text1, text2);
+	free(text1);
+	free(text2);
+
+	return 0;
+}
+
+/* Check that a table survives export to and import from binary */
+static int env_test_bin_roundtrip(struct unit_test_state *uts)
+{
+	struct hsearch_data htab1, htab2;
+	struct env_entry item, *ep;
+	char *buf;
+	int len;
+
+	memset(&htab1, '\0', sizeof(htab1));
+	memset(&htab2, '\0', sizeof(htab2));
+	buf = malloc(BUF_SIZE);
+	ut_assertnonnull(buf);
+
+	ut_asserteq(1, himport_r(&htab1, test_env, sizeof(test_env), '\0', 0,
+				 0, 0, NULL));
+	len = hexport_bin_r(&htab1, buf, BUF_SIZE);
+	ut_assert(len > sizeof(struct env_bin_hdr));
+	ut_assert(env_is_binary(buf));
+	ut_asserteq(6, get_unaligned_le16(&((struct env_bin_hdr *)buf)->count));
+
+	ut_asserteq(1, himport_bin_r(&htab2, buf, BUF_SIZE, 0));
+	ut_assertok(check_same(uts, &htab1, &htab2));
+
+	/* The stored hashes must lead to the right slots */
+	item.key = "bootdelay";
+	item.data = NULL;
+	ut_assert(hsearch_r(item, ENV_FIND, &ep, &htab2, 0));
+	ut_asserteq_str("2", ep->data);
+	item.key = "a";
+	ut_assert(hsearch_r(item, ENV_FIND, &ep, &htab2, 0));
+	ut_asserteq_str("1", ep->data);
+
+	/* Exporting the same table again gives the same image */
+	ut_asserteq(len, hexport_bin_r(&htab2, buf + BUF_SIZE / 2,
+				       BUF_SIZE / 2));
+	ut_asserteq_mem(buf, buf + BUF_SIZE / 2, len);
+
+	hdestroy_r(&htab1);
+	hdestroy_r(&htab2);
+	free(buf);
+
+	return 0;
+}
+ENV_TEST(env_test_bin_roundtrip, 0);
+
+/* Check that bad binary data and small buffers are rejected */
+static int env_test_bin_bad(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	struct env_bin_entry *be;
+	char buf[0x200];
+	int len;
+
+	memset(&htab, '\0', sizeof(htab));
+	ut_asserteq(1, himport_r(&htab, test_env, sizeof(test_env), '\0', 0,
+				 0, 0, NULL));
+	ut_asserteq(-1, hexport_bin_r(&htab, buf, 0x20));
+	len = hexport_bin_r(&htab, buf, sizeof(buf));
+	ut_assert(len > 0);
+	hdestroy_r(&htab);
+
+	/* Text is not binary */
+	ut_asserteq(0, himport_bin_r(&htab, test_env, sizeof(test_env), 0));
+
+	/* An entry running past the end */
+	be = (struct env_bin_entry *)(buf + sizeof(struct env_bin_hdr));
+	put_unaligned_le32(len, &be->value_len);
+	ut_asserteq(0, himport_bin_r(&htab, buf, sizeof(buf), 0));
+	hdestroy_r(&htab);
+
+	/* A missing terminator */
+	put_unaligned_le32(0, &be->value_len);
+	ut_asserteq(0, himport_bin_r(&htab, buf, sizeof(buf), 0));
+	hdestroy_r(&htab);
+
+	return 0;
+}
+ENV_TEST(env_test_bin_bad, 0);
+
+/* Compare the time taken to import and export each format */
+static int env_test_bin_timing(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	ulong text_imp, bin_imp, text_exp, bin_exp, start;
+	char *text, *bin, *p;
+	int i;
+
+	text = malloc(BUF_SIZE * 2);
+	bin = malloc(BUF_SIZE * 2);
+	ut_assertnonnull(text);
+	ut_assertnonnull(bin);
+	for (i = 0, p = text; i < NUM_VARS; i++)
+		p += sprintf(p, "variable%d=value of variable %d", i, i) + 1;
+	*p++ = '\0';
+
+	memset(&htab, '\0', sizeof(htab));
+	ut_asserteq(1, himport_r(&htab, text, p - text, '\0', 0, 0, 0, NULL));
+	ut_asserteq(NUM_VARS, htab.filled);
+	ut_assert(hexport_bin_r(&htab, bin, BUF_SIZE * 2) > 0);
+
+	start = timer_get_us();
+	for (i = 0; i < ITERATIONS; i++)
+		ut_asserteq(1, himport_r(&htab, text, BUF_SIZE * 2, '\0', 0, 0,
+					 0, NULL));
+	text_imp = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < ITERATIONS; i++)
+		ut_asserteq(1, himport_bin_r(&htab, bin, BUF_SIZE * 2, 0));
+	bin_imp = timer_get_us() - start;
+	ut_asserteq(NUM_VARS, htab.filled);
+
+	start = timer_get_us();
+	for (i = 0; i < ITERATIONS; i++)
+		ut_assert(hexport_r(&htab, '\0', 0, &text, BUF_SIZE * 2, 0,
+				    NULL) > 0);
+	text_exp = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < ITERATIONS; i++)
+		ut_assert(hexport_bin_r(&htab, bin, BUF_SIZE * 2) > 0);
+	bin_exp = timer_get_us() - start;
+
+	printf("%d variables, %d runs: import text %lu us, binary %lu us; export text %lu us, binary %lu us\n",
+	       NUM_VARS, ITERATIONS, text_imp, bin_imp, text_exp, bin_exp);
+
+	hdestroy_r(&htab);
+	free(text);
+	free(bin);
+
+	return 0;
+}
+ENV_TEST(env_test_bin_timing, 0);
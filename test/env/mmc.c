@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for saving the environment to MMC
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <dm.h>
+#include <env.h>
+#include <env_internal.h>
+#include <malloc.h>
+#include <part.h>
+#include <asm/test.h>
+#include <test/env.h>
+#include <test/ut.h>
+#include <linux/stringify.h>
+
+#define ENV_TEST_BLKSZ		512
+#define ENV_TEST_START		(CONFIG_ENV_OFFSET / ENV_TEST_BLKSZ)
+#define ENV_TEST_BLOCKS		(CONFIG_ENV_SIZE / ENV_TEST_BLKSZ)
+
+/* Count the blocks which differ between two images of the environment */
+static uint env_test_changed(const u8 *old, const u8 *new)
+{
+	uint i, changed = 0;
+
+	for (i = 0; i < ENV_TEST_BLOCKS; i++) {
+		if (memcmp(old + i * ENV_TEST_BLKSZ, new + i * ENV_TEST_BLKSZ,
+			   ENV_TEST_BLKSZ))
+			changed++;
+	}
+
+	return changed;
+}
+
+/* Check that saving writes only the blocks which changed */
+static int env_test_mmc_delta(struct unit_test_state *uts)
+{
+	struct env_driver *drv = ll_entry_get(struct env_driver, mmc,
+					      env_driver);
+	struct blk_desc *desc;
+	struct udevice *dev;
+	u8 *old, *new;
+	uint written;
+
+	ut_assertok(uclass_get_device_by_seq(UCLASS_MMC,
+					     CONFIG_SYS_MMC_ENV_DEV, &dev));
+	ut_assert(blk_get_device_by_str("mmc",
+					__stringify(CONFIG_SYS_MMC_ENV_DEV),
+					&desc) >= 0);
+	old = malloc(CONFIG_ENV_SIZE);
+	ut_assertnonnull(old);
+	new = malloc(CONFIG_ENV_SIZE);
+	ut_assertnonnull(new);
+
+	ut_assertok(env_set("env_test_mmc", "1"));
+	ut_assertok(drv->save());
+	ut_asserteq(ENV_TEST_BLOCKS, blk_dread(desc, ENV_TEST_START,
+					       ENV_TEST_BLOCKS, old));
+
+	/* Changing one value should leave most of the blocks alone */
+	ut_assertok(env_set("env_test_mmc", "2"));
+	written = sandbox_mmc_get_blocks_written(dev);
+	ut_assertok(drv->save());
+	written = sandbox_mmc_get_blocks_written(dev) - written;
+	ut_asserteq(ENV_TEST_BLOCKS, blk_dread(desc, ENV_TEST_START,
+					       ENV_TEST_BLOCKS, new));
+	ut_asserteq(env_test_changed(old, new), written);
+	ut_assert(written > 0 && written < ENV_TEST_BLOCKS);
+
+	ut_assertok(env_set("env_test_mmc", NULL));
+	ut_assertok(drv->load());
+	ut_asserteq_str("2", env_get("env_test_mmc"));
+
+	/*
+	 * Overwrite the last block, as 'mmc write' might. Saving must notice,
+	 * else the CRC no longer matches what is on the card.
+	 */
+	memset(new, 0xa5, ENV_TEST_BLKSZ);
+	ut_asserteq(1, blk_dwrite(desc, ENV_TEST_START + ENV_TEST_BLOCKS - 1, 1,
+				  new));
+	ut_assertok(env_set("env_test_mmc", "3"));
+	ut_assertok(drv->save());
+	ut_assertok(env_set("env_test_mmc", NULL));
+	ut_assertok(drv->load());
+	ut_asserteq_str("3", env_get("env_test_mmc"));
+
+	ut_assertok(env_set("env_test_mmc", NULL));
+	free(new);
+	free(old);
+
+	return 0;
+}
+ENV_TEST(env_test_mmc_delta, 0);
@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the arena allocator
+ */
+
+#include <common.h>
+#include <env.h>
+#include <env_internal.h>
+#include <malloc.h>
+#include <malloc_arena.h>
+#include <search.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Check allocation, alignment and release via marks */
+static int lib_test_arena_push_pop(struct unit_test_state *uts)
+{
+	struct arena_stats before, after;
+	ulong mark, inner;
+	char *a, *b, *c;
+
+	arena_get_stats(&before);
+	mark = arena_push();
+
+	a = arena_alloc(10);
+	ut_assertnonnull(a);
+	ut_assert(arena_contains(a));
+	ut_asserteq(0, (ulong)a % ARCH_DMA_MINALIGN);
+
+	inner = arena_push();
+	b = arena_calloc(4, 8);
+	ut_assertnonnull(b);
+	ut_assert(arena_contains(b));
+	ut_assert(b > a);
+	ut_asserteq(0, b[0] | b[31]);
+	arena_pop(inner);
+
+	/* Memory released by the inner pop is handed out again */
+	c = arena_alloc(32);
+	ut_asserteq_ptr(b, c);
+
+	arena_get_stats(&after);
+	ut_asserteq(before.allocs + 3, after.allocs);
+	ut_asserteq(before.fallbacks, after.fallbacks);
+
+	arena_pop(mark);
+	arena_get_stats(&after);
+	ut_asserteq(before.used, after.used);
+
+	return 0;
+}
+LIB_TEST(lib_test_arena_push_pop, 0);
+
+/* Check that freeing the most recent allocation rewinds the arena */
+static int lib_test_arena_free(struct unit_test_state *uts)
+{
+	ulong mark;
+	char *a, *b, *c;
+
+	mark = arena_push();
+	a = arena_alloc(64);
+	b = arena_alloc(64);
+	ut_assertnonnull(a);
+	ut_assertnonnull(b);
+
+	arena_free(b);
+	c = arena_alloc(64);
+	ut_asserteq_ptr(b, c);
+
+	/* Freeing an older buffer does not move the arena pointer */
+	arena_free(a);
+	c = arena_alloc(64);
+	ut_assert(c > b);
+
+	arena_free(NULL);
+	arena_pop(mark);
+
+	return 0;
+}
+LIB_TEST(lib_test_arena_free, 0);
+
+/* Check that requests which do not fit fall back to malloc() */
+static int lib_test_arena_fallback(struct unit_test_state *uts)
+{
+	struct arena_stats before, after;
+	ulong mark;
+	char *ptr;
+
+	arena_get_stats(&before);
+	mark = arena_push();
+
+	ptr = arena_alloc(before.size + 1);
+	ut_assertnonnull(ptr);
+	ut_assert(!arena_contains(ptr));
+	ut_asserteq(0, (ulong)ptr % ARCH_DMA_MINALIGN);
+	arena_free(ptr);
+
+	arena_get_stats(&after);
+	ut_asserteq(before.fallbacks + 1, after.fallbacks);
+	ut_asserteq(before.used, after.used);
+	arena_pop(mark);
+
+	return 0;
+}
+LIB_TEST(lib_test_arena_fallback, 0);
+
+/* Check that buffers allocated outside any mark come from malloc() */
+static int lib_test_arena_no_mark(struct unit_test_state *uts)
+{
+	struct arena_stats before, after;
+	char *ptr;
+
+	arena_get_stats(&before);
+	ptr = arena_alloc(64);
+	ut_assertnonnull(ptr);
+	ut_assert(!arena_contains(ptr));
+	arena_free(ptr);
+
+	arena_get_stats(&after);
+	ut_asserteq(before.allocs, after.allocs);
+	ut_asserteq(before.used, after.used);
+
+	return 0;
+}
+LIB_TEST(lib_test_arena_no_mark, 0);
+
+/* Check that importing the environment copies it into the arena */
+static int lib_test_arena_env_import(struct unit_test_state *uts)
+{
+	struct arena_stats before, after;
+	env_t *env;
+
+	env = calloc(1, sizeof(*env));
+	ut_assertnonnull(env);
+	strcpy((char *)env->data, "arena_test=1");
+
+	arena_get_stats(&before);
+	ut_assertok(env_import((char *)env, 0, H_NOCLEAR));
+	arena_get_stats(&after);
+	ut_asserteq(before.allocs + 1, after.allocs);
+	ut_asserteq(before.fallbacks, after.fallbacks);
+	ut_asserteq(before.used, after.used);
+	ut_asserteq_str("1", env_get("arena_test"));
+
+	ut_assertok(env_set("arena_test", NULL));
+	free(env);
+
+	return 0;
+}
+LIB_TEST(lib_test_arena_env_import, 0);
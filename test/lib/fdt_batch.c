@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for batched device-tree edits
+ */
+
+#include <common.h>
+#include <fdt_batch.h>
+#include <fdt_support.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <linux/libfdt.h>
+
+enum {
+	TREE_SIZE	= 0x1000,
+};
+
+static int make_tree(struct unit_test_state *uts, void *fdt, int size)
+{
+	int node;
+
+	ut_assertok(fdt_create_empty_tree(fdt, size));
+	ut_assertok(fdt_setprop_u32(fdt, 0, "#address-cells", 1));
+	ut_assertok(fdt_setprop_u32(fdt, 0, "#size-cells", 1));
+	node = fdt_add_subnode(fdt, 0, "chosen");
+	ut_assert(node > 0);
+	ut_assertok(fdt_setprop_string(fdt, node, "bootargs", "quiet"));
+	node = fdt_add_subnode(fdt, 0, "soc");
+	ut_assert(node > 0);
+	node = fdt_add_subnode(fdt, node, "serial");
+	ut_assert(node > 0);
+	ut_assertok(fdt_setprop_string(fdt, node, "compatible", "ns16550"));
+	ut_assertok(fdt_setprop_string(fdt, node, "status", "disabled"));
+
+	return 0;
+}
+
+/* Make a set of edits, through a batch if one is open */
+static int do_fixups(struct unit_test_state *uts, void *fdt)
+{
+	int chosen, mem, node;
+
+	ut_assertok(fdt_batch_setprop_string(fdt, 0, "serial-number", "1234"));
+	chosen = fdt_batch_find_or_add_subnode(fdt, 0, "chosen");
+	ut_assert(chosen > 0);
+	ut_assertok(fdt_batch_setprop_string(fdt, chosen, "bootargs",
+					     "console=ttyS0,115200 quiet"));
+	ut_assertok(fdt_batch_setprop_string(fdt, chosen, "linux,stdout-path",
+					     "/soc/serial"));
+	mem = fdt_batch_find_or_add_subnode(fdt, 0, "memory");
+	ut_assert(mem > 0);
+	ut_asserteq(mem, fdt_batch_find_or_add_subnode(fdt, 0, "memory"));
+	ut_assertok(fdt_batch_setprop_string(fdt, mem, "device_type",
+					     "memory"));
+	node = fdt_batch_find_or_add_subnode(fdt, mem, "bank");
+	ut_assert(node > 0);
+	ut_assertok(fdt_batch_setprop_u64(fdt, node, "reg", 0x40000000));
+	ut_assertok(fdt_batch_setprop_u32(fdt, mem, "reg", 0x40000000));
+
+	/* Setting a property again should just replace the value */
+	chosen = fdt_batch_find_or_add_subnode(fdt, 0, "chosen");
+	ut_assertok(fdt_batch_setprop_string(fdt, chosen, "bootargs", "rw"));
+	node = fdt_path_offset(fdt, "/soc/serial");
+	ut_assert(node > 0);
+	ut_assertok(fdt_batch_setprop_string(fdt, node, "status", "okay"));
+	ut_assertok(fdt_batch_setprop(fdt, node, "u-boot,empty", NULL, 0));
+
+	return 0;
+}
+
+/* Check that two trees have the same nodes and properties in the same order */
+static int check_same(struct unit_test_state *uts, const void *fdt1,
+		      const void *fdt2)
+{
+	int offset, next1, next2;
+	u32 tag1, tag2;
+
+	ut_asserteq(fdt_size_dt_struct(fdt1), fdt_size_dt_struct(fdt2));
+	ut_asserteq(fdt_size_dt_strings(fdt1), fdt_size_dt_strings(fdt2));
+	ut_asserteq_mem(fdt1 + fdt_off_dt_strings(fdt1),
+			fdt2 + fdt_off_dt_strings(fdt2),
+			fdt_size_dt_strings(fdt1));
+
+	offset = 0;
+	do {
+		tag1 = fdt_next_tag(fdt1, offset, &next1);
+		tag2 = fdt_next_tag(fdt2, offset, &next2);
+		ut_asserteq(tag1, tag2);
+		ut_asserteq(next1, next2);
+		if (tag1 == FDT_BEGIN_NODE) {
+			ut_asserteq_str(fdt_get_name(fdt1, offset, NULL),
+					fdt_get_name(fdt2, offset, NULL));
+		} else if (tag1 == FDT_PROP) {
+			const char *name1, *name2;
+			const void *val1, *val2;
+			int len1, len2;
+
+			val1 = fdt_getprop_by_offset(fdt1, offset, &name1,
+						     &len1);
+			val2 = fdt_getprop_by_offset(fdt2, offset, &name2,
+						     &len2);
+			ut_asserteq_str(name1, name2);
+			ut_asserteq(len1, len2);
+			ut_asserteq_mem(val1, val2, len1);
+		}
+		offset = next1;
+	} while (tag1 != FDT_END);
+
+	return 0;
+}
+
+/* Check that a batch gives the same tree as editing it directly */
+static int lib_test_fdt_batch_same(struct unit_test_state *uts)
+{
+	char direct[TREE_SIZE], batched[TREE_SIZE];
+	const fdt64_t *reg;
+	int node;
+
+	ut_assertok(make_tree(uts, direct, sizeof(direct)));
+	ut_assertok(make_tree(uts, batched, sizeof(batched)));
+	ut_assertok(do_fixups(uts, direct));
+
+	ut_assertok(fdt_batch_begin(batched));
+	ut_assertok(do_fixups(uts, batched));
+
+	/* Nothing changes until the batch ends */
+	node = fdt_path_offset(batched, "/chosen");
+	ut_asserteq_str("quiet", fdt_getprop(batched, node, "bootargs", NULL));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdt_path_offset(batched, "/memory"));
+	ut_assertok(fdt_batch_end(batched));
+
+	ut_assertok(fdt_check_header(batched));
+	ut_assertok(check_same(uts, direct, batched));
+	node = fdt_path_offset(batched, "/memory/bank");
+	ut_assert(node > 0);
+	reg = fdt_getprop(batched, node, "reg", NULL);
+	ut_assertnonnull(reg);
+	ut_asserteq_64(0x40000000, fdt64_to_cpu(*reg));
+
+	return 0;
+}
+LIB_TEST(lib_test_fdt_batch_same, 0);
+
+/* Check that a tree is left alone if the edits do not fit */
+static int lib_test_fdt_batch_nospace(struct unit_test_state *uts)
+{
+	char fdt[TREE_SIZE], before[TREE_SIZE];
+	int size;
+
+	ut_assertok(make_tree(uts, fdt, sizeof(fdt)));
+	ut_assertok(fdt_pack(fdt));
+	size = fdt_totalsize(fdt);
+	fdt_set_totalsize(fdt, size + 0x10);
+	memcpy(before, fdt, size + 0x10);
+
+	ut_assertok(fdt_batch_begin(fdt));
+	ut_assertok(do_fixups(uts, fdt));
+	ut_asserteq(-FDT_ERR_NOSPACE, fdt_batch_end(fdt));
+	ut_asserteq_mem(before, fdt, size + 0x10);
+
+	/* The batch is closed, so edits go straight to the tree again */
+	ut_asserteq(-FDT_ERR_BADSTATE, fdt_batch_end(fdt));
+	ut_assertok(fdt_batch_setprop_u32(fdt, 0, "#size-cells", 2));
+	ut_asserteq(2, fdt_getprop_u32_default_node(fdt, 0, 0, "#size-cells",
+						    0));
+
+	return 0;
+}
+LIB_TEST(lib_test_fdt_batch_nospace, 0);
+
+/* Check that editing the tree behind the batch's back is caught */
+static int lib_test_fdt_batch_badstate(struct unit_test_state *uts)
+{
+	char fdt[TREE_SIZE], other[TREE_SIZE];
+
+	ut_assertok(make_tree(uts, fdt, sizeof(fdt)));
+	ut_assertok(make_tree(uts, other, sizeof(other)));
+
+	ut_assertok(fdt_batch_begin(fdt));
+	ut_asserteq(-FDT_ERR_BADSTATE, fdt_batch_begin(other));
+	ut_assertok(fdt_batch_begin(fdt));
+	ut_assertok(fdt_batch_setprop_u32(fdt, 0, "test", 1));
+	ut_assertok(fdt_batch_end(fdt));
+	ut_assertnull(fdt_getprop(fdt, 0, "test", NULL));
+	ut_asserteq(-FDT_ERR_BADOFFSET, fdt_batch_setprop_u32(fdt, 3, "x", 1));
+
+	ut_assertok(fdt_setprop_u32(fdt, 0, "direct", 1));
+	ut_asserteq(-FDT_ERR_BADSTATE, fdt_batch_end(fdt));
+	ut_assertnull(fdt_getprop(fdt, 0, "test", NULL));
+
+	return 0;
+}
+LIB_TEST(lib_test_fdt_batch_badstate, 0);
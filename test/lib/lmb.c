@@ -5,12 +5,16 @@
 
 #include <common.h>
 #include <dm.h>
+#include <env.h>
 #include <lmb.h>
 #include <log.h>
 #include <malloc.h>
 #include <dm/test.h>
 #include <test/test.h>
 #include <test/ut.h>
+#include <asm/global_data.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 static int check_lmb(struct unit_test_state *uts, struct lmb *lmb,
 		     phys_addr_t ram_base, phys_size_t ram_size,
@@ -659,3 +663,50 @@ static int lib_test_lmb_get_free_size(struct unit_test_state *uts)
 
 DM_TEST(lib_test_lmb_get_free_size,
 	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(LMB_AUTO)
+/* Check that 'auto' regions do not overlap and are reserved once loaded */
+static int lib_test_lmb_auto(struct unit_test_state *uts)
+{
+	ulong addr_a, addr_b;
+	struct lmb lmb;
+
+	ut_assert(lmb_auto_requested("auto"));
+	ut_assert(lmb_auto_requested("auto:ut_a:1000"));
+	ut_assert(!lmb_auto_requested("autoboot"));
+	ut_assert(!lmb_auto_requested("1000"));
+
+	ut_assertok(lmb_auto_alloc("auto:ut_a", 0x3000, &addr_a));
+	ut_asserteq(addr_a, env_get_hex("ut_a", 0));
+	ut_asserteq(0, addr_a & 0xfff);
+
+	/* Not reserved while it is being loaded */
+	lmb_init_and_reserve(&lmb, gd->bd, NULL);
+	ut_assert(!lmb_is_reserved(&lmb, addr_a));
+	lmb_auto_done(addr_a, 0x2000);
+
+	lmb_init_and_reserve(&lmb, gd->bd, NULL);
+	ut_assert(lmb_is_reserved(&lmb, addr_a));
+	ut_assert(lmb_auto_fits(addr_a, 0x2000, 0));
+	ut_assert(!lmb_auto_fits(addr_a, 0x2000, addr_a + 0x1000));
+
+	/* A size hint larger than the image size wins */
+	ut_assertok(lmb_auto_alloc("auto:ut_b:100000", 0x1000, &addr_b));
+	ut_assert(addr_b + 0x100000 <= addr_a || addr_b >= addr_a + 0x2000);
+	lmb_auto_done(addr_b, 0x100000);
+	ut_assert(lmb_auto_fits(addr_b, 0x100000, 0));
+
+	/* A failed load releases the region */
+	ut_assertok(lmb_auto_alloc("auto:ut_b", 0x1000, &addr_b));
+	lmb_auto_done(addr_b, 0);
+	ut_assert(!lmb_auto_fits(addr_b, 0x1000, 0));
+	ut_assertok(lmb_auto_alloc("auto:ut_a", 0x1000, &addr_a));
+	lmb_auto_done(addr_a, 0);
+
+	env_set("ut_a", NULL);
+	env_set("ut_b", NULL);
+
+	return 0;
+}
+DM_TEST(lib_test_lmb_auto, 0);
+#endif
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the heap and LMB usage profiler
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <memprof.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Check that heap use is tracked through malloc() and free() */
+static int lib_test_memprof_heap(struct unit_test_state *uts)
+{
+	struct memprof_export before, during, after;
+	const char *prev;
+	void *ptr;
+
+	memprof_get_export(&before);
+	ut_assert(before.malloc_size);
+
+	prev = memprof_push("test");
+	ptr = malloc(0x10000);
+	ut_assertnonnull(ptr);
+	memprof_get_export(&during);
+	ut_assert(during.malloc_used >= before.malloc_used + 0x10000);
+	ut_assert(during.live_peak >= 0x10000);
+	ut_assert(during.malloc_peak >= during.malloc_used);
+
+	free(ptr);
+	memprof_pop(prev);
+	memprof_get_export(&after);
+	ut_asserteq(before.malloc_used, after.malloc_used);
+
+	return 0;
+}
+LIB_TEST(lib_test_memprof_heap, 0);
+
+/* Check that a free is charged to the subsystem which made the allocation */
+static int lib_test_memprof_owner(struct unit_test_state *uts)
+{
+	const char *prev;
+	long live;
+	void *ptr;
+
+	live = memprof_get_live("test");
+	prev = memprof_push("test");
+	ptr = malloc(0x1000);
+	ut_assertnonnull(ptr);
+	memprof_pop(prev);
+	ut_assert(memprof_get_live("test") >= live + 0x1000);
+
+	prev = memprof_push("test-free");
+	free(ptr);
+	memprof_pop(prev);
+	ut_asserteq(live, memprof_get_live("test"));
+	ut_asserteq(0, memprof_get_live("test-free"));
+
+	return 0;
+}
+LIB_TEST(lib_test_memprof_owner, 0);
+
+/* Check that the LMB span covers reservations but not frees */
+static int lib_test_memprof_lmb(struct unit_test_state *uts)
+{
+	struct memprof_export exp;
+	void *save;
+
+	/* Keep the profile gathered so far, for 'memprof' after the tests */
+	save = memprof_save();
+	ut_assertnonnull(save);
+	memprof_reset();
+	memprof_lmb(MEMPROF_LMB_RESERVE, 0x40000000, 0x1000);
+	memprof_lmb(MEMPROF_LMB_ALLOC, 0x48000000, 0x2000);
+	memprof_lmb(MEMPROF_LMB_FREE, 0x30000000, 0x1000);
+	memprof_get_export(&exp);
+	ut_asserteq_64(0x40000000, exp.lmb_low);
+	ut_asserteq_64(0x48002000, exp.lmb_high);
+
+	memprof_reset();
+	memprof_get_export(&exp);
+	ut_asserteq_64(0, exp.lmb_high);
+	memprof_restore(save);
+
+	return 0;
+}
+LIB_TEST(lib_test_memprof_lmb, 0);
@@ -12,9 +12,14 @@
 #include <common.h>
 #include <command.h>
 #include <log.h>
+#include <malloc.h>
+#include <time.h>
 #include <test/lib.h>
 #include <test/test.h>
 #include <test/ut.h>
+#include <asm/cache.h>
+#include <linux/math64.h>
+#include <linux/sizes.h>
 
 /* Xor mask used for marking memory regions */
 #define MASK 0xA5
@@ -193,3 +198,166 @@ static int lib_memmove(struct unit_test_state *uts)
 }
 
 LIB_TEST(lib_memmove, 0);
+
+/* Lengths around the point where the bulk (e.g. NEON) routines take over */
+static const int large_lens[] = {
+	63, 64, 65, 127, 128, 129, 135, 191, 192, 255, 256, 1000, 4096, 4103,
+};
+
+#define LARGE_BUFLEN	(4103 + 2 * SWEEP)
+
+/**
+ * lib_memcpy_large() - unit test for memcpy() on larger regions
+ *
+ * Check that bytes before and after the copied region are untouched for
+ * varied alignment of source and destination.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_memcpy_large(struct unit_test_state *uts)
+{
+	int offset1, offset2, i, j;
+	u8 *src, *dst;
+
+	src = malloc(LARGE_BUFLEN);
+	dst = malloc(LARGE_BUFLEN);
+	ut_assertnonnull(src);
+	ut_assertnonnull(dst);
+	for (i = 0; i < LARGE_BUFLEN; i++)
+		src[i] = (i * 7) ^ MASK;
+
+	for (i = 0; i < ARRAY_SIZE(large_lens); i++) {
+		int len = large_lens[i];
+
+		for (offset1 = 0; offset1 < SWEEP; offset1 += 3) {
+			for (offset2 = 0; offset2 < SWEEP; offset2++) {
+				memset(dst, 0, LARGE_BUFLEN);
+				ut_asserteq_ptr(dst + offset2,
+						memcpy(dst + offset2,
+						       src + offset1, len));
+				for (j = 0; j < offset2; j++)
+					ut_asserteq(0, dst[j]);
+				ut_asserteq_mem(src + offset1, dst + offset2,
+						len);
+				for (j = offset2 + len; j < LARGE_BUFLEN; j++)
+					ut_asserteq(0, dst[j]);
+			}
+		}
+	}
+	free(dst);
+	free(src);
+
+	return 0;
+}
+
+LIB_TEST(lib_memcpy_large, 0);
+
+/**
+ * lib_memset_large() - unit test for memset() on larger regions
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_memset_large(struct unit_test_state *uts)
+{
+	int offset, i, j;
+	u8 *buf;
+
+	buf = malloc(LARGE_BUFLEN);
+	ut_assertnonnull(buf);
+
+	for (i = 0; i < ARRAY_SIZE(large_lens); i++) {
+		int len = large_lens[i];
+
+		for (offset = 0; offset < SWEEP; offset++) {
+			memset(buf, 0, LARGE_BUFLEN);
+			ut_asserteq_ptr(buf + offset,
+					memset(buf + offset, MASK, len));
+			for (j = 0; j < LARGE_BUFLEN; j++) {
+				if (j < offset || j >= offset + len) {
+					ut_asserteq(0, buf[j]);
+				} else {
+					ut_asserteq(MASK, buf[j]);
+				}
+			}
+		}
+	}
+	free(buf);
+
+	return 0;
+}
+
+LIB_TEST(lib_memset_large, 0);
+
+#ifdef CONFIG_UT_LIB_BENCH
+#define BENCH_SIZE	SZ_1M
+#define BENCH_LOOPS	16
+
+/**
+ * bench_rate() - convert a byte count and time to KiB/s
+ *
+ * @bytes:	number of bytes processed
+ * @us:		time taken in microseconds
+ * Return:	rate in KiB/s
+ */
+static ulong bench_rate(ulong bytes, ulong us)
+{
+	return us ? (ulong)div_u64((u64)bytes * 1000000 / 1024, us) : 0;
+}
+
+/**
+ * lib_mem_bench() - benchmark memcpy() and memset()
+ *
+ * This times memcpy() and memset() on 1 MiB buffers against a plain word
+ * loop, so the gain from the architecture's routines can be seen. Only the
+ * results are checked, not the speed.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_mem_bench(struct unit_test_state *uts)
+{
+	ulong start, t_cpy, t_set, t_loop;
+	u32 *src, *dst;
+	int i, j;
+
+	src = memalign(ARCH_DMA_MINALIGN, BENCH_SIZE);
+	dst = memalign(ARCH_DMA_MINALIGN, BENCH_SIZE);
+	ut_assertnonnull(src);
+	ut_assertnonnull(dst);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		memset(src, i, BENCH_SIZE);
+	t_set = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		memcpy(dst, src, BENCH_SIZE);
+	t_cpy = timer_get_us() - start;
+	ut_asserteq_mem(src, dst, BENCH_SIZE);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++) {
+		volatile u32 *vdst = dst;
+
+		for (j = 0; j < BENCH_SIZE / sizeof(u32); j++)
+			vdst[j] = src[j];
+	}
+	t_loop = timer_get_us() - start;
+
+	printf("memset %8lu KiB/s\n",
+	       bench_rate(BENCH_SIZE * BENCH_LOOPS, t_set));
+	printf("memcpy %8lu KiB/s\n",
+	       bench_rate(BENCH_SIZE * BENCH_LOOPS, t_cpy));
+	printf("loop   %8lu KiB/s\n",
+	       bench_rate(BENCH_SIZE * BENCH_LOOPS, t_loop));
+	free(dst);
+	free(src);
+
+	return 0;
+}
+
+LIB_TEST(lib_mem_bench, 0);
+#endif
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for cooperative threads
+ */
+
+#include <common.h>
+#include <uthread.h>
+#include <linux/errno.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define UTHREAD_TEST_STEPS	3
+
+/**
+ * struct uthread_test_step - Argument of a thread which logs its steps
+ *
+ * @log: Log shared by the threads, to which each step adds @id
+ * @id: Character identifying the thread
+ */
+struct uthread_test_step {
+	char *log;
+	char id;
+};
+
+/**
+ * struct uthread_test_flag - Flag set by a thread after some time
+ *
+ * @ticks: Number of times to yield before setting @ready
+ * @ready: Set by the producer thread
+ * @seen: Set by the waiting thread once it has seen @ready
+ */
+struct uthread_test_flag {
+	int ticks;
+	bool ready;
+	bool seen;
+};
+
+static void uthread_test_steps(void *arg)
+{
+	struct uthread_test_step *step = arg;
+	int i;
+
+	for (i = 0; i < UTHREAD_TEST_STEPS; i++) {
+		step->log[strlen(step->log)] = step->id;
+		uthread_schedule();
+	}
+}
+
+static void uthread_test_producer(void *arg)
+{
+	struct uthread_test_flag *flag = arg;
+
+	while (flag->ticks--)
+		uthread_schedule();
+	flag->ready = true;
+}
+
+static bool uthread_test_ready(void *arg)
+{
+	struct uthread_test_flag *flag = arg;
+
+	return flag->ready;
+}
+
+/* Start a producer thread from this thread and wait for it */
+static void uthread_test_waiter(void *arg)
+{
+	struct uthread_test_flag *flag = arg;
+
+	if (uthread_create(NULL, uthread_test_producer, flag, 0))
+		return;
+	if (!uthread_wait(uthread_test_ready, flag, 0))
+		flag->seen = true;
+}
+
+/* Check that threads take turns and are removed when they finish */
+static int lib_test_uthread_turns(struct unit_test_state *uts)
+{
+	char log[2 * UTHREAD_TEST_STEPS + 1] = "";
+	struct uthread_test_step a = { log, 'a' };
+	struct uthread_test_step b = { log, 'b' };
+	struct uthread ta, tb;
+
+	ut_assertok(uthread_create(&ta, uthread_test_steps, &a, 0));
+	ut_assertok(uthread_create(&tb, uthread_test_steps, &b, 8192));
+	ut_asserteq(2, uthread_count());
+
+	while (!uthread_done(&ta) || !uthread_done(&tb))
+		ut_assert(uthread_schedule());
+	ut_asserteq_str("ababab", log);
+	ut_asserteq(0, uthread_count());
+	ut_assert(!uthread_schedule());
+
+	return 0;
+}
+LIB_TEST(lib_test_uthread_turns, 0);
+
+/* Check that waiting lets other threads run, and that it can time out */
+static int lib_test_uthread_wait(struct unit_test_state *uts)
+{
+	struct uthread_test_flag flag = { .ticks = 5 };
+
+	ut_assertok(uthread_create(NULL, uthread_test_producer, &flag, 0));
+	ut_assertok(uthread_wait(uthread_test_ready, &flag, 0));
+	ut_asserteq(-1, flag.ticks);
+	ut_asserteq(0, uthread_count());
+
+	flag.ready = false;
+	ut_asserteq(-ETIMEDOUT, uthread_wait(uthread_test_ready, &flag, 10));
+
+	return 0;
+}
+LIB_TEST(lib_test_uthread_wait, 0);
+
+/* Check that a thread can start another thread and wait for it */
+static int lib_test_uthread_nested(struct unit_test_state *uts)
+{
+	struct uthread_test_flag flag = { .ticks = 3 };
+	struct uthread waiter;
+
+	ut_assertok(uthread_create(&waiter, uthread_test_waiter, &flag, 0));
+	while (!uthread_done(&waiter))
+		ut_assert(uthread_schedule());
+	ut_assert(flag.ready);
+	ut_assert(flag.seen);
+	ut_asserteq(0, uthread_count());
+
+	return 0;
+}
+LIB_TEST(lib_test_uthread_nested, 0);